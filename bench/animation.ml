@@ -0,0 +1,47 @@
+open OgamlMath
+open OgamlUtils
+
+(* 10000 animated properties sampled at a shared time : cubic interpolators
+ * evaluated one by one, and the same curves compiled as animation tracks *)
+
+let properties = 10_000
+
+let keys = 16
+
+let times = Array.init keys (fun i -> float_of_int i /. float_of_int (keys - 1))
+
+let values = Array.init properties (fun _ -> Array.init keys (fun _ -> Random.float 100.))
+
+let interpolators = Array.map (fun v ->
+  let steps = Array.to_list (Array.init (keys - 2) (fun i -> (times.(i + 1), v.(i + 1)))) in
+  Interpolator.cubic (v.(0), 0.) steps (v.(keys - 1), 0.)) values
+
+let anim = Animation.create (Array.to_list (Array.map (Animation.Track.cubic times) values))
+
+let rotations = Animation.create (Array.to_list (Array.init (properties / 4) (fun _ ->
+  Animation.Track.rotation times (Array.init keys (fun _ ->
+    Quaternion.rotation Vector3f.unit_y (Random.float 6.))))))
+
+let buf = Animation.buffer anim
+
+let rbuf = Animation.buffer rotations
+
+let sum = ref 0.
+
+let time = ref 0.
+
+let advance () =
+  time := !time +. 0.0137;
+  if !time > 1. then time := 0.;
+  !time
+
+let () =
+  let open Benchmark in
+  register "animation" "Interpolator.get (10k cubic)" (fun () ->
+    let t = advance () in
+    Array.iter (fun ip -> sum := !sum +. Interpolator.get ip t) interpolators);
+  register "animation" "Animation.sample (10k cubic)" (fun () ->
+    Animation.sample anim (advance ()) buf);
+  register "animation" "Animation.sample (2.5k slerp)" (fun () ->
+    Animation.sample rotations (advance ()) rbuf);
+  main ()
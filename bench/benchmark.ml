@@ -0,0 +1,218 @@
+(* Micro-benchmark runner.
+ *
+ * Each benchmark is first calibrated : the number of runs per sample is
+ * doubled until a sample lasts at least [sample_time]. It is then warmed up
+ * for [warmup_time] seconds before [samples] samples are taken. We report
+ * the median time per run, its median absolute deviation, and the number of
+ * words allocated per run (minor and major heaps, from Gc.counters).
+ *
+ * Each sample is paired with a sample of an empty benchmark returning the
+ * same kind of result, whose time and allocations are subtracted : they are
+ * the cost of the harness, such as the boxing of float results.
+ * Times come from the monotonic clock of OgamlUtils.Clock.
+ *
+ * Results are printed and appended to a CSV file, tagged with a commit id,
+ * so that successive runs can be compared with -compare. *)
+
+type result = {
+  group  : string;
+  name   : string;
+  median : float; (* ns per run *)
+  mad    : float; (* ns per run *)
+  minor  : float; (* words per run *)
+  major  : float; (* words per run *)
+  runs   : int;   (* runs per sample *)
+  count  : int    (* number of samples *)
+}
+
+type bench = {
+  bgroup : string;
+  bname  : string;
+  run    : unit -> unit;
+  empty  : unit -> unit
+}
+
+let benches = ref []
+
+let samples = ref 21
+
+let sample_time = ref 0.01
+
+let warmup_time = ref 0.2
+
+let output = ref None
+
+let baseline = ref None
+
+let commit = ref "unknown"
+
+let filter = ref ""
+
+(* Keep the results alive so that the computations are not discarded.
+ * Float results are stored unboxed, but still leave their closure boxed. *)
+let sink = ref (Obj.repr 0)
+
+let float_sink = Array.make 2 0.
+
+let keep f = fun () -> sink := Obj.repr (f ())
+
+let keep_float f = fun () -> Array.unsafe_set float_sink 0 (f ())
+
+let empty = keep (fun () -> ())
+
+let empty_float = keep_float (fun () -> Array.unsafe_get float_sink 1)
+
+let register group name f =
+  benches := {bgroup = group; bname = name; run = keep f; empty} :: !benches
+
+let register_float group name f =
+  benches := {bgroup = group; bname = name; run = keep_float f; empty = empty_float}
+             :: !benches
+
+
+(* Statistics *)
+let median arr =
+  let arr = Array.copy arr in
+  Array.sort compare arr;
+  let n = Array.length arr in
+  if n = 0 then nan
+  else if n mod 2 = 1 then arr.(n / 2)
+  else (arr.(n / 2 - 1) +. arr.(n / 2)) /. 2.
+
+let mad arr =
+  let m = median arr in
+  median (Array.map (fun x -> abs_float (x -. m)) arr)
+
+
+(* Measurement *)
+let time_runs f runs =
+  let start = OgamlUtils.Clock.now_ns () in
+  for _i = 1 to runs do f () done;
+  float_of_int (OgamlUtils.Clock.now_ns () - start) *. 1e-9
+
+let rec calibrate f runs =
+  if time_runs f runs >= !sample_time || runs >= 1 lsl 30 then runs
+  else calibrate f (runs * 2)
+
+let warmup f runs =
+  let start = OgamlUtils.Clock.now () in
+  while OgamlUtils.Clock.now () -. start < !warmup_time do
+    ignore (time_runs f runs)
+  done
+
+(* Time (ns), minor words and major words per run of a sample *)
+let sample f runs =
+  let (mi1, pr1, ma1) = Gc.counters () in
+  let t = time_runs f runs in
+  let (mi2, pr2, ma2) = Gc.counters () in
+  let fruns = float_of_int runs in
+  (t *. 1e9 /. fruns, (mi2 -. mi1) /. fruns, ((ma2 -. ma1) -. (pr2 -. pr1)) /. fruns)
+
+let measure b =
+  let runs = calibrate b.run 1 in
+  warmup b.run runs;
+  let times  = Array.make !samples 0. in
+  let minors = Array.make !samples 0. in
+  let majors = Array.make !samples 0. in
+  for i = 0 to !samples - 1 do
+    let (t, mi, ma) = sample b.run runs in
+    let (t0, mi0, ma0) = sample b.empty runs in
+    times.(i)  <- t -. t0;
+    minors.(i) <- mi -. mi0;
+    majors.(i) <- ma -. ma0
+  done;
+  {group  = b.bgroup;
+   name   = b.bname;
+   median = max 0. (median times);
+   mad    = mad times;
+   minor  = max 0. (median minors);
+   major  = max 0. (median majors);
+   runs;
+   count  = !samples}
+
+
+(* Output *)
+let csv_header = "commit,group,name,median_ns,mad_ns,minor_words,major_words,runs,samples"
+
+let csv_line r =
+  Printf.sprintf "%s,%s,%s,%.3f,%.3f,%.3f,%.3f,%i,%i"
+    !commit r.group r.name r.median r.mad r.minor r.major r.runs r.count
+
+let write_csv file results =
+  let exists = Sys.file_exists file in
+  let chan = open_out_gen [Open_append; Open_creat; Open_text] 0o644 file in
+  if not exists then output_string chan (csv_header ^ "\n");
+  List.iter (fun r -> output_string chan (csv_line r ^ "\n")) results;
+  close_out chan
+
+let split c s =
+  let rec aux i j acc =
+    if j < 0 then String.sub s 0 i :: acc
+    else if s.[j] = c then aux j (j-1) (String.sub s (j+1) (i-j-1) :: acc)
+    else aux i (j-1) acc
+  in
+  aux (String.length s) (String.length s - 1) []
+
+(* Returns the last result of each benchmark recorded for another commit *)
+let read_baseline file =
+  let tbl = Hashtbl.create 97 in
+  let chan = open_in file in
+  (try
+    while true do
+      match split ',' (input_line chan) with
+      | [c; g; n; med; md; _; _; _; _] when c <> "commit" && c <> !commit ->
+        Hashtbl.replace tbl (g, n) (float_of_string med, float_of_string md)
+      | _ -> ()
+    done
+  with End_of_file -> ());
+  close_in chan;
+  tbl
+
+let print_result base r =
+  let delta =
+    match base with
+    | None -> ""
+    | Some tbl ->
+      try
+        let (med, md) = Hashtbl.find tbl (r.group, r.name) in
+        let pct = 100. *. (r.median -. med) /. med in
+        (* Only flag differences larger than the noise of both runs *)
+        let significant = abs_float (r.median -. med) > 3. *. (r.mad +. md) in
+        Printf.sprintf " %+7.1f%%%s" pct
+          (if not significant then "" else if pct > 0. then " (slower)" else " (faster)")
+      with Not_found -> " (new)"
+  in
+  Printf.printf "%-14s %-36s %12.1f ns  +/- %8.1f %10.1f w %8.1f W%s\n%!"
+    r.group r.name r.median r.mad r.minor r.major delta
+
+let contains s sub =
+  let n, m = String.length s, String.length sub in
+  let rec aux i = i + m <= n && (String.sub s i m = sub || aux (i+1)) in
+  m = 0 || aux 0
+
+let main () =
+  Arg.parse [
+    "-o", Arg.String (fun s -> output := Some s), "FILE Append results to a CSV file";
+    "-compare", Arg.String (fun s -> baseline := Some s), "FILE Compare with the last results of a CSV file";
+    "-commit", Arg.Set_string commit, "ID Commit id recorded with the results";
+    "-filter", Arg.Set_string filter, "STR Only run benchmarks whose name contains STR";
+    "-samples", Arg.Set_int samples, "N Number of samples (default 21)";
+    "-warmup", Arg.Set_float warmup_time, "T Warm-up time in seconds (default 0.2)";
+  ] (fun _ -> ()) "Usage: bench [options]";
+  let base =
+    match !baseline with
+    | Some f when Sys.file_exists f -> Some (read_baseline f)
+    | _ -> None
+  in
+  Printf.printf "%-14s %-36s %15s  %11s %12s %10s\n%!"
+    "group" "benchmark" "median" "mad" "minor" "major";
+  let results =
+    List.rev !benches
+    |> List.filter (fun b -> contains (b.bgroup ^ "." ^ b.bname) !filter)
+    |> List.map (fun b ->
+      let r = measure b in
+      print_result base r; r)
+  in
+  match !output with
+  | None -> ()
+  | Some f -> write_csv f results
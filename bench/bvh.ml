@@ -0,0 +1,48 @@
+open OgamlMath
+open OgamlUtils
+
+(* Picking and collision queries on a soup of 100k triangles, 
+ * compared with a linear scan *)
+
+let ntriangles = 100_000
+
+let triangles = 
+  Array.init ntriangles (fun _ -> 
+    let p = Vector3f.make (Random.float 1000.) (Random.float 1000.) (Random.float 1000.) in
+    let d () = Vector3f.make (Random.float 5.) (Random.float 5.) (Random.float 5.) in
+    BVH.Triangle (p, Vector3f.add p (d ()), Vector3f.add p (d ())))
+
+let bvh = BVH.create triangles
+
+let singles = Array.map (fun t -> BVH.create [|t|]) triangles
+
+let origin = Vector3f.make (-10.) 500. 500.
+
+let direction = Vector3f.make 1. 0.01 (-0.02)
+
+let linear_raycast () = 
+  Array.fold_left (fun best b -> 
+    match BVH.raycast b ~origin ~direction () with
+    | Some h when h.BVH.distance < best -> h.BVH.distance
+    | _ -> best
+  ) infinity singles
+
+let () = 
+  match BVH.raycast bvh ~origin ~direction () with
+  | Some h -> assert (h.BVH.distance = linear_raycast ())
+  | None -> assert (linear_raycast () = infinity)
+
+let () = 
+  let open Benchmark in
+  let count = ref 0 in
+  register "bvh" "create (100k triangles)" (fun () -> BVH.create triangles);
+  register "bvh" "refit (100k triangles)" (fun () -> BVH.refit bvh);
+  register "bvh" "update" (fun () -> BVH.update bvh 0 triangles.(0));
+  register "bvh" "raycast" (fun () -> BVH.raycast bvh ~origin ~direction ());
+  register "bvh" "raycast (linear scan)" linear_raycast;
+  register "bvh" "overlap_sphere" (fun () -> 
+    BVH.overlap_sphere bvh (Vector3f.make 500. 500. 500.) 20. (fun _ -> incr count));
+  register "bvh" "overlap_box" (fun () -> 
+    BVH.overlap_box bvh (FloatBox.create (Vector3f.make 480. 480. 480.) (Vector3f.make 40. 40. 40.)) 
+      (fun _ -> incr count));
+  main ()
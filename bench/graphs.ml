@@ -0,0 +1,76 @@
+open OgamlUtils
+
+(* Compares the persistent graphs with their frozen CSR copies, 
+ * on a 4-connected grid and on a random graph *)
+
+module G = Graph.Make (struct
+
+  type t = int
+
+  let compare (i : int) (j : int) = compare i j
+
+end)
+
+let side = 200
+
+let grid = 
+  let g = ref G.empty in
+  for y = 0 to side - 1 do
+    for x = 0 to side - 1 do
+      let v = y * side + x in
+      let cost = 1. +. Random.float 1. in
+      if x > 0 then g := G.add_edge !g ~cost v (v - 1);
+      if x < side - 1 then g := G.add_edge !g ~cost v (v + 1);
+      if y > 0 then g := G.add_edge !g ~cost v (v - side);
+      if y < side - 1 then g := G.add_edge !g ~cost v (v + side)
+    done
+  done;
+  !g
+
+let nrandom = 20_000
+
+let random = 
+  let g = ref G.empty in
+  for v = 0 to nrandom - 1 do
+    for _i = 1 to 4 do
+      g := G.add_edge !g ~cost:(Random.float 10.) v (Random.int nrandom)
+    done
+  done;
+  !g
+
+let (grid_csr, grid_id, _) = G.to_csr grid
+
+let (random_csr, random_id, _) = G.to_csr random
+
+let manhattan v = 
+  float_of_int (abs (v mod side - (side - 1)) + abs (v / side - (side - 1)))
+
+let () = 
+  let check g csr id s t = 
+    match G.dijkstra g s t, Graph.CSR.dijkstra csr (id s) (id t) with
+    | None, None -> ()
+    | Some (d, _), Some (d', _) -> assert (d = d')
+    | _ -> assert false
+  in
+  check grid grid_csr grid_id 0 (side * side - 1);
+  check random random_csr random_id 0 (nrandom - 1)
+
+let () = 
+  let open Benchmark in
+  let last = side * side - 1 in
+  let count = ref 0 in
+  register "graphs" "grid dijkstra (G)" (fun () -> G.dijkstra grid 0 last);
+  register "graphs" "grid dijkstra (CSR)" (fun () -> 
+    Graph.CSR.dijkstra grid_csr (grid_id 0) (grid_id last));
+  register "graphs" "grid astar (G)" (fun () -> G.astar grid 0 last manhattan);
+  register "graphs" "grid astar (CSR)" (fun () -> 
+    Graph.CSR.astar grid_csr (grid_id 0) (grid_id last) manhattan);
+  register "graphs" "grid bfs (G)" (fun () -> G.bfs grid 0 (fun _ -> incr count));
+  register "graphs" "grid bfs (CSR)" (fun () -> Graph.CSR.bfs grid_csr (grid_id 0) (fun _ -> incr count));
+  register "graphs" "random dijkstra (G)" (fun () -> G.dijkstra random 0 (nrandom - 1));
+  register "graphs" "random dijkstra (CSR)" (fun () -> 
+    Graph.CSR.dijkstra random_csr (random_id 0) (random_id (nrandom - 1)));
+  register "graphs" "random dfs (G)" (fun () -> G.dfs random 0 (fun _ -> incr count));
+  register "graphs" "random dfs (CSR)" (fun () -> Graph.CSR.dfs random_csr (random_id 0) (fun _ -> incr count));
+  register "graphs" "to_csr (grid)" (fun () -> G.to_csr grid);
+  main ()
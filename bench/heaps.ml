@@ -0,0 +1,64 @@
+open OgamlUtils
+
+(* Compares the persistent leftist heap with the mutable indexed heaps *)
+
+module Prio = struct
+
+  type t = float
+
+  let compare (f1 : float) (f2 : float) = compare f1 f2
+
+end
+
+module Q = PriorityQueue.Make (Prio)
+
+module IQ = PriorityQueue.Indexed (Prio)
+
+let n = 10_000
+
+let prios = Array.init n (fun _ -> Random.float 1.)
+
+let elements = Array.map (fun p -> (p, 0)) prios
+
+let leftist () = 
+  let q = Array.fold_left (fun q p -> Q.insert q p 0) Q.empty prios in
+  let q = ref q in
+  while not (Q.is_empty !q) do q := Q.pop !q done
+
+let indexed arity () = 
+  let q = IQ.create ~arity () in
+  Array.iter (fun p -> ignore (IQ.insert q p 0)) prios;
+  while not (IQ.is_empty q) do IQ.pop q done
+
+let heapified arity () = 
+  let q = IQ.heapify ~arity elements in
+  while not (IQ.is_empty q) do IQ.pop q done
+
+(* Typical open set of a search : each element has its key decreased 
+ * a few times before being extracted. The leftist heap inserts duplicates. *)
+let leftist_decrease () = 
+  let q = ref Q.empty in
+  Array.iteri (fun i p -> 
+    q := Q.insert !q p i;
+    q := Q.insert !q (p /. 2.) i;
+    q := Q.insert !q (p /. 4.) i) prios;
+  while not (Q.is_empty !q) do q := Q.pop !q done
+
+let indexed_decrease arity () = 
+  let q = IQ.create ~arity () in
+  Array.iteri (fun i p -> 
+    let h = IQ.insert q p i in
+    IQ.decrease_key q h (p /. 2.);
+    IQ.decrease_key q h (p /. 4.)) prios;
+  while not (IQ.is_empty q) do IQ.pop q done
+
+let () = 
+  let open Benchmark in
+  register "heaps" "insert/pop 10k (leftist)" leftist;
+  register "heaps" "insert/pop 10k (binary)" (indexed 2);
+  register "heaps" "insert/pop 10k (4-ary)" (indexed 4);
+  register "heaps" "heapify/pop 10k (4-ary)" (heapified 4);
+  register "heaps" "decrease/pop 10k (leftist)" leftist_decrease;
+  register "heaps" "decrease/pop 10k (binary)" (indexed_decrease 2);
+  register "heaps" "decrease/pop 10k (4-ary)" (indexed_decrease 4);
+  main ()
@@ -0,0 +1,27 @@
+open OgamlUtils
+
+(* Cost of a log message on the calling thread, written synchronously or
+ * left to the background thread, and of a disabled message *)
+
+let file = Filename.temp_file "ogaml" ".log"
+
+let output = open_out file
+
+let sync = Log.create ~output ~color:false ()
+
+let async = Log.create ~output ~color:false ~async:true ~capacity:65536 ()
+
+let quiet = Log.create ~output ~debug:false ()
+
+let v = 3.14159
+
+let () =
+  let open Benchmark in
+  register "log" "debug (disabled)" (fun () -> Log.debug quiet "value %f at frame %i" v 42);
+  register "log" "info (sync)" (fun () -> Log.info sync "value %f at frame %i" v 42);
+  register "log" "info (async)" (fun () -> Log.info async "value %f at frame %i" v 42);
+  register "log" "sprintf (reference)" (fun () -> Printf.sprintf "value %f at frame %i" v 42);
+  main ();
+  Log.flush async;
+  close_out output;
+  Sys.remove file
@@ -0,0 +1,75 @@
+open OgamlMath
+
+(* Hot operations of OgamlMath *)
+
+let v1 = Vector3f.make 1. 2. 3.
+
+let v2 = Vector3f.make (-4.) 0.5 2.
+
+let u1 = Vector2f.make 1. 2.
+
+let u2 = Vector2f.make (-3.) 0.5
+
+let q1 = Quaternion.rotation (Vector3f.normalize v1) 0.7
+
+let q2 = Quaternion.rotation Vector3f.unit_y 1.2
+
+let m1 = Matrix3D.rotation v1 0.3
+
+let m2 = Matrix3D.perspective ~near:0.1 ~far:100. ~width:800. ~height:600. ~fov:1.2
+
+let dst = Matrix3D.identity ()
+
+let box1 = FloatBox.create (Vector3f.make 0. 0. 0.) (Vector3f.make 2. 2. 2.)
+
+let box2 = FloatBox.create (Vector3f.make 1. 1. 1.) (Vector3f.make 3. 3. 3.)
+
+let rect1 = FloatRect.create (Vector2f.make 0. 0.) (Vector2f.make 2. 2.)
+
+let rect2 = FloatRect.create (Vector2f.make 1. 1.) (Vector2f.make 3. 3.)
+
+let irect = IntRect.create (Vector2i.make 0 0) (Vector2i.make 64 64)
+
+let () = 
+  let open Benchmark in
+  register "Vector3f" "add" (fun () -> Vector3f.add v1 v2);
+  register "Vector3f" "prop" (fun () -> Vector3f.prop 2. v1);
+  register_float "Vector3f" "dot" (fun () -> Vector3f.dot v1 v2);
+  register "Vector3f" "cross" (fun () -> Vector3f.cross v1 v2);
+  register_float "Vector3f" "norm" (fun () -> Vector3f.norm v1);
+  register "Vector3f" "normalize" (fun () -> Vector3f.normalize v1);
+  register "Vector3f" "map2" (fun () -> Vector3f.map2 v1 v2 min);
+  register "Vector3f" "direction" (fun () -> Vector3f.direction v1 v2);
+  register "Vector2f" "add" (fun () -> Vector2f.add u1 u2);
+  register_float "Vector2f" "dot" (fun () -> Vector2f.dot u1 u2);
+  register "Vector2f" "normalize" (fun () -> Vector2f.normalize u1);
+  register "Quaternion" "times" (fun () -> Quaternion.times q1 q2);
+  register "Quaternion" "rotation" (fun () -> Quaternion.rotation Vector3f.unit_x 0.5);
+  register "Quaternion" "normalize" (fun () -> Quaternion.normalize q1);
+  register "Quaternion" "inverse" (fun () -> Quaternion.inverse q1);
+  register "Matrix3D" "identity" (fun () -> Matrix3D.identity ());
+  register "Matrix3D" "product" (fun () -> Matrix3D.product m1 m2);
+  register "Matrix3D" "product_into" (fun () -> Matrix3D.product_into m1 m2 dst);
+  register "Matrix3D" "transpose" (fun () -> Matrix3D.transpose m1);
+  register "Matrix3D" "translate" (fun () -> Matrix3D.translate v1 m1);
+  register "Matrix3D" "scale" (fun () -> Matrix3D.scale v1 m1);
+  register "Matrix3D" "rotate" (fun () -> Matrix3D.rotate v1 0.3 m1);
+  register "Matrix3D" "times" (fun () -> Matrix3D.times m1 v1);
+  register "Matrix3D" "from_quaternion" (fun () -> Matrix3D.from_quaternion q1);
+  register "Matrix3D" "look_at" (fun () -> 
+    Matrix3D.look_at ~from:v1 ~at:v2 ~up:Vector3f.unit_y);
+  register "Matrix3D" "look_at_eulerian" (fun () -> 
+    Matrix3D.look_at_eulerian ~from:v1 ~theta:0.3 ~phi:0.2);
+  register "Matrix3D" "perspective" (fun () -> 
+    Matrix3D.perspective ~near:0.1 ~far:100. ~width:800. ~height:600. ~fov:1.2);
+  register "FloatBox" "intersects" (fun () -> FloatBox.intersects box1 box2);
+  register "FloatBox" "includes" (fun () -> FloatBox.includes box1 box2);
+  register "FloatBox" "contains" (fun () -> FloatBox.contains box1 v1);
+  register "FloatBox" "extend" (fun () -> FloatBox.extend box1 v1);
+  register "FloatBox" "center" (fun () -> FloatBox.center box1);
+  register "FloatRect" "intersects" (fun () -> FloatRect.intersects rect1 rect2);
+  register "FloatRect" "contains" (fun () -> FloatRect.contains rect1 u1);
+  register "IntRect" "iter (64x64)" (fun () -> IntRect.iter irect (fun _ -> ()));
+  register "IntRect" "fold (64x64)" (fun () -> 
+    IntRect.fold irect (fun v acc -> acc + v.Vector2i.x) 0);
+  main ()
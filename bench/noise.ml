@@ -0,0 +1,42 @@
+open OgamlMath
+open OgamlUtils
+open Noise
+
+(* Single samples of each noise, and a 512x512 heightmap of 6 octaves
+ * filled in OCaml and natively *)
+
+let size = 512
+
+let perlin = Perlin2D.create_with_seed (Random.State.make [|1|])
+
+let simplex = Simplex2D.create_with_seed (Random.State.make [|1|])
+
+let opensimplex = OpenSimplex2D.create_with_seed (Random.State.make [|1|])
+
+let fbm = Fractal.create (Fractal.Simplex simplex)
+
+let warped = Fractal.create ~octaves:4 ~warp:0.5 (Fractal.OpenSimplex opensimplex)
+
+let field = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (size * size)
+
+let all = IntRect.create Vector2i.zero (Vector2i.make size size)
+
+let origin = Vector2f.make 0.5 0.5
+
+let step = 0.01
+
+let p = Vector2f.make 12.3 45.6
+
+let () =
+  let open Benchmark in
+  register_float "noise" "perlin2D" (fun () -> Perlin2D.get perlin p);
+  register_float "noise" "simplex2D" (fun () -> Simplex2D.get simplex p);
+  register_float "noise" "opensimplex2D" (fun () -> OpenSimplex2D.get opensimplex p);
+  register_float "noise" "fbm (6 octaves)" (fun () -> Fractal.get fbm p);
+  register "noise" "fill 512x512 fbm (ocaml)" (fun () ->
+    Fractal.fill ~native:false fbm field ~stride:size ~origin ~step all);
+  register "noise" "fill 512x512 fbm (native)" (fun () ->
+    Fractal.fill fbm field ~stride:size ~origin ~step all);
+  register "noise" "fill 512x512 warped (native)" (fun () ->
+    Fractal.fill warped field ~stride:size ~origin ~step all);
+  main ()
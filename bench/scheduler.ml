@@ -0,0 +1,44 @@
+open OgamlMath
+open OgamlUtils
+
+(* Overhead of the tasks of the pool, and a 1024x1024 heightmap filled
+ * natively in bands, compared with a single call *)
+
+let pool = Scheduler.create ~workers:4 ()
+
+let size = 1024
+
+let bands = 16
+
+let fbm =
+  Noise.Fractal.create (Noise.Fractal.Simplex (Noise.Simplex2D.create_with_seed (Random.State.make [|1|])))
+
+let field = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (size * size)
+
+let origin = Vector2f.make 0.5 0.5
+
+let step = 0.005
+
+let fill_band j =
+  let h = size / bands in
+  Noise.Fractal.fill fbm field ~stride:size ~origin ~step
+    (IntRect.create (Vector2i.make 0 (j * h)) (Vector2i.make size h))
+
+let data = Array.init 100_000 (fun i -> float_of_int i)
+
+let () =
+  let open Benchmark in
+  register "scheduler" "async + await" (fun () -> Scheduler.await pool (Scheduler.async pool (fun () -> 1)));
+  register_float "scheduler" "sum 100k (sequential)" (fun () -> Array.fold_left (+.) 0. data);
+  register_float "scheduler" "sum 100k (parallel_reduce)" (fun () ->
+    Scheduler.parallel_reduce pool ~start:0 ~finish:(Array.length data - 1) (+.) 0. (fun i -> data.(i)));
+  register "scheduler" "fill 1024x1024 fbm (1 thread)" (fun () ->
+    for j = 0 to bands - 1 do fill_band j done);
+  register "scheduler" "fill 1024x1024 fbm (4 workers)" (fun () ->
+    Scheduler.parallel_for pool ~chunk_size:1 ~start:0 ~finish:(bands - 1) fill_band);
+  main ();
+  Array.iteri (fun i s ->
+    Printf.printf "worker %d : %d tasks, %d steals, %.0f%% busy\n%!"
+      i s.Scheduler.tasks s.Scheduler.steals (100. *. Scheduler.utilization s)
+  ) (Scheduler.stats pool);
+  Scheduler.shutdown pool
@@ -0,0 +1,56 @@
+open OgamlMath
+open OgamlUtils
+
+(* Broad phase of 10k moving sprites, rebuilt every frame, compared with
+ * the pairwise tests it replaces *)
+
+let nobjects = 10_000
+
+let world = 2_000.
+
+let rects =
+  Array.init nobjects (fun _ ->
+    FloatRect.create (Vector2f.make (Random.float world) (Random.float world)) (Vector2f.make 8. 8.))
+
+let grid = SpatialHash2D.create ~capacity:nobjects ~cell_size:8. ()
+
+let move () =
+  for i = 0 to nobjects - 1 do
+    rects.(i) <- FloatRect.translate rects.(i)
+        (Vector2f.make (Random.float 2. -. 1.) (Random.float 2. -. 1.))
+  done
+
+let fill () =
+  SpatialHash2D.clear grid;
+  Array.iteri (fun i r -> SpatialHash2D.add grid i r) rects
+
+let count_pairs () =
+  let count = ref 0 in
+  SpatialHash2D.iter_pairs grid (fun _ _ -> incr count);
+  !count
+
+let pairwise () =
+  let count = ref 0 in
+  for i = 0 to nobjects - 1 do
+    for j = i + 1 to nobjects - 1 do
+      if FloatRect.intersects rects.(i) rects.(j) then incr count
+    done
+  done;
+  !count
+
+let () =
+  fill ();
+  assert (count_pairs () = pairwise ())
+
+let () =
+  let open Benchmark in
+  register "spatialhash" "clear + fill (10k)" fill;
+  register "spatialhash" "move + fill + pairs (10k)" (fun () -> move (); fill (); count_pairs ());
+  register "spatialhash" "pairs (10k)" count_pairs;
+  register "spatialhash" "pairs (pairwise tests)" pairwise;
+  register "spatialhash" "query" (fun () ->
+    let count = ref 0 in
+    SpatialHash2D.query grid (FloatRect.create (Vector2f.make 900. 900.) (Vector2f.make 200. 200.))
+      (fun _ -> incr count);
+    !count);
+  main ()
@@ -0,0 +1,95 @@
+open OgamlMath
+open OgamlUtils
+open SpatialTree
+
+(* 100k objects moving in a 2D world, updated every frame, and queried with
+ * range and nearest-neighbour queries, compared with a linear scan *)
+
+let nobjects = 100_000
+
+let world = 10_000.
+
+let positions = Array.init nobjects (fun _ -> Vector2f.make (Random.float world) (Random.float world))
+
+let velocities = Array.init nobjects (fun _ -> Vector2f.make (Random.float 4. -. 2.) (Random.float 4. -. 2.))
+
+let size = Vector2f.make 4. 4.
+
+let quadtree = Quadtree.create (FloatRect.create Vector2f.zero (Vector2f.make world world))
+
+let handles = Array.map (fun p -> Quadtree.insert quadtree (FloatRect.create p size) ()) positions
+
+let rects = Array.map (fun p -> FloatRect.create p size) positions
+
+(* Moves every object, bouncing on the borders of the world *)
+let step () =
+  for i = 0 to nobjects - 1 do
+    let p = Vector2f.add positions.(i) velocities.(i) in
+    let v = velocities.(i) in
+    let vx = if p.Vector2f.x < 0. || p.Vector2f.x > world then -. v.Vector2f.x else v.Vector2f.x in
+    let vy = if p.Vector2f.y < 0. || p.Vector2f.y > world then -. v.Vector2f.y else v.Vector2f.y in
+    velocities.(i) <- Vector2f.make vx vy;
+    positions.(i) <- p;
+    rects.(i) <- FloatRect.create p size
+  done
+
+let update () =
+  step ();
+  for i = 0 to nobjects - 1 do
+    Quadtree.update quadtree handles.(i) rects.(i)
+  done
+
+let rebuild () =
+  step ();
+  Quadtree.clear quadtree;
+  for i = 0 to nobjects - 1 do
+    handles.(i) <- Quadtree.insert quadtree rects.(i) ()
+  done
+
+let query = FloatRect.create (Vector2f.make 4800. 4800.) (Vector2f.make 400. 400.)
+
+let center = Vector2f.make 5000. 5000.
+
+let range () =
+  let count = ref 0 in
+  Quadtree.range quadtree query (fun _ () -> incr count);
+  !count
+
+let linear_range () =
+  let count = ref 0 in
+  Array.iter (fun r -> if FloatRect.intersects r query then incr count) rects;
+  !count
+
+let () =
+  assert (range () = linear_range ())
+
+(* Octree of 100k static boxes, culled by a frustum *)
+let octree =
+  let t = Octree.create (FloatBox.create Vector3f.zero (Vector3f.make 1000. 1000. 1000.)) in
+  for _i = 1 to nobjects do
+    let p = Vector3f.make (Random.float 1000.) (Random.float 1000.) (Random.float 1000.) in
+    ignore (Octree.insert t (FloatBox.create p (Vector3f.make 2. 2. 2.)) ())
+  done;
+  t
+
+let frustum =
+  let view = Matrix3D.look_at ~from:(Vector3f.make 500. 500. (-10.)) ~at:(Vector3f.make 500. 500. 500.)
+      ~up:Vector3f.unit_y in
+  let projection = Matrix3D.perspective ~near:1. ~far:400. ~width:800. ~height:600.
+      ~fov:(Constants.pi /. 3.) in
+  Frustum.create ~view ~projection
+
+let () =
+  let open Benchmark in
+  let count = ref 0 in
+  register "spatialtrees" "quadtree update (100k moving)" update;
+  register "spatialtrees" "quadtree rebuild (100k moving)" rebuild;
+  register "spatialtrees" "quadtree range" range;
+  register "spatialtrees" "range (linear scan)" linear_range;
+  register "spatialtrees" "quadtree point" (fun () ->
+    Quadtree.point quadtree center (fun _ () -> incr count));
+  register "spatialtrees" "quadtree nearest (k = 16)" (fun () ->
+    Quadtree.nearest quadtree center 16);
+  register "spatialtrees" "octree frustum (100k static)" (fun () ->
+    Octree.frustum octree frustum (fun _ () -> incr count));
+  main ()
@@ -0,0 +1,57 @@
+open OgamlMath
+
+(* Compares the allocating Matrix3D API with its destination-passing 
+ * and batched variants *)
+
+let npoints = 100_000
+
+let m1 = Matrix3D.rotation Vector3f.unit_y 0.3
+
+let m2 = Matrix3D.translation (Vector3f.make 1. 2. 3.)
+
+let dst = Matrix3D.identity ()
+
+let axis = Vector3f.make 1. 1. 0.
+
+let offset = Vector3f.make 0.5 0. (-0.5)
+
+let points = 
+  let arr = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (3 * npoints) in
+  for i = 0 to 3 * npoints - 1 do
+    arr.{i} <- Random.float 10.
+  done;
+  arr
+
+let points_dst = 
+  Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (3 * npoints)
+
+let vectors = 
+  Array.init npoints (fun i -> 
+    Vector3f.make points.{3*i} points.{3*i+1} points.{3*i+2})
+
+let () = 
+  Matrix3D.transform_points m1 points points_dst;
+  for i = 0 to npoints - 1 do
+    let v = Matrix3D.times m1 vectors.(i) in
+    assert (abs_float (v.Vector3f.x -. points_dst.{3*i}) < 1e-3);
+    assert (abs_float (v.Vector3f.y -. points_dst.{3*i+1}) < 1e-3);
+    assert (abs_float (v.Vector3f.z -. points_dst.{3*i+2}) < 1e-3)
+  done
+
+let () = 
+  let open Benchmark in
+  register "transforms" "product" (fun () -> Matrix3D.product m1 m2);
+  register "transforms" "product_into" (fun () -> Matrix3D.product_into m1 m2 dst);
+  register "transforms" "translate" (fun () -> Matrix3D.translate offset m1);
+  register "transforms" "translate_into" (fun () -> Matrix3D.translate_into offset m1 dst);
+  register "transforms" "rotate" (fun () -> Matrix3D.rotate axis 0.1 m1);
+  register "transforms" "rotate_into" (fun () -> Matrix3D.rotate_into axis 0.1 m1 dst);
+  register "transforms" "times (100k points)" (fun () -> 
+    Array.iter (fun v -> ignore (Matrix3D.times m1 v)) vectors);
+  register "transforms" "times_into (100k points)" (fun () -> 
+    Array.iteri (fun i v -> Matrix3D.times_into m1 v points_dst i) vectors);
+  register "transforms" "transform_points (100k points)" (fun () -> 
+    Matrix3D.transform_points m1 points points_dst);
+  register "transforms" "transform_normals (100k normals)" (fun () -> 
+    Matrix3D.transform_normals m1 points points_dst);
+  main ()
@@ -0,0 +1,23 @@
+open OgamlUtils
+
+(* Validation and decoding of 4KB of ASCII and of mixed text *)
+
+let ascii = String.concat "" (Array.to_list (Array.make 128 "The quick brown fox jumps over."))
+
+let mixed = String.concat "" (Array.to_list (Array.make 128 "Voil\xc3\xa0 l'\xc3\xa9t\xc3\xa9 \xe2\x82\xac \xe6\x97\xa5\xe6\x9c\xac"))
+
+let ascii_utf8 = UTF8String.from_string ascii
+
+let mixed_utf8 = UTF8String.from_string mixed
+
+let sum = ref 0
+
+let () =
+  let open Benchmark in
+  register "utf8" "from_string (ascii)" (fun () -> UTF8String.from_string ascii);
+  register "utf8" "from_string (mixed)" (fun () -> UTF8String.from_string mixed);
+  register "utf8" "iter (ascii)" (fun () -> UTF8String.iter ascii_utf8 (fun c -> sum := !sum + c));
+  register "utf8" "iter (mixed)" (fun () -> UTF8String.iter mixed_utf8 (fun c -> sum := !sum + c));
+  register "utf8" "get (mixed)" (fun () ->
+    for i = 0 to 99 do sum := !sum + UTF8String.get mixed_utf8 (i * 20) done);
+  main ()
@@ -92,7 +92,11 @@ UTILS_PACK = OgamlUtils
 
 # Commands
 
-PPCOMMAND = -pp "cppo -D \"$(strip $(PP_DEFINE))\""
+# Log levels compiled out of the libraries, ex. LOG_DEFINES="-D OGAML_LOG_NO_DEBUG"
+# (or OGAML_LOG_NO_INFO to also remove information messages)
+LOG_DEFINES =
+
+PPCOMMAND = -pp "cppo -D \"$(strip $(PP_DEFINE))\" $(LOG_DEFINES)"
 
 DEPCOMMAND = $(OCAMLFIND) $(OCAMLDEP) $(PPCOMMAND) $(INCLUDE_DIRS)
 
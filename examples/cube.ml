@@ -163,4 +163,7 @@ let () =
   Clock.restart fps_clock;
   main_loop ();
   Printf.printf "Avg FPS: %f\n%!" (Clock.tps fps_clock);
+  let stats = Window.frame_stats window in
+  Printf.printf "Frame times: p50 %.2fms, p99 %.2fms, %i hitches\n%!"
+    (FrameStats.p50 stats *. 1000.) (FrameStats.p99 stats *. 1000.) (FrameStats.hitches stats);
   Window.destroy window
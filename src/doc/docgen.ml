@@ -7,6 +7,8 @@ open AST
 open ASTpp
 open Lexing
 
+module UTF8String = OgamlUtils.UTF8String
+
 
 exception Error of string
 
@@ -238,31 +240,48 @@ and pp hierarchy modulename ast : ASTpp.module_data =
 
 let preprocess modulename ast = pp [] modulename ast
 
-let print_position lexbuf =
+(* Columns are counted in characters rather than in bytes *)
+let count_chars s =
+  try UTF8String.length (UTF8String.from_string s)
+  with UTF8String.UTF8_error _ -> String.length s
+
+let print_position src lexbuf =
   let pos = lexbuf.lex_curr_p in
   let str = Lexing.lexeme lexbuf in
-  let begchar = pos.pos_cnum - pos.pos_bol + 1 in
+  let start = Lexing.lexeme_start lexbuf in
+  let begchar =
+    if start < pos.pos_bol then 1
+    else count_chars (String.sub src pos.pos_bol (start - pos.pos_bol)) + 1
+  in
   Printf.sprintf "In %s, line %d, characters %d-%d : %s"
     pos.pos_fname pos.pos_lnum begchar
-    (begchar + (String.length str))
-    (Lexing.lexeme lexbuf)
+    (begchar + (count_chars str))
+    str
 
-let parse_with_errors lexbuf =
+let parse_with_errors src lexbuf =
   try
     Parser.file Lexer.token lexbuf
   with
     |Lexer.SyntaxError msg ->
-        error "%s : %s" (print_position lexbuf) msg
+        error "%s : %s" (print_position src lexbuf) msg
     |Parser.Error ->
-        error "%s : Syntax Error" (print_position lexbuf)
+        error "%s : Syntax Error" (print_position src lexbuf)
 
+(* The pages are declared as UTF-8, so the sources are checked beforehand *)
 let parse_from_file f = 
-  let input = open_in f in
-  let lexbuf = from_channel input in
-  lexbuf.lex_curr_p <- {lexbuf.lex_curr_p with pos_fname = f};
-  let ast = parse_with_errors lexbuf in
+  let input = open_in_bin f in
+  let src = really_input_string input (in_channel_length input) in
   close_in input;
-  ast
+  begin match UTF8String.validate src with
+  | Some i ->
+    let line = ref 1 in
+    String.iteri (fun j c -> if j < i && c = '\n' then incr line) src;
+    error "In %s, line %d : invalid UTF-8 byte sequence" f !line
+  | None -> ()
+  end;
+  let lexbuf = from_string src in
+  lexbuf.lex_curr_p <- {lexbuf.lex_curr_p with pos_fname = f};
+  parse_with_errors src lexbuf
 
 let preprocess_file file = 
   let modulename = 
@@ -10,15 +10,6 @@ module IntMap = Map.Make (struct
 end)
 
 
-module IIMap = Map.Make (struct
-
-  type t = int * int
-
-  let compare (i1 : t) (i2 : t) = compare i1 i2
-
-end)
-
-
 module Glyph = struct
 
   type t = {advance : float;
@@ -38,6 +29,135 @@ end
 
 exception Font_error of string
 
+
+(* Direct-mapped glyph table. The BMP is split in 256 blocks of 256 glyphs,
+ * allocated on first use. Other planes are stored in a map. *)
+module GlyphTable = struct
+
+  type t = {
+            blocks : Glyph.t option array array;
+    mutable others : Glyph.t IntMap.t
+  }
+
+  let create () = {blocks = Array.make 256 [||]; others = IntMap.empty}
+
+  let find t c =
+    if c >= 0 && c < 0x10000 then begin
+      let block = t.blocks.(c lsr 8) in
+      if Array.length block = 0 then None
+      else block.(c land 0xff)
+    end else
+      try Some (IntMap.find c t.others)
+      with Not_found -> None
+
+  let add t c g =
+    if c >= 0 && c < 0x10000 then begin
+      let i = c lsr 8 in
+      if Array.length t.blocks.(i) = 0 then t.blocks.(i) <- Array.make 256 None;
+      t.blocks.(i).(c land 0xff) <- Some g
+    end else
+      t.others <- IntMap.add c g t.others
+
+end
+
+
+(* Kernings in font units, shared by all the sizes of a font. The kerning of
+ * every pair of known characters is computed when they become known, and the
+ * non-zero ones are stored in arrays sorted by pair, searched by dichotomy. *)
+module KernTable = struct
+
+  type t = {
+    mutable first  : int array;
+    mutable second : int array;
+    mutable values : int array;
+    mutable codes  : int list;
+    known : (int, unit) Hashtbl.t
+  }
+
+  let create () = {
+    first  = [||];
+    second = [||];
+    values = [||];
+    codes  = [];
+    known  = Hashtbl.create 256
+  }
+
+  let compare_pair a1 a2 b1 b2 =
+    if a1 <> b1 then compare (a1 : int) b1 else compare (a2 : int) b2
+
+  let find t c1 c2 =
+    let lo = ref 0 and hi = ref (Array.length t.first) and res = ref 0 in
+    while !lo < !hi do
+      let mid = (!lo + !hi) / 2 in
+      let c = compare_pair t.first.(mid) t.second.(mid) c1 c2 in
+      if c < 0 then lo := mid + 1
+      else if c > 0 then hi := mid
+      else begin
+        res := t.values.(mid);
+        lo := !hi
+      end
+    done;
+    !res
+
+  let known t c = Hashtbl.mem t.known c
+
+  (* Merges sorted pairs with the table *)
+  let merge t pairs =
+    let pairs = Array.of_list pairs in
+    let n = Array.length t.first and m = Array.length pairs in
+    let first  = Array.make (n + m) 0 in
+    let second = Array.make (n + m) 0 in
+    let values = Array.make (n + m) 0 in
+    let i = ref 0 and j = ref 0 in
+    for k = 0 to n + m - 1 do
+      let take_old =
+        !j >= m ||
+        (!i < n &&
+         let (c1, c2, _) = pairs.(!j) in
+         compare_pair t.first.(!i) t.second.(!i) c1 c2 < 0)
+      in
+      if take_old then begin
+        first.(k)  <- t.first.(!i);
+        second.(k) <- t.second.(!i);
+        values.(k) <- t.values.(!i);
+        incr i
+      end else begin
+        let (c1, c2, v) = pairs.(!j) in
+        first.(k)  <- c1;
+        second.(k) <- c2;
+        values.(k) <- v;
+        incr j
+      end
+    done;
+    t.first  <- first;
+    t.second <- second;
+    t.values <- values
+
+  (* Makes characters known. [kern c1 c2] returns the kerning of a pair. *)
+  let add t kern codes =
+    let fresh = List.fold_left (fun l c ->
+      if known t c then l
+      else begin
+        Hashtbl.add t.known c ();
+        c :: l
+      end) [] codes
+    in
+    if fresh <> [] then begin
+      let pairs = ref [] in
+      let add_pair c1 c2 =
+        let k = kern c1 c2 in
+        if k <> 0 then pairs := (c1, c2, k) :: !pairs
+      in
+      List.iter (fun c ->
+        List.iter (fun d -> add_pair c d; add_pair d c) t.codes;
+        List.iter (fun d -> add_pair c d) fresh
+      ) fresh;
+      t.codes <- List.rev_append fresh t.codes;
+      merge t (List.sort (fun (a1, a2, _) (b1, b2, _) -> compare_pair a1 a2 b1 b2) !pairs)
+    end
+
+end
+
 module Shelf = struct
 
   type t = {
@@ -114,6 +234,8 @@ module Internal = struct
 
   type t
 
+  (* Faces are mapped read-only and shared by the fonts loaded from the same
+   * file. They are released when the last of these fonts is collected. *)
   external load : string -> t = "caml_stb_load_font"
 
   external is_valid : t -> bool = "caml_stb_isvalid"
@@ -134,6 +256,10 @@ module Internal = struct
     t -> int -> int -> float -> (Bytes.t * int * int) 
     = "caml_stb_render_bitmap"
 
+  external sdf_bitmap :
+    t -> int -> float -> float -> (Bytes.t * int * int * int * int)
+    = "caml_stb_sdf_bitmap"
+
   let convert_1chan_bitmap bmp =
     let s = Bytes.length bmp in
     let bts = Bytes.make (s * 4) '\000' in
@@ -149,11 +275,10 @@ end
 
 
 type page = {
-  mutable glyph   : Glyph.t IntMap.t;
-  mutable glyph_b : Glyph.t IntMap.t;
-  mutable kerning : float IIMap.t;
+  glyph   : GlyphTable.t;
+  glyph_b : GlyphTable.t;
   mutable index   : int; (* Index of the page in the texture array *)
-  mutable modified: bool;
+  mutable version : int; (* Incremented when a glyph is added *)
   shelf   : Shelf.t;
   scale   : float;
   spacing : float;
@@ -162,32 +287,67 @@ type page = {
 }
 
 
+(* Rasterized glyph, before its insertion in a page *)
+type raster =
+  | Bitmap of int * int * IntRect.t * (Bytes.t * int * int)
+  | Field  of int * (Bytes.t * int * int * int * int)
+
+(* Glyph being rasterized by a pool *)
+type pending = {
+  pool    : OgamlUtils.Scheduler.t;
+  promise : raster OgamlUtils.Scheduler.promise;
+  page    : page;
+  table   : GlyphTable.t
+}
+
+(* Texture of a font in a context. Pages are shared by all the contexts,
+ * each context uploads the pages that changed since its last upload. *)
+type texture = {
+  context : Context.t;
+  mutable array    : Texture.Texture2DArray.t;
+  mutable height   : int;
+  mutable versions : int array  (* Uploaded version of each page *)
+}
+
 type t = {
   mutable pages    : page IntMap.t;
+          by_size  : page option array; (* Pages of the sizes below 256 *)
+  mutable sdf      : page option;
+          kerning  : KernTable.t;
   mutable nindex   : int;
-  mutable texture  : Texture.Texture2DArray.t option;
-  mutable height   : int;
+  mutable textures : texture list;
+          pending  : (int * bool * int, pending) Hashtbl.t;
           internal : Internal.t
 }
 
 
 type code = [`Char of char | `Code of int]
 
+type charset = [`ASCII | `Latin | `Codes of code list]
+
+
+(* Distance field glyphs are generated once, at a reference size, and are
+ * stored in a page of their own whose key is not a valid size *)
+let sdf_size = 48
+
+let sdf_range = 8.
+
+let sdf_key = -1
+
 
 (** Internal functions *)
 
 let scale_int i f = (float_of_int i *. f)
 
-let load_size (t : t) s =
+let load_page (t : t) key s =
   let scale = Internal.scale t.internal s in
   let (ascent, descent, linegap) = Internal.metrics t.internal in
   let new_page =
     {
-      glyph    = IntMap.empty;
-      glyph_b  = IntMap.empty;
-      kerning  = IIMap.empty;
+      glyph    = GlyphTable.create ();
+      glyph_b  = GlyphTable.create ();
       index    = t.nindex;
-      modified = false;
+      version  = 0;
       shelf    = Shelf.create 2048;
       spacing  = scale_int linegap scale;
       ascent   = scale_int ascent  scale;
@@ -196,15 +356,30 @@ let load_size (t : t) s =
     }
   in
   t.nindex <- t.nindex + 1;
-  t.texture <- None;
-  t.pages <- IntMap.add s new_page t.pages;
+  t.pages <- IntMap.add key new_page t.pages;
+  if key > 0 && key < Array.length t.by_size then
+    t.by_size.(key) <- Some new_page
+  else if key = sdf_key then
+    t.sdf <- Some new_page;
   new_page
 
+let load_size (t : t) s = load_page t s s
+
+let find_size (t : t) s =
+  if s > 0 && s < Array.length t.by_size then t.by_size.(s)
+  else
+    try Some (IntMap.find s t.pages)
+    with Not_found -> None
 
 let get_size (t : t) s =
-  try IntMap.find s t.pages
-  with Not_found ->
-    load_size t s
+  match find_size t s with
+  | Some page -> page
+  | None -> load_size t s
+
+let sdf_page (t : t) =
+  match t.sdf with
+  | Some page -> page
+  | None -> load_page t sdf_key sdf_size
 
 (* For debugging purposes *)
 let print_bitmap bmp w h = 
@@ -219,39 +394,91 @@ let print_bitmap bmp w h =
     print_endline "";
   done
 
-let load_glyph_return (t : t) s c b oversampling =
-  let page  = get_size t s in
+(* Rasterization only reads the face, so it can run on any thread *)
+let rasterize internal c oversampling scale =
+  let (advance, lbear) = Internal.char_h_metrics internal c in
+  let rect = Internal.char_box internal c in
+  let (bmp,w,h) = Internal.render_bitmap internal c oversampling scale in
+  Bitmap (advance, lbear, rect, (Internal.convert_1chan_bitmap bmp, w, h))
+
+
+(* The field extends [sdf_range] pixels around the outline, so the glyph is
+ * bigger than its box and starts at the offset given by the stub *)
+let rasterize_sdf internal c scale =
+  let (advance, _) = Internal.char_h_metrics internal c in
+  Field (advance, Internal.sdf_bitmap internal c scale sdf_range)
+
+
+let place page table c raster =
   let glyph =
-    let (advance, lbear) = Internal.char_h_metrics t.internal c in
-    let rect = Internal.char_box t.internal c in
-    let (bmp,w,h) = Internal.render_bitmap t.internal c oversampling page.scale in
-    let bmp = Internal.convert_1chan_bitmap bmp in
-    let uv = Shelf.add page.shelf (Image.create (`Data (Vector2i.({x = w; y = h}),bmp))) in
-    {
-      Glyph.advance = scale_int advance page.scale;
-      Glyph.bearing = Vector2f.({x = scale_int lbear page.scale;
-                                 y = scale_int (rect.IntRect.y + rect.IntRect.height) page.scale});
-      Glyph.rect = FloatRect.({x = scale_int rect.IntRect.x page.scale;
-                               y = scale_int rect.IntRect.y page.scale;
-                               width  = scale_int rect.IntRect.width  page.scale;
-                               height = scale_int rect.IntRect.height page.scale;
-                             });
-      Glyph.uv = FloatRect.from_int uv
-    }
+    match raster with
+    | Bitmap (advance, lbear, rect, (bmp,w,h)) ->
+      let uv = Shelf.add page.shelf (Image.create (`Data (Vector2i.({x = w; y = h}),bmp))) in
+      {
+        Glyph.advance = scale_int advance page.scale;
+        Glyph.bearing = Vector2f.({x = scale_int lbear page.scale;
+                                   y = scale_int (rect.IntRect.y + rect.IntRect.height) page.scale});
+        Glyph.rect = FloatRect.({x = scale_int rect.IntRect.x page.scale;
+                                 y = scale_int rect.IntRect.y page.scale;
+                                 width  = scale_int rect.IntRect.width  page.scale;
+                                 height = scale_int rect.IntRect.height page.scale;
+                               });
+        Glyph.uv = FloatRect.from_int uv
+      }
+    | Field (advance, (bmp,w,h,xoff,yoff)) ->
+      let uv = Shelf.add page.shelf (Image.create (`Data (Vector2i.({x = w; y = h}),bmp))) in
+      {
+        Glyph.advance = scale_int advance page.scale;
+        Glyph.bearing = Vector2f.({x = float_of_int xoff; y = float_of_int (- yoff)});
+        Glyph.rect = FloatRect.({x = float_of_int xoff;
+                                 y = float_of_int (- yoff - h);
+                                 width  = float_of_int w;
+                                 height = float_of_int h;
+                               });
+        Glyph.uv = FloatRect.from_int uv
+      }
   in
-  if b then
-    page.glyph_b <- IntMap.add c glyph page.glyph_b
-  else
-    page.glyph   <- IntMap.add c glyph page.glyph;
-  page.modified <- true;
+  GlyphTable.add table c glyph;
+  page.version <- page.version + 1;
   glyph
 
 
-let load_kerning t s (c1, c2) =
-  let page = get_size t s in
-  let kern = scale_int (Internal.kern t.internal c1 c2) page.scale in
-  page.kerning <- IIMap.add (c1, c2) kern page.kerning;
-  kern
+(* Glyphs being prefetched are awaited instead of being rasterized again *)
+let find_raster (t : t) key bold c f =
+  let k = (key, bold, c) in
+  let pending = try Some (Hashtbl.find t.pending k) with Not_found -> None in
+  match pending with
+  | Some p ->
+    Hashtbl.remove t.pending k;
+    OgamlUtils.Scheduler.await p.pool p.promise
+  | None -> f ()
+
+
+(* Inserts the glyphs whose rasterization is over *)
+let commit (t : t) =
+  if Hashtbl.length t.pending > 0 then begin
+    let ready = Hashtbl.fold (fun k p l ->
+      if OgamlUtils.Scheduler.is_ready p.promise then (k, p) :: l else l
+    ) t.pending [] in
+    List.iter (fun ((_, _, c) as k, p) ->
+      Hashtbl.remove t.pending k;
+      ignore (place p.page p.table c (OgamlUtils.Scheduler.await p.pool p.promise))
+    ) ready
+  end
+
+
+let prefetch_codes (t : t) pool key page table bold codes f =
+  let pool =
+    match pool with
+    | Some pool -> pool
+    | None -> OgamlUtils.Scheduler.shared ()
+  in
+  List.iter (fun c ->
+    if GlyphTable.find table c = None && not (Hashtbl.mem t.pending (key, bold, c)) then begin
+      let promise = OgamlUtils.Scheduler.async pool (fun () -> f c) in
+      Hashtbl.add t.pending (key, bold, c) {pool; promise; page; table}
+    end
+  ) codes
 
 
 let code_to_int = function
@@ -260,30 +487,52 @@ let code_to_int = function
 
 let oversampling_of_size s = min 4 ((80 + s - 1)/s)
 
+let rec range a b = if a > b then [] else a :: range (a + 1) b
+
+let charset_codes = function
+  | `ASCII   -> range 0x20 0x7e
+  | `Latin   -> range 0x20 0x7e @ range 0xa0 0x17f
+  | `Codes l -> List.map code_to_int l
+
+let font_kerning (t : t) c1 c2 =
+  if not (KernTable.known t.kerning c1 && KernTable.known t.kerning c2) then
+    KernTable.add t.kerning (Internal.kern t.internal) [c1; c2];
+  KernTable.find t.kerning c1 c2
+
 (** Exposed functions *)
-let load s =
+let load ?charset s =
   if not (Sys.file_exists s) then
     raise (Font_error (Printf.sprintf "File not found : %s" s));
   let internal = Internal.load s in
   if not (Internal.is_valid internal) then
     raise (Font_error (Printf.sprintf "Invalid font file : %s" s));
+  let kerning = KernTable.create () in
+  begin match charset with
+  | Some cs -> KernTable.add kerning (Internal.kern internal) (charset_codes cs)
+  | None -> ()
+  end;
   {
     pages  = IntMap.empty;
+    by_size = Array.make 256 None;
+    sdf    = None;
+    kerning;
     nindex = 0;
-    height = 0;
-    texture = None;
+    textures = [];
+    pending  = Hashtbl.create 16;
     internal
   }
 
 
 let glyph (t : t) c size bold =
-  let glyphs =
-    if bold then (get_size t size).glyph_b
-    else (get_size t size).glyph
-  in
-  try IntMap.find (code_to_int c) glyphs
-  with Not_found ->
-    load_glyph_return t size (code_to_int c) bold (oversampling_of_size size)
+  let page = get_size t size in
+  let c = code_to_int c in
+  let table = if bold then page.glyph_b else page.glyph in
+  match GlyphTable.find table c with
+  | Some g -> g
+  | None ->
+    find_raster t size bold c (fun () ->
+      rasterize t.internal c (oversampling_of_size size) page.scale)
+    |> place page table c
 
 
 let load_glyph (t : t) c s b = 
@@ -291,41 +540,97 @@ let load_glyph (t : t) c s b =
 
 
 let kerning t c1 c2 s =
-  let k = (get_size t s).kerning in
-  try IIMap.find (code_to_int c1, code_to_int c2) k
-  with Not_found ->
-    load_kerning t s (code_to_int c1, code_to_int c2)
+  scale_int (font_kerning t (code_to_int c1) (code_to_int c2)) (get_size t s).scale
+
+
+let sdf_glyph (t : t) c =
+  let page = sdf_page t in
+  let c = code_to_int c in
+  match GlyphTable.find page.glyph c with
+  | Some g -> g
+  | None ->
+    find_raster t sdf_key false c (fun () -> rasterize_sdf t.internal c page.scale)
+    |> place page page.glyph c
+
+
+let sdf_kerning t c1 c2 =
+  scale_int (font_kerning t (code_to_int c1) (code_to_int c2)) (sdf_page t).scale
+
+
+(* Kernings are computed on the calling thread, only the glyphs are
+ * rasterized by the pool *)
+let prefetch t ?bold:(bold = false) ?pool size charset =
+  let codes = charset_codes charset in
+  KernTable.add t.kerning (Internal.kern t.internal) codes;
+  let page = get_size t size in
+  let oversampling = oversampling_of_size size in
+  prefetch_codes t pool size page (if bold then page.glyph_b else page.glyph) bold codes
+    (fun c -> rasterize t.internal c oversampling page.scale)
+
+
+let prefetch_sdf t ?pool charset =
+  let codes = charset_codes charset in
+  KernTable.add t.kerning (Internal.kern t.internal) codes;
+  let page = sdf_page t in
+  prefetch_codes t pool sdf_key page page.glyph false codes
+    (fun c -> rasterize_sdf t.internal c page.scale)
+
+
+(* The kerning of the whole set is computed at once, before the glyphs *)
+let preload t ?bold:(bold = false) ?pool size charset =
+  let codes = charset_codes charset in
+  begin match pool with
+  | Some _ -> prefetch t ~bold ?pool size charset
+  | None -> KernTable.add t.kerning (Internal.kern t.internal) codes
+  end;
+  List.iter (fun c -> load_glyph t (`Code c) size bold) codes
+
+
+let preload_sdf t ?pool charset =
+  let codes = charset_codes charset in
+  begin match pool with
+  | Some _ -> prefetch_sdf t ?pool charset
+  | None -> KernTable.add t.kerning (Internal.kern t.internal) codes
+  end;
+  List.iter (fun c -> ignore (sdf_glyph t (`Code c))) codes
+
+
+(* Sizes without a page are measured without creating one, so that distance
+ * field texts do not add a layer per size to the texture *)
+let metrics (t : t) i =
+  match find_size t i with
+  | Some page -> (page.ascent, page.descent, page.spacing)
+  | None ->
+    let scale = Internal.scale t.internal i in
+    let (ascent, descent, linegap) = Internal.metrics t.internal in
+    (scale_int ascent scale, scale_int descent scale, scale_int linegap scale)
 
 
 let ascent t i =
-  (get_size t i).ascent
+  let (a,_,_) = metrics t i in a
 
 
 let descent t i =
-  (get_size t i).descent
+  let (_,d,_) = metrics t i in d
 
 
 let linegap t i =
-  (get_size t i).spacing
+  let (_,_,l) = metrics t i in l
 
 
 let spacing t i =
   (ascent t i) -. (descent t i) +. (linegap t i)
 
-let rebuild_page_texture (type s) (module M : RenderTarget.T with type t = s) target t height page = 
-  let i_layer = page.index in
-  let layer = 
-    match t.texture with
-    | None   -> assert false
-    | Some t -> Texture.Texture2DArray.layer t i_layer
-  in
+let rebuild_page_texture tex height page = 
+  let layer = Texture.Texture2DArray.layer tex.array page.index in
   let mipmap = 
     Texture.Texture2DArrayLayer.mipmap layer 0
   in
   Texture.Texture2DArrayLayerMipmap.write
     mipmap
     IntRect.({x = 0; y = 0; width = 2048; height})
-    (Shelf.image height page.shelf)
+    (Shelf.image height page.shelf);
+  tex.versions.(page.index) <- page.version
 
 let rebuild_full_texture (type s) (module M : RenderTarget.T with type t = s) target t height = 
   let rec insert (w, elt) = function
@@ -349,30 +654,47 @@ let rebuild_full_texture (type s) (module M : RenderTarget.T with type t = s) ta
   in
   Texture.Texture2DArray.minify  texture Texture.MinifyFilter.Linear;
   Texture.Texture2DArray.magnify texture Texture.MagnifyFilter.Linear;
-  t.texture <- Some texture
+  let versions = Array.make t.nindex 0 in
+  IntMap.iter (fun _ page -> versions.(page.index) <- page.version) t.pages;
+  texture, versions
 
+(* The texture of a context is rebuilt when pages are added or get taller
+ * than its layers, otherwise only the modified pages are uploaded *)
 let texture (type s) (module M : RenderTarget.T with type t = s) target t =
-  let mod_pages, max_height = IntMap.fold (fun _ page (l,h) ->
-    if page.modified then begin
-      page.modified <- false;
-      (page :: l, max (Shelf.total_height page.shelf) h)
-    end else (l, h)
-  ) t.pages ([], t.height)
+  commit t;
+  let context = M.context target in
+  let max_height = IntMap.fold (fun _ page h ->
+    max (Shelf.total_height page.shelf) h
+  ) t.pages 0
   in
-  if t.height < max_height || t.texture = None then begin
-    rebuild_full_texture (module M) target t max_height;
-    t.height <- max_height
-  end else if mod_pages <> [] then begin
-    List.iter (fun p -> rebuild_page_texture (module M) target t max_height p) mod_pages
-  end;
-  match t.texture with
-  | None -> assert false
-  | Some t -> t
+  let tex =
+    try Some (List.find (fun tex -> tex.context == context) t.textures)
+    with Not_found -> None
+  in
+  match tex with
+  | Some tex when tex.height >= max_height && Array.length tex.versions = t.nindex ->
+    IntMap.iter (fun _ page ->
+      if tex.versions.(page.index) <> page.version then
+        rebuild_page_texture tex tex.height page
+    ) t.pages;
+    tex.array
+  | Some tex ->
+    let height = max tex.height max_height in
+    let (array, versions) = rebuild_full_texture (module M) target t height in
+    tex.array <- array;
+    tex.height <- height;
+    tex.versions <- versions;
+    array
+  | None ->
+    let (array, versions) = rebuild_full_texture (module M) target t max_height in
+    t.textures <- {context; array; height = max_height; versions} :: t.textures;
+    array
 
 let size_index t s = 
-  try 
-    let page = IntMap.find s t.pages in
-    page.index
-  with
-    Not_found -> raise (Font_error "Font size's index not found")
+  match find_size t s with
+  | Some page -> page.index
+  | None -> raise (Font_error "Font size's index not found")
     
+
+let sdf_index t =
+  (sdf_page t).index
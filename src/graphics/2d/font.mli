@@ -22,8 +22,10 @@ type t
 
 type code = [`Char of char | `Code of int]
 
-(** Loads a font from a file *)
-val load : string -> t
+type charset = [`ASCII | `Latin | `Codes of code list]
+
+(** Loads a font from a file, computing the kernings of a charset *)
+val load : ?charset:charset -> string -> t
 
 (** Preloads a glyph *)
 val load_glyph : t -> code -> int -> bool -> unit
@@ -31,6 +33,18 @@ val load_glyph : t -> code -> int -> bool -> unit
 (** Usage : glyph font char size bold *)
 val glyph : t -> code -> int -> bool -> Glyph.t
 
+(** Preloads the glyphs of a charset at a size *)
+val preload : t -> ?bold:bool -> ?pool:OgamlUtils.Scheduler.t -> int -> charset -> unit
+
+(** Preloads the distance field glyphs of a charset *)
+val preload_sdf : t -> ?pool:OgamlUtils.Scheduler.t -> charset -> unit
+
+(** Rasterizes the glyphs of a charset in the background *)
+val prefetch : t -> ?bold:bool -> ?pool:OgamlUtils.Scheduler.t -> int -> charset -> unit
+
+(** Rasterizes the distance field glyphs of a charset in the background *)
+val prefetch_sdf : t -> ?pool:OgamlUtils.Scheduler.t -> charset -> unit
+
 (** Returns the kerning between two chars *)
 val kerning : t -> code -> code -> int -> float
 
@@ -55,6 +69,21 @@ val texture : (module RenderTarget.T with type t = 'a) -> 'a
 (** Returns the index associated to a font size in the font's texture *)
 val size_index : t -> int -> int
 
+(** Reference size of the distance field glyphs *)
+val sdf_size : int
+
+(** Distance range of the distance field glyphs, in pixels at the reference size *)
+val sdf_range : float
+
+(** Returns a distance field glyph, at the reference size *)
+val sdf_glyph : t -> code -> Glyph.t
+
+(** Returns the kerning between two chars at the reference size *)
+val sdf_kerning : t -> code -> code -> float
+
+(** Returns the index of the distance field page in the font's texture *)
+val sdf_index : t -> int
+
 
 
 
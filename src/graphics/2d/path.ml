@@ -0,0 +1,631 @@
+open OgamlMath
+open Bigarray
+
+exception Path_error of string
+
+type command =
+  | Move  of Vector2f.t
+  | Line  of Vector2f.t
+  | Quad  of Vector2f.t * Vector2f.t
+  | Cubic of Vector2f.t * Vector2f.t * Vector2f.t
+  | Arc   of Vector2f.t * float * float * float
+  | Close
+
+(* Commands in reverse order *)
+type t = command list
+
+type triangles = (float, float32_elt, c_layout) Array1.t
+
+type mesh = {
+  vertices : triangles;
+  indices  : (int32, int32_elt, c_layout) Array1.t
+}
+
+type rule = [`NonZero | `EvenOdd]
+
+type join = [`Miter of float | `Bevel | `Round]
+
+type cap = [`Butt | `Square | `Round]
+
+type side = [`Center | `Left | `Right]
+
+let tolerance = 0.25
+
+(* Maximal number of segments of a flattened curve *)
+let max_segments = 1024
+
+
+(* Construction *)
+let empty = []
+
+let move_to p t = Move p :: t
+
+let line_to p t = Line p :: t
+
+let quad_to ~control p t = Quad (control, p) :: t
+
+let cubic_to c1 c2 p t = Cubic (c1, c2, p) :: t
+
+let arc ~center ~radius ~start ~stop t =
+  if radius < 0. then raise (Path_error "Negative arc radius");
+  Arc (center, radius, start, stop) :: t
+
+let close t = Close :: t
+
+let append t1 t2 = t2 @ t1
+
+let polygon = function
+  | [] -> empty
+  | p :: l ->
+    List.fold_left (fun t p -> line_to p t) (move_to p empty) l
+    |> close
+
+let rectangle ~position ~size =
+  let open Vector2f in
+  polygon [position;
+           add position {x = size.x; y = 0.};
+           add position size;
+           add position {x = 0.; y = size.y}]
+
+let circle ~center ~radius =
+  empty
+  |> arc ~center ~radius ~start:0. ~stop:(2. *. Constants.pi)
+  |> close
+
+let rounded_rectangle ~position ~size ~radius =
+  let open Vector2f in
+  let r = min radius (min (abs_float size.x) (abs_float size.y) /. 2.) in
+  if r <= 0. then rectangle ~position ~size
+  else begin
+    let pi = Constants.pi in
+    let x0 = position.x +. r and y0 = position.y +. r in
+    let x1 = position.x +. size.x -. r and y1 = position.y +. size.y -. r in
+    empty
+    |> arc ~center:{x = x0; y = y0} ~radius:r ~start:pi ~stop:(1.5 *. pi)
+    |> arc ~center:{x = x1; y = y0} ~radius:r ~start:(1.5 *. pi) ~stop:(2. *. pi)
+    |> arc ~center:{x = x1; y = y1} ~radius:r ~start:0. ~stop:(0.5 *. pi)
+    |> arc ~center:{x = x0; y = y1} ~radius:r ~start:(0.5 *. pi) ~stop:pi
+    |> close
+  end
+
+(* The vertices are obtained by successive rotations of the first one *)
+let regular ~center ~radius amount =
+  if amount < 3 then raise (Path_error "A regular polygon needs 3 vertices");
+  let a = 2. *. Constants.pi /. float_of_int amount in
+  let c = cos a and s = sin a in
+  let rec points k x y l =
+    if k = amount then List.rev l
+    else
+      points (k + 1) (c *. x -. s *. y) (s *. x +. c *. y)
+        (Vector2f.({x = center.x +. x; y = center.y +. y}) :: l)
+  in
+  polygon (points 0 radius 0. [])
+
+
+(* Growable arrays of coordinates *)
+module Points = struct
+
+  type t = {mutable data : float array; mutable length : int}
+
+  let create () = {data = Array.make 64 0.; length = 0}
+
+  let add b x y =
+    if b.length + 2 > Array.length b.data then begin
+      let data = Array.make (2 * Array.length b.data) 0. in
+      Array.blit b.data 0 data 0 b.length;
+      b.data <- data
+    end;
+    b.data.(b.length) <- x;
+    b.data.(b.length + 1) <- y;
+    b.length <- b.length + 2
+
+  (* Coincident consecutive points are merged *)
+  let push b x y =
+    let n = b.length in
+    if n = 0 then add b x y
+    else begin
+      let dx = x -. b.data.(n - 2) and dy = y -. b.data.(n - 1) in
+      if dx *. dx +. dy *. dy > 1e-12 then add b x y
+    end
+
+  let contents b closed =
+    let n = b.length in
+    let n =
+      if closed && n >= 4 then
+        let dx = b.data.(0) -. b.data.(n - 2) and dy = b.data.(1) -. b.data.(n - 1) in
+        if dx *. dx +. dy *. dy <= 1e-12 then n - 2 else n
+      else n
+    in
+    Array.sub b.data 0 n
+
+end
+
+(* Growable float32 bigarrays of triangles *)
+module Triangles = struct
+
+  type t = {mutable data : triangles; mutable length : int}
+
+  let create n = {data = Array1.create float32 c_layout (max 12 n); length = 0}
+
+  let reserve b n =
+    let dim = Array1.dim b.data in
+    if b.length + n > dim then begin
+      let data = Array1.create float32 c_layout (max (2 * dim) (b.length + n)) in
+      Array1.blit (Array1.sub b.data 0 b.length) (Array1.sub data 0 b.length);
+      b.data <- data
+    end
+
+  let add b x0 y0 x1 y1 x2 y2 =
+    reserve b 6;
+    let d = b.data and i = b.length in
+    Array1.unsafe_set d i x0;
+    Array1.unsafe_set d (i + 1) y0;
+    Array1.unsafe_set d (i + 2) x1;
+    Array1.unsafe_set d (i + 3) y1;
+    Array1.unsafe_set d (i + 4) x2;
+    Array1.unsafe_set d (i + 5) y2;
+    b.length <- i + 6
+
+  let quad b x0 y0 x1 y1 x2 y2 x3 y3 =
+    add b x0 y0 x1 y1 x2 y2;
+    add b x2 y2 x3 y3 x0 y0
+
+  let contents b = Array1.sub b.data 0 b.length
+
+end
+
+
+(* Flattening *)
+let clamp_segments n =
+  if n <> n || n < 1. then 1
+  else if n > float_of_int max_segments then max_segments
+  else int_of_float (ceil n)
+
+(* Wang's formula : a Bézier curve of degree d is approximated within tol
+ * by n = sqrt(d(d-1)/8 * M / tol) segments, where M bounds the norm of its
+ * second differences *)
+let quad_segments tol p0 c p =
+  let open Vector2f in
+  let m = norm {x = p0.x -. 2. *. c.x +. p.x; y = p0.y -. 2. *. c.y +. p.y} in
+  clamp_segments (sqrt (m /. (4. *. tol)))
+
+let cubic_segments tol p0 c1 c2 p =
+  let open Vector2f in
+  let m1 = norm {x = p0.x -. 2. *. c1.x +. c2.x; y = p0.y -. 2. *. c1.y +. c2.y} in
+  let m2 = norm {x = c1.x -. 2. *. c2.x +. p.x; y = c1.y -. 2. *. c2.y +. p.y} in
+  clamp_segments (sqrt (0.75 *. max m1 m2 /. tol))
+
+(* Angle of the chords of an arc whose sagitta is tol *)
+let arc_step tol r =
+  if tol >= r then Constants.pi /. 2.
+  else 2. *. acos (1. -. tol /. r)
+
+let arc_segments tol r sweep =
+  clamp_segments (abs_float sweep /. arc_step tol r)
+
+let flatten ?tolerance:(tol = tolerance) t =
+  if not (tol > 0.) then raise (Path_error "Tolerance must be positive");
+  let contours = ref [] in
+  let cur = Points.create () in
+  let pen = ref None and start = ref None in
+  let finish closed =
+    if cur.Points.length >= 4 then
+      contours := (Points.contents cur closed, closed) :: !contours;
+    cur.Points.length <- 0
+  in
+  let point x y =
+    if cur.Points.length = 0 then start := Some (x, y);
+    Points.push cur x y;
+    pen := Some (x, y)
+  in
+  (* A segment starts at the pen, or at its first point if there is none *)
+  let begin_at x y =
+    if cur.Points.length = 0 then
+      match !pen with
+      | Some (px, py) -> point px py
+      | None -> point x y
+  in
+  let pen_or p =
+    match !pen with Some q -> q | None -> (p.Vector2f.x, p.Vector2f.y)
+  in
+  List.iter (function
+    | Move p ->
+      finish false;
+      pen := Some (p.Vector2f.x, p.Vector2f.y)
+    | Line p ->
+      begin_at p.Vector2f.x p.Vector2f.y;
+      point p.Vector2f.x p.Vector2f.y
+    | Quad (c, p) ->
+      let (x0, y0) = pen_or c in
+      begin_at x0 y0;
+      let n = quad_segments tol (Vector2f.make x0 y0) c p in
+      for i = 1 to n do
+        let s = float_of_int i /. float_of_int n in
+        let a = (1. -. s) *. (1. -. s) and b = 2. *. s *. (1. -. s) and d = s *. s in
+        point (a *. x0 +. b *. c.Vector2f.x +. d *. p.Vector2f.x)
+              (a *. y0 +. b *. c.Vector2f.y +. d *. p.Vector2f.y)
+      done
+    | Cubic (c1, c2, p) ->
+      let (x0, y0) = pen_or c1 in
+      begin_at x0 y0;
+      let n = cubic_segments tol (Vector2f.make x0 y0) c1 c2 p in
+      for i = 1 to n do
+        let s = float_of_int i /. float_of_int n in
+        let u = 1. -. s in
+        let a = u *. u *. u and b = 3. *. s *. u *. u
+        and c = 3. *. s *. s *. u and d = s *. s *. s in
+        point (a *. x0 +. b *. c1.Vector2f.x +. c *. c2.Vector2f.x +. d *. p.Vector2f.x)
+              (a *. y0 +. b *. c1.Vector2f.y +. c *. c2.Vector2f.y +. d *. p.Vector2f.y)
+      done
+    | Arc (center, r, a0, a1) ->
+      let cx = center.Vector2f.x and cy = center.Vector2f.y in
+      let x0 = cx +. r *. cos a0 and y0 = cy +. r *. sin a0 in
+      begin_at x0 y0;
+      point x0 y0;
+      let sweep = a1 -. a0 in
+      let n = arc_segments tol r sweep in
+      for i = 1 to n do
+        let a = a0 +. sweep *. float_of_int i /. float_of_int n in
+        point (cx +. r *. cos a) (cy +. r *. sin a)
+      done
+    | Close ->
+      let s = !start in
+      finish true;
+      if s <> None then pen := s
+  ) (List.rev t);
+  finish false;
+  List.rev !contours
+
+
+(* Filling *)
+
+(* Growable arrays of indices *)
+module Indices = struct
+
+  type t = {mutable data : int array; mutable length : int}
+
+  let create n = {data = Array.make (max 16 n) 0; length = 0}
+
+  let add b i =
+    if b.length = Array.length b.data then begin
+      let data = Array.make (2 * b.length) 0 in
+      Array.blit b.data 0 data 0 b.length;
+      b.data <- data
+    end;
+    b.data.(b.length) <- i;
+    b.length <- b.length + 1
+
+end
+
+let make_mesh (p : Points.t) (i : Indices.t) =
+  let vertices = Array1.create float32 c_layout p.Points.length in
+  for k = 0 to p.Points.length - 1 do
+    Array1.unsafe_set vertices k p.Points.data.(k)
+  done;
+  let indices = Array1.create int32 c_layout i.Indices.length in
+  for k = 0 to i.Indices.length - 1 do
+    Array1.unsafe_set indices k (Int32.of_int i.Indices.data.(k))
+  done;
+  {vertices; indices}
+
+(* A contour is convex if it always turns in the same direction, and turns
+ * exactly once *)
+let convex p =
+  let n = Array.length p / 2 in
+  let sign = ref 0. and turn = ref 0. and ok = ref true in
+  for i = 0 to n - 1 do
+    let j = (i + 1) mod n and k = (i + 2) mod n in
+    let ax = p.(2 * j) -. p.(2 * i) and ay = p.(2 * j + 1) -. p.(2 * i + 1) in
+    let bx = p.(2 * k) -. p.(2 * j) and by = p.(2 * k + 1) -. p.(2 * j + 1) in
+    let c = ax *. by -. ay *. bx in
+    if c <> 0. then begin
+      if !sign = 0. then sign := c
+      else if c *. !sign < 0. then ok := false
+    end;
+    turn := !turn +. atan2 c (ax *. bx +. ay *. by)
+  done;
+  !ok && abs_float (abs_float !turn -. 2. *. Constants.pi) < 1e-6
+
+let fan p =
+  let n = Array.length p / 2 in
+  let points = {Points.data = Array.copy p; Points.length = 2 * n} in
+  let indices = Indices.create (3 * n) in
+  for i = 1 to n - 2 do
+    Indices.add indices 0;
+    Indices.add indices i;
+    Indices.add indices (i + 1)
+  done;
+  make_mesh points indices
+
+module FloatSet = Set.Make (struct type t = float let compare = compare end)
+
+(* Sweep line trapezoidation. The plane is cut in horizontal slabs at the
+ * ordinates of the vertices and of the intersections of the edges, so that
+ * the edges crossing a slab are ordered from left to right. The spans of a
+ * slab between consecutive edges are inside the shape depending on the
+ * winding number on their left. A trapezoid bounded by the same two edges
+ * is extended over consecutive slabs, and vertices are shared. *)
+let sweep rule contours =
+  let count = List.fold_left (fun n (p, _) -> n + Array.length p / 2) 0 contours in
+  let ex0 = Array.make count 0. and ey0 = Array.make count 0. in
+  let ex1 = Array.make count 0. and ey1 = Array.make count 0. in
+  let slope = Array.make count 0. and dir = Array.make count 0 in
+  let ne = ref 0 in
+  let events = ref FloatSet.empty in
+  List.iter (fun (p, _) ->
+    let n = Array.length p / 2 in
+    for i = 0 to n - 1 do
+      let j = (i + 1) mod n in
+      let xa = p.(2 * i) and ya = p.(2 * i + 1) in
+      let xb = p.(2 * j) and yb = p.(2 * j + 1) in
+      (* Horizontal edges do not change the winding of any span *)
+      if ya <> yb then begin
+        let e = !ne in
+        if ya < yb then begin
+          ex0.(e) <- xa; ey0.(e) <- ya; ex1.(e) <- xb; ey1.(e) <- yb; dir.(e) <- 1
+        end else begin
+          ex0.(e) <- xb; ey0.(e) <- yb; ex1.(e) <- xa; ey1.(e) <- ya; dir.(e) <- -1
+        end;
+        slope.(e) <- (ex1.(e) -. ex0.(e)) /. (ey1.(e) -. ey0.(e));
+        events := FloatSet.add ey0.(e) (FloatSet.add ey1.(e) !events);
+        incr ne
+      end
+    done
+  ) contours;
+  let ne = !ne in
+  let order = Array.init ne (fun i -> i) in
+  Array.sort (fun a b -> compare ey0.(a) ey0.(b)) order;
+  let xat e y =
+    if y = ey0.(e) then ex0.(e)
+    else if y = ey1.(e) then ex1.(e)
+    else ex0.(e) +. (y -. ey0.(e)) *. slope.(e)
+  in
+  let inside w =
+    match rule with
+    | `NonZero -> w <> 0
+    | `EvenOdd -> w land 1 = 1
+  in
+  let points = Points.create () and indices = Indices.create 0 in
+  let table = Hashtbl.create 97 in
+  let vertex x y =
+    try Hashtbl.find table (x, y)
+    with Not_found ->
+      let i = points.Points.length / 2 in
+      Points.add points x y;
+      Hashtbl.add table (x, y) i;
+      i
+  in
+  let emit a b (xa, xb, y0) y1 =
+    let tl = vertex xa y0 and tr = vertex xb y0 in
+    let br = vertex (xat b y1) y1 and bl = vertex (xat a y1) y1 in
+    if tl <> tr then begin
+      Indices.add indices tl; Indices.add indices tr; Indices.add indices br
+    end;
+    if br <> bl then begin
+      Indices.add indices br; Indices.add indices bl; Indices.add indices tl
+    end
+  in
+  (* Active edges, kept in their order of the previous slab so that
+   * insertion sorts are almost linear *)
+  let active = Array.make ne 0 and keys = Array.make ne 0. and na = ref 0 in
+  let next = ref 0 in
+  let opened = ref (Hashtbl.create 16) and opened' = ref (Hashtbl.create 16) in
+  let last = ref 0. in
+  while not (FloatSet.is_empty !events) do
+    let y0 = FloatSet.min_elt !events in
+    events := FloatSet.remove y0 !events;
+    last := y0;
+    while !next < ne && ey0.(order.(!next)) <= y0 do
+      active.(!na) <- order.(!next);
+      incr na;
+      incr next
+    done;
+    let k = ref 0 in
+    for i = 0 to !na - 1 do
+      if ey1.(active.(i)) > y0 then begin
+        active.(!k) <- active.(i);
+        incr k
+      end
+    done;
+    na := !k;
+    let n = !na in
+    if not (FloatSet.is_empty !events) then begin
+      let y1 = ref (FloatSet.min_elt !events) in
+      (* The slab is cut at the first crossing of two consecutive edges,
+       * until its edges are ordered at both ends *)
+      let sorted = ref false in
+      while not !sorted do
+        let ym = (y0 +. !y1) /. 2. in
+        for i = 0 to n - 1 do keys.(i) <- xat active.(i) ym done;
+        for i = 1 to n - 1 do
+          let e = active.(i) and x = keys.(i) in
+          let j = ref (i - 1) in
+          while !j >= 0 && keys.(!j) > x do
+            active.(!j + 1) <- active.(!j);
+            keys.(!j + 1) <- keys.(!j);
+            decr j
+          done;
+          active.(!j + 1) <- e;
+          keys.(!j + 1) <- x
+        done;
+        let cut = ref !y1 in
+        let eps = 1e-9 *. (1. +. abs_float y0 +. abs_float !y1) in
+        for i = 0 to n - 2 do
+          let a = active.(i) and b = active.(i + 1) in
+          let dt = xat b y0 -. xat a y0 and db = xat b !y1 -. xat a !y1 in
+          if dt < 0. || db < 0. then begin
+            let ds = slope.(a) -. slope.(b) in
+            if ds <> 0. then begin
+              let yc = y0 +. dt /. ds in
+              if yc > y0 +. eps && yc < !cut -. eps then cut := yc
+            end
+          end
+        done;
+        if !cut < !y1 then begin
+          y1 := !cut;
+          events := FloatSet.add !cut !events
+        end else
+          sorted := true
+      done;
+      (* Spans inside the shape continue the trapezoids of the previous slab
+       * or open new ones, the others are closed *)
+      let cur = !opened' in
+      Hashtbl.reset cur;
+      let w = ref 0 in
+      for i = 0 to n - 2 do
+        let a = active.(i) and b = active.(i + 1) in
+        w := !w + dir.(a);
+        if inside !w then begin
+          let key = a * ne + b in
+          try
+            Hashtbl.add cur key (Hashtbl.find !opened key);
+            Hashtbl.remove !opened key
+          with Not_found ->
+            Hashtbl.add cur key (xat a y0, xat b y0, y0)
+        end
+      done;
+      Hashtbl.iter (fun key top -> emit (key / ne) (key mod ne) top y0) !opened;
+      opened' := !opened;
+      opened := cur
+    end
+  done;
+  Hashtbl.iter (fun key top -> emit (key / ne) (key mod ne) top !last) !opened;
+  make_mesh points indices
+
+let triangulate ?rule:(rule = `NonZero) contours =
+  match List.filter (fun (p, _) -> Array.length p >= 6) contours with
+  | [] -> make_mesh (Points.create ()) (Indices.create 0)
+  | [(p, _)] when convex p -> fan p
+  | contours -> sweep rule contours
+
+
+(* Stroking. The stroke covers the band between the offsets d0 <= 0 <= d1
+ * along the left normal of each segment. *)
+
+(* Fan of triangles around (px, py) from the angle a, over sweep *)
+let stroke_fan buf tol px py r a sweep =
+  let n = arc_segments tol r sweep in
+  let x = ref (px +. r *. cos a) and y = ref (py +. r *. sin a) in
+  for i = 1 to n do
+    let b = a +. sweep *. float_of_int i /. float_of_int n in
+    let x' = px +. r *. cos b and y' = py +. r *. sin b in
+    Triangles.add buf px py !x !y x' y';
+    x := x';
+    y := y'
+  done
+
+(* Contours given to outline may repeat points, which have no direction *)
+let merge p closed =
+  let b = Points.create () in
+  for i = 0 to Array.length p / 2 - 1 do
+    Points.push b p.(2 * i) p.(2 * i + 1)
+  done;
+  Points.contents b closed
+
+let stroke_contour buf tol join cap d0 d1 (p, closed) =
+  let p = merge p closed in
+  let n = Array.length p / 2 in
+  let closed = closed && n > 2 in
+  let m = if closed then n else n - 1 in
+  if m >= 1 then begin
+    (* Unit directions of the segments *)
+    let dx = Array.make m 0. and dy = Array.make m 0. in
+    for i = 0 to m - 1 do
+      let j = (i + 1) mod n in
+      let x = p.(2 * j) -. p.(2 * i) and y = p.(2 * j + 1) -. p.(2 * i + 1) in
+      let l = sqrt (x *. x +. y *. y) in
+      dx.(i) <- x /. l;
+      dy.(i) <- y /. l
+    done;
+    for i = 0 to m - 1 do
+      let j = (i + 1) mod n in
+      let ax = p.(2 * i) and ay = p.(2 * i + 1) in
+      let bx = p.(2 * j) and by = p.(2 * j + 1) in
+      let nx = -. dy.(i) and ny = dx.(i) in
+      Triangles.quad buf
+        (ax +. d0 *. nx) (ay +. d0 *. ny) (bx +. d0 *. nx) (by +. d0 *. ny)
+        (bx +. d1 *. nx) (by +. d1 *. ny) (ax +. d1 *. nx) (ay +. d1 *. ny)
+    done;
+    (* The gap on the outer side of a turn is filled around the vertex *)
+    let side k a b s e =
+      let px = p.(2 * k) and py = p.(2 * k + 1) in
+      let ux = -. s *. dy.(a) and uy = s *. dx.(a) in
+      let vx = -. s *. dy.(b) and vy = s *. dx.(b) in
+      let ax = px +. e *. ux and ay = py +. e *. uy in
+      let bx = px +. e *. vx and by = py +. e *. vy in
+      let dot = ux *. vx +. uy *. vy in
+      match join with
+      | `Bevel -> Triangles.add buf px py ax ay bx by
+      | `Miter limit ->
+        let k = 1. +. dot in
+        if k > 1e-9 && 2. /. k <= limit *. limit then begin
+          let mx = px +. e *. (ux +. vx) /. k and my = py +. e *. (uy +. vy) /. k in
+          Triangles.add buf px py ax ay mx my;
+          Triangles.add buf px py mx my bx by
+        end else
+          Triangles.add buf px py ax ay bx by
+      | `Round ->
+        let cross = ux *. vy -. uy *. vx in
+        let sweep =
+          if abs_float cross < 1e-9 && dot < 0. then -. s *. Constants.pi
+          else atan2 cross dot
+        in
+        stroke_fan buf tol px py e (atan2 uy ux) sweep
+    in
+    let join_at k a b =
+      let cross = dx.(a) *. dy.(b) -. dy.(a) *. dx.(b) in
+      let dot = dx.(a) *. dx.(b) +. dy.(a) *. dy.(b) in
+      if cross > 1e-9 then begin
+        if d0 < 0. then side k a b (-1.) (-. d0)
+      end else if cross < -1e-9 then begin
+        if d1 > 0. then side k a b 1. d1
+      end else if dot < 0. then begin
+        if d1 > 0. then side k a b 1. d1;
+        if d0 < 0. then side k a b (-1.) (-. d0)
+      end
+    in
+    if closed then
+      for k = 0 to n - 1 do join_at k ((k + m - 1) mod m) k done
+    else begin
+      for k = 1 to n - 2 do join_at k (k - 1) k done;
+      let r = (d1 -. d0) /. 2. and c = (d0 +. d1) /. 2. in
+      (* s = -1 at the start of the contour, 1 at its end *)
+      let cap_at k i s =
+        let px = p.(2 * k) and py = p.(2 * k + 1) in
+        let nx = -. dy.(i) and ny = dx.(i) in
+        match cap with
+        | `Butt -> ()
+        | `Square ->
+          let ex = s *. r *. dx.(i) and ey = s *. r *. dy.(i) in
+          Triangles.quad buf
+            (px +. d0 *. nx) (py +. d0 *. ny) (px +. d1 *. nx) (py +. d1 *. ny)
+            (px +. d1 *. nx +. ex) (py +. d1 *. ny +. ey)
+            (px +. d0 *. nx +. ex) (py +. d0 *. ny +. ey)
+        | `Round ->
+          stroke_fan buf tol (px +. c *. nx) (py +. c *. ny) r
+            (atan2 ny nx) (-. s *. Constants.pi)
+      in
+      cap_at 0 0 (-1.);
+      cap_at (n - 1) (m - 1) 1.
+    end
+  end
+
+let outline ?tolerance:(tol = tolerance) ?join:(join = `Miter 4.) ?cap:(cap = `Butt)
+            ?side:(side = `Center) ~width contours =
+  if not (tol > 0.) then raise (Path_error "Tolerance must be positive");
+  let buf = Triangles.create 0 in
+  if width > 0. then begin
+    let d0, d1 = match side with
+      | `Center -> (-. width /. 2., width /. 2.)
+      | `Left   -> (0., width)
+      | `Right  -> (-. width, 0.)
+    in
+    List.iter (stroke_contour buf tol join cap d0 d1) contours
+  end;
+  Triangles.contents buf
+
+let fill ?tolerance ?rule t = triangulate ?rule (flatten ?tolerance t)
+
+let stroke ?tolerance ?join ?cap ?side ~width t =
+  outline ?tolerance ?join ?cap ?side ~width (flatten ?tolerance t)
+
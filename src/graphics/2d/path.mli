@@ -0,0 +1,87 @@
+(** Paths made of lines, curves and arcs *)
+
+exception Path_error of string
+
+(** Type of paths *)
+type t
+
+(** Triangles, as a flat array of 2D coordinates *)
+type triangles = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+(** Indexed triangles : 2D coordinates, and three indices per triangle *)
+type mesh = {
+  vertices : triangles;
+  indices  : (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+}
+
+(** Fill rules *)
+type rule = [`NonZero | `EvenOdd]
+
+(** Joins between the segments of a stroke *)
+type join = [`Miter of float | `Bevel | `Round]
+
+(** Ends of the open contours of a stroke *)
+type cap = [`Butt | `Square | `Round]
+
+(** Position of a stroke relative to its path *)
+type side = [`Center | `Left | `Right]
+
+(** Default flattening tolerance *)
+val tolerance : float
+
+(** Empty path *)
+val empty : t
+
+(** Starts a new contour at a point *)
+val move_to : OgamlMath.Vector2f.t -> t -> t
+
+(** Adds a line to a point *)
+val line_to : OgamlMath.Vector2f.t -> t -> t
+
+(** Adds a quadratic Bézier curve *)
+val quad_to : control:OgamlMath.Vector2f.t -> OgamlMath.Vector2f.t -> t -> t
+
+(** Adds a cubic Bézier curve given its two control points and its end point *)
+val cubic_to : OgamlMath.Vector2f.t -> OgamlMath.Vector2f.t -> OgamlMath.Vector2f.t -> t -> t
+
+(** Adds an arc of circle, joined to the current point by a line *)
+val arc : center:OgamlMath.Vector2f.t -> radius:float -> start:float -> stop:float -> t -> t
+
+(** Closes the current contour *)
+val close : t -> t
+
+(** Concatenates two paths *)
+val append : t -> t -> t
+
+(** Closed polygon *)
+val polygon : OgamlMath.Vector2f.t list -> t
+
+(** Rectangle *)
+val rectangle : position:OgamlMath.Vector2f.t -> size:OgamlMath.Vector2f.t -> t
+
+(** Circle *)
+val circle : center:OgamlMath.Vector2f.t -> radius:float -> t
+
+(** Rectangle with rounded corners *)
+val rounded_rectangle : position:OgamlMath.Vector2f.t -> size:OgamlMath.Vector2f.t -> radius:float -> t
+
+(** Regular polygon with a given number of vertices *)
+val regular : center:OgamlMath.Vector2f.t -> radius:float -> int -> t
+
+(** Flattens a path into contours of coordinates, with a closed flag *)
+val flatten : ?tolerance:float -> t -> (float array * bool) list
+
+(** Triangulates the interior of flattened contours *)
+val triangulate : ?rule:rule -> (float array * bool) list -> mesh
+
+(** Triangulates the stroke of flattened contours *)
+val outline : ?tolerance:float -> ?join:join -> ?cap:cap -> ?side:side -> width:float ->
+              (float array * bool) list -> triangles
+
+(** Triangulates the interior of a path *)
+val fill : ?tolerance:float -> ?rule:rule -> t -> mesh
+
+(** Triangulates the stroke of a path *)
+val stroke : ?tolerance:float -> ?join:join -> ?cap:cap -> ?side:side -> width:float ->
+             t -> triangles
+
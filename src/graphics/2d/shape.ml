@@ -1,7 +1,12 @@
 open OgamlMath
 
 type shape_vals = {
-  points    : Vector2f.t list ;
+  path      : Path.t ;
+  filled    : bool ;
+  rule      : Path.rule ;
+  join      : Path.join ;
+  cap       : Path.cap ;
+  side      : Path.side ;
   mutable position  : Vector2f.t ;
   mutable origin    : Vector2f.t ;
   mutable rotation  : float ;
@@ -11,165 +16,92 @@ type shape_vals = {
   mutable out_color : Color.t
 }
 
+(* The path is tessellated in its own coordinates, the transformations are
+ * applied when drawing. The curves are flattened for a given scale, and
+ * flattened again when the scale changes by a factor 2. *)
 type t = {
-  mutable vertices : VertexArray.SimpleVertex.T.s VertexArray.Vertex.t list option ;
-  mutable outline  : VertexArray.SimpleVertex.T.s VertexArray.Vertex.t list option ;
-  shape_vals       : shape_vals
+  mutable contours : (float array * bool) list option ;
+  mutable fill     : Path.mesh option ;
+  mutable outline  : Path.triangles option ;
+  mutable detail   : float ;
+  shape_vals       : shape_vals ;
+  (* GPU copy of the vertices and indices (filling then outline), created
+   * on the first draw, and the ranges that changed since the last upload *)
+  mutable buffer   : (Context.t
+                      * (VertexArray.dynamic, VertexArray.SimpleVertex.T.s) VertexArray.t
+                      * IndexArray.dynamic IndexArray.t) option ;
+  mutable fill_dirty    : bool ;
+  mutable outline_dirty : bool ;
+  mutable fill_changed  : bool
 }
 
 (* Utility *)
 
-(* foreachtwo : ('a -> 'b -> 'b -> 'a) -> 'a -> 'b list -> 'a *)
-let rec foreachtwo f res = function
-  | a :: b :: r -> foreachtwo f (f res a b) (b :: r)
-  | _ -> res
-
-(* foralltwo : ('a -> 'b -> 'b -> 'a) -> 'a -> 'b list -> 'a *)
-let foralltwo f res =
-  let rec aux first res = function
-    | a :: b :: r -> aux first (f res a b) (b :: r)
-    | a :: []     -> f res a first
-    | []          -> res
+let transformation vals =
+  Matrix2D.transformation
+    ~translation:vals.position
+    ~rotation:vals.rotation
+    ~scale:vals.scale
+    ~origin:vals.origin
+
+let scale_factor vals =
+  max (abs_float vals.scale.Vector2f.x) (abs_float vals.scale.Vector2f.y)
+
+let compute_vertices shape =
+  let vals = shape.shape_vals in
+  let s = scale_factor vals in
+  begin match shape.contours with
+  | Some _ when s > 0. && (s > 2. *. shape.detail || s < shape.detail /. 2.) ->
+    shape.contours <- None;
+    shape.fill     <- None;
+    shape.outline  <- None;
+    shape.outline_dirty <- true
+  | _ -> ()
+  end;
+  let contours =
+    match shape.contours with
+    | Some c -> c
+    | None ->
+      shape.detail <- if s > 0. then s else 1.;
+      let c = Path.flatten ~tolerance:(Path.tolerance /. shape.detail) vals.path in
+      shape.contours <- Some c;
+      c
   in
-  function
-  | [] -> res
-  | first :: r -> aux first res (first :: r)
-
-
-(* Applies transformations to a point *)
-let apply_transformations position origin rotation scale point =
-  (* Position offset *)
-  Vector2f.({
-    x = point.x +. position.x -. origin.x ;
-    y = point.y +. position.y -. origin.y
-  })
-  |> fun point ->
-  (* Scale *)
-  Vector2f.({
-    x = (point.x -. position.x) *. scale.x +. position.x ;
-    y = (point.y -. position.y) *. scale.y +. position.y
-  })
-  |> fun point ->
-  (* Rotation *)
-  Vector2f.({
-    x = cos(rotation) *. (point.x-.position.x) -.
-        sin(rotation) *. (point.y-.position.y) +. position.x ;
-    y = sin(rotation) *. (point.x-.position.x) +.
-        cos(rotation) *. (point.y-.position.y) +. position.y
-  })
-
-(* Computes the actual points of a shape from its vals *)
-let actual_points vals =
-  List.map
-    (apply_transformations
-      vals.position vals.origin vals.rotation vals.scale)
-    vals.points
-  |> List.map Vector3f.lift
-
-(* Turns actual points to a vertices for the shape *)
-let vertices_of_points points color =
-  List.map (fun v ->
-    VertexArray.SimpleVertex.create ~position:v ~color ()
-  ) points
-  |> function
-  | [] -> []
-  | edge :: vertices ->
-    foreachtwo
-      (fun l a b -> edge :: a :: b :: l) [] vertices
-
-(* Producing bisectors out of actual points *)
-let bisectors_of_points points =
-  (* First compute the normals *)
-  let v = Vector3f.({ x = 0. ; y = 0. ; z = 1. }) in
-  foralltwo
-    (fun l a b ->
-      let open Vector3f in
-      let ab = direction a b in
-      (cross ab v) :: l
-    )
-    []
-    points
-  (* Then we can finally get the bisectors *)
-  |>
-  foralltwo
-    (fun l n1 n2 ->
-      Vector3f.(
-        prop 0.5 (add n1 n2)
-      ) :: l
-    )
-    []
-  (* The last thing is to put all that in order *)
-  (* |> List.rev
-  |> function
-     | []     -> []
-     | a :: r -> a :: (List.rev r) *)
-
-(* Takes the actual points and computes the outline *)
-let outline_of_points points thickness color =
-  match points with
-  | [] -> None
-  | head :: _ ->
-    if thickness = 0. then None
-    (* We'll deal with thickness of 1 later *)
-    (* In the last case, we just draw a rectangle for each line *)
-    else begin
-      (* First the bisectors *)
-      let bisectors = bisectors_of_points points in
-      (* Then the outline *)
-      let tovtx v =
-        VertexArray.SimpleVertex.create ~position:v ~color ()
+  let tolerance = Path.tolerance /. shape.detail in
+  let fill =
+    match shape.fill with
+    | Some f -> f
+    | None ->
+      let f =
+        if vals.filled then Path.triangulate ~rule:vals.rule contours
+        else Path.triangulate []
       in
-      (* Then we compute the outline *)
-      foralltwo
-        (
-          let open Vector3f in
-          let v = { x = 0. ; y = 0. ; z = 1. } in
-          fun lst (a,ba) (b,bb) ->
-            (* Normal to the direction (a b) *)
-            let n =
-              let u = direction a b in
-              cross u v
-            in
-            (* The local thickness *)
-            let xa = thickness /. (dot n ba)
-            and xb = thickness /. (dot n bb) in
-            (* The vector for this thickness *)
-            let vxa = prop xa ba
-            and vxb = prop xb bb in
-            (* Finally the vertices *)
-            let v1 = tovtx (add a vxa)
-            and v2 = tovtx (add b vxb)
-            and v3 = tovtx b
-            and v4 = tovtx a in
-            v1 :: v2 :: v3 :: v3 :: v4 :: v1 :: lst
-        )
-        []
-        (* It shouldn't raise Invalid_argument *)
-        (List.combine points bisectors)
-      |> fun x -> Some (x)
-    end
-
-let compute_vertices poly = 
-  match poly.vertices with
-  | None -> 
-    let points = actual_points poly.shape_vals in
-    let vertices = vertices_of_points points poly.shape_vals.color in
-    let outline = outline_of_points points poly.shape_vals.thickness poly.shape_vals.out_color in
-    poly.vertices <- Some vertices;
-    poly.outline  <- outline;
-    (vertices, outline)
-  | Some v -> (v, poly.outline)
+      shape.fill <- Some f;
+      shape.fill_changed <- true;
+      f
+  in
+  let outline =
+    match shape.outline with
+    | Some o -> o
+    | None ->
+      let o =
+        Path.outline ~tolerance ~join:vals.join ~cap:vals.cap ~side:vals.side
+          ~width:vals.thickness contours
+      in
+      shape.outline <- Some o;
+      o
+  in
+  (fill, outline)
 
-let create_polygon ~points
-                   ~color
-                   ?origin:(origin=Vector2f.zero)
-                   ?position:(position=Vector2f.zero)
-                   ?scale:(scale=Vector2f.({ x = 1. ; y = 1.}))
-                   ?rotation:(rotation=0.)
-                   ?thickness:(thickness=0.)
-                   ?border_color:(out_color=(`RGB Color.RGB.black)) () =
+let make_shape ~path ~filled ~rule ~join ~cap ~side ~color ~origin ~position
+               ~scale ~rotation ~thickness ~out_color =
   let vals = {
-   points    = points ;
+   path      = path ;
+   filled    = filled ;
+   rule      = rule ;
+   join      = join ;
+   cap       = cap ;
+   side      = side ;
    position  = position ;
    origin    = origin ;
    rotation  = rotation ;
@@ -180,11 +112,52 @@ let create_polygon ~points
   }
   in
   {
-   vertices   = None;
+   contours   = None;
+   fill       = None;
    outline    = None;
-   shape_vals = vals
+   detail     = 1.;
+   shape_vals = vals;
+   buffer     = None;
+   fill_dirty    = false;
+   outline_dirty = false;
+   fill_changed  = false
   }
 
+let create_path ~path
+                ?color
+                ?origin:(origin=Vector2f.zero)
+                ?position:(position=Vector2f.zero)
+                ?scale:(scale=Vector2f.({ x = 1. ; y = 1.}))
+                ?rotation:(rotation=0.)
+                ?thickness:(thickness=0.)
+                ?border_color:(out_color=(`RGB Color.RGB.black))
+                ?rule:(rule=`NonZero)
+                ?join:(join=`Miter 4.)
+                ?cap:(cap=`Butt) () =
+  let filled, color = match color with
+    | Some c -> (true, c)
+    | None   -> (false, `RGB Color.RGB.transparent)
+  in
+  make_shape ~path ~filled ~rule ~join ~cap ~side:`Center ~color ~origin ~position
+             ~scale ~rotation ~thickness ~out_color
+
+(* Closed shapes are outlined on the outside of their clockwise contour *)
+let create_closed ~path ~color ~origin ~position ~scale ~rotation
+                  ~thickness ~out_color =
+  make_shape ~path ~filled:true ~rule:`NonZero ~join:(`Miter 4.) ~cap:`Butt ~side:`Right
+             ~color ~origin ~position ~scale ~rotation ~thickness ~out_color
+
+let create_polygon ~points
+                   ~color
+                   ?origin:(origin=Vector2f.zero)
+                   ?position:(position=Vector2f.zero)
+                   ?scale:(scale=Vector2f.({ x = 1. ; y = 1.}))
+                   ?rotation:(rotation=0.)
+                   ?thickness:(thickness=0.)
+                   ?border_color:(out_color=(`RGB Color.RGB.black)) () =
+  create_closed ~path:(Path.polygon points) ~color ~origin ~position ~scale
+                ~rotation ~thickness ~out_color
+
 let create_rectangle ~position
                      ~size
                      ~color
@@ -192,17 +165,21 @@ let create_rectangle ~position
                      ?scale:(scale=Vector2f.({ x = 1. ; y = 1.}))
                      ?rotation:(rotation=0.)
                      ?thickness:(thickness=0.)
-                     ?border_color:(border_color=(`RGB Color.RGB.black)) () =
-  let w = Vector2f.({ x = size.x ; y = 0. })
-  and h = Vector2f.({ x = 0. ; y = size.y }) in
-  create_polygon ~points:Vector2f.([zero ; w ; size ; h])
-                 ~color
-                 ~origin
-                 ~position
-                 ~scale
-                 ~rotation
-                 ~thickness
-                 ~border_color ()
+                     ?border_color:(out_color=(`RGB Color.RGB.black)) () =
+  create_closed ~path:(Path.rectangle ~position:Vector2f.zero ~size)
+                ~color ~origin ~position ~scale ~rotation ~thickness ~out_color
+
+let create_rounded_rectangle ~position
+                             ~size
+                             ~radius
+                             ~color
+                             ?origin:(origin=Vector2f.zero)
+                             ?scale:(scale=Vector2f.({ x = 1. ; y = 1.}))
+                             ?rotation:(rotation=0.)
+                             ?thickness:(thickness=0.)
+                             ?border_color:(out_color=(`RGB Color.RGB.black)) () =
+  create_closed ~path:(Path.rounded_rectangle ~position:Vector2f.zero ~size ~radius)
+                ~color ~origin ~position ~scale ~rotation ~thickness ~out_color
 
 let create_regular ~position
                    ~radius
@@ -212,27 +189,22 @@ let create_regular ~position
                    ?scale:(scale=Vector2f.({ x = 1. ; y = 1.}))
                    ?rotation:(rotation=0.)
                    ?thickness:(thickness=0.)
-                   ?border_color:(border_color=(`RGB Color.RGB.black)) () =
-  let rec vertices k l =
-    if k >= amount then l
-    else begin
-      let fk = float_of_int k in
-      let fn = float_of_int amount in
-      Vector2f.({
-        x = radius *. (cos (2. *. fk *. Constants.pi /. fn)) +. radius ;
-        y = radius *. (sin (2. *. fk *. Constants.pi /. fn)) +. radius
-      }) :: l
-      |> vertices (k+1)
-    end
-  in
-  create_polygon ~points:(List.rev (vertices 0 []))
-               ~color
-               ~origin
-               ~position
-               ~scale
-               ~rotation
-               ~thickness
-               ~border_color ()
+                   ?border_color:(out_color=(`RGB Color.RGB.black)) () =
+  let center = Vector2f.({ x = radius ; y = radius }) in
+  create_closed ~path:(Path.regular ~center ~radius amount)
+                ~color ~origin ~position ~scale ~rotation ~thickness ~out_color
+
+let create_circle ~position
+                  ~radius
+                  ~color
+                  ?origin:(origin=Vector2f.zero)
+                  ?scale:(scale=Vector2f.({ x = 1. ; y = 1.}))
+                  ?rotation:(rotation=0.)
+                  ?thickness:(thickness=0.)
+                  ?border_color:(out_color=(`RGB Color.RGB.black)) () =
+  let center = Vector2f.({ x = radius ; y = radius }) in
+  create_closed ~path:(Path.circle ~center ~radius)
+                ~color ~origin ~position ~scale ~rotation ~thickness ~out_color
 
 let create_line ~thickness
                 ~color
@@ -241,13 +213,9 @@ let create_line ~thickness
                 ?position:(position=Vector2f.zero)
                 ?origin:(origin=Vector2f.zero)
                 ?rotation:(rotation=0.) () =
-  let a3 = Vector3f.lift top 
-  and b3 = Vector3f.lift tip in
-  let n = Vector3f.(
-    let u = direction a3 b3 in
-    let v = { x = 0. ; y = 0. ; z = 1. } in
-    let n = cross u v in
-    project n
+  let n = Vector2f.(
+    let u = direction top tip in
+    { x = u.y ; y = -. u.x }
   ) in
   let points = Vector2f.(
     let delta = prop (thickness /. 2.) n in
@@ -265,43 +233,35 @@ let create_line ~thickness
                ~rotation
                  ()
 
-(* Applies the modifications to shape_vals *)
-let update shape =
-  shape.vertices <- None;
-  shape.outline  <- None
-
+(* Transformations do not modify the vertices *)
 let set_position shape position =
-  shape.shape_vals.position <- position ;
-  update shape
+  shape.shape_vals.position <- position
 
 let set_origin shape origin =
-  shape.shape_vals.origin <- origin ;
-  update shape
+  shape.shape_vals.origin <- origin
 
 let set_rotation shape rotation =
-  shape.shape_vals.rotation <- rotation ;
-  update shape
+  shape.shape_vals.rotation <- rotation
 
 let set_scale shape scale =
-  shape.shape_vals.scale <- scale ;
-  update shape
+  shape.shape_vals.scale <- scale
 
 let set_thickness shape thickness =
   shape.shape_vals.thickness <- thickness ;
-  update shape
+  shape.outline <- None ;
+  shape.outline_dirty <- true
 
 let set_color shape color =
   shape.shape_vals.color <- color ;
-  update shape
+  shape.fill_dirty <- true
 
 let set_border_color shape color =
   shape.shape_vals.out_color <- color ;
-  update shape
+  shape.outline_dirty <- true
 
 let translate shape delta =
   shape.shape_vals.position
-    <- Vector2f.(add delta shape.shape_vals.position) ;
-  update shape
+    <- Vector2f.(add delta shape.shape_vals.position)
 
 let rotate shape delta =
   mod_float (shape.shape_vals.rotation +. delta) (2. *. Constants.pi)
@@ -330,6 +290,14 @@ let color shape = shape.shape_vals.color
 
 let border_color shape = shape.shape_vals.out_color
 
+let add_vertices src coords color =
+  for i = 0 to Bigarray.Array1.dim coords / 2 - 1 do
+    VertexArray.SimpleVertex.create
+      ~position:(Vector3f.make coords.{2 * i} coords.{2 * i + 1} 0.)
+      ~color ()
+    |> VertexArray.VertexSource.add src
+  done
+
 let draw (type s) (module M : RenderTarget.T with type t = s)
          ?parameters:(parameters = DrawParameter.make
          ~depth_test:DrawParameter.DepthTest.None
@@ -338,43 +306,94 @@ let draw (type s) (module M : RenderTarget.T with type t = s)
   let context = M.context target in
   let program = Context.LL.shape_drawing context in
   let size = M.size target in
+  let vals = shape.shape_vals in
   let uniform =
     Uniform.empty
-    |> Uniform.vector2f "size" (Vector2f.from_int size)
+    |> Uniform.matrix2D "transform"
+         (Matrix2D.product
+           (Matrix2D.projection ~size:(Vector2f.from_int size))
+           (transformation vals))
   in
-  let vertices = 
-    let src = VertexArray.VertexSource.empty
-      ~size:8 ()
-    in
-    let vtcs, outline = compute_vertices shape in
-    List.iter (VertexArray.VertexSource.add src) vtcs;
-    begin match outline with
-    | None -> ()
-    | Some vtcs -> List.iter (VertexArray.VertexSource.add src) vtcs
-    end;
-    VertexArray.static (module M) target src
+  let fill, outline = compute_vertices shape in
+  let nfill = Bigarray.Array1.dim fill.Path.vertices / 2 in
+  let length = nfill + Bigarray.Array1.dim outline / 2 in
+  let source () =
+    let src = VertexArray.VertexSource.empty ~size:length () in
+    add_vertices src fill.Path.vertices vals.color;
+    add_vertices src outline vals.out_color;
+    src
   in
-  VertexArray.draw (module M)
-        ~target
-        ~vertices
-        ~program
-        ~parameters
-        ~uniform
-        ~mode:DrawMode.Triangles () 
-
-let map_to_source shape f src = 
-  let vtcs, outline = compute_vertices shape in
-  List.iter (fun v -> VertexArray.VertexSource.add src (f v)) vtcs;
-  begin match outline with
-  | None -> ()
-  | Some vtcs -> List.iter (fun v -> VertexArray.VertexSource.add src (f v)) vtcs
-  end
-
-let to_source shape src = 
-  let vtcs, outline = compute_vertices shape in
-  List.iter (VertexArray.VertexSource.add src) vtcs;
-  begin match outline with
+  let part coords color =
+    let src = VertexArray.VertexSource.empty ~size:(Bigarray.Array1.dim coords / 2) () in
+    add_vertices src coords color;
+    src
+  in
+  (* The outline is not indexed, its vertices follow the filling *)
+  let indices () =
+    let n = Bigarray.Array1.dim fill.Path.indices in
+    let src = IndexArray.Source.empty (n + length - nfill) in
+    for i = 0 to n - 1 do
+      IndexArray.Source.add src (Int32.to_int fill.Path.indices.{i})
+    done;
+    for i = nfill to length - 1 do IndexArray.Source.add src i done;
+    src
+  in
+  (* Only the modified ranges are uploaded again. The buffers are rebuilt if
+   * the filling was tessellated again or the number of vertices changed. *)
+  let buffers =
+    if length = 0 then None
+    else match shape.buffer with
+    | Some (c, vao, ebo) when c == context && VertexArray.length vao = length
+                           && not shape.fill_changed ->
+      if shape.fill_dirty && nfill > 0 then
+        VertexArray.update vao (part fill.Path.vertices vals.color) 0;
+      if shape.outline_dirty && length > nfill then
+        VertexArray.update vao (part outline vals.out_color) nfill;
+      Some (vao, ebo)
+    | Some (c, vao, ebo) when c == context ->
+      VertexArray.rebuild vao (source ()) 0;
+      IndexArray.rebuild ebo (indices ()) 0;
+      Some (vao, ebo)
+    | _ ->
+      let vao = VertexArray.dynamic (module M) target (source ()) in
+      let ebo = IndexArray.dynamic (module M) target (indices ()) in
+      shape.buffer <- Some (context, vao, ebo);
+      Some (vao, ebo)
+  in
+  shape.fill_dirty <- false;
+  shape.outline_dirty <- false;
+  shape.fill_changed <- false;
+  match buffers with
   | None -> ()
-  | Some vtcs -> List.iter (VertexArray.VertexSource.add src) vtcs
-  end
-
+  | Some (vertices, indices) ->
+    VertexArray.draw (module M)
+          ~target
+          ~vertices
+          ~indices
+          ~program
+          ~parameters
+          ~uniform
+          ~mode:DrawMode.Triangles ()
+
+(* Sources are filled with the transformed triangles *)
+let iter_vertices shape f =
+  let fill, outline = compute_vertices shape in
+  let vals = shape.shape_vals in
+  let m = transformation vals in
+  let vertex coords i color =
+    let p = Matrix2D.times m (Vector2f.make coords.{2 * i} coords.{2 * i + 1}) in
+    f (VertexArray.SimpleVertex.create ~position:(Vector3f.lift p) ~color ())
+  in
+  let indices = fill.Path.indices in
+  for i = 0 to Bigarray.Array1.dim indices - 1 do
+    vertex fill.Path.vertices (Int32.to_int indices.{i}) vals.color
+  done;
+  for i = 0 to Bigarray.Array1.dim outline / 2 - 1 do
+    vertex outline i vals.out_color
+  done
+
+let map_to_source shape f src =
+  iter_vertices shape (fun v -> VertexArray.VertexSource.add src (f v))
+
+let to_source shape src =
+  iter_vertices shape (VertexArray.VertexSource.add src)
@@ -3,7 +3,7 @@
 (** Type of shapes *)
 type t
 
-(** Creates a convex polygon given a list of points.
+(** Creates a polygon given a list of points, filled with the non-zero rule.
   * points is this list of points,
   * origin is the origin of the polygon.
   * All coordinates are taken with respect to the top-left corner of the
@@ -46,6 +46,47 @@ val create_regular :
   ?border_color : Color.t ->
   unit -> t
 
+(** Creates a circle. Its curve is flattened within Path.tolerance pixels. *)
+val create_circle :
+  position      : OgamlMath.Vector2f.t ->
+  radius        : float ->
+  color         : Color.t ->
+  ?origin       : OgamlMath.Vector2f.t ->
+  ?scale        : OgamlMath.Vector2f.t ->
+  ?rotation     : float ->
+  ?thickness    : float ->
+  ?border_color : Color.t ->
+  unit -> t
+
+(** Creates a rectangle with rounded corners. *)
+val create_rounded_rectangle :
+  position      : OgamlMath.Vector2f.t ->
+  size          : OgamlMath.Vector2f.t ->
+  radius        : float ->
+  color         : Color.t ->
+  ?origin       : OgamlMath.Vector2f.t ->
+  ?scale        : OgamlMath.Vector2f.t ->
+  ?rotation     : float ->
+  ?thickness    : float ->
+  ?border_color : Color.t ->
+  unit -> t
+
+(** Creates a shape from a path, filled if a color is given and stroked
+  * along the path with the given thickness. *)
+val create_path :
+  path          : Path.t ->
+  ?color        : Color.t ->
+  ?origin       : OgamlMath.Vector2f.t ->
+  ?position     : OgamlMath.Vector2f.t ->
+  ?scale        : OgamlMath.Vector2f.t ->
+  ?rotation     : float ->
+  ?thickness    : float ->
+  ?border_color : Color.t ->
+  ?rule         : Path.rule ->
+  ?join         : Path.join ->
+  ?cap          : Path.cap ->
+  unit -> t
+
 (** Creates a line from $top$ (zero by default) to $tip$. *)
 val create_line :
   thickness : float ->
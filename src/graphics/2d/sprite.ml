@@ -11,6 +11,9 @@ type t = {
   mutable rotation : float ;
   mutable scale    : Vector2f.t;
   mutable color    : Color.t;
+  (* GPU copy of the vertices, created on the first draw *)
+  mutable vertices : (Context.t * (VertexArray.dynamic, VertexArray.SimpleVertex.T.s) VertexArray.t) option;
+  mutable dirty    : bool
 }
 
 let error msg = raise (Sprite_error msg)
@@ -112,7 +115,9 @@ let create ~texture
     origin   = origin ;
     color    = color ;
     rotation = rotation ;
-    scale    = scale
+    scale    = scale ;
+    vertices = None ;
+    dirty    = false
   }
 
 let map_to_source sprite f src = 
@@ -138,12 +143,23 @@ let draw (type s) (module Target : RenderTarget.T with type t = s)
     |> Uniform.vector2f "size" size
     |> Uniform.texture2D "utexture" sprite.texture
   in
-  let vertices = 
+  let source () =
     let sprite_source = VertexArray.VertexSource.empty ~size:6 () in
     List.iter (VertexArray.VertexSource.add sprite_source) (get_vertices sprite);
-    let vao = VertexArray.static (module Target) target sprite_source in
-    vao
+    sprite_source
+  in
+  (* The vertices are only uploaded again after a modification *)
+  let vertices = 
+    match sprite.vertices with
+    | Some (c, vao) when c == context ->
+      if sprite.dirty then VertexArray.update vao (source ()) 0;
+      vao
+    | _ ->
+      let vao = VertexArray.dynamic (module Target) target (source ()) in
+      sprite.vertices <- Some (context, vao);
+      vao
   in
+  sprite.dirty <- false;
   VertexArray.draw (module Target)
         ~target
         ~vertices
@@ -152,25 +168,31 @@ let draw (type s) (module Target : RenderTarget.T with type t = s)
         ~uniform ()
 
 let set_position sprite position =
-  sprite.position <- position 
+  sprite.position <- position ;
+  sprite.dirty <- true
 
 let set_origin sprite origin =
-  sprite.origin <- origin 
+  sprite.origin <- origin ;
+  sprite.dirty <- true
 
 let set_rotation sprite rotation =
-  sprite.rotation <- rotation 
+  sprite.rotation <- rotation ;
+  sprite.dirty <- true
 
 let set_size sprite size = 
-  sprite.size <- size
+  sprite.size <- size ;
+  sprite.dirty <- true
 
 let set_scale sprite scale =
-  sprite.scale <- scale 
+  sprite.scale <- scale ;
+  sprite.dirty <- true
 
 let set_color sprite color =
-  sprite.color <- color
+  sprite.color <- color ;
+  sprite.dirty <- true
 
 let translate sprite delta =
-  sprite.position <- Vector2f.(add delta sprite.position) 
+  set_position sprite Vector2f.(add delta sprite.position) 
 
 let rotate sprite delta =
   mod_float (sprite.rotation +. delta) (2. *. Constants.pi)
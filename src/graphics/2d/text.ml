@@ -94,23 +94,18 @@ module Fx = struct
              ~size
              () =
     let utf8 = UTF8String.from_string text in
-    let length = UTF8String.length utf8 in
-    let rec fold i =
-      if i >= length then []
-      else if i = length - 1 then begin
-        let code = (`Code (UTF8String.get utf8 i)) in
+    (* The kerning of a char is only known once the next one is decoded *)
+    let chars =
+      UTF8String.fold utf8 (fun c l ->
+        let code = `Code c in
         let glyph = Font.glyph font code size false in
-        [0.,code,glyph]
-      end
-      else begin
-        let code = (`Code (UTF8String.get utf8 i)) in
-        let code' = (`Code (UTF8String.get utf8 (i+1))) in
-        let glyph = Font.glyph font code size false in
-        let kern = Font.kerning font code code' size in
-        (kern,code,glyph) :: (fold (i+1))
-      end
+        match l with
+        | (_,code',glyph') :: t ->
+          (0.,code,glyph) :: (Font.kerning font code' code size,code',glyph') :: t
+        | [] -> [0.,code,glyph]
+      ) []
+      |> List.rev
     in
-    let chars = fold 0 in
     (* Compute the list of colours. *)
     let color_list = full_iter (full_lift colors) chars in
     let chars = List.combine chars color_list in
@@ -247,120 +242,37 @@ module Fx = struct
 end
 
 type t = {
-  font       : Font.t;
-  size       : int;
-  chars      : (float * Font.code * Font.Glyph.t) list;
-  vertices   : VertexArray.SimpleVertex.T.s VertexArray.Vertex.t list;
-  advance    : Vector2f.t ;
-  boundaries : FloatRect.t
+  font     : Font.t;
+  size     : int;
+  layout   : TextLayout.t;
+  position : Vector2f.t;
+  color    : Color.t;
+  sdf      : bool;
+  weight   : float;
+  outline  : Color.t * float;
+  glow     : Color.t * float;
+  (* GPU copy of the vertices, created on the first draw *)
+  mutable buffer : (Context.t * (VertexArray.static, VertexArray.SimpleVertex.T.s) VertexArray.t) option
 }
 
-let create ~text ~position ~font ?color:(color=(`RGB Color.RGB.black)) ~size ?bold:(bold = false) () =
-  let utf8 = UTF8String.from_string text in
-  let length = UTF8String.length utf8 in
-  let rec iter i =
-    if i >= length then []
-    else if i = length - 1 then begin
-      let code = (`Code (UTF8String.get utf8 i)) in
-      let glyph = Font.glyph font code size bold in
-      [0.,code,glyph]
-    end
-    else begin
-      let code = (`Code (UTF8String.get utf8 i)) in
-      let code' = (`Code (UTF8String.get utf8 (i+1))) in
-      let glyph = Font.glyph font code size bold in
-      let kern = Font.kerning font code code' size in
-      (kern,code,glyph) :: (iter (i+1))
-    end
-  in
-  let chars = iter 0 in
-  let vertices,advance,width =
-    let lift v = Vector3f.lift v in
-    List.fold_left
-      (fun (lvtx, advance_vec, line_width) (kern,code,glyph) ->
-       match code with
-       | `Code i when i = Char.code '\n' ->
-         lvtx,
-         Vector2f.({
-           x = 0. ;
-           y = advance_vec.y +. (Font.spacing font size)
-         }),
-         max advance_vec.Vector2f.x line_width
-       | code ->
-         let bearing = Font.Glyph.bearing glyph in
-         let bearingX = Vector2f.({ x = bearing.x ; y = 0. })
-         and bearingY = Vector2f.({ x = 0. ; y = bearing.y }) in
-         let (width, height) =
-           let rect = Font.Glyph.rect glyph in
-           let open FloatRect in
-           Vector2f.({ x = rect.width ; y = 0. }),
-           Vector2f.({ x = 0. ; y = rect.height })
-         in
-         let corner = Vector2f.(
-           add advance_vec (add position (sub bearingX bearingY))
-         ) in
-         let uv = Font.Glyph.uv glyph in
-         let (uvx,uvy,uvw,uvh) =
-           let open FloatRect in
-           uv.x, uv.y, uv.width, uv.height
-         in
-         let v1 =
-           VertexArray.SimpleVertex.create
-             ~position:(lift corner)
-             ~uv:Vector2f.({ x = uvx ; y = uvy })
-             ~color
-             ()
-         and v2 =
-           VertexArray.SimpleVertex.create
-             ~position:(lift Vector2f.(add corner width))
-             ~uv:Vector2f.({ x = uvx +. uvw ; y = uvy })
-             ~color
-             ()
-         and v3 =
-           VertexArray.SimpleVertex.create
-             ~position:(lift Vector2f.(add corner (add width height)))
-             ~uv:Vector2f.({ x = uvx +. uvw ; y = uvy +. uvh })
-             ~color
-             ()
-         and v4 =
-           VertexArray.SimpleVertex.create
-             ~position:(lift Vector2f.(add corner height))
-             ~uv:Vector2f.({ x = uvx ; y = uvy +. uvh })
-             ~color
-             ()
-         in
-         v1 :: v2 :: v3 :: v3 :: v1 :: v4 :: lvtx,
-         Vector2f.(
-           add advance_vec { x = Font.Glyph.advance glyph +. kern ; y = 0. }
-         ),
-         line_width
-      )
-      (
-        [],
-        Vector2f.zero,
-        0.
-      )
-      chars
-    |> fun (lvtx, advance, line_width) -> lvtx,
-                                          advance,
-                                          max advance.Vector2f.x line_width
-  in
-  let boundaries = {
-    FloatRect.x      = position.Vector2f.x ;
-    FloatRect.y      = position.Vector2f.y
-                     -. (Font.ascent font size) ;
-    FloatRect.width  = width ;
-    FloatRect.height = advance.Vector2f.y
-                     +. (Font.ascent font size)
-                     -. (Font.descent font size)
-  } in
+let no_effect = (`RGB Color.RGB.transparent, 0.)
+
+let create ~text ~position ~font ?color:(color=(`RGB Color.RGB.black)) ~size ?bold:(bold = false)
+           ?sdf:(sdf = false) ?outline ?glow ?width ?alignment () =
+  let sdf = sdf || outline <> None || glow <> None in
+  let layout = TextLayout.create ~font ~size ~bold ~sdf ?width ?alignment ~text () in
   {
     font     ;
     size     ;
-    chars    ;
-    vertices ;
-    advance  ;
-    boundaries
+    layout   ;
+    position ;
+    color    ;
+    sdf      ;
+    (* Bold distance field glyphs are drawn thicker *)
+    weight  = if sdf && bold then 0.03 *. float_of_int size else 0. ;
+    outline = (match outline with Some o -> o | None -> no_effect) ;
+    glow    = (match glow with Some g -> g | None -> no_effect) ;
+    buffer = None
   }
 
 
@@ -370,46 +282,75 @@ let draw (type s) (module M : RenderTarget.T with type t = s)
          ~depth_test:DrawParameter.DepthTest.None
          ~blend_mode:DrawParameter.BlendMode.alpha ())
          ~text ~target () =
-  let context = M.context target in
-  let program = Context.LL.text_drawing context in
-  let texture = Font.texture (module M) target text.font in
-  let size = Vector2f.from_int (M.size target) in
-  let index = Font.size_index text.font text.size in
-  let tsize = 
-    Texture.Texture2DArray.size texture
-    |> Vector3i.project
-    |> Vector2f.from_int
-  in
-  let uniform =
-    Uniform.empty
-    |> Uniform.vector2f "window_size" size
-    |> Uniform.vector2f "atlas_size" tsize
-    |> Uniform.texture2Darray "atlas" texture
-    |> Uniform.int "atlas_offset" index
-  in
-  let vertices = 
-    let vtx = text.vertices in
-    let src = VertexArray.VertexSource.empty
-      ~size:32 () 
+  if TextLayout.glyphs text.layout > 0 then begin
+    let context = M.context target in
+    let program =
+      if text.sdf then Context.LL.sdf_text_drawing context
+      else Context.LL.text_drawing context
+    in
+    let texture = Font.texture (module M) target text.font in
+    let size = Vector2f.from_int (M.size target) in
+    let index =
+      if text.sdf then Font.sdf_index text.font
+      else Font.size_index text.font text.size
+    in
+    let tsize = 
+      Texture.Texture2DArray.size texture
+      |> Vector3i.project
+      |> Vector2f.from_int
+    in
+    let uniform =
+      Uniform.empty
+      |> Uniform.vector2f "window_size" size
+      |> Uniform.vector2f "atlas_size" tsize
+      |> Uniform.texture2Darray "atlas" texture
+      |> Uniform.int "atlas_offset" index
+    in
+    let uniform =
+      if not text.sdf then uniform
+      else begin
+        let (outline_color, outline_width) = text.outline in
+        let (glow_color, glow_width) = text.glow in
+        uniform
+        |> Uniform.float "distance_scale"
+             (2. *. Font.sdf_range *. float_of_int text.size /. float_of_int Font.sdf_size)
+        |> Uniform.float "weight" text.weight
+        |> Uniform.color "outline_color" outline_color
+        |> Uniform.float "outline_width" outline_width
+        |> Uniform.color "glow_color" glow_color
+        |> Uniform.float "glow_width" glow_width
+      end
+    in
+    (* Texts are immutable, so their vertices are only uploaded once per context *)
+    let vertices = 
+      match text.buffer with
+      | Some (c, vao) when c == context -> vao
+      | _ ->
+        let src = VertexArray.VertexSource.empty
+          ~size:(6 * TextLayout.glyphs text.layout) ()
+        in
+        TextLayout.to_source text.layout ~position:text.position ~color:text.color src;
+        let vao = VertexArray.static (module M) target src in
+        text.buffer <- Some (context, vao);
+        vao
     in
-    List.iter (VertexArray.VertexSource.add src) vtx;
-    VertexArray.static (module M) target src
-  in
-  VertexArray.draw
-        (module M)
-        ~target
-        ~vertices
-        ~program
-        ~parameters
-        ~uniform
-        ~mode:DrawMode.Triangles ()
+    VertexArray.draw
+          (module M)
+          ~target
+          ~vertices
+          ~program
+          ~parameters
+          ~uniform
+          ~mode:DrawMode.Triangles ()
+  end
 
 let to_source text src = 
-  List.iter (VertexArray.VertexSource.add src) text.vertices
+  TextLayout.to_source text.layout ~position:text.position ~color:text.color src
 
 let map_to_source text f src = 
-  List.iter (fun v -> VertexArray.VertexSource.add src (f v)) text.vertices
+  TextLayout.iter_vertices text.layout ~position:text.position ~color:(fun _ -> text.color)
+    (fun v -> VertexArray.VertexSource.add src (f v))
 
-let advance text = text.advance
+let advance text = TextLayout.advance text.layout
 
-let boundaries text = text.boundaries
+let boundaries text = TextLayout.boundaries text.layout text.position
@@ -49,6 +49,11 @@ val create :
   ?color : Color.t ->
   size  : int ->
   ?bold : bool ->
+  ?sdf  : bool ->
+  ?outline : (Color.t * float) ->
+  ?glow : (Color.t * float) ->
+  ?width : float ->
+  ?alignment : TextLayout.alignment ->
   unit -> t
 
 val draw :
@@ -0,0 +1,341 @@
+open OgamlMath
+open OgamlUtils
+
+exception TextLayout_error of string
+
+type alignment = Left | Center | Right | Justify
+
+
+(* Shaped runs : the glyphs of a string, decoded and measured once *)
+type run = {
+  codes    : int array;
+  metrics  : float array;  (* 8 floats per glyph : x, y, width, height of the
+                              quad relative to the pen, and its rectangle in
+                              the atlas *)
+  advances : float array   (* Advance to the next glyph, kerning included *)
+}
+
+let newline = Char.code '\n'
+
+let is_space c = c = Char.code ' ' || c = Char.code '\t'
+
+(* The string is decoded, and its glyphs and kernings looked up, in a single
+ * pass. Distance field glyphs are scaled from the reference size. *)
+let shape font size bold sdf text =
+  let utf8 = UTF8String.from_string text in
+  let n = UTF8String.length utf8 in
+  let codes = Array.make n 0 in
+  let metrics = Array.make (8 * n) 0. in
+  let advances = Array.make n 0. in
+  let scale = if sdf then float_of_int size /. float_of_int Font.sdf_size else 1. in
+  UTF8String.iteri utf8 (fun k c ->
+    let code = `Code c in
+    codes.(k) <- c;
+    if c <> newline then begin
+      let glyph =
+        if sdf then Font.sdf_glyph font code
+        else Font.glyph font code size bold
+      in
+      let bearing = Font.Glyph.bearing glyph in
+      let rect = Font.Glyph.rect glyph in
+      let uv = Font.Glyph.uv glyph in
+      let m = 8 * k in
+      metrics.(m)     <- scale *. bearing.Vector2f.x;
+      metrics.(m + 1) <- -. scale *. bearing.Vector2f.y;
+      metrics.(m + 2) <- scale *. rect.FloatRect.width;
+      metrics.(m + 3) <- scale *. rect.FloatRect.height;
+      metrics.(m + 4) <- uv.FloatRect.x;
+      metrics.(m + 5) <- uv.FloatRect.y;
+      metrics.(m + 6) <- uv.FloatRect.width;
+      metrics.(m + 7) <- uv.FloatRect.height;
+      advances.(k) <- scale *. Font.Glyph.advance glyph;
+      let p = if k > 0 then codes.(k - 1) else newline in
+      if p <> newline then
+        advances.(k - 1) <- advances.(k - 1) +.
+          (if sdf then scale *. Font.sdf_kerning font (`Code p) code
+           else Font.kerning font (`Code p) code size)
+    end
+  );
+  {codes; metrics; advances}
+
+
+(* Least recently used cache of shaped runs. Fonts are compared physically,
+ * and only the other fields are hashed. *)
+module Key = struct
+
+  type t = {font : Font.t; size : int; bold : bool; sdf : bool; text : string}
+
+  let equal k1 k2 =
+    k1.font == k2.font && k1.size = k2.size && k1.bold = k2.bold &&
+    k1.sdf = k2.sdf && k1.text = k2.text
+
+  let hash k = Hashtbl.hash (k.size, k.bold, k.sdf, k.text)
+
+end
+
+module KeyTable = Hashtbl.Make (Key)
+
+module Cache = struct
+
+  type node = {
+    key : Key.t;
+    run : run;
+    mutable prev : node option;  (* More recently used *)
+    mutable next : node option   (* Less recently used *)
+  }
+
+  type t = {
+    table : node KeyTable.t;
+    mutable first : node option;
+    mutable last  : node option;
+    mutable capacity : int
+  }
+
+  let unlink c n =
+    begin match n.prev with
+    | Some p -> p.next <- n.next
+    | None   -> c.first <- n.next
+    end;
+    begin match n.next with
+    | Some x -> x.prev <- n.prev
+    | None   -> c.last <- n.prev
+    end;
+    n.prev <- None;
+    n.next <- None
+
+  let push c n =
+    n.next <- c.first;
+    begin match c.first with
+    | Some f -> f.prev <- Some n
+    | None   -> c.last <- Some n
+    end;
+    c.first <- Some n
+
+  let rec trim c =
+    if KeyTable.length c.table > c.capacity then
+      match c.last with
+      | None -> ()
+      | Some n ->
+        unlink c n;
+        KeyTable.remove c.table n.key;
+        trim c
+
+  let find c key =
+    let n = KeyTable.find c.table key in
+    unlink c n;
+    push c n;
+    n.run
+
+  let add c key run =
+    if c.capacity > 0 then begin
+      let n = {key; run; prev = None; next = None} in
+      KeyTable.replace c.table key n;
+      push c n;
+      trim c
+    end
+
+  let clear c =
+    KeyTable.reset c.table;
+    c.first <- None;
+    c.last <- None
+
+end
+
+let cache = {
+  Cache.table = KeyTable.create 256;
+  Cache.first = None;
+  Cache.last  = None;
+  Cache.capacity = 256
+}
+
+let cache_capacity () = cache.Cache.capacity
+
+let set_cache_capacity n =
+  if n < 0 then raise (TextLayout_error "Negative cache capacity");
+  cache.Cache.capacity <- n;
+  Cache.trim cache
+
+let cached () = KeyTable.length cache.Cache.table
+
+let clear_cache () = Cache.clear cache
+
+let run font size bold sdf text =
+  let key = {Key.font; size; bold; sdf; text} in
+  try Cache.find cache key
+  with Not_found ->
+    let r = shape font size bold sdf text in
+    Cache.add cache key r;
+    r
+
+
+(* Layouts *)
+type t = {
+  quads   : float array;  (* 8 floats per glyph : x, y, width, height of the
+                             quad relative to the origin, and its rectangle
+                             in the atlas *)
+  indices : int array;    (* Index of the code point of each quad *)
+  glyphs  : int;
+  lines   : int;
+  advance : Vector2f.t;
+  size    : Vector2f.t;
+  left    : float;        (* Offset of the leftmost line *)
+  ascent  : float
+}
+
+(* Greedy line breaking. Lines are broken after their last space when the
+ * next word does not fit, or inside the word if it is alone on its line.
+ * Returns the lines in reverse order as (start, stop, hard) where [start,
+ * stop) are the code points of the line and hard is true for the last line
+ * of a paragraph. *)
+let break_lines r width =
+  let codes = r.codes and adv = r.advances in
+  let n = Array.length codes in
+  let lines = ref [] in
+  let start = ref 0 and pen = ref 0. and brk = ref (-1) and k = ref 0 in
+  let skip_spaces () =
+    while !start < n && is_space codes.(!start) do incr start done;
+    k := !start
+  in
+  while !k < n do
+    let c = codes.(!k) in
+    if c = newline then begin
+      lines := (!start, !k, true) :: !lines;
+      start := !k + 1;
+      k := !start;
+      pen := 0.;
+      brk := -1
+    end else if width < infinity && !pen +. adv.(!k) > width
+                && !k > !start && not (is_space c) then begin
+      if !brk > !start then begin
+        lines := (!start, !brk, false) :: !lines;
+        start := !brk + 1;
+        skip_spaces ()
+      end else begin
+        lines := (!start, !k, false) :: !lines;
+        start := !k
+      end;
+      pen := 0.;
+      brk := -1
+    end else begin
+      if is_space c then brk := !k;
+      pen := !pen +. adv.(!k);
+      incr k
+    end
+  done;
+  (!start, n, true) :: !lines
+
+let create ~font ~size ?bold:(bold = false) ?sdf:(sdf = false)
+           ?width ?alignment:(alignment = Left) ~text () =
+  let wrap = match width with Some w -> w | None -> infinity in
+  if not (wrap > 0.) then raise (TextLayout_error "Wrap width must be positive");
+  let r = run font size bold sdf text in
+  let codes = r.codes and adv = r.advances and m = r.metrics in
+  let lines = Array.of_list (List.rev (break_lines r wrap)) in
+  let nlines = Array.length lines in
+  (* Trailing spaces are not part of the width of a line *)
+  let visible = Array.map (fun (start, stop, _) ->
+    let s = ref stop in
+    while !s > start && is_space codes.(!s - 1) do decr s done;
+    !s) lines
+  in
+  let widths = Array.mapi (fun i (start, _, _) ->
+    let w = ref 0. in
+    for k = start to visible.(i) - 1 do w := !w +. adv.(k) done;
+    !w) lines
+  in
+  let box = match width with Some w -> w | None -> Array.fold_left max 0. widths in
+  let spacing = Font.spacing font size in
+  let quads = Array.make (Array.length m) 0. in
+  let indices = Array.make (Array.length codes) 0 in
+  let count = ref 0 and pen = ref 0. in
+  let left = ref infinity and right = ref neg_infinity in
+  for i = 0 to nlines - 1 do
+    let (start, stop, hard) = lines.(i) in
+    let y = float_of_int i *. spacing in
+    let free = box -. widths.(i) in
+    let spaces = ref 0 in
+    for k = start to visible.(i) - 1 do
+      if is_space codes.(k) then incr spaces
+    done;
+    (* The last line of a paragraph is not justified *)
+    let gap =
+      if alignment <> Justify || hard || !spaces = 0 then 0.
+      else free /. float_of_int !spaces
+    in
+    pen := begin match alignment with
+      | Left | Justify -> 0.
+      | Center -> free /. 2.
+      | Right  -> free
+    end;
+    left  := min !left !pen;
+    right := max !right (!pen +. widths.(i) +. gap *. float_of_int !spaces);
+    for k = start to stop - 1 do
+      if m.(8 * k + 2) > 0. && m.(8 * k + 3) > 0. then begin
+        let q = 8 * !count in
+        quads.(q)     <- !pen +. m.(8 * k);
+        quads.(q + 1) <- y +. m.(8 * k + 1);
+        Array.blit m (8 * k + 2) quads (q + 2) 6;
+        indices.(!count) <- k;
+        incr count
+      end;
+      pen := !pen +. adv.(k);
+      if is_space codes.(k) && k < visible.(i) then pen := !pen +. gap
+    done
+  done;
+  {
+    quads   = Array.sub quads 0 (8 * !count);
+    indices = Array.sub indices 0 !count;
+    glyphs  = !count;
+    lines   = nlines;
+    advance = Vector2f.({x = !pen; y = float_of_int (nlines - 1) *. spacing});
+    size    = Vector2f.({x = !right -. !left;
+                         y = float_of_int (nlines - 1) *. spacing
+                           +. Font.ascent font size -. Font.descent font size});
+    left    = !left;
+    ascent  = Font.ascent font size
+  }
+
+let glyphs t = t.glyphs
+
+let quads t = t.quads
+
+let indices t = t.indices
+
+let lines t = t.lines
+
+let advance t = t.advance
+
+let size t = t.size
+
+let boundaries t (position : Vector2f.t) =
+  FloatRect.({x = position.Vector2f.x +. t.left;
+              y = position.Vector2f.y -. t.ascent;
+              width  = t.size.Vector2f.x;
+              height = t.size.Vector2f.y})
+
+let iter_vertices t ~position ~color f =
+  let px = position.Vector2f.x and py = position.Vector2f.y in
+  for i = 0 to t.glyphs - 1 do
+    let q = 8 * i in
+    let x = px +. t.quads.(q) and y = py +. t.quads.(q + 1) in
+    let w = t.quads.(q + 2) and h = t.quads.(q + 3) in
+    let u = t.quads.(q + 4) and v = t.quads.(q + 5) in
+    let uw = t.quads.(q + 6) and vh = t.quads.(q + 7) in
+    let color = color t.indices.(i) in
+    let vertex x y u v =
+      VertexArray.SimpleVertex.create
+        ~position:(Vector3f.make x y 0.)
+        ~uv:(Vector2f.make u v)
+        ~color
+        ()
+    in
+    let v1 = vertex x y u v
+    and v2 = vertex (x +. w) y (u +. uw) v
+    and v3 = vertex (x +. w) (y +. h) (u +. uw) (v +. vh)
+    and v4 = vertex x (y +. h) u (v +. vh) in
+    f v1; f v2; f v3;
+    f v3; f v1; f v4
+  done
+
+let to_source t ~position ~color src =
+  iter_vertices t ~position ~color:(fun _ -> color) (VertexArray.VertexSource.add src)
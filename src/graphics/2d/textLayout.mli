@@ -0,0 +1,45 @@
+exception TextLayout_error of string
+
+type alignment = Left | Center | Right | Justify
+
+type t
+
+val create :
+  font : Font.t ->
+  size : int ->
+  ?bold : bool ->
+  ?sdf : bool ->
+  ?width : float ->
+  ?alignment : alignment ->
+  text : string ->
+  unit -> t
+
+val glyphs : t -> int
+
+val quads : t -> float array
+
+val indices : t -> int array
+
+val lines : t -> int
+
+val advance : t -> OgamlMath.Vector2f.t
+
+val size : t -> OgamlMath.Vector2f.t
+
+val boundaries : t -> OgamlMath.Vector2f.t -> OgamlMath.FloatRect.t
+
+val iter_vertices :
+  t -> position : OgamlMath.Vector2f.t -> color : (int -> Color.t) ->
+  (VertexArray.SimpleVertex.T.s VertexArray.Vertex.t -> unit) -> unit
+
+val to_source :
+  t -> position : OgamlMath.Vector2f.t -> color : Color.t ->
+  VertexArray.SimpleVertex.T.s VertexArray.VertexSource.t -> unit
+
+val cache_capacity : unit -> int
+
+val set_cache_capacity : int -> unit
+
+val cached : unit -> int
+
+val clear_cache : unit -> unit
@@ -324,6 +324,8 @@ module Program = struct
 
   external utype : t -> int -> GLTypes.GlslType.t = "caml_uniform_type"
 
+  external usize : t -> int -> int = "caml_uniform_size"
+
   external atype : t -> int -> GLTypes.GlslType.t = "caml_attribute_type"
 
   external log : t -> string = "caml_program_log"
@@ -462,6 +464,8 @@ module Uniform = struct
 
   external abst_mat4 : int -> (float, Data.float_32) Data.batype -> unit = "caml_uniform_mat4"
 
+  external abst_mat4v : int -> int -> (float, Data.float_32) Data.batype -> unit = "caml_uniform_mat4v"
+
   external abst_mat23 : int -> (float, Data.float_32) Data.batype -> unit = "caml_uniform_mat23"
 
   external abst_mat32 : int -> (float, Data.float_32) Data.batype -> unit = "caml_uniform_mat32"
@@ -480,6 +484,8 @@ module Uniform = struct
 
   let mat4  i m = abst_mat4  i m.Data.data
 
+  let mat4v i n m = abst_mat4v i n m.Data.data
+
   let mat23 i m = abst_mat23 i m.Data.data
 
   let mat32 i m = abst_mat32 i m.Data.data
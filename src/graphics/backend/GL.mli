@@ -282,6 +282,9 @@ module Program : sig
   (** Returns the type of a uniform from its index *)
   val utype : t -> int -> GLTypes.GlslType.t
 
+  (** Returns the number of elements of a uniform from its index *)
+  val usize : t -> int -> int
+
   (** Returns the type of an attribute from its index *)
   val atype : t -> int -> GLTypes.GlslType.t
 
@@ -485,6 +488,8 @@ module Uniform : sig
 
   val mat4  : Program.u_location -> (float, Data.float_32) Data.t -> unit
 
+  val mat4v : Program.u_location -> int -> (float, Data.float_32) Data.t -> unit
+
 end
 
 
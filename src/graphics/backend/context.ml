@@ -27,6 +27,7 @@ type t = {
   sprite_program : ProgramInternal.t;
   shape_program  : ProgramInternal.t;
   text_program   : ProgramInternal.t;
+  sdf_text_program : ProgramInternal.t;
   mutable msaa : bool;
   mutable culling_mode  : DrawParameter.CullingMode.t;
   mutable polygon_mode  : DrawParameter.PolygonMode.t;
@@ -130,6 +131,7 @@ module LL = struct
       sprite_program = ProgramInternal.Sources.create_sprite (-3) glsl;
       shape_program  = ProgramInternal.Sources.create_shape  (-2) glsl;
       text_program   = ProgramInternal.Sources.create_text   (-1) glsl;
+      sdf_text_program = ProgramInternal.Sources.create_sdf_text (-4) glsl;
       msaa = false;
       culling_mode = DrawParameter.CullingMode.CullNone;
       polygon_mode = DrawParameter.PolygonMode.DrawFill;
@@ -164,6 +166,8 @@ module LL = struct
 
   let text_drawing s = s.text_program
 
+  let sdf_text_drawing s = s.sdf_text_program
+
   let culling_mode s =
     s.culling_mode
 
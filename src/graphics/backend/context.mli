@@ -69,6 +69,9 @@ module LL : sig
   (** Returns the internal text-drawing program *)
   val text_drawing : t -> ProgramInternal.t
 
+  (** Returns the internal distance field text-drawing program *)
+  val sdf_text_drawing : t -> ProgramInternal.t
+
   (** Returns the current culling mode *)
   val culling_mode : t -> DrawParameter.CullingMode.t
 
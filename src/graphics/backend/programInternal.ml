@@ -4,7 +4,7 @@ exception Program_internal_error of string
 
 module Uniform = struct
 
-  type t = {name : string; kind : GLTypes.GlslType.t; location : GL.Program.u_location}
+  type t = {name : string; kind : GLTypes.GlslType.t; location : GL.Program.u_location; size : int}
 
   let name u = u.name
 
@@ -12,6 +12,8 @@ module Uniform = struct
 
   let location u = u.location
 
+  let size u = u.size
+
 end
 
 
@@ -76,13 +78,21 @@ let create ~vertex ~fragment ~id =
     |n -> begin
       let name = GL.Program.uname program (n - 1) in
       let kind = GL.Program.utype program (n - 1) in
+      let size = GL.Program.usize program (n - 1) in
       let location = GL.Program.uloc program name in
       if kind = GLTypes.GlslType.Unknown then
         raise (Program_internal_error "Unsupported GLSL type");
+      (* Arrays are reported as their first element *)
+      let l = String.length name in
+      let name =
+        if l > 3 && String.sub name (l - 3) 3 = "[0]" then String.sub name 0 (l - 3)
+        else name
+      in
       {
         Uniform.name = name; 
         Uniform.kind = kind; 
-        Uniform.location = location
+        Uniform.location = location;
+        Uniform.size = size
       } :: (uniforms (n-1))
     end
   in
@@ -137,9 +147,9 @@ let create_pp ~vertex ~fragment ~id ~version =
 
 module Sources = struct
 
-  (** 2D drawing program *)
+  (** 2D drawing program, transform maps the vertices to clip coordinates *)
   let vertex_shader_source_130 = "
-    uniform vec2 size;
+    uniform mat3 transform;
 
     in vec3 position;
     in vec4 color;
@@ -148,10 +158,9 @@ module Sources = struct
 
     void main() {
 
-      gl_Position.x = 2.0 * position.x / size.x - 1.0;
-      gl_Position.y = 2.0 * (size.y - position.y) / size.y - 1.0;
-      gl_Position.z = 0.0;
-      gl_Position.w = 1.0;
+      vec3 p = transform * vec3(position.xy, 1.0);
+
+      gl_Position = vec4(p.xy, 0.0, 1.0);
 
       frag_color = color;
 
@@ -266,4 +275,53 @@ module Sources = struct
     create_pp ~version ~id ~vertex:vertex_shader_source_text_130
                            ~fragment:fragment_shader_source_text_130
 
+
+  (* Distance field text drawing program. The glyphs are drawn from the median
+   * of the color channels, which keeps their corners sharp, and the effects
+   * from the true distance in the alpha channel. Distances are converted to
+   * window pixels by distance_scale. *)
+  let fragment_shader_source_sdf_text_130 = "
+    uniform sampler2DArray atlas;
+    uniform int atlas_offset;
+    uniform float distance_scale;
+    uniform float weight;
+    uniform vec4 outline_color;
+    uniform float outline_width;
+    uniform vec4 glow_color;
+    uniform float glow_width;
+
+    in vec2 frag_uv;
+    in vec4 frag_color;
+
+    out vec4 color;
+
+    float median(float r, float g, float b) {
+      return max(min(r, g), min(max(r, g), b));
+    }
+
+    void main() {
+
+      vec4 field = texture(atlas, vec3(frag_uv.xy,atlas_offset));
+      float dist = (median(field.r, field.g, field.b) - 0.5) * distance_scale + weight;
+      float true_dist = (field.a - 0.5) * distance_scale + weight;
+
+      float fill = clamp(dist + 0.5, 0.0, 1.0);
+      float outline = 0.0;
+      float glow = 0.0;
+      if (outline_width > 0.0)
+        outline = clamp(true_dist + outline_width + 0.5, 0.0, 1.0);
+      if (glow_width > 0.0)
+        glow = clamp(1.0 + (true_dist + outline_width) / glow_width, 0.0, 1.0);
+
+      color = vec4(glow_color.rgb, glow_color.a * glow * glow);
+      color = mix(color, outline_color, outline);
+      color = mix(color, frag_color, fill);
+
+    }
+  "
+
+  let create_sdf_text id version =
+    create_pp ~version ~id ~vertex:vertex_shader_source_text_130
+                           ~fragment:fragment_shader_source_sdf_text_130
+
 end
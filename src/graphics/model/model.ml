@@ -181,6 +181,253 @@ let compute_normals ?smooth:(smooth=false) t =
 let simplify t = 
   List.sort_uniq compare t
 
+
+(* Decimation (quadric error metric, half-edge collapses) *)
+module Decimation = struct
+
+  module CQueue = OgamlUtils.PriorityQueue.Make (struct
+
+    type t = float
+
+    let compare (f1 : float) (f2 : float) = compare f1 f2
+
+  end)
+
+  (* Penalty applied to the planes guarding open borders and UV seams *)
+  let boundary_weight = 1000.
+
+  (* Quadrics are symmetric 4x4 matrices stored as 10 floats per vertex :
+   * aa ab ac ad bb bc bd cc cd dd *)
+  let add_plane q i w (n : Vector3f.t) d = 
+    let o = i * 10 in
+    let a, b, c = n.Vector3f.x, n.Vector3f.y, n.Vector3f.z in
+    q.(o+0) <- q.(o+0) +. w *. a *. a;
+    q.(o+1) <- q.(o+1) +. w *. a *. b;
+    q.(o+2) <- q.(o+2) +. w *. a *. c;
+    q.(o+3) <- q.(o+3) +. w *. a *. d;
+    q.(o+4) <- q.(o+4) +. w *. b *. b;
+    q.(o+5) <- q.(o+5) +. w *. b *. c;
+    q.(o+6) <- q.(o+6) +. w *. b *. d;
+    q.(o+7) <- q.(o+7) +. w *. c *. c;
+    q.(o+8) <- q.(o+8) +. w *. c *. d;
+    q.(o+9) <- q.(o+9) +. w *. d *. d
+
+  let add_quadric q dst src = 
+    for k = 0 to 9 do
+      q.(dst*10+k) <- q.(dst*10+k) +. q.(src*10+k)
+    done
+
+  (* Computes v^T Q v for the quadric of the vertex i *)
+  let eval q i (v : Vector3f.t) = 
+    let o = i * 10 in
+    let x, y, z = v.Vector3f.x, v.Vector3f.y, v.Vector3f.z in
+    q.(o+0) *. x *. x +. 2. *. q.(o+1) *. x *. y +. 2. *. q.(o+2) *. x *. z
+    +. 2. *. q.(o+3) *. x +. q.(o+4) *. y *. y +. 2. *. q.(o+5) *. y *. z
+    +. 2. *. q.(o+6) *. y +. q.(o+7) *. z *. z +. 2. *. q.(o+8) *. z
+    +. q.(o+9)
+
+  let tri_normal p1 p2 p3 = 
+    Vector3f.cross (Vector3f.sub p2 p1) (Vector3f.sub p3 p1)
+
+  (* Returns the list of the successive simplifications of a model at 
+   * the given (decreasing) face ratios, each one with its geometric error *)
+  let chain (t : Face.t list) ratios = 
+    let nfaces = List.length t in
+    let tris = Array.make (3 * nfaces) 0 in
+    let index = Hashtbl.create 97 in
+    let vlist = ref [] in
+    let nverts = ref 0 in
+    let get_index v = 
+      try Hashtbl.find index v
+      with Not_found ->
+        let i = !nverts in
+        Hashtbl.add index v i;
+        vlist := v :: !vlist;
+        incr nverts;
+        i
+    in
+    List.iteri (fun k f ->
+      let (v1,v2,v3) = Face.vertices f in
+      tris.(3*k)   <- get_index v1;
+      tris.(3*k+1) <- get_index v2;
+      tris.(3*k+2) <- get_index v3
+    ) t;
+    let verts = Array.of_list (List.rev !vlist) in
+    let nverts = Array.length verts in
+    let pos = Array.map Vertex.position verts in
+    let q = Array.make (10 * nverts) 0. in
+    (* The error is measured on the face planes only, without the penalties *)
+    let qe = Array.make (10 * nverts) 0. in
+    let tri_alive = Array.make nfaces true in
+    let vert_alive = Array.make nverts true in
+    let stamps = Array.make nverts 0 in
+    let vfaces = Array.make nverts [] in
+    let alive = ref nfaces in
+    let error = ref 0. in
+    (* Face planes and adjacency *)
+    let edges = Hashtbl.create 97 in
+    let edge_key a b = if a < b then (a,b) else (b,a) in
+    for k = 0 to nfaces - 1 do
+      let a, b, c = tris.(3*k), tris.(3*k+1), tris.(3*k+2) in
+      let n = tri_normal pos.(a) pos.(b) pos.(c) in
+      if Vector3f.norm n > 0. then begin
+        let n = Vector3f.normalize n in
+        let d = -. (Vector3f.dot n pos.(a)) in
+        List.iter (fun v -> add_plane q v 1. n d; add_plane qe v 1. n d) [a; b; c]
+      end;
+      List.iter (fun (i,j) ->
+        let key = edge_key i j in
+        let cnt = try Hashtbl.find edges key with Not_found -> 0 in
+        Hashtbl.replace edges key (cnt + 1)
+      ) [(a,b); (b,c); (c,a)];
+      vfaces.(a) <- k :: vfaces.(a);
+      vfaces.(b) <- k :: vfaces.(b);
+      vfaces.(c) <- k :: vfaces.(c)
+    done;
+    (* Border planes, orthogonal to the face along each open edge *)
+    for k = 0 to nfaces - 1 do
+      let a, b, c = tris.(3*k), tris.(3*k+1), tris.(3*k+2) in
+      let n = tri_normal pos.(a) pos.(b) pos.(c) in
+      List.iter (fun (i,j) ->
+        if Hashtbl.find edges (edge_key i j) = 1 then begin
+          let e = Vector3f.cross (Vector3f.sub pos.(j) pos.(i)) n in
+          if Vector3f.norm e > 0. then begin
+            let e = Vector3f.normalize e in
+            let d = -. (Vector3f.dot e pos.(i)) in
+            add_plane q i boundary_weight e d;
+            add_plane q j boundary_weight e d
+          end
+        end
+      ) [(a,b); (b,c); (c,a)]
+    done;
+    let cost src dst = 
+      max 0. (eval q src pos.(dst) +. eval q dst pos.(dst))
+    in
+    let push queue src dst = 
+      let c = cost src dst in
+      CQueue.insert queue c (c, src, dst, stamps.(src), stamps.(dst))
+    in
+    let queue = ref CQueue.empty in
+    for k = 0 to 3 * nfaces - 1 do
+      let a = tris.(k) in
+      let b = tris.(if k mod 3 = 2 then k - 2 else k + 1) in
+      queue := push (push !queue a b) b a
+    done;
+    (* Neighbours of a vertex, with the number of remaining faces shared with each *)
+    let ring v = 
+      List.fold_left (fun acc f ->
+        if not tri_alive.(f) then acc
+        else List.fold_left (fun acc w ->
+          if w = v then acc
+          else 
+            try 
+              let n = List.assoc w acc in 
+              (w, n + 1) :: List.remove_assoc w acc
+            with Not_found -> (w, 1) :: acc
+        ) acc [tris.(3*f); tris.(3*f+1); tris.(3*f+2)]
+      ) [] vfaces.(v)
+    in
+    (* Link condition : the common neighbours of src and dst must be the 
+     * opposite vertices of the faces of the edge, otherwise the collapse 
+     * folds the surface onto itself. An inner edge between two border 
+     * vertices would also pinch the border. *)
+    let manifold src dst = 
+      let rs = ring src and rd = ring dst in
+      let opposite = List.fold_left (fun acc f ->
+        let a, b, c = tris.(3*f), tris.(3*f+1), tris.(3*f+2) in
+        if not tri_alive.(f) || (a <> dst && b <> dst && c <> dst) then acc
+        else List.filter (fun w -> w <> src && w <> dst && not (List.mem w acc)) [a; b; c] @ acc
+      ) [] vfaces.(src) in
+      let common = List.filter (fun (w, _) -> List.mem_assoc w rd) rs in
+      let border r = List.exists (fun (_, n) -> n = 1) r in
+      List.length common = List.length opposite
+      && List.for_all (fun (w, _) -> List.mem w opposite) common
+      && not (List.length opposite = 2 && border rs && border rd)
+    in
+    (* A collapse is valid if it keeps the surface manifold and does not flip
+     * any of the remaining faces *)
+    let valid src dst = 
+      manifold src dst &&
+      List.for_all (fun f ->
+        if not tri_alive.(f) then true
+        else begin
+          let a, b, c = tris.(3*f), tris.(3*f+1), tris.(3*f+2) in
+          if a = dst || b = dst || c = dst then true
+          else begin
+            let moved i = if i = src then pos.(dst) else pos.(i) in
+            let n1 = tri_normal pos.(a) pos.(b) pos.(c) in
+            let n2 = tri_normal (moved a) (moved b) (moved c) in
+            Vector3f.norm n1 = 0. || Vector3f.dot n1 n2 > 0.
+          end
+        end
+      ) vfaces.(src)
+    in
+    let collapse src dst = 
+      List.iter (fun f ->
+        if tri_alive.(f) then begin
+          let a, b, c = tris.(3*f), tris.(3*f+1), tris.(3*f+2) in
+          if a = dst || b = dst || c = dst then begin
+            tri_alive.(f) <- false;
+            decr alive
+          end else begin
+            for k = 3*f to 3*f+2 do
+              if tris.(k) = src then tris.(k) <- dst
+            done;
+            vfaces.(dst) <- f :: vfaces.(dst)
+          end
+        end
+      ) vfaces.(src);
+      vfaces.(src) <- [];
+      vfaces.(dst) <- List.filter (fun f -> tri_alive.(f)) vfaces.(dst);
+      vert_alive.(src) <- false;
+      add_quadric q dst src;
+      add_quadric qe dst src;
+      stamps.(dst) <- stamps.(dst) + 1;
+      List.iter (fun f ->
+        for k = 3*f to 3*f+2 do
+          let w = tris.(k) in
+          if w <> dst then queue := push (push !queue dst w) w dst
+        done
+      ) vfaces.(dst)
+    in
+    let rec run target = 
+      if !alive > target && not (CQueue.is_empty !queue) then begin
+        let ((_, src, dst, ss, sd), queue') = CQueue.extract !queue in
+        queue := queue';
+        if vert_alive.(src) && vert_alive.(dst) 
+          && ss = stamps.(src) && sd = stamps.(dst) 
+          && valid src dst then begin
+          let e = eval qe src pos.(dst) +. eval qe dst pos.(dst) in
+          error := max !error (sqrt (max 0. e));
+          collapse src dst
+        end;
+        run target
+      end
+    in
+    let snapshot () = 
+      let faces = ref [] in
+      for k = nfaces - 1 downto 0 do
+        if tri_alive.(k) then
+          faces := Face.create verts.(tris.(3*k)) 
+                               verts.(tris.(3*k+1)) 
+                               verts.(tris.(3*k+2)) :: !faces
+      done;
+      (!faces, !error)
+    in
+    List.map (fun r ->
+      run (int_of_float (r *. float_of_int nfaces));
+      snapshot ()
+    ) ratios
+
+end
+
+let decimate t ratio = 
+  if ratio < 0. || ratio > 1. then
+    raise (Error "Cannot decimate model : ratio must be in [0;1]");
+  match Decimation.chain t [ratio] with
+  | [res] -> res
+  | _ -> assert false
+
 let source (t : t) ?index_source ~vertex_source () =
   let source_vertex v = 
     let va = Vertex.to_vao v in
@@ -365,3 +612,91 @@ let from_obj s =
   List.fold_left (from_ast tblv tbluv tbln) empty ast
 
 
+
+
+(* Levels of detail *)
+module LOD = struct
+
+  type model = t
+
+  type level = {
+    model  : model;
+    error  : float;
+    faces  : int
+  }
+
+  type t = {
+    levels : level array;
+    center : Vector3f.t;
+    radius : float
+  }
+
+  let create ?ratios:(ratios = [1.; 0.5; 0.25; 0.125]) (m : model) = 
+    if ratios = [] then
+      raise (Error "Cannot create LOD chain : no ratio given");
+    if List.exists (fun r -> r < 0. || r > 1.) ratios then
+      raise (Error "Cannot create LOD chain : ratios must be in [0;1]");
+    let ratios = List.sort_uniq (fun r1 r2 -> compare r2 r1) ratios in
+    let levels = 
+      Decimation.chain m ratios
+      |> List.map (fun (model, error) -> {model; error; faces = List.length model})
+      |> Array.of_list
+    in
+    let minp, maxp = 
+      fold m (fun (minp, maxp) f ->
+        let (v1,v2,v3) = Face.vertices f in
+        List.fold_left (fun (minp, maxp) v ->
+          let p = Vertex.position v in
+          (Vector3f.map2 minp p min, Vector3f.map2 maxp p max)
+        ) (minp, maxp) [v1; v2; v3]
+      ) (Vector3f.make infinity infinity infinity,
+         Vector3f.make neg_infinity neg_infinity neg_infinity)
+    in
+    if m = empty then 
+      {levels; center = Vector3f.zero; radius = 0.}
+    else
+      {levels; 
+       center = Vector3f.div 2. (Vector3f.add minp maxp);
+       radius = Vector3f.dist minp maxp /. 2.}
+
+  let check t i = 
+    if i < 0 || i >= Array.length t.levels then
+      raise (Error (Printf.sprintf "Invalid LOD level %i" i))
+
+  let levels t = Array.length t.levels
+
+  let model t i = check t i; t.levels.(i).model
+
+  let error t i = check t i; t.levels.(i).error
+
+  let faces t i = check t i; t.levels.(i).faces
+
+  let screen_error t ?transform ~view ~projection ~height i = 
+    check t i;
+    let proj = Matrix3D.to_bigarray projection in
+    let scale, center = 
+      match transform with
+      | None -> 1., t.center
+      | Some m ->
+        let b = Matrix3D.to_bigarray m in
+        let col k = sqrt (b.{4*k} *. b.{4*k} +. b.{4*k+1} *. b.{4*k+1} +. b.{4*k+2} *. b.{4*k+2}) in
+        (max (col 0) (max (col 1) (col 2)), Matrix3D.times m t.center)
+    in
+    let err = t.levels.(i).error *. scale *. proj.{5} *. height /. 2. in
+    (* Orthographic projections do not depend on the distance *)
+    if proj.{11} = 0. then err
+    else begin
+      let dist = -. (Matrix3D.times view center).Vector3f.z in
+      if dist <= t.radius *. scale then infinity
+      else err /. dist
+    end
+
+  let select t ?threshold:(threshold = 1.) ?transform ~view ~projection ~height () = 
+    let rec select_aux i = 
+      if i < 0 then 0
+      else if screen_error t ?transform ~view ~projection ~height i <= threshold then i
+      else select_aux (i-1)
+    in
+    select_aux (Array.length t.levels - 1)
+
+end
@@ -74,6 +74,8 @@ val compute_normals : ?smooth:bool -> t -> t
 
 val simplify : t -> t
 
+val decimate : t -> float -> (t * float)
+
 val source : t -> ?index_source:IndexArray.Source.t 
                -> vertex_source:VertexArray.SimpleVertex.T.s VertexArray.VertexSource.t 
                -> unit -> unit
@@ -88,3 +90,35 @@ val fold : t -> ('a -> Face.t -> 'a) -> 'a -> 'a
 
 val map : t -> (Face.t -> Face.t) -> t
 
+
+
+(* Levels of detail *)
+
+module LOD : sig
+
+  type model = t
+
+  type t
+
+  val create : ?ratios:float list -> model -> t
+
+  val levels : t -> int
+
+  val model : t -> int -> model
+
+  val error : t -> int -> float
+
+  val faces : t -> int -> int
+
+  val screen_error : t -> ?transform:OgamlMath.Matrix3D.t 
+                       -> view:OgamlMath.Matrix3D.t
+                       -> projection:OgamlMath.Matrix3D.t
+                       -> height:float -> int -> float
+
+  val select : t -> ?threshold:float 
+                 -> ?transform:OgamlMath.Matrix3D.t
+                 -> view:OgamlMath.Matrix3D.t
+                 -> projection:OgamlMath.Matrix3D.t
+                 -> height:float -> unit -> int
+
+end
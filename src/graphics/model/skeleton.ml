@@ -0,0 +1,397 @@
+open OgamlMath
+open OgamlUtils
+
+exception Skeleton_error of string
+
+let error fmt = Printf.ksprintf (fun s -> raise (Skeleton_error s)) fmt
+
+type buffer = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+type joint = {
+  name        : string;
+  parent      : int;
+  translation : Vector3f.t;
+  rotation    : Quaternion.t;
+  scale       : Vector3f.t
+}
+
+(* Joint indices are stored in bytes *)
+let max_joints = 256
+
+(* Local transforms are stored as 10 floats per joint : translation,
+ * rotation (r, i, j, k) and scale. Affine transforms are stored as 12
+ * floats per joint : the 3 columns of the linear part, then the
+ * translation. *)
+let local_size = 10
+
+let affine_size = 12
+
+type t = {
+  joints  : joint array;
+  bind    : float array;  (* Local bind pose *)
+  inverse : float array;  (* Inverse of the global bind pose, affine *)
+  names   : (string, int) Hashtbl.t
+}
+
+
+(* Affine transforms *)
+
+(* Affine transform of the local transform of l at i, written in a at j *)
+let compose_local l i a j =
+  let tx = l.(i) and ty = l.(i + 1) and tz = l.(i + 2) in
+  let r = l.(i + 3) and qi = l.(i + 4) and qj = l.(i + 5) and qk = l.(i + 6) in
+  let sx = l.(i + 7) and sy = l.(i + 8) and sz = l.(i + 9) in
+  a.(j)      <- (1. -. 2. *. (qj *. qj +. qk *. qk)) *. sx;
+  a.(j + 1)  <- 2. *. (qi *. qj +. r *. qk) *. sx;
+  a.(j + 2)  <- 2. *. (qi *. qk -. r *. qj) *. sx;
+  a.(j + 3)  <- 2. *. (qi *. qj -. r *. qk) *. sy;
+  a.(j + 4)  <- (1. -. 2. *. (qi *. qi +. qk *. qk)) *. sy;
+  a.(j + 5)  <- 2. *. (qj *. qk +. r *. qi) *. sy;
+  a.(j + 6)  <- 2. *. (qi *. qk +. r *. qj) *. sz;
+  a.(j + 7)  <- 2. *. (qj *. qk -. r *. qi) *. sz;
+  a.(j + 8)  <- (1. -. 2. *. (qi *. qi +. qj *. qj)) *. sz;
+  a.(j + 9)  <- tx;
+  a.(j + 10) <- ty;
+  a.(j + 11) <- tz
+
+(* Replaces the affine transform b at j by a(at i) * b *)
+let premultiply a i b j =
+  for c = 0 to 3 do
+    let x = b.(j + 3 * c) and y = b.(j + 3 * c + 1) and z = b.(j + 3 * c + 2) in
+    let w = if c = 3 then 1. else 0. in
+    for r = 0 to 2 do
+      b.(j + 3 * c + r) <-
+        a.(i + r) *. x +. a.(i + 3 + r) *. y +. a.(i + 6 + r) *. z +. w *. a.(i + 9 + r)
+    done
+  done
+
+(* Inverse of the affine transform a at i, written in b at j *)
+let invert a i b j =
+  let m k = a.(i + k) in
+  let c00 = m 4 *. m 8 -. m 7 *. m 5
+  and c01 = m 7 *. m 2 -. m 1 *. m 8
+  and c02 = m 1 *. m 5 -. m 4 *. m 2 in
+  let det = m 0 *. c00 +. m 3 *. c01 +. m 6 *. c02 in
+  if abs_float det < 1e-12 then error "Singular bind pose";
+  let d = 1. /. det in
+  b.(j)     <- c00 *. d;
+  b.(j + 1) <- c01 *. d;
+  b.(j + 2) <- c02 *. d;
+  b.(j + 3) <- (m 6 *. m 5 -. m 3 *. m 8) *. d;
+  b.(j + 4) <- (m 0 *. m 8 -. m 6 *. m 2) *. d;
+  b.(j + 5) <- (m 3 *. m 2 -. m 0 *. m 5) *. d;
+  b.(j + 6) <- (m 3 *. m 7 -. m 6 *. m 4) *. d;
+  b.(j + 7) <- (m 6 *. m 1 -. m 0 *. m 7) *. d;
+  b.(j + 8) <- (m 0 *. m 4 -. m 3 *. m 1) *. d;
+  for r = 0 to 2 do
+    b.(j + 9 + r) <-
+      -. (b.(j + r) *. m 9 +. b.(j + 3 + r) *. m 10 +. b.(j + 6 + r) *. m 11)
+  done
+
+(* Global transforms of a local pose, parents come before their children *)
+let globals skel local world =
+  Array.iteri (fun k jt ->
+    compose_local local (local_size * k) world (affine_size * k);
+    if jt.parent >= 0 then
+      premultiply world (affine_size * jt.parent) world (affine_size * k)) skel.joints
+
+
+(* Skeletons *)
+
+let create joints =
+  let joints = Array.of_list joints in
+  let n = Array.length joints in
+  if n = 0 then error "Empty skeleton";
+  if n > max_joints then error "Too many joints (%i, at most %i)" n max_joints;
+  let names = Hashtbl.create n in
+  let bind = Array.make (local_size * n) 0. in
+  Array.iteri (fun k jt ->
+    if Hashtbl.mem names jt.name then error "Joint %s is defined twice" jt.name;
+    Hashtbl.add names jt.name k;
+    if jt.parent >= k || jt.parent < -1 then
+      error "The parent of joint %s must come before it" jt.name;
+    let q =
+      try Quaternion.normalize jt.rotation
+      with Quaternion.Quaternion_exception _ -> error "Joint %s has a zero rotation" jt.name
+    in
+    let o = local_size * k in
+    bind.(o)     <- jt.translation.Vector3f.x;
+    bind.(o + 1) <- jt.translation.Vector3f.y;
+    bind.(o + 2) <- jt.translation.Vector3f.z;
+    bind.(o + 3) <- q.Quaternion.r;
+    bind.(o + 4) <- q.Quaternion.i;
+    bind.(o + 5) <- q.Quaternion.j;
+    bind.(o + 6) <- q.Quaternion.k;
+    bind.(o + 7) <- jt.scale.Vector3f.x;
+    bind.(o + 8) <- jt.scale.Vector3f.y;
+    bind.(o + 9) <- jt.scale.Vector3f.z) joints;
+  let skel = {joints; bind; inverse = Array.make (affine_size * n) 0.; names} in
+  let world = Array.make (affine_size * n) 0. in
+  globals skel bind world;
+  for k = 0 to n - 1 do
+    invert world (affine_size * k) skel.inverse (affine_size * k)
+  done;
+  skel
+
+let joints t = Array.length t.joints
+
+let joint t i =
+  if i < 0 || i >= Array.length t.joints then error "Invalid joint %i" i;
+  t.joints.(i)
+
+let find t name =
+  try Hashtbl.find t.names name
+  with Not_found -> error "Unknown joint %s" name
+
+let buffer t =
+  let buf = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (16 * joints t) in
+  Bigarray.Array1.fill buf 0.;
+  buf
+
+(* Keeps the 4 heaviest influences, normalized *)
+let influences l =
+  let l = List.filter (fun (_, w) -> w > 0.) l in
+  List.iter (fun (j, _) ->
+    if j < 0 || j >= max_joints then error "Invalid joint %i" j) l;
+  let sorted = List.stable_sort (fun (_, w) (_, w') -> compare w' w) l in
+  let a = Array.make 4 (0, 0.) in
+  List.iteri (fun k x -> if k < 4 then a.(k) <- x) sorted;
+  let total = Array.fold_left (fun s (_, w) -> s +. w) 0. a in
+  let w k = if total > 0. then snd a.(k) /. total else 0. in
+  ((fst a.(0), fst a.(1), fst a.(2), fst a.(3)), (w 0, w 1, w 2, w 3))
+
+
+(* Poses *)
+module Pose = struct
+
+  type skeleton = t
+
+  type t = {
+    skeleton : skeleton;
+    local    : float array;
+    world    : float array
+  }
+
+  let create skeleton = {
+    skeleton;
+    local = Array.copy skeleton.bind;
+    world = Array.make (affine_size * Array.length skeleton.joints) 0.
+  }
+
+  let reset p =
+    Array.blit p.skeleton.bind 0 p.local 0 (Array.length p.local)
+
+  let copy src dst =
+    if src.skeleton != dst.skeleton then error "Poses of different skeletons";
+    Array.blit src.local 0 dst.local 0 (Array.length src.local)
+
+  let check p i =
+    if i < 0 || i >= Array.length p.skeleton.joints then error "Invalid joint %i" i;
+    local_size * i
+
+  let translation p i =
+    let o = check p i in
+    Vector3f.({x = p.local.(o); y = p.local.(o + 1); z = p.local.(o + 2)})
+
+  let rotation p i =
+    let o = check p i in
+    Quaternion.({r = p.local.(o + 3); i = p.local.(o + 4);
+                 j = p.local.(o + 5); k = p.local.(o + 6)})
+
+  let scale p i =
+    let o = check p i in
+    Vector3f.({x = p.local.(o + 7); y = p.local.(o + 8); z = p.local.(o + 9)})
+
+  let set_translation p i v =
+    let o = check p i in
+    p.local.(o)     <- v.Vector3f.x;
+    p.local.(o + 1) <- v.Vector3f.y;
+    p.local.(o + 2) <- v.Vector3f.z
+
+  let set_rotation p i q =
+    let o = check p i in
+    let q =
+      try Quaternion.normalize q
+      with Quaternion.Quaternion_exception _ -> error "Zero rotation"
+    in
+    p.local.(o + 3) <- q.Quaternion.r;
+    p.local.(o + 4) <- q.Quaternion.i;
+    p.local.(o + 5) <- q.Quaternion.j;
+    p.local.(o + 6) <- q.Quaternion.k
+
+  let set_scale p i v =
+    let o = check p i in
+    p.local.(o + 7) <- v.Vector3f.x;
+    p.local.(o + 8) <- v.Vector3f.y;
+    p.local.(o + 9) <- v.Vector3f.z
+
+  (* Translations and scales are interpolated linearly, and rotations
+   * along the shortest path with a normalized linear interpolation *)
+  let blend ?mask a b w dst =
+    if a.skeleton != b.skeleton || a.skeleton != dst.skeleton then
+      error "Poses of different skeletons";
+    let n = Array.length a.skeleton.joints in
+    begin match mask with
+    | Some m when Array.length m <> n -> error "The mask must have a weight per joint"
+    | _ -> ()
+    end;
+    let la = a.local and lb = b.local and ld = dst.local in
+    for k = 0 to n - 1 do
+      let w = match mask with Some m -> w *. m.(k) | None -> w in
+      let o = local_size * k in
+      let d =
+        la.(o + 3) *. lb.(o + 3) +. la.(o + 4) *. lb.(o + 4) +.
+        la.(o + 5) *. lb.(o + 5) +. la.(o + 6) *. lb.(o + 6)
+      in
+      let wq = if d < 0. then -. w else w in
+      for c = 0 to 2 do
+        ld.(o + c) <- la.(o + c) +. w *. (lb.(o + c) -. la.(o + c));
+        ld.(o + 7 + c) <- la.(o + 7 + c) +. w *. (lb.(o + 7 + c) -. la.(o + 7 + c))
+      done;
+      for c = 3 to 6 do
+        ld.(o + c) <- (1. -. w) *. la.(o + c) +. wq *. lb.(o + c)
+      done;
+      let norm = sqrt (ld.(o + 3) *. ld.(o + 3) +. ld.(o + 4) *. ld.(o + 4) +.
+                       ld.(o + 5) *. ld.(o + 5) +. ld.(o + 6) *. ld.(o + 6)) in
+      if norm > 0. then
+        for c = 3 to 6 do ld.(o + c) <- ld.(o + c) /. norm done
+      else
+        Array.blit la (o + 3) ld (o + 3) 4
+    done
+
+end
+
+(* Skinning matrices : global transform times inverse bind transform *)
+let palette pose buf =
+  let skel = pose.Pose.skeleton in
+  let n = Array.length skel.joints in
+  if Bigarray.Array1.dim buf < 16 * n then error "Palette buffer too small";
+  let world = pose.Pose.world and inv = skel.inverse in
+  globals skel pose.Pose.local world;
+  for k = 0 to n - 1 do
+    let a = affine_size * k in
+    for c = 0 to 3 do
+      let x = inv.(a + 3 * c) and y = inv.(a + 3 * c + 1) and z = inv.(a + 3 * c + 2) in
+      let w = if c = 3 then 1. else 0. in
+      for r = 0 to 2 do
+        Bigarray.Array1.unsafe_set buf (16 * k + 4 * c + r)
+          (world.(a + r) *. x +. world.(a + 3 + r) *. y +.
+           world.(a + 6 + r) *. z +. w *. world.(a + 9 + r))
+      done;
+      Bigarray.Array1.unsafe_set buf (16 * k + 4 * c + 3) w
+    done
+  done
+
+
+(* Clips *)
+module Clip = struct
+
+  type channel = Translation | Rotation | Scale
+
+  type skeleton = t
+
+  type t = {
+    skeleton : skeleton;
+    anim     : Animation.t;
+    buf      : Animation.buffer;
+    targets  : int array;  (* Offset of each track in the local pose *)
+    dims     : int array
+  }
+
+  let create skeleton tracks =
+    begin match tracks with [] -> error "Empty clip" | _ -> () end;
+    let n = Array.length skeleton.joints in
+    let targets = Array.of_list (List.map (fun (j, channel, track) ->
+      if j < 0 || j >= n then error "Invalid joint %i" j;
+      let dim = Animation.Track.dimension track in
+      let (offset, expected) =
+        match channel with
+        | Translation -> (0, 3)
+        | Rotation    -> (3, 4)
+        | Scale       -> (7, 3)
+      in
+      if dim <> expected then
+        error "Track of joint %i has %i components instead of %i" j dim expected;
+      local_size * j + offset) tracks)
+    in
+    let anim = Animation.create (List.map (fun (_, _, track) -> track) tracks) in
+    {
+      skeleton; anim; targets;
+      buf  = Animation.buffer anim;
+      dims = Array.of_list (List.map (fun (_, _, tr) -> Animation.Track.dimension tr) tracks)
+    }
+
+  let duration t = Animation.duration t.anim
+
+  (* Joints that are not animated keep their bind pose *)
+  let sample ?loop t time pose =
+    if pose.Pose.skeleton != t.skeleton then error "Pose of another skeleton";
+    Pose.reset pose;
+    Animation.sample ?loop t.anim time t.buf;
+    let local = pose.Pose.local in
+    for k = 0 to Array.length t.targets - 1 do
+      let o = Animation.offset t.anim k and dst = t.targets.(k) in
+      for c = 0 to t.dims.(k) - 1 do
+        local.(dst + c) <- Bigarray.Array1.unsafe_get t.buf (o + c)
+      done
+    done
+
+end
+
+
+(* Vertex skinning, the weights are normalized in the shader *)
+let skinning_source t = Printf.sprintf "
+    uniform mat4 joint_matrices[%i];
+
+    in ivec4 joints;
+    in vec4 weights;
+
+    mat4 skin_matrix() {
+
+      float total = weights.x + weights.y + weights.z + weights.w;
+
+      if (total <= 0.0) return mat4(1.0);
+
+      mat4 m = weights.x * joint_matrices[joints.x]
+             + weights.y * joint_matrices[joints.y]
+             + weights.z * joint_matrices[joints.z]
+             + weights.w * joint_matrices[joints.w];
+
+      return m / total;
+
+    }
+  " (joints t)
+
+let vertex_shader_source t = skinning_source t ^ "
+    uniform mat4 transform;
+
+    in vec3 position;
+    in vec4 color;
+
+    out vec4 frag_color;
+
+    void main() {
+
+      gl_Position = transform * skin_matrix() * vec4(position, 1.0);
+
+      frag_color = color;
+
+    }
+  "
+
+let fragment_shader_source = "
+    in vec4 frag_color;
+
+    out vec4 pixel_color;
+
+    void main() {
+
+      pixel_color = frag_color;
+
+    }
+  "
+
+let program (type s) (module M : RenderTarget.T with type t = s) ~context t =
+  Program.from_source_pp (module M) ~context
+    ~vertex_source:(`String (vertex_shader_source t))
+    ~fragment_source:(`String fragment_shader_source) ()
@@ -0,0 +1,77 @@
+exception Skeleton_error of string
+
+type buffer = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+type joint = {
+  name        : string;
+  parent      : int;
+  translation : OgamlMath.Vector3f.t;
+  rotation    : OgamlMath.Quaternion.t;
+  scale       : OgamlMath.Vector3f.t
+}
+
+type t
+
+val max_joints : int
+
+val create : joint list -> t
+
+val joints : t -> int
+
+val joint : t -> int -> joint
+
+val find : t -> string -> int
+
+val buffer : t -> buffer
+
+val influences : (int * float) list -> (int * int * int * int) * (float * float * float * float)
+
+module Pose : sig
+
+  type skeleton = t
+
+  type t
+
+  val create : skeleton -> t
+
+  val reset : t -> unit
+
+  val copy : t -> t -> unit
+
+  val translation : t -> int -> OgamlMath.Vector3f.t
+
+  val rotation : t -> int -> OgamlMath.Quaternion.t
+
+  val scale : t -> int -> OgamlMath.Vector3f.t
+
+  val set_translation : t -> int -> OgamlMath.Vector3f.t -> unit
+
+  val set_rotation : t -> int -> OgamlMath.Quaternion.t -> unit
+
+  val set_scale : t -> int -> OgamlMath.Vector3f.t -> unit
+
+  val blend : ?mask:float array -> t -> t -> float -> t -> unit
+
+end
+
+val palette : Pose.t -> buffer -> unit
+
+module Clip : sig
+
+  type skeleton = t
+
+  type channel = Translation | Rotation | Scale
+
+  type t
+
+  val create : skeleton -> (int * channel * OgamlUtils.Animation.Track.t) list -> t
+
+  val duration : t -> float
+
+  val sample : ?loop:bool -> t -> float -> Pose.t -> unit
+
+end
+
+val skinning_source : t -> string
+
+val program : (module RenderTarget.T with type t = 'a) -> context:'a -> t -> Program.t
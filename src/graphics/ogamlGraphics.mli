@@ -1186,8 +1186,46 @@ module Font : sig
   (** Type alias for a character given in ASCII or UTF-8 *)
   type code = [`Char of char | `Code of int]
 
-  (** Loads a font from a file *)
-  val load : string -> t
+  (** Sets of characters : printable ASCII (0x20-0x7E), Latin (printable
+    * ASCII, Latin-1 supplement and Latin Extended-A, up to 0x17F) or an
+    * explicit list *)
+  type charset = [`ASCII | `Latin | `Codes of code list]
+
+  (** Loads a font from a file.
+    *
+    * The file is mapped read-only in memory rather than read, and the
+    * mapping is shared by all the fonts loaded from the same file : it is
+    * released when the last of them is collected.
+    *
+    * Kernings are computed once per pair of characters and shared by all
+    * the sizes. If $charset$ is given, the kernings of its characters are
+    * computed upfront instead of the first time they are needed.
+    * @raise Font_error if the file does not exist or is not a valid font *)
+  val load : ?charset:charset -> string -> t
+
+  (** $preload font ~bold ~pool size charset$ loads the glyphs of $charset$
+    * at the size $size$ (and with the modifier $bold$, defaults to false),
+    * so that drawing texts made of these characters does not rasterize
+    * glyphs or rebuild the texture.
+    *
+    * If $pool$ is given, the glyphs are rasterized in parallel by its
+    * workers, and this function waits for them.
+    * @see:OgamlUtils.Scheduler *)
+  val preload : t -> ?bold:bool -> ?pool:OgamlUtils.Scheduler.t -> int -> charset -> unit
+
+  (** $prefetch font ~bold ~pool size charset$ rasterizes the glyphs of
+    * $charset$ at the size $size$ on the workers of $pool$ (defaults to
+    * $OgamlUtils.Scheduler.shared ()$) and returns immediately.
+    *
+    * Rasterized glyphs are added to the font the next time its texture is
+    * requested (that is, when a text is drawn). A glyph requested before
+    * the end of its rasterization is waited for.
+    *
+    * Fonts are not thread-safe : this function must be called from the
+    * thread that uses the font, only the rasterization runs on the pool.
+    * @raise OgamlUtils.Scheduler.Scheduler_exception if the pool has been
+    * shut down *)
+  val prefetch : t -> ?bold:bool -> ?pool:OgamlUtils.Scheduler.t -> int -> charset -> unit
 
   (** $glyph font code size bold$ returns the glyph
     * representing the character $code$ in $font$
@@ -1215,8 +1253,12 @@ module Font : sig
     * (equals ascent + linegap - descent) *)
   val spacing : t -> int -> float
 
-  (** Returns the texture associated to a font.
-    * In this texture, every layer correspond to a font size (in loading order).
+  (** Returns the texture associated to a font in the context of a render
+    * target.
+    * In this texture, every layer correspond to a font size (in loading order),
+    * or to the distance field glyphs.
+    * Glyphs are rasterized once and shared by all the contexts, every context
+    * having its own texture in which the modified layers are uploaded.
     * Use $Font.size_index$ to get the layer associated to a font size. 
     * This texture is not mipmapped. *)
   val texture : (module RenderTarget.T with type t = 'a) -> 'a -> 
@@ -1226,6 +1268,43 @@ module Font : sig
     * Raises Font_error if the font size has not been loaded yet. *)
   val size_index : t -> int -> int
 
+  (*** Distance fields *)
+
+  (** Fonts can also store their glyphs as multi-channel signed distance
+    * fields. Such glyphs are generated once, at the size $sdf_size$, in a
+    * single page of the texture, and can be drawn at any size with sharp
+    * corners, outlines and glows (see $Text.create$).
+    *
+    * The red, green and blue channels of this page hold the distances used
+    * to draw the glyphs (take their median), the alpha channel holds the true
+    * signed distance. Distances are mapped from [-sdf_range, sdf_range] pixels
+    * to [0, 1], and are positive inside the glyphs. *)
+
+  (** Reference size of the distance field glyphs *)
+  val sdf_size : int
+
+  (** Distance range of the distance field glyphs, in pixels
+    * at the reference size *)
+  val sdf_range : float
+
+  (** $sdf_glyph font code$ returns the distance field glyph representing
+    * the character $code$ in $font$. Its metrics are given at the size
+    * $sdf_size$ and scale linearly to other sizes. *)
+  val sdf_glyph : t -> code -> Glyph.t
+
+  (** Returns the kerning between two chars at the size $sdf_size$ *)
+  val sdf_kerning : t -> code -> code -> float
+
+  (** Loads the distance field glyphs of a charset (see $preload$) *)
+  val preload_sdf : t -> ?pool:OgamlUtils.Scheduler.t -> charset -> unit
+
+  (** Rasterizes the distance field glyphs of a charset in the background
+    * (see $prefetch$) *)
+  val prefetch_sdf : t -> ?pool:OgamlUtils.Scheduler.t -> charset -> unit
+
+  (** Returns the index of the distance field page in the font's texture *)
+  val sdf_index : t -> int
+
 end
 
 
@@ -1324,6 +1403,19 @@ module Uniform : sig
   (** See vector3f. Type : mat3. @see:OgamlMath.Matrix3D *)
   val matrix3D : string -> OgamlMath.Matrix3D.t -> t -> t
 
+  (** $matrix3D_array name data set$ adds an array of matrices to $set$,
+    * given as 16 floats per matrix in column-major order (as returned
+    * by $Matrix3D.to_bigarray$). The array is uploaded in a single call,
+    * and may be shorter than the GLSL array.
+    *
+    * Type : mat4[].
+    *
+    * @raise Invalid_uniform if $name$ is already bound, if the size of
+    * $data$ is not a multiple of 16 or, when drawing, if the program
+    * array is shorter than $data$
+    * @see:OgamlMath.Matrix3D *)
+  val matrix3D_array : string -> (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> t -> t
+
   (** See vector3f. Type : mat2. @see:OgamlMath.Matrix2D *)
   val matrix2D : string -> OgamlMath.Matrix2D.t -> t -> t
 
@@ -1436,9 +1528,18 @@ module Window : sig
   val poll_event : t -> OgamlCore.Event.t option
 
   (*** Displaying and Drawing *)
-  (** Displays the window after the GL calls *)
+  (** Displays the window after the GL calls.
+    *
+    * If a framerate limit is set, waits until the time of the next frame,
+    * measured with a monotonic clock : the thread sleeps, then spins for the
+    * last couple of milliseconds, which keeps frame times stable. *)
   val display : t -> unit
 
+  (** Returns the statistics of the durations of the last frames, measured
+    * between two calls to $display$ (percentiles, histogram, hitches)
+    * @see:OgamlUtils.FrameStats *)
+  val frame_stats : t -> OgamlUtils.FrameStats.t
+
   (** Clears the window.
     * Clears the color buffer with opaque black by default. 
     * Clears the depth buffer and the stencil buffer by default. *)
@@ -1587,6 +1688,9 @@ module VertexArray : sig
     (** Raised when trying to get the value of an unset attribute *)
     exception Unbound_attribute of string
 
+    (** Raised when setting an attribute to a value out of its range *)
+    exception Invalid_value of string
+
     (** Type of a vertex *)
     type 'a t
 
@@ -1620,6 +1724,21 @@ module VertexArray : sig
       (** Color attribute *)
       val color : Color.t s
 
+      (** Four unsigned bytes, packed in 4 bytes of the vertex, such as the
+        * joint indices of a skinned vertex. Setting a component out of
+        * [0;255] raises $Invalid_value$.
+        *
+        * Type : ivec4. *)
+      val u8x4 : (int * int * int * int) s
+
+      (** Four floats in [0;1], stored as normalized unsigned bytes in 4
+        * bytes of the vertex, such as the joint weights of a skinned
+        * vertex. Components are clamped and rounded to the nearest
+        * multiple of 1/255.
+        *
+        * Type : vec4. *)
+      val unorm8x4 : (float * float * float * float) s
+
     end
 
 
@@ -1727,6 +1846,56 @@ module VertexArray : sig
   end
 
 
+  (** Pre-initialized structure for skinned meshes *)
+  module SkinnedVertex : sig
+
+    (** This module provides the attributes of $SimpleVertex$, and the
+      * following attributes for skeletal animation :
+      *
+      *
+      * - joints, which should be refered to as $"joints"$, which stores
+      *   the indices of up to 4 joints influencing the vertex, as
+      *   $u8x4$ values.
+      *
+      *
+      * - weights, which should be refered to as $"weights"$, which stores
+      *   the weights of these joints, as $unorm8x4$ values.
+      *
+      * @see:OgamlGraphics.Skeleton *)
+
+    (** Associated vertex structure *)
+    module T : Vertex.VERTEX
+
+    (** Creates a vertex with predefined attributes *)
+    val create : 
+      ?position:OgamlMath.Vector3f.t ->
+      ?color:Color.t ->
+      ?uv:OgamlMath.Vector2f.t ->
+      ?normal:OgamlMath.Vector3f.t ->
+      ?joints:(int * int * int * int) ->
+      ?weights:(float * float * float * float) -> unit -> T.s Vertex.t
+
+    (** Position attribute *)
+    val position : (OgamlMath.Vector3f.t, T.s) Vertex.Attribute.s
+
+    (** Color attribute *)
+    val color : (Color.t, T.s) Vertex.Attribute.s
+
+    (** UV attribute *)
+    val uv : (OgamlMath.Vector2f.t, T.s) Vertex.Attribute.s
+
+    (** Normal attribute *)
+    val normal : (OgamlMath.Vector3f.t, T.s) Vertex.Attribute.s
+
+    (** Joint indices attribute *)
+    val joints : (int * int * int * int, T.s) Vertex.Attribute.s
+
+    (** Joint weights attribute *)
+    val weights : (float * float * float * float, T.s) Vertex.Attribute.s
+
+  end
+
+
   (** Vertex source *)
   module VertexSource : sig
 
@@ -1829,6 +1998,14 @@ module VertexArray : sig
     * @see:OgamlGraphics.VertexArray.Source *)
   val rebuild : (dynamic, 'b) t -> 'b VertexSource.t -> int -> unit
 
+  (** $update array src offset$ overwrites the vertices of $array$ starting
+    * from position $offset$ with the vertices of $src$, without changing its
+    * length. Only the modified range is uploaded.
+    *
+    * @raise Out_of_bounds if $src$ does not fit in $array$ from $offset$
+    * @see:OgamlGraphics.VertexArray.Source *)
+  val update : (dynamic, 'b) t -> 'b VertexSource.t -> int -> unit
+
   (** Returns the length of a vertex array *)
   val length : ('a, 'b) t -> int
 
@@ -1979,6 +2156,19 @@ module Model : sig
   (** Simpifies a model (removes all redundant faces) *)
   val simplify : t -> t
 
+  (** $decimate m r$ reduces $m$ to about $r$ times its number of faces
+    * by collapsing the edges of least quadric error. Vertex attributes are
+    * preserved, open borders and UV seams are kept in place, and collapses
+    * that would fold the surface onto itself are skipped.
+    *
+    * Returns the simplified model together with its geometric error
+    * (a bound of the distance of the collapsed vertices to the planes of
+    * the original faces, in model units ; border and seam penalties are
+    * not included).
+    *
+    * Raises $Error$ if $r$ is not in [0;1] *)
+  val decimate : t -> float -> (t * float)
+
   (** Appends a model to a vertex source. Uses indexing if an index source is provided.
     * Use Triangles as DrawMode with this source.
     * @see:OgamlGraphics.IndexArray.Source
@@ -1999,6 +2189,389 @@ module Model : sig
   (** Maps a model face by face *)
   val map : t -> (Face.t -> Face.t) -> t
 
+
+  (** Automatically generated levels of detail *)
+  module LOD : sig
+
+    (** This module generates chains of simplified models and selects
+      * the appropriate level at draw time from its projected error. *)
+
+    (** Alias for the type of models *)
+    type model = t
+
+    (** Type of a chain of levels of detail *)
+    type t
+
+    (** Creates a chain of levels of detail from a model.
+      *
+      * Each ratio in $ratios$ generates a level containing about that fraction
+      * of the faces of the model. Levels are sorted from the most detailed (0)
+      * to the coarsest one. $ratios$ defaults to $[1.; 0.5; 0.25; 0.125]$.
+      *
+      * Raises $Error$ if $ratios$ is empty or contains values outside [0;1] *)
+    val create : ?ratios:float list -> model -> t
+
+    (** Returns the number of levels of a chain *)
+    val levels : t -> int
+
+    (** Returns the model of a given level. Raises $Error$ if the level does not exist. *)
+    val model : t -> int -> model
+
+    (** Returns the geometric error of a given level, in model units *)
+    val error : t -> int -> float
+
+    (** Returns the number of faces of a given level *)
+    val faces : t -> int -> int
+
+    (** $screen_error lod ~view ~projection ~height i$ returns the error of the 
+      * level $i$ projected on a viewport of height $height$ (in pixels).
+      *
+      * $transform$ is the model matrix of the drawn object (defaults to identity).
+      * Returns $infinity$ if the camera is inside the bounding sphere of the model.
+      * @see:OgamlMath.Matrix3D *)
+    val screen_error : t -> ?transform:OgamlMath.Matrix3D.t 
+                         -> view:OgamlMath.Matrix3D.t
+                         -> projection:OgamlMath.Matrix3D.t
+                         -> height:float -> int -> float
+
+    (** Returns the coarsest level whose projected error is lower than $threshold$ 
+      * pixels (defaults to 1). Returns 0 if no level is precise enough. 
+      * @see:OgamlMath.Matrix3D *)
+    val select : t -> ?threshold:float 
+                   -> ?transform:OgamlMath.Matrix3D.t
+                   -> view:OgamlMath.Matrix3D.t
+                   -> projection:OgamlMath.Matrix3D.t
+                   -> height:float -> unit -> int
+
+  end
+
+end
+
+
+(** Skeletal animation with GPU skinning
+  *
+  * A skeleton is a hierarchy of joints with a bind pose. Animation clips
+  * are sampled in poses, which can be blended, and the skinning matrices of
+  * a pose are flattened in a palette uploaded as a uniform array :
+  *
+  * $Skeleton.Clip.sample ~loop:true walk time pose;
+  *  Skeleton.palette pose palette;
+  *  Uniform.matrix3D_array "joint_matrices" palette uniform$
+  *
+  * Skinning runs in the vertex shader : each vertex is transformed by
+  * the palette matrices of up to 4 joints, given by the attributes of
+  * $VertexArray.SkinnedVertex$.
+  *
+  * @see:OgamlGraphics.VertexArray.SkinnedVertex *)
+module Skeleton : sig
+
+  (** Raised when an error occurs *)
+  exception Skeleton_error of string
+
+  (** Type of the palettes of skinning matrices *)
+  type buffer = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  (** Type of a joint. $parent$ is the index of the parent joint, or -1
+    * for a root. The translation, rotation and scale give the bind pose
+    * of the joint, relative to its parent. *)
+  type joint = {
+    name        : string;
+    parent      : int;
+    translation : OgamlMath.Vector3f.t;
+    rotation    : OgamlMath.Quaternion.t;
+    scale       : OgamlMath.Vector3f.t
+  }
+
+  (** Type of a skeleton *)
+  type t
+
+  (** Maximal number of joints of a skeleton (256), joint indices are
+    * stored in bytes *)
+  val max_joints : int
+
+  (** Creates a skeleton from a list of joints. The index of a joint is
+    * its position in the list.
+    *
+    * @raise Skeleton_error if the list is empty or too long, two joints
+    * have the same name, a joint comes before its parent, a rotation is
+    * zero or the bind pose is not invertible *)
+  val create : joint list -> t
+
+  (** Returns the number of joints of a skeleton *)
+  val joints : t -> int
+
+  (** Returns a joint of a skeleton
+    *
+    * @raise Skeleton_error if the index is invalid *)
+  val joint : t -> int -> joint
+
+  (** Returns the index of the joint of a given name
+    *
+    * @raise Skeleton_error if there is no such joint *)
+  val find : t -> string -> int
+
+  (** Returns a palette for a skeleton, filled with zeros *)
+  val buffer : t -> buffer
+
+  (** $influences l$ returns the joints and weights of a vertex from a
+    * list of (joint, weight) pairs : the 4 heaviest influences are kept and
+    * their weights are normalized. Unused slots have a zero weight.
+    *
+    * @raise Skeleton_error if a joint index does not fit in a byte *)
+  val influences : (int * float) list -> (int * int * int * int) * (float * float * float * float)
+
+  (** Poses of a skeleton *)
+  module Pose : sig
+
+    (** Type of a skeleton *)
+    type skeleton = t
+
+    (** Type of a pose : the local transform of each joint *)
+    type t
+
+    (** Creates a pose of a skeleton, initialized to its bind pose *)
+    val create : skeleton -> t
+
+    (** Resets a pose to the bind pose *)
+    val reset : t -> unit
+
+    (** $copy src dst$ copies $src$ into $dst$
+      *
+      * @raise Skeleton_error if the poses have different skeletons *)
+    val copy : t -> t -> unit
+
+    (** Returns the local translation of a joint
+      *
+      * @raise Skeleton_error if the index is invalid *)
+    val translation : t -> int -> OgamlMath.Vector3f.t
+
+    (** Returns the local rotation of a joint
+      *
+      * @raise Skeleton_error if the index is invalid *)
+    val rotation : t -> int -> OgamlMath.Quaternion.t
+
+    (** Returns the local scale of a joint
+      *
+      * @raise Skeleton_error if the index is invalid *)
+    val scale : t -> int -> OgamlMath.Vector3f.t
+
+    (** Sets the local translation of a joint
+      *
+      * @raise Skeleton_error if the index is invalid *)
+    val set_translation : t -> int -> OgamlMath.Vector3f.t -> unit
+
+    (** Sets the local rotation of a joint, the rotation is normalized
+      *
+      * @raise Skeleton_error if the index is invalid or the rotation is zero *)
+    val set_rotation : t -> int -> OgamlMath.Quaternion.t -> unit
+
+    (** Sets the local scale of a joint
+      *
+      * @raise Skeleton_error if the index is invalid *)
+    val set_scale : t -> int -> OgamlMath.Vector3f.t -> unit
+
+    (** $blend ~mask a b w dst$ interpolates between $a$ (for $w = 0$) and
+      * $b$ (for $w = 1$) and stores the result in $dst$, which can be $a$
+      * or $b$. Rotations are interpolated along the shortest path.
+      *
+      * $mask$ gives a factor of $w$ for each joint, to blend only a part
+      * of the skeleton.
+      *
+      * @raise Skeleton_error if the poses have different skeletons or the
+      * mask does not have a weight per joint *)
+    val blend : ?mask:float array -> t -> t -> float -> t -> unit
+
+  end
+
+  (** $palette pose buf$ computes the skinning matrices of a pose and
+    * stores them in $buf$, as column-major 4x4 matrices. The matrix of a
+    * joint transforms a vertex from the bind pose to the pose.
+    *
+    * @raise Skeleton_error if the buffer is too small *)
+  val palette : Pose.t -> buffer -> unit
+
+  (** Animation clips *)
+  module Clip : sig
+
+    (** Type of a skeleton *)
+    type skeleton = t
+
+    (** Animated transform of a joint *)
+    type channel = Translation | Rotation | Scale
+
+    (** Type of a clip *)
+    type t
+
+    (** $create skeleton tracks$ creates a clip from a list of
+      * (joint, channel, track). Translation and scale tracks have 3
+      * components, rotation tracks are created with
+      * $OgamlUtils.Animation.Track.rotation$.
+      *
+      * @raise Skeleton_error if the list is empty, a joint is invalid or a
+      * track has the wrong dimension
+      *
+      * @see:OgamlUtils.Animation.Track *)
+    val create : skeleton -> (int * channel * OgamlUtils.Animation.Track.t) list -> t
+
+    (** Returns the duration of a clip *)
+    val duration : t -> float
+
+    (** $sample ~loop clip time pose$ stores the pose of a clip at a given
+      * time in $pose$. Joints that are not animated by the clip take their
+      * bind pose. If $loop$ is true (defaults to false), the time wraps
+      * around the clip.
+      *
+      * @raise Skeleton_error if the pose is not a pose of the skeleton of
+      * the clip *)
+    val sample : ?loop:bool -> t -> float -> Pose.t -> unit
+
+  end
+
+  (** Returns the GLSL declarations of the palette uniform
+    * $joint_matrices$, of the $joints$ (ivec4) and $weights$ (vec4)
+    * inputs, and of a function $mat4 skin_matrix()$ that returns the
+    * skinning matrix of the current vertex. *)
+  val skinning_source : t -> string
+
+  (** Returns a program that draws skinned vertices with their color.
+    * It expects the uniforms $transform$ (mat4) and $joint_matrices$, and
+    * the attributes $position$, $color$, $joints$ and $weights$.
+    *
+    * @see:OgamlGraphics.RenderTarget.T *)
+  val program : (module RenderTarget.T with type t = 'a) -> context:'a -> t -> Program.t
+
+end
+
+
+(** Paths made of lines, curves and arcs
+  *
+  * Paths are immutable and built by successive commands :
+  *
+  * $Path.(empty |> move_to a |> line_to b |> quad_to ~control:c d |> close)$
+  *
+  * Curves are flattened adaptively : quadratic and cubic Bézier curves are
+  * split in the number of segments given by Wang's formula, and arcs in
+  * chords whose distance to the circle is at most the tolerance.
+  * Triangulations are output as flat float32 bigarrays of 2D coordinates,
+  * three points per triangle. *)
+module Path : sig
+
+  (** Raised when a path or a tessellation parameter is invalid *)
+  exception Path_error of string
+
+  (** Type of paths *)
+  type t
+
+  (** Triangles, as a flat array of 2D coordinates (6 floats per triangle) *)
+  type triangles = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  (** Indexed triangles : $vertices$ holds the 2D coordinates of the vertices,
+    * and $indices$ three indices of vertices per triangle *)
+  type mesh = {
+    vertices : triangles;
+    indices  : (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+  }
+
+  (** Fill rules. A point is inside a path if the contours wind around it a
+    * non-zero number of times, or an odd number of times. *)
+  type rule = [`NonZero | `EvenOdd]
+
+  (** Joins between the segments of a stroke. A miter join becomes a bevel
+    * when the ratio of its length to the width of the stroke exceeds the
+    * given limit. *)
+  type join = [`Miter of float | `Bevel | `Round]
+
+  (** Ends of the open contours of a stroke *)
+  type cap = [`Butt | `Square | `Round]
+
+  (** Position of a stroke relative to its path : centered on the path, or
+    * entirely on the left or the right of the segments *)
+  type side = [`Center | `Left | `Right]
+
+  (** Default flattening tolerance (0.25 pixels) *)
+  val tolerance : float
+
+  (** Empty path *)
+  val empty : t
+
+  (** Starts a new contour at a point *)
+  val move_to : OgamlMath.Vector2f.t -> t -> t
+
+  (** Adds a line from the current point to a point *)
+  val line_to : OgamlMath.Vector2f.t -> t -> t
+
+  (** Adds a quadratic Bézier curve from the current point *)
+  val quad_to : control:OgamlMath.Vector2f.t -> OgamlMath.Vector2f.t -> t -> t
+
+  (** $cubic_to c1 c2 p$ adds a cubic Bézier curve from the current point to
+    * $p$ with control points $c1$ and $c2$ *)
+  val cubic_to : OgamlMath.Vector2f.t -> OgamlMath.Vector2f.t -> OgamlMath.Vector2f.t -> t -> t
+
+  (** Adds an arc of circle from the angle $start$ to $stop$ (in radians).
+    * The current point, if any, is joined to the start of the arc by a line.
+    * @raise Path_error if the radius is negative *)
+  val arc : center:OgamlMath.Vector2f.t -> radius:float -> start:float -> stop:float -> t -> t
+
+  (** Closes the current contour. The next commands start from its first point. *)
+  val close : t -> t
+
+  (** $append p1 p2$ returns the commands of $p1$ followed by those of $p2$ *)
+  val append : t -> t -> t
+
+  (** Closed polygon *)
+  val polygon : OgamlMath.Vector2f.t list -> t
+
+  (** Rectangle, given its top-left corner and its size *)
+  val rectangle : position:OgamlMath.Vector2f.t -> size:OgamlMath.Vector2f.t -> t
+
+  (** Circle *)
+  val circle : center:OgamlMath.Vector2f.t -> radius:float -> t
+
+  (** Rectangle with rounded corners. The radius is clamped to half the
+    * smallest side. *)
+  val rounded_rectangle : position:OgamlMath.Vector2f.t -> size:OgamlMath.Vector2f.t -> radius:float -> t
+
+  (** Regular polygon with a given number of vertices
+    * @raise Path_error if the number of vertices is lower than 3 *)
+  val regular : center:OgamlMath.Vector2f.t -> radius:float -> int -> t
+
+  (** Flattens a path into contours, given as arrays of coordinates
+    * $[|x0; y0; x1; y1; ...|]$ with a flag telling if the contour is closed.
+    * Coincident consecutive points are merged.
+    *
+    * $tolerance$ is the maximal distance between the curves and their
+    * segments, and defaults to $tolerance$.
+    * @raise Path_error if the tolerance is not positive *)
+  val flatten : ?tolerance:float -> t -> (float array * bool) list
+
+  (** Triangulates the interior of flattened contours, which are implicitly
+    * closed. The contours may be concave, intersect themselves or each
+    * other, and describe holes.
+    *
+    * A single convex contour is triangulated as a fan. Otherwise, the plane
+    * is swept in slabs cut at the vertices and at the intersections of the
+    * edges, and the spans inside the path for $rule$ (defaults to
+    * $`NonZero$) are output as trapezoids that share their vertices. *)
+  val triangulate : ?rule:rule -> (float array * bool) list -> mesh
+
+  (** Triangulates the stroke of flattened contours.
+    *
+    * $join$ defaults to $`Miter 4.$, $cap$ to $`Butt$ and $side$ to
+    * $`Center$. Round joins and caps are flattened within $tolerance$.
+    * Repeated consecutive points are merged.
+    * Returns no triangles if $width$ is not positive. *)
+  val outline : ?tolerance:float -> ?join:join -> ?cap:cap -> ?side:side -> width:float ->
+                (float array * bool) list -> triangles
+
+  (** Flattens and triangulates the interior of a path.
+    * @see:OgamlGraphics.Path.triangulate *)
+  val fill : ?tolerance:float -> ?rule:rule -> t -> mesh
+
+  (** Flattens and triangulates the stroke of a path.
+    * @see:OgamlGraphics.Path.outline *)
+  val stroke : ?tolerance:float -> ?join:join -> ?cap:cap -> ?side:side -> width:float ->
+               t -> triangles
+
 end
 
 
@@ -2008,7 +2581,9 @@ module Shape : sig
   (** Type of shapes *)
   type t
 
-  (** Creates a convex polygon given a list of points.
+  (** Creates a polygon given a list of points.
+    * The polygon may be concave or self-intersecting, and is filled with the
+    * non-zero rule.
     * points is this list of points,
     * origin is the origin of the polygon.
     * All coordinates are taken with respect to the top-left corner of the
@@ -2051,6 +2626,56 @@ module Shape : sig
     ?border_color : Color.t ->
     unit -> t
 
+  (** Creates a circle. Its top-left corner is at the origin of the shape.
+    *
+    * The circle is flattened within $Path.tolerance$ pixels at the scale it
+    * is drawn with. *)
+  val create_circle :
+    position      : OgamlMath.Vector2f.t ->
+    radius        : float ->
+    color         : Color.t ->
+    ?origin       : OgamlMath.Vector2f.t ->
+    ?scale        : OgamlMath.Vector2f.t ->
+    ?rotation     : float ->
+    ?thickness    : float ->
+    ?border_color : Color.t ->
+    unit -> t
+
+  (** Creates a rectangle with rounded corners.
+    * Its origin is positioned with respect to the top-left corner. *)
+  val create_rounded_rectangle :
+    position      : OgamlMath.Vector2f.t ->
+    size          : OgamlMath.Vector2f.t ->
+    radius        : float ->
+    color         : Color.t ->
+    ?origin       : OgamlMath.Vector2f.t ->
+    ?scale        : OgamlMath.Vector2f.t ->
+    ?rotation     : float ->
+    ?thickness    : float ->
+    ?border_color : Color.t ->
+    unit -> t
+
+  (** Creates a shape from a path.
+    *
+    * The contours of the path are filled with $rule$ (defaults to
+    * $`NonZero$) if $color$ is given, and stroked
+    * with a line of width $thickness$ (0 by default) centered on the path,
+    * using $join$ and $cap$.
+    * @see:OgamlGraphics.Path *)
+  val create_path :
+    path          : Path.t ->
+    ?color        : Color.t ->
+    ?origin       : OgamlMath.Vector2f.t ->
+    ?position     : OgamlMath.Vector2f.t ->
+    ?scale        : OgamlMath.Vector2f.t ->
+    ?rotation     : float ->
+    ?thickness    : float ->
+    ?border_color : Color.t ->
+    ?rule         : Path.rule ->
+    ?join         : Path.join ->
+    ?cap          : Path.cap ->
+    unit -> t
+
   (** Creates a line from $top$ (zero by default) to $tip$. *)
   val create_line :
     thickness : float ->
@@ -2063,6 +2688,17 @@ module Shape : sig
     unit -> t
 
   (** Draws a shape on a window using the given parameters.
+    *
+    * The vertices of a shape are tessellated in its own coordinates,
+    * uploaded on its first draw with their indices and kept on the GPU. A
+    * shape is drawn in a single call. Its position, origin,
+    * rotation and scale are applied by the vertex shader, so transforming a
+    * shape uploads nothing. Only the vertices modified since the last draw
+    * are uploaded again (the filling or the outline for a color change, the
+    * outline for a thickness change). Curves are flattened again when the
+    * scale changes by a factor 2.
+    *
+    * The outline is scaled with the shape.
     *
     * $parameters$ defaults to $DrawParameter.make ~depth_test:false ~blend_mode:DrawParameter.BlendMode.alpha$
     *
@@ -2157,6 +2793,9 @@ module Sprite : sig
     unit -> t
 
   (** Draws a sprite on a window using the given parameters.
+    *
+    * The vertices of a sprite are uploaded on its first draw and kept on the
+    * GPU. They are only uploaded again after a modification.
     *
     * $parameters$ defaults to $DrawParameter.make ~depth_test:false ~blend_mode:DrawParameter.BlendMode.alpha$
     *
@@ -2232,6 +2871,102 @@ module Sprite : sig
 end
 
 
+(** Layout of texts *)
+module TextLayout : sig
+
+  (** This module converts strings to glyph quads, breaking lines to a
+    * width and aligning them.
+    *
+    * The glyphs and kernings of a string are looked up once and cached
+    * (with the font, size and mode of the string) in a least recently used
+    * cache, so laying the same strings out again at each frame is cheap. *)
+
+  (** Raised when an error occurs in this module *)
+  exception TextLayout_error of string
+
+  (** Horizontal alignment of the lines. Justified lines are stretched to
+    * the width of the layout, except for the last line of a paragraph. *)
+  type alignment = Left | Center | Right | Justify
+
+  (** Type of a layout *)
+  type t
+
+  (** Lays a string out.
+    *
+    * $sdf$ (defaults to false) uses the distance field glyphs of the font
+    * (see $Font.sdf_glyph$).
+    *
+    * If $width$ is given, lines are broken after their last space when the
+    * next word would overflow it, or inside words that do not fit on a line.
+    * Lines are also broken at every newline.
+    *
+    * $alignment$ defaults to $Left$. When no width is given, the lines are
+    * aligned to the widest one.
+    *
+    * @raise TextLayout_error if $width$ is not positive
+    * @raise OgamlUtils.UTF8String.UTF8_error if $text$ is not valid UTF-8 *)
+  val create :
+    font : Font.t ->
+    size : int ->
+    ?bold : bool ->
+    ?sdf : bool ->
+    ?width : float ->
+    ?alignment : alignment ->
+    text : string ->
+    unit -> t
+
+  (** Returns the number of quads of a layout (spaces and newlines
+    * have none) *)
+  val glyphs : t -> int
+
+  (** Returns the quads of a layout, 8 floats per quad : the position
+    * (top-left corner) and size of the quad relative to the origin of the
+    * first line, followed by its rectangle in the font's texture (in pixels).
+    * Y coordinates increase downwards. *)
+  val quads : t -> float array
+
+  (** Returns the index in the string (in code points) of the
+    * character of each quad *)
+  val indices : t -> int array
+
+  (** Returns the number of lines of a layout *)
+  val lines : t -> int
+
+  (** Returns the position of the pen after the last character, relative
+    * to the origin of the first line *)
+  val advance : t -> OgamlMath.Vector2f.t
+
+  (** Returns the size of a layout, from the ascent of its first line to
+    * the descent of its last line *)
+  val size : t -> OgamlMath.Vector2f.t
+
+  (** $boundaries layout position$ returns the rectangle containing a
+    * layout whose first line starts at $position$ *)
+  val boundaries : t -> OgamlMath.Vector2f.t -> OgamlMath.FloatRect.t
+
+  (** $to_source layout ~position ~color source$ outputs the triangles of a
+    * layout to a vertex source (see $Text.to_source$) *)
+  val to_source :
+    t -> position : OgamlMath.Vector2f.t -> color : Color.t ->
+    VertexArray.SimpleVertex.T.s VertexArray.VertexSource.t -> unit
+
+  (** Returns the maximal number of strings in the cache (defaults to 256) *)
+  val cache_capacity : unit -> int
+
+  (** Sets the maximal number of strings in the cache. A capacity of 0
+    * disables the cache.
+    * @raise TextLayout_error if the capacity is negative *)
+  val set_cache_capacity : int -> unit
+
+  (** Returns the number of strings in the cache *)
+  val cached : unit -> int
+
+  (** Empties the cache *)
+  val clear_cache : unit -> unit
+
+end
+
+
 (** Text rendering *)
 module Text : sig
 
@@ -2315,7 +3050,17 @@ module Text : sig
   (** The type of pre-rendered texts. *)
   type t
 
-  (** Creates a drawable text from the given string. *)
+  (** Creates a drawable text from the given string.
+    *
+    * If $sdf$ is true (defaults to false), the text is drawn from the
+    * distance field glyphs of the font, which are shared by every size.
+    *
+    * $outline$ and $glow$ respectively give the color and width in pixels of
+    * an outline and of a glow around the glyphs, and imply $sdf$. Their
+    * widths are limited to $Font.sdf_range * size / Font.sdf_size$.
+    *
+    * $width$ and $alignment$ break and align the lines of the text
+    * (see $TextLayout.create$). *)
   val create :
     text : string ->
     position : OgamlMath.Vector2f.t ->
@@ -2323,9 +3068,15 @@ module Text : sig
     ?color : Color.t ->
     size : int ->
     ?bold : bool ->
+    ?sdf : bool ->
+    ?outline : (Color.t * float) ->
+    ?glow : (Color.t * float) ->
+    ?width : float ->
+    ?alignment : TextLayout.alignment ->
     unit -> t
 
-  (** Draws text on the screen. *)
+  (** Draws text on the screen. The vertices of a text are uploaded on its
+    * first draw and kept on the GPU. *)
   val draw :
     (module RenderTarget.T with type t = 'a) ->
     ?parameters : DrawParameter.t ->
@@ -23,6 +23,10 @@ module Uniform : sig
     * used internally *)
   val location : t -> GL.Program.u_location
 
+  (** Returns the number of elements of a uniform array (1 for other
+    * uniforms) *)
+  val size : t -> int
+
 end
 
 
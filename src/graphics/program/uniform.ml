@@ -16,6 +16,7 @@ type uniform =
   | Int       of int
   | Texture2DArray of (int option * Texture.Texture2DArray.t)
   | Cubemap   of (int option * Texture.Cubemap.t)
+  | Matrix3DArray of (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
 
 module UniformMap = Map.Make (struct
 
@@ -53,6 +54,12 @@ let matrix3D s mat m =
   assert_free m s;
   UniformMap.add s (Matrix3D mat) m
 
+let matrix3D_array s data m =
+  assert_free m s;
+  if Bigarray.Array1.dim data mod 16 <> 0 then
+    error "Uniform %s : the size of a matrix array must be a multiple of 16" s;
+  UniformMap.add s (Matrix3DArray data) m
+
 let matrix2D s mat m = 
   assert_free m s;
   UniformMap.add s (Matrix2D mat) m
@@ -129,9 +136,15 @@ module LL = struct
           OgamlMath.Matrix3D.(
             GL.Uniform.mat4 location (GL.Data.of_bigarray (to_bigarray m))
           )
+      | Matrix3DArray d, GLTypes.GlslType.Float4x4 ->
+          let n = Bigarray.Array1.dim d / 16 in
+          if n > Program.Uniform.size u then
+            error "Uniform %s has %i matrices, the program expects at most %i"
+              name n (Program.Uniform.size u);
+          if n > 0 then GL.Uniform.mat4v location n (GL.Data.of_bigarray d)
       | Matrix2D m, GLTypes.GlslType.Float3x3 -> 
           OgamlMath.Matrix2D.(
-            GL.Uniform.mat4 location (GL.Data.of_bigarray (to_bigarray m))
+            GL.Uniform.mat3 location (GL.Data.of_bigarray (to_bigarray m))
           )
       | Color    c, GLTypes.GlslType.Float4   -> 
           Color.RGB.(
@@ -33,6 +33,9 @@ val float : string -> float -> t -> t
 (** Adds a matrix3D to a uniform structure *)
 val matrix3D : string -> OgamlMath.Matrix3D.t -> t -> t
 
+(** Adds an array of matrix3D, given as 16 floats per matrix, to a uniform structure *)
+val matrix3D_array : string -> (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> t -> t
+
 (** Adds a matrix2D to a uniform structure *)
 val matrix2D : string -> OgamlMath.Matrix2D.t -> t -> t
 
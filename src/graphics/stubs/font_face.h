@@ -0,0 +1,24 @@
+#ifndef CAML_FONT_FACE_HEADER
+#define CAML_FONT_FACE_HEADER
+
+#include <stddef.h>
+#include <caml/custom.h>
+#include "stb_truetype.h"
+
+/* A font file mapped read-only in memory, shared by all the fonts loaded
+ * from the same file. The mapping is never written to, so the stb functions
+ * can read it from several threads at once. */
+typedef struct font_face {
+  stbtt_fontinfo info;
+  unsigned char* data;
+  size_t size;
+  unsigned long long dev, ino;  /* Identity of the file */
+  int refcount;
+  struct font_face* next;
+} font_face;
+
+#define Face_val(v) (*((font_face**)Data_custom_val(v)))
+
+#define Info_val(v) (&Face_val(v)->info)
+
+#endif
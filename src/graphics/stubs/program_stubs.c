@@ -311,6 +311,24 @@ caml_uniform_type(value id, value index)
 }
 
 
+// INPUT   : a program id, a uniform index
+// OUTPUT  : the number of elements of the uniform (1 if it is not an array)
+CAMLprim value
+caml_uniform_size(value id, value index)
+{
+  CAMLparam2(id,index);
+
+  GLsizei tmp_len;
+  GLint   tmp_size;
+  GLenum  tmp_type;
+  GLchar  tmp_name;
+
+  glGetActiveUniform(PROGRAM(id), Int_val(index), 0, &tmp_len, &tmp_size, &tmp_type, &tmp_name);
+
+  CAMLreturn(Val_int(tmp_size));
+}
+
+
 // INPUT   : a program id, an attribute index
 // OUTPUT  : the type of the attribute
 CAMLprim value
@@ -0,0 +1,367 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include <caml/signals.h>
+#include "stb_truetype.h"
+#include "font_face.h"
+
+
+/* Multi-channel signed distance fields of glyph outlines.
+ *
+ * Curves are flattened into segments in pixel coordinates. The edges of each
+ * contour are split at its corners and colored so that the two edges meeting
+ * at a corner only share one channel : the median of the three channels then
+ * keeps the corner sharp when the field is interpolated. The alpha channel
+ * holds the true signed distance, which is better suited to effects that
+ * reach far from the outline (outlines, glows). */
+
+#define SDF_RED   1
+#define SDF_GREEN 2
+#define SDF_BLUE  4
+#define SDF_WHITE 7
+
+#define SDF_CYAN    (SDF_GREEN | SDF_BLUE)
+#define SDF_MAGENTA (SDF_RED | SDF_BLUE)
+#define SDF_YELLOW  (SDF_RED | SDF_GREEN)
+
+#define SDF_CURVE_STEPS 8
+
+/* Sine of the smallest angle between two edges considered a corner */
+#define SDF_CORNER_CROSS 0.14112f
+
+typedef struct {
+  float x0, y0, x1, y1;
+  int color;
+  int first;  /* The segment starts an edge of the outline */
+  int last;   /* The segment ends an edge of the outline */
+} sdf_segment;
+
+typedef struct {
+  int start, count;       /* Segments of the edge */
+  float dx0, dy0;         /* Direction at the start of the edge */
+  float dx1, dy1;         /* Direction at the end of the edge */
+} sdf_edge;
+
+
+static int sdf_is_corner(float ax, float ay, float bx, float by)
+{
+  float la = sqrtf(ax * ax + ay * ay);
+  float lb = sqrtf(bx * bx + by * by);
+  if(la == 0.f || lb == 0.f)
+    return 0;
+  ax /= la; ay /= la;
+  bx /= lb; by /= lb;
+  return ax * bx + ay * by <= 0.f || fabsf(ax * by - ay * bx) > SDF_CORNER_CROSS;
+}
+
+
+static void sdf_color_range(sdf_segment* segs, sdf_edge* edges, int from, int to, int color)
+{
+  int i, j;
+  for(i = from; i < to; i++)
+    for(j = 0; j < edges[i].count; j++)
+      segs[edges[i].start + j].color = color;
+}
+
+
+/* Colors the edges edges[0..n) of a closed contour */
+static void sdf_color_contour(sdf_segment* segs, sdf_edge* edges, int n, int* corners)
+{
+  static const int cycle[3] = {SDF_CYAN, SDF_MAGENTA, SDF_YELLOW};
+  int i, k, ncorners = 0;
+
+  for(i = 0; i < n; i++) {
+    sdf_edge* prev = &edges[(i + n - 1) % n];
+    if(sdf_is_corner(prev->dx1, prev->dy1, edges[i].dx0, edges[i].dy0))
+      corners[ncorners++] = i;
+  }
+
+  if(ncorners == 0) {
+    /* Smooth contour : every channel sees the same distance */
+    sdf_color_range(segs, edges, 0, n, SDF_WHITE);
+  }
+  else if(ncorners == 1) {
+    /* Teardrop : the segments are split in three around the corner */
+    int total = 0, seen = 0;
+    for(i = 0; i < n; i++)
+      total += edges[i].count;
+    for(k = 0; k < n; k++) {
+      sdf_edge* e = &edges[(corners[0] + k) % n];
+      for(i = 0; i < e->count; i++, seen++) {
+        int third = (3 * seen) / total;
+        segs[e->start + i].color =
+          (total < 3) ? SDF_WHITE :
+          (third == 0) ? SDF_CYAN :
+          (third == 1) ? SDF_WHITE : SDF_MAGENTA;
+      }
+    }
+  }
+  else {
+    /* The color changes at each corner. The last spline also meets the
+     * first one, so it takes the color used by neither of its neighbours. */
+    for(k = 0; k < ncorners; k++) {
+      int from  = corners[k];
+      int to    = (k + 1 < ncorners) ? corners[k + 1] : corners[0] + n;
+      int color = cycle[k % 3];
+      if(k == ncorners - 1 && k % 3 == 0)
+        color = cycle[1];
+      for(i = from; i < to; i++)
+        sdf_color_range(segs, edges, i % n, i % n + 1, color);
+    }
+  }
+}
+
+
+/* Flattens the outline of a glyph. Returns the number of segments. */
+static int sdf_flatten(stbtt_vertex* verts, int nverts, float scale, float ox, float oy,
+                       sdf_segment* segs, sdf_edge* edges, int* corners)
+{
+  int i, j, nsegs = 0, nedges = 0, contour = 0;
+  float px = 0.f, py = 0.f;
+
+  for(i = 0; i <= nverts; i++) {
+    if(i == nverts || verts[i].type == STBTT_vmove) {
+      if(nedges > contour)
+        sdf_color_contour(segs, edges + contour, nedges - contour, corners);
+      contour = nedges;
+      if(i == nverts)
+        break;
+      px = verts[i].x * scale + ox;
+      py = oy - verts[i].y * scale;
+    }
+    else {
+      float x = verts[i].x * scale + ox;
+      float y = oy - verts[i].y * scale;
+      sdf_edge* e = &edges[nedges];
+      if(verts[i].type == STBTT_vline) {
+        if(x == px && y == py)
+          continue;
+        e->start = nsegs;
+        e->count = 1;
+        e->dx0 = e->dx1 = x - px;
+        e->dy0 = e->dy1 = y - py;
+        segs[nsegs].x0 = px; segs[nsegs].y0 = py;
+        segs[nsegs].x1 = x;  segs[nsegs].y1 = y;
+        nsegs++;
+      }
+      else {
+        float cx = verts[i].cx * scale + ox;
+        float cy = oy - verts[i].cy * scale;
+        float lx = px, ly = py;
+        if(x == px && y == py && cx == px && cy == py)
+          continue;
+        e->start = nsegs;
+        e->count = SDF_CURVE_STEPS;
+        e->dx0 = (cx != px || cy != py) ? cx - px : x - px;
+        e->dy0 = (cx != px || cy != py) ? cy - py : y - py;
+        e->dx1 = (cx != x || cy != y) ? x - cx : x - px;
+        e->dy1 = (cx != x || cy != y) ? y - cy : y - py;
+        for(j = 1; j <= SDF_CURVE_STEPS; j++) {
+          float t = (float)j / SDF_CURVE_STEPS;
+          float u = 1.f - t;
+          float qx = u * u * px + 2.f * u * t * cx + t * t * x;
+          float qy = u * u * py + 2.f * u * t * cy + t * t * y;
+          segs[nsegs].x0 = lx; segs[nsegs].y0 = ly;
+          segs[nsegs].x1 = qx; segs[nsegs].y1 = qy;
+          lx = qx; ly = qy;
+          nsegs++;
+        }
+      }
+      for(j = e->start; j < nsegs; j++) {
+        segs[j].first = (j == e->start);
+        segs[j].last  = (j == nsegs - 1);
+        segs[j].color = SDF_WHITE;
+      }
+      nedges++;
+      px = x;
+      py = y;
+    }
+  }
+  return nsegs;
+}
+
+
+static float sdf_median(float a, float b, float c)
+{
+  return fmaxf(fminf(a, b), fminf(fmaxf(a, b), c));
+}
+
+
+static unsigned char sdf_encode(float d, float range)
+{
+  float v = 0.5f + d / (2.f * range);
+  if(v < 0.f) v = 0.f;
+  if(v > 1.f) v = 1.f;
+  return (unsigned char)(v * 255.f + 0.5f);
+}
+
+
+/* Renders the field of a glyph into an RGBA buffer of size w * h. Pixel
+ * (x,y) has its center at (x + 0.5, y + 0.5) in segment coordinates. */
+static void sdf_render(sdf_segment* segs, int nsegs, unsigned char* out, int w, int h, float range)
+{
+  int x, y, i, c;
+  float area = 0.f, orient;
+
+  for(i = 0; i < nsegs; i++)
+    area += segs[i].x0 * segs[i].y1 - segs[i].x1 * segs[i].y0;
+  orient = (area >= 0.f) ? 1.f : -1.f;
+
+  for(y = 0; y < h; y++) {
+    for(x = 0; x < w; x++) {
+      float p[2] = {x + 0.5f, y + 0.5f};
+      float best[3]  = {1e30f, 1e30f, 1e30f};
+      float ortho[3] = {2.f, 2.f, 2.f};
+      int   seg[3]   = {-1, -1, -1};
+      float tru = 1e30f, chan[3], sd, m;
+      int winding = 0;
+      unsigned char* o = out + 4 * (y * w + x);
+
+      for(i = 0; i < nsegs; i++) {
+        sdf_segment* s = &segs[i];
+        float dx = s->x1 - s->x0, dy = s->y1 - s->y0;
+        float len2 = dx * dx + dy * dy;
+        float t, qx, qy, d, dot = 0.f;
+
+        if(len2 == 0.f)
+          continue;
+
+        /* Nonzero winding along a horizontal ray */
+        if((s->y0 <= p[1]) != (s->y1 <= p[1])) {
+          float ix = s->x0 + (p[1] - s->y0) * dx / dy;
+          if(ix > p[0])
+            winding += (s->y1 > s->y0) ? 1 : -1;
+        }
+
+        t = ((p[0] - s->x0) * dx + (p[1] - s->y0) * dy) / len2;
+        if(t < 0.f) t = 0.f;
+        if(t > 1.f) t = 1.f;
+        qx = p[0] - (s->x0 + t * dx);
+        qy = p[1] - (s->y0 + t * dy);
+        d  = sqrtf(qx * qx + qy * qy);
+        if(d < tru)
+          tru = d;
+
+        /* Two segments sharing a vertex are equally close to the points
+         * beyond it : the one the point lies the most in front of wins */
+        if((t == 0.f || t == 1.f) && d > 0.f)
+          dot = fabsf(qx * dx + qy * dy) / (d * sqrtf(len2));
+
+        for(c = 0; c < 3; c++) {
+          if(!(s->color & (1 << c)))
+            continue;
+          if(d < best[c] - 1e-5f || (d <= best[c] + 1e-5f && dot < ortho[c])) {
+            best[c]  = d;
+            ortho[c] = dot;
+            seg[c]   = i;
+          }
+        }
+      }
+
+      /* Pseudo-distances : the distance to the line extending an edge, for
+       * the points beyond its ends */
+      for(c = 0; c < 3; c++) {
+        sdf_segment* s;
+        float dx, dy, len, t, cross;
+        if(seg[c] < 0) {
+          chan[c] = -range;
+          continue;
+        }
+        s = &segs[seg[c]];
+        dx = s->x1 - s->x0;
+        dy = s->y1 - s->y0;
+        len = sqrtf(dx * dx + dy * dy);
+        t = ((p[0] - s->x0) * dx + (p[1] - s->y0) * dy) / (len * len);
+        cross = (dx * (p[1] - s->y0) - dy * (p[0] - s->x0)) / len;
+        if((t < 0.f && s->first) || (t > 1.f && s->last))
+          chan[c] = orient * cross;
+        else
+          chan[c] = (orient * cross >= 0.f) ? best[c] : -best[c];
+      }
+
+      sd = (winding != 0) ? tru : -tru;
+
+      /* Overlapping contours and stray pseudo-distances can flip the median :
+       * such pixels fall back to the true distance */
+      m = sdf_median(chan[0], chan[1], chan[2]);
+      if((m > 0.f) != (sd > 0.f) && fabsf(sd) > 0.5f)
+        chan[0] = chan[1] = chan[2] = sd;
+
+      o[0] = sdf_encode(chan[0], range);
+      o[1] = sdf_encode(chan[1], range);
+      o[2] = sdf_encode(chan[2], range);
+      o[3] = sdf_encode(sd, range);
+    }
+  }
+}
+
+
+// INPUT   : a font, a code point, a scale and a distance range in pixels
+// OUTPUT  : the RGBA distance field of the glyph, its size, and the offset of
+//           its top-left corner from the origin of the glyph
+CAMLprim value
+caml_stb_sdf_bitmap(value info, value code, value scale, value range)
+{
+  CAMLparam4(info, code, scale, range);
+  CAMLlocal2(res, bmp);
+
+  stbtt_fontinfo* stb_info = Info_val(info);
+  int stb_code = Int_val(code);
+  float stb_scale = Double_val(scale);
+  float stb_range = Double_val(range);
+  int pad = (int)ceilf(stb_range);
+
+  stbtt_vertex* verts = NULL;
+  int nverts;
+
+  int ix0 = 0, iy0 = 0, ix1 = 0, iy1 = 0;
+  int width = 0, height = 0;
+  unsigned char* bitmap = NULL;
+
+  /* Computed without the runtime lock, see caml_stb_render_bitmap */
+  caml_enter_blocking_section();
+
+  nverts = stbtt_GetCodepointShape(stb_info, stb_code, &verts);
+
+  if(nverts > 0) {
+    sdf_segment* segs  = malloc(nverts * SDF_CURVE_STEPS * sizeof(sdf_segment));
+    sdf_edge*    edges = malloc(nverts * sizeof(sdf_edge));
+    int*       corners = malloc(nverts * sizeof(int));
+    int nsegs;
+
+    stbtt_GetCodepointBitmapBox(stb_info, stb_code, stb_scale, stb_scale,
+                                &ix0, &iy0, &ix1, &iy1);
+    width  = ix1 - ix0 + 2 * pad;
+    height = iy1 - iy0 + 2 * pad;
+
+    nsegs  = sdf_flatten(verts, nverts, stb_scale,
+                         (float)(pad - ix0), (float)(pad - iy0),
+                         segs, edges, corners);
+    bitmap = malloc(width * height * 4);
+    sdf_render(segs, nsegs, bitmap, width, height, stb_range);
+
+    free(segs);
+    free(edges);
+    free(corners);
+    stbtt_FreeShape(stb_info, verts);
+  }
+
+  caml_leave_blocking_section();
+
+  res = caml_alloc(5, 0);
+
+  bmp = caml_alloc_string(width * height * 4);
+  if(bitmap) {
+    memcpy((char*)String_val(bmp), bitmap, width * height * 4);
+    free(bitmap);
+  }
+
+  Store_field(res, 0, bmp);
+  Store_field(res, 1, Val_int(width));
+  Store_field(res, 2, Val_int(height));
+  Store_field(res, 3, Val_int(ix0 - pad));
+  Store_field(res, 4, Val_int(iy0 - pad));
+
+  CAMLreturn(res);
+}
@@ -1,33 +1,166 @@
 #include <caml/bigarray.h>
+#include <caml/signals.h>
 #include "utils.h"
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
 #define STB_TRUETYPE_IMPLEMENTATION
-#include "stb_truetype.h"
+#include "font_face.h"
 
 
-CAMLprim value
-caml_stb_load_font(value filename)
+/* Faces are registered by file identity. The registry is only accessed
+ * with the runtime lock held (from loads and finalizers). */
+static font_face* faces = NULL;
+
+
+static int map_file(const char* filename, font_face* face)
 {
-  CAMLparam1(filename);
+#if defined(_WIN32)
+  BY_HANDLE_FILE_INFORMATION file_info;
+  LARGE_INTEGER size;
+  HANDLE mapping;
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return 0;
+  if(!GetFileInformationByHandle(file, &file_info) || !GetFileSizeEx(file, &size)
+     || size.QuadPart == 0) {
+    CloseHandle(file);
+    return 0;
+  }
+  face->dev  = file_info.dwVolumeSerialNumber;
+  face->ino  = ((unsigned long long)file_info.nFileIndexHigh << 32) | file_info.nFileIndexLow;
+  face->size = (size_t)size.QuadPart;
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if(mapping == NULL)
+    return 0;
+  face->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  return face->data != NULL;
+#else
+  struct stat st;
+  void* data;
+  int fd = open(filename, O_RDONLY);
+  if(fd < 0)
+    return 0;
+  if(fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED)
+    return 0;
+  face->dev  = st.st_dev;
+  face->ino  = st.st_ino;
+  face->size = st.st_size;
+  face->data = data;
+  return 1;
+#endif
+}
 
-  long size;
-  unsigned char* fontBuffer;
-  FILE* fontFile = fopen(String_val(filename), "rb");
-  stbtt_fontinfo* info;
 
-  fseek(fontFile, 0, SEEK_END);
-  size = ftell(fontFile);
-  fseek(fontFile, 0, SEEK_SET);
+static void unmap_file(font_face* face)
+{
+#if defined(_WIN32)
+  UnmapViewOfFile(face->data);
+#else
+  munmap(face->data, face->size);
+#endif
+}
 
-  fontBuffer = malloc(size);
 
-  fread(fontBuffer, size, 1, fontFile);
-  fclose(fontFile);
+/* stb_truetype trusts the table directory of the file, whose offsets could
+ * point past the end of the mapping */
+static int check_tables(const unsigned char* data, size_t size)
+{
+  size_t i, n;
+  if(size < 12)
+    return 0;
+  n = data[4] * 256 + data[5];
+  if(12 + 16 * n > size)
+    return 0;
+  for(i = 0; i < n; i++) {
+    const unsigned char* rec = data + 12 + 16 * i;
+    size_t offset = ((size_t)rec[8]  << 24) | (rec[9]  << 16) | (rec[10] << 8) | rec[11];
+    size_t length = ((size_t)rec[12] << 24) | (rec[13] << 16) | (rec[14] << 8) | rec[15];
+    if(offset > size || length > size - offset)
+      return 0;
+  }
+  return 1;
+}
 
-  info = malloc(sizeof(stbtt_fontinfo));
-  if (stbtt_InitFont(info, fontBuffer, 0) == 0)
-    info = NULL;
 
-  CAMLreturn((value)info);
+static void release_face(value v)
+{
+  font_face* face = Face_val(v);
+  font_face** prev = &faces;
+  if(face == NULL || --face->refcount > 0)
+    return;
+  while(*prev != face)
+    prev = &(*prev)->next;
+  *prev = face->next;
+  unmap_file(face);
+  free(face);
+}
+
+
+static struct custom_operations face_ops = {
+  "ogaml.font_face",
+  release_face,
+  custom_compare_default,
+  custom_hash_default,
+  custom_serialize_default,
+  custom_deserialize_default,
+  custom_compare_ext_default
+};
+
+
+// INPUT   a file name
+// OUTPUT  a face sharing the mapping of the file with the other faces loaded
+//         from it, or an invalid face if the file is not a valid font
+CAMLprim value
+caml_stb_load_font(value filename)
+{
+  CAMLparam1(filename);
+  CAMLlocal1(res);
+
+  font_face tmp;
+  font_face* face = NULL;
+
+  /* Allocate first: the allocation may finalize a dead face of the registry,
+   * which must not happen between the lookup and the reference count bump */
+  res = caml_alloc_custom(&face_ops, sizeof(font_face*), 0, 1);
+  Face_val(res) = NULL;
+
+  if(map_file(String_val(filename), &tmp)) {
+    face = faces;
+    while(face != NULL && (face->dev != tmp.dev || face->ino != tmp.ino))
+      face = face->next;
+    if(face != NULL) {
+      unmap_file(&tmp);
+    } else if(check_tables(tmp.data, tmp.size) && stbtt_InitFont(&tmp.info, tmp.data, 0)) {
+      face = malloc(sizeof(font_face));
+      *face = tmp;
+      face->refcount = 0;
+      face->next = faces;
+      faces = face;
+    } else {
+      unmap_file(&tmp);
+    }
+  }
+
+  Face_val(res) = face;
+  if(face != NULL)
+    face->refcount++;
+
+  CAMLreturn(res);
 }
 
 
@@ -35,7 +168,7 @@ CAMLprim value
 caml_stb_isvalid(value info)
 {
   CAMLparam1(info);
-  CAMLreturn(Val_bool((stbtt_fontinfo*)info != NULL));
+  CAMLreturn(Val_bool(Face_val(info) != NULL));
 }
 
 
@@ -45,7 +178,7 @@ caml_stb_kern_advance(value info, value c1, value c2)
   CAMLparam3(info, c1, c2);
   CAMLreturn(
     Val_int(
-      stbtt_GetCodepointKernAdvance((stbtt_fontinfo*)info, 
+      stbtt_GetCodepointKernAdvance(Info_val(info), 
                                               Int_val(c1), 
                                               Int_val(c2))
     )
@@ -59,7 +192,7 @@ caml_stb_scale(value info, value px)
   CAMLparam2(info, px);
   CAMLreturn(
     caml_copy_double(
-      stbtt_ScaleForPixelHeight((stbtt_fontinfo*)info, 
+      stbtt_ScaleForPixelHeight(Info_val(info), 
                                           Int_val(px))
     )
   );
@@ -73,7 +206,7 @@ caml_stb_metrics(value info)
   CAMLlocal1(res);
 
   int ascent, descent, linegap;
-  stbtt_GetFontVMetrics((stbtt_fontinfo*)info, &ascent, &descent, &linegap);
+  stbtt_GetFontVMetrics(Info_val(info), &ascent, &descent, &linegap);
 
   res = caml_alloc(3, 0);
   Store_field(res, 0, Val_int(ascent));
@@ -90,7 +223,7 @@ caml_stb_hmetrics(value info, value code)
   CAMLparam2(info, code);
   
   int advance, bearing;
-  stbtt_GetCodepointHMetrics((stbtt_fontinfo*)info, Int_val(code), &advance, &bearing);
+  stbtt_GetCodepointHMetrics(Info_val(info), Int_val(code), &advance, &bearing);
 
   CAMLreturn(Int_pair(advance,bearing));
 }
@@ -103,7 +236,7 @@ caml_stb_box(value info, value code)
   CAMLlocal1(res);
 
   int x0, y0, x1, y1;
-  if(!stbtt_GetCodepointBox((stbtt_fontinfo*)info, Int_val(code), &x0, &y0, &x1, &y1)) {
+  if(!stbtt_GetCodepointBox(Info_val(info), Int_val(code), &x0, &y0, &x1, &y1)) {
     x0 = 0;
     y0 = 0;
     x1 = 0;
@@ -128,7 +261,7 @@ caml_stb_bitmap(value info, value code, value scale)
 
   int width, height, xoff, yoff;
 
-  unsigned char* bitmap = stbtt_GetCodepointBitmap((stbtt_fontinfo*)info, 
+  unsigned char* bitmap = stbtt_GetCodepointBitmap(Info_val(info), 
                                                        Double_val(scale), 
                                                        Double_val(scale), 
                                                            Int_val(code),
@@ -165,7 +298,7 @@ caml_stb_render_bitmap(value info, value code, value oversampling, value scale)
   CAMLparam4(info, code, oversampling, scale);
   CAMLlocal2(res, bmp);
 
-  stbtt_fontinfo* stb_info = (stbtt_fontinfo*)info;
+  stbtt_fontinfo* stb_info = Info_val(info);
   int stb_code = Int_val(code);
   int stb_oversampling = Int_val(oversampling);
   float stb_scale = Double_val(scale);
@@ -175,7 +308,11 @@ caml_stb_render_bitmap(value info, value code, value oversampling, value scale)
   int width, height;
 
   unsigned char* bitmap;
-  
+
+  /* The face is not managed by the GC, so glyphs are rasterized without the
+   * runtime lock, in parallel with the other threads */
+  caml_enter_blocking_section();
+
   stbtt_GetCodepointBitmapBox(stb_info, 
                               stb_code,
                               stb_scale * stb_oversampling,
@@ -217,6 +354,8 @@ caml_stb_render_bitmap(value info, value code, value oversampling, value scale)
                        stb_oversampling);
   }
 
+  caml_leave_blocking_section();
+
   res = caml_alloc(3,0);
   
   bmp = caml_alloc_string(width * height);
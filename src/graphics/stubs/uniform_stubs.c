@@ -156,6 +156,15 @@ caml_uniform_mat4(value loc, value dat)
 }
 
 
+CAMLprim value
+caml_uniform_mat4v(value loc, value count, value dat)
+{
+  CAMLparam3(loc,count,dat);
+  glUniformMatrix4fv((GLuint)Int_val(loc), Int_val(count), GL_FALSE, (GLfloat*)Caml_ba_data_val(dat));
+  CAMLreturn(Val_unit);
+}
+
+
 CAMLprim value
 caml_uniform_mat23(value loc, value dat)
 {
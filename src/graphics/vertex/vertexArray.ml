@@ -8,6 +8,8 @@ module Vertex = struct
 
   exception Unbound_attribute of string
 
+  exception Invalid_value of string
+
   module AttributeVal = struct
 
     type s = 
@@ -19,11 +21,16 @@ module Vertex = struct
       | Vec2f of Vector2f.t
       | Vec3f of Vector3f.t
       | Color of Color.t
+      | UByte4 of (int * int * int * int)
+      | UNorm4 of (float * float * float * float)
 
+    (* Packed attributes take a single integer *)
     let fields = function
       | Unset -> 0
       | Int _  
-      | Float _ -> 1
+      | Float _
+      | UByte4 _
+      | UNorm4 _ -> 1
       | Vec2i _
       | Vec2f _ -> 2
       | Vec3i _
@@ -33,7 +40,9 @@ module Vertex = struct
     let is_int = function
       | Int _ 
       | Vec2i _
-      | Vec3i _ -> true
+      | Vec3i _
+      | UByte4 _
+      | UNorm4 _ -> true
       | _ -> false
 
   end
@@ -48,6 +57,8 @@ module Vertex = struct
       | Vec2f
       | Vec3f
       | Color
+      | UByte4
+      | UNorm4
 
     let int = Int
 
@@ -63,6 +74,10 @@ module Vertex = struct
 
     let color = Color
 
+    let u8x4 = UByte4
+
+    let unorm8x4 = UNorm4
+
     let value_of (v : 'a) (t : 'a s) = 
       match t with
       | Int   -> AttributeVal.Int (Obj.magic v)
@@ -72,6 +87,8 @@ module Vertex = struct
       | Vec2f -> AttributeVal.Vec2f (Obj.magic v)
       | Vec3f -> AttributeVal.Vec3f (Obj.magic v)
       | Color -> AttributeVal.Color (Obj.magic v)
+      | UByte4 -> AttributeVal.UByte4 (Obj.magic v)
+      | UNorm4 -> AttributeVal.UNorm4 (Obj.magic v)
 
     let unbox (v : AttributeVal.s) (t : 'a s) : 'a =
       match v with
@@ -83,6 +100,8 @@ module Vertex = struct
       | AttributeVal.Vec2f f -> (Obj.magic f)
       | AttributeVal.Vec3f f -> (Obj.magic f)
       | AttributeVal.Color f -> (Obj.magic f)
+      | AttributeVal.UByte4 f -> (Obj.magic f)
+      | AttributeVal.UNorm4 f -> (Obj.magic f)
 
     let to_glsl (t : 'a s) = 
       match t with
@@ -93,11 +112,14 @@ module Vertex = struct
       | Vec2f -> GLTypes.GlslType.Float2
       | Vec3f -> GLTypes.GlslType.Float3
       | Color -> GLTypes.GlslType.Float4
+      | UByte4 -> GLTypes.GlslType.Int4
+      | UNorm4 -> GLTypes.GlslType.Float4
 
     let glsl_size = function
       | GLTypes.GlslType.Int    -> 1
       | GLTypes.GlslType.Int2   -> 2
       | GLTypes.GlslType.Int3   -> 3
+      | GLTypes.GlslType.Int4   -> 4
       | GLTypes.GlslType.Float  -> 1
       | GLTypes.GlslType.Float2 -> 2
       | GLTypes.GlslType.Float3 -> 3
@@ -107,7 +129,8 @@ module Vertex = struct
     let glsl_is_int = function
       | GLTypes.GlslType.Int 
       | GLTypes.GlslType.Int2
-      | GLTypes.GlslType.Int3   -> true
+      | GLTypes.GlslType.Int3
+      | GLTypes.GlslType.Int4   -> true
       | _ -> false
 
     let fields t =
@@ -116,6 +139,20 @@ module Vertex = struct
     let is_int t =
       glsl_is_int (to_glsl t)
 
+    (* Four bytes packed in an int32, the first component in the lowest
+     * byte. On little-endian hosts, the bytes are in memory order. *)
+    let pack a b c d =
+      Int32.logor (Int32.shift_left (Int32.of_int d) 24)
+        (Int32.of_int (a lor (b lsl 8) lor (c lsl 16)))
+
+    let byte v k =
+      Int32.to_int (Int32.logand (Int32.shift_right_logical v (8 * k)) 0xffl)
+
+    let quantize f =
+      if f <= 0. then 0
+      else if f >= 1. then 255
+      else truncate (f *. 255. +. 0.5)
+
   end
 
   type 'a vertex =
@@ -156,12 +193,25 @@ module Vertex = struct
     match attrib with
     | Boxed_Attrib a -> AttributeType.to_glsl a.atype
 
+  let packing_of attrib =
+    match attrib with
+    | Boxed_Attrib {atype = AttributeType.UByte4; _} -> `Integer
+    | Boxed_Attrib {atype = AttributeType.UNorm4; _} -> `Normalized
+    | Boxed_Attrib _ -> `None
+
   module Attribute = struct
 
     type ('a, 'b) s = ('a, 'b) attrib
 
     let set (vtx : 'b t) (attr : ('a, 'b) s) (vl : 'a) : unit = 
-      vtx.data.(attr.aoffset) <- (AttributeType.value_of vl attr.atype)
+      let v = AttributeType.value_of vl attr.atype in
+      begin match v with
+      | AttributeVal.UByte4 (a, b, c, d) ->
+        if a land 0xff <> a || b land 0xff <> b || c land 0xff <> c || d land 0xff <> d then
+          raise (Invalid_value (Printf.sprintf "Attribute %s : components must be in [0;255]" attr.aname))
+      | _ -> ()
+      end;
+      vtx.data.(attr.aoffset) <- v
 
     let get (vtx : 'b t) (attr : ('a, 'b) s) : 'a =
       match vtx.data.(attr.aoffset) with
@@ -274,6 +324,47 @@ module SimpleVertex = struct
 end
 
 
+module SkinnedVertex = struct
+
+  module T = (val Vertex.make () : Vertex.VERTEX)
+
+  let position =
+    T.attribute "position" Vertex.AttributeType.vector3f
+
+  let color =
+    T.attribute "color" Vertex.AttributeType.color
+
+  let uv =
+    T.attribute "uv" Vertex.AttributeType.vector2f
+
+  let normal = 
+    T.attribute "normal" Vertex.AttributeType.vector3f
+
+  let joints =
+    T.attribute "joints" Vertex.AttributeType.u8x4
+
+  let weights =
+    T.attribute "weights" Vertex.AttributeType.unorm8x4
+
+  let () = 
+    T.seal ()
+
+  let create ?position:pp ?color:cl ?uv:tc ?normal:nr ?joints:jt ?weights:wt () = 
+    let vtx = T.create () in
+    let set attr = function
+      | None   -> ()
+      | Some v -> Vertex.Attribute.set vtx attr v
+    in
+    set position pp;
+    set color cl;
+    set uv tc;
+    set normal nr;
+    set joints jt;
+    set weights wt;
+    vtx
+
+end
+
 module VertexSource = struct
 
   exception Uninitialized_field of string
@@ -363,6 +454,11 @@ module VertexSource = struct
         GL.Data.add_3i src.idata v
       | Vertex.AttributeVal.Color v ->
         GL.Data.add_color src.fdata v
+      | Vertex.AttributeVal.UByte4 (a, b, c, d) ->
+        GL.Data.add_int32 src.idata (Vertex.AttributeType.pack a b c d)
+      | Vertex.AttributeVal.UNorm4 (a, b, c, d) ->
+        let q = Vertex.AttributeType.quantize in
+        GL.Data.add_int32 src.idata (Vertex.AttributeType.pack (q a) (q b) (q c) (q d))
     ) src.init_fields;
     src.length <- src.length + 1
 
@@ -469,6 +565,16 @@ module VertexSource = struct
             in
             vertex.Vertex.data.(aoffset) <- Vertex.AttributeVal.Vec3i v;
             (off_i + 3, off_f)
+          | Vertex.AttributeType.UByte4 ->
+            let p = GL.Data.get src.idata off_i in
+            let b = Vertex.AttributeType.byte p in
+            vertex.Vertex.data.(aoffset) <- Vertex.AttributeVal.UByte4 (b 0, b 1, b 2, b 3);
+            (off_i + 1, off_f)
+          | Vertex.AttributeType.UNorm4 ->
+            let p = GL.Data.get src.idata off_i in
+            let b k = float_of_int (Vertex.AttributeType.byte p k) /. 255. in
+            vertex.Vertex.data.(aoffset) <- Vertex.AttributeVal.UNorm4 (b 0, b 1, b 2, b 3);
+            (off_i + 1, off_f)
           end;
       ) (i_offset, f_offset) src.init_fields
       |> ignore;
@@ -604,6 +710,22 @@ let rebuild t src start =
   t.size_i <- max (lengthi + start_i) t.size_i;
   t.length <- VertexSource.length src + start
 
+(* Overwrites a range in place : the buffer is neither resized nor rebound *)
+let update t src start =
+  let dataf = src.VertexSource.fdata in
+  let datai = src.VertexSource.idata in
+  let lengthf = GL.Data.length dataf in
+  let lengthi = GL.Data.length datai in
+  if t.init_fields <> src.VertexSource.init_fields then
+    raise VertexSource.Incompatible_sources;
+  if start < 0 || start + VertexSource.length src > t.length then
+    raise (Out_of_bounds "Invalid vertex array bounds");
+  GL.VBO.bind (Some t.buffer);
+  GL.VBO.subdata (t.stride_f * start * 4) (lengthf * 4) dataf;
+  if lengthi > 0 then
+    GL.VBO.subdata ((t.size_f + t.stride_i * start) * 4) (lengthi * 4) datai;
+  GL.VBO.bind None
+
 let bind context t prog = 
   if t.bound <> Some prog then begin
     t.bound <- Some prog;
@@ -631,23 +753,38 @@ let bind context t prog =
               (Program.Attribute.name att)
             ));
         GL.VAO.enable_attrib (Program.Attribute.location att);
-        if Vertex.AttributeType.glsl_is_int typ then begin 
-          let offset = t.stride_i - offset in
+        (* Packed attributes are read as 4 bytes from the integer data *)
+        match Vertex.packing_of attrib with
+        | `Integer ->
           GL.VAO.attrib_int
-            (Program.Attribute.location att)
-            (Vertex.AttributeType.glsl_size typ)
-            (GLTypes.GlIntType.Int)
-            ((t.size_f + offset) * 4)
+            (Program.Attribute.location att) 4
+            (GLTypes.GlIntType.UByte)
+            ((t.size_f + t.stride_i - offset) * 4)
             (t.stride_i * 4)
-        end else begin
-          let offset = t.stride_f - offset in
-          GL.VAO.attrib_float 
-            (Program.Attribute.location att)
-            (Vertex.AttributeType.glsl_size typ)
-            (GLTypes.GlFloatType.Float)
-            (offset     * 4)
-            (t.stride_f * 4)
-        end
+        | `Normalized ->
+          GL.VAO.attrib_float
+            (Program.Attribute.location att) 4
+            (GLTypes.GlFloatType.UByte)
+            ((t.size_f + t.stride_i - offset) * 4)
+            (t.stride_i * 4)
+        | `None ->
+          if Vertex.AttributeType.glsl_is_int typ then begin 
+            let offset = t.stride_i - offset in
+            GL.VAO.attrib_int
+              (Program.Attribute.location att)
+              (Vertex.AttributeType.glsl_size typ)
+              (GLTypes.GlIntType.Int)
+              ((t.size_f + offset) * 4)
+              (t.stride_i * 4)
+          end else begin
+            let offset = t.stride_f - offset in
+            GL.VAO.attrib_float 
+              (Program.Attribute.location att)
+              (Vertex.AttributeType.glsl_size typ)
+              (GLTypes.GlFloatType.Float)
+              (offset     * 4)
+              (t.stride_f * 4)
+          end
       ) (Program.LL.attributes prog);
     (*if !attribs <> [] then
       Printf.eprintf "Warning : omitting attribute %s not required by program\n%!" 
@@ -7,6 +7,8 @@ module Vertex : sig
 
   exception Unbound_attribute of string
 
+  exception Invalid_value of string
+
   type 'a t
 
 
@@ -28,6 +30,10 @@ module Vertex : sig
 
     val color : Color.t s
 
+    val u8x4 : (int * int * int * int) s
+
+    val unorm8x4 : (float * float * float * float) s
+
   end
 
 
@@ -87,6 +93,33 @@ module SimpleVertex : sig
 end
 
 
+module SkinnedVertex : sig
+
+  module T : Vertex.VERTEX
+
+  val create : 
+    ?position:OgamlMath.Vector3f.t ->
+    ?color:Color.t ->
+    ?uv:OgamlMath.Vector2f.t ->
+    ?normal:OgamlMath.Vector3f.t ->
+    ?joints:(int * int * int * int) ->
+    ?weights:(float * float * float * float) -> unit -> T.s Vertex.t
+
+  val position : (OgamlMath.Vector3f.t, T.s) Vertex.Attribute.s
+
+  val color : (Color.t, T.s) Vertex.Attribute.s
+
+  val uv : (OgamlMath.Vector2f.t, T.s) Vertex.Attribute.s
+
+  val normal : (OgamlMath.Vector3f.t, T.s) Vertex.Attribute.s
+
+  val joints : (int * int * int * int, T.s) Vertex.Attribute.s
+
+  val weights : (float * float * float * float, T.s) Vertex.Attribute.s
+
+end
+
+
 module VertexSource : sig
 
   exception Uninitialized_field of string
@@ -135,6 +168,8 @@ val dynamic : (module RenderTarget.T with type t = 'a)
 
 val rebuild : (dynamic, 'b) t -> 'b VertexSource.t -> int -> unit
 
+val update : (dynamic, 'b) t -> 'b VertexSource.t -> int -> unit
+
 val length : (_, _) t -> int
 
 val draw :
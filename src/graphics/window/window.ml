@@ -7,7 +7,9 @@ type t = {
   internal : LL.Window.t;
   settings : ContextSettings.t;
   mutable min_spf  : float;
-  clock : Clock.t
+  mutable deadline : int;  (* Monotonic time of the next frame, in nanoseconds *)
+  mutable last     : int;  (* Monotonic time of the last frame *)
+  stats : FrameStats.t
 }
 
 let create ?width:(width=800) ?height:(height=600) ?title:(title="") 
@@ -25,12 +27,15 @@ let create ?width:(width=800) ?height:(height=600) ?title:(title="")
     internal;
     settings;
     min_spf;
-    clock = Clock.create ()
+    deadline = Clock.now_ns ();
+    last     = Clock.now_ns ();
+    stats    = FrameStats.create ()
   }
 
 let set_title win title = LL.Window.set_title win.internal title
 
 let set_framerate_limit win i = 
+  win.deadline <- Clock.now_ns ();
   match i with
   | None   -> win.min_spf <- 0.
   | Some i -> win.min_spf <- 1. /. (float_of_int i)
@@ -55,14 +60,24 @@ let size win = LL.Window.size win.internal
 
 let poll_event win = LL.Window.poll_event win.internal
 
+(* Frames are paced against fixed deadlines, so that an early or late frame
+ * does not shift the following ones. The deadlines are only reset when the
+ * application falls behind by more than a frame. *)
 let display win = 
   RenderTarget.bind_fbo win.context 0 None;
   LL.Window.display win.internal;
   if win.min_spf <> 0. then begin
-    let dt = win.min_spf -. (Clock.time win.clock) in
-    if dt > 0. then Thread.delay dt;
-    Clock.restart win.clock
-  end 
+    let period = int_of_float (win.min_spf *. 1e9) in
+    let deadline = win.deadline + period in
+    let now = Clock.now_ns () in
+    if deadline > now then Clock.sleep_until deadline;
+    win.deadline <- if now - deadline > period then now else deadline
+  end;
+  let now = Clock.now_ns () in
+  FrameStats.add win.stats (float_of_int (now - win.last) *. 1e-9);
+  win.last <- now
+
+let frame_stats win = win.stats
 
 let clear ?color:(color=Some (`RGB Color.RGB.black))
           ?depth:(depth=true) 
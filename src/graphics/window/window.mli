@@ -50,6 +50,9 @@ val poll_event : t -> OgamlCore.Event.t option
 (** Display the window after the GL calls *)
 val display : t -> unit
 
+(** Returns the statistics of the durations of the last frames *)
+val frame_stats : t -> OgamlUtils.FrameStats.t
+
 (** Clears the window *)
 val clear : ?color:Color.t option -> ?depth:bool -> ?stencil:bool -> t -> unit
 
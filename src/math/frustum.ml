@@ -0,0 +1,271 @@
+exception Frustum_exception of string
+
+(* 6 planes (a,b,c,d) with a normalized (a,b,c), pointing inwards, in the
+ * order left, right, bottom, top, near, far *)
+type t = {planes : float array}
+
+type bigarray = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+type visibility = Outside | Intersect | Inside
+
+let from_matrix m =
+  let m = Matrix3D.to_bigarray m in
+  let planes = Array.make 24 0. in
+  (* Row r of a column-major matrix is (m.{r}, m.{r+4}, m.{r+8}, m.{r+12}) *)
+  let set_plane p r sign =
+    let n = ref 0. in
+    for k = 0 to 3 do
+      planes.(4*p + k) <- m.{3 + 4*k} +. sign *. m.{r + 4*k};
+    done;
+    for k = 0 to 2 do
+      n := !n +. planes.(4*p + k) *. planes.(4*p + k)
+    done;
+    let n = sqrt !n in
+    if n = 0. then raise (Frustum_exception "Cannot extract frustum : degenerate matrix");
+    for k = 0 to 3 do
+      planes.(4*p + k) <- planes.(4*p + k) /. n
+    done
+  in
+  set_plane 0 0 1.;
+  set_plane 1 0 (-1.);
+  set_plane 2 1 1.;
+  set_plane 3 1 (-1.);
+  set_plane 4 2 1.;
+  set_plane 5 2 (-1.);
+  {planes}
+
+let create ~view ~projection =
+  from_matrix (Matrix3D.product projection view)
+
+let distance t i (v : Vector3f.t) =
+  let p = t.planes in
+  p.(4*i) *. v.Vector3f.x +. p.(4*i+1) *. v.Vector3f.y +. p.(4*i+2) *. v.Vector3f.z +. p.(4*i+3)
+
+let plane t i =
+  if i < 0 || i > 5 then raise (Frustum_exception "Invalid plane index");
+  (Vector3f.make t.planes.(4*i) t.planes.(4*i+1) t.planes.(4*i+2), t.planes.(4*i+3))
+
+let contains t v =
+  let rec aux i = i > 5 || (distance t i v >= 0. && aux (i+1)) in
+  aux 0
+
+let classify_sphere t center radius =
+  let rec aux i res =
+    if i > 5 then res
+    else begin
+      let d = distance t i center in
+      if d < -. radius then Outside
+      else if d < radius then aux (i+1) Intersect
+      else aux (i+1) res
+    end
+  in
+  aux 0 Inside
+
+let intersects_sphere t center radius =
+  classify_sphere t center radius <> Outside
+
+let classify_box t box =
+  let open Vector3f in
+  let minp = FloatBox.abs_position box in
+  let maxp = FloatBox.abs_corner box in
+  let p = t.planes in
+  let rec aux i res =
+    if i > 5 then res
+    else begin
+      let a, b, c, d = p.(4*i), p.(4*i+1), p.(4*i+2), p.(4*i+3) in
+      (* Farthest and nearest corners along the normal of the plane *)
+      let far =
+        a *. (if a >= 0. then maxp.x else minp.x)
+        +. b *. (if b >= 0. then maxp.y else minp.y)
+        +. c *. (if c >= 0. then maxp.z else minp.z) +. d
+      in
+      let near =
+        a *. (if a >= 0. then minp.x else maxp.x)
+        +. b *. (if b >= 0. then minp.y else maxp.y)
+        +. c *. (if c >= 0. then minp.z else maxp.z) +. d
+      in
+      if far < 0. then Outside
+      else if near < 0. then aux (i+1) Intersect
+      else aux (i+1) res
+    end
+  in
+  aux 0 Inside
+
+let intersects_box t box =
+  classify_box t box <> Outside
+
+
+module Visibility = struct
+
+  type t = {bits : Bytes.t; length : int}
+
+  let create n = {bits = Bytes.make ((n + 7) / 8) '\000'; length = n}
+
+  let length t = t.length
+
+  let get t i =
+    if i < 0 || i >= t.length then raise (Frustum_exception "Visibility index out of bounds");
+    (Char.code (Bytes.unsafe_get t.bits (i lsr 3))) land (1 lsl (i land 7)) <> 0
+
+  let unsafe_set t i b =
+    let c = Char.code (Bytes.unsafe_get t.bits (i lsr 3)) in
+    let c = if b then c lor (1 lsl (i land 7)) else c land (lnot (1 lsl (i land 7))) in
+    Bytes.unsafe_set t.bits (i lsr 3) (Char.unsafe_chr c)
+
+  let popcount c =
+    let rec aux c n = if c = 0 then n else aux (c land (c - 1)) (n + 1) in
+    aux c 0
+
+  let count t =
+    let n = ref 0 in
+    for i = 0 to Bytes.length t.bits - 1 do
+      n := !n + popcount (Char.code (Bytes.unsafe_get t.bits i))
+    done;
+    !n
+
+  let iter t f =
+    for i = 0 to Bytes.length t.bits - 1 do
+      let c = Char.code (Bytes.unsafe_get t.bits i) in
+      if c <> 0 then
+        for k = 0 to 7 do
+          if c land (1 lsl k) <> 0 then f (8*i + k)
+        done
+    done
+
+end
+
+
+(* Structure-of-arrays of boxes : 6 blocks (minx, miny, minz, maxx, maxy, maxz)
+ * of [capacity] floats each *)
+module Boxes = struct
+
+  type t = {data : bigarray; capacity : int}
+
+  let create n =
+    let data = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (6 * n) in
+    Bigarray.Array1.fill data 0.;
+    {data; capacity = n}
+
+  let length t = t.capacity
+
+  let check t i =
+    if i < 0 || i >= t.capacity then raise (Frustum_exception "Box index out of bounds")
+
+  let set_bounds t i ~min:(minp : Vector3f.t) ~max:(maxp : Vector3f.t) =
+    check t i;
+    let n = t.capacity in
+    t.data.{i}       <- minp.Vector3f.x;
+    t.data.{n + i}   <- minp.Vector3f.y;
+    t.data.{2*n + i} <- minp.Vector3f.z;
+    t.data.{3*n + i} <- maxp.Vector3f.x;
+    t.data.{4*n + i} <- maxp.Vector3f.y;
+    t.data.{5*n + i} <- maxp.Vector3f.z
+
+  let set t i box =
+    set_bounds t i ~min:(FloatBox.abs_position box) ~max:(FloatBox.abs_corner box)
+
+  let get t i =
+    check t i;
+    let n = t.capacity in
+    FloatBox.create_from_points
+      (Vector3f.make t.data.{i} t.data.{n + i} t.data.{2*n + i})
+      (Vector3f.make t.data.{3*n + i} t.data.{4*n + i} t.data.{5*n + i})
+
+end
+
+
+(* Structure-of-arrays of spheres : 4 blocks (x, y, z, radius) *)
+module Spheres = struct
+
+  type t = {data : bigarray; capacity : int}
+
+  let create n =
+    let data = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (4 * n) in
+    Bigarray.Array1.fill data 0.;
+    {data; capacity = n}
+
+  let length t = t.capacity
+
+  let check t i =
+    if i < 0 || i >= t.capacity then raise (Frustum_exception "Sphere index out of bounds")
+
+  let set t i (center : Vector3f.t) radius =
+    check t i;
+    let n = t.capacity in
+    t.data.{i}       <- center.Vector3f.x;
+    t.data.{n + i}   <- center.Vector3f.y;
+    t.data.{2*n + i} <- center.Vector3f.z;
+    t.data.{3*n + i} <- radius
+
+  let get t i =
+    check t i;
+    let n = t.capacity in
+    (Vector3f.make t.data.{i} t.data.{n + i} t.data.{2*n + i}, t.data.{3*n + i})
+
+end
+
+
+(* Batch culling, see stubs/culling_stubs.c *)
+external cull_boxes_stub : float array -> bigarray -> int -> Bytes.t -> unit
+  = "caml_frustum_cull_boxes"
+
+external cull_spheres_stub : float array -> bigarray -> int -> Bytes.t -> unit
+  = "caml_frustum_cull_spheres"
+
+let cull_boxes_ml t boxes vis =
+  let p = t.planes in
+  let n = boxes.Boxes.capacity in
+  let data = boxes.Boxes.data in
+  for i = 0 to n - 1 do
+    let visible = ref true in
+    let k = ref 0 in
+    while !visible && !k < 6 do
+      let a, b, c, d = p.(4 * !k), p.(4 * !k + 1), p.(4 * !k + 2), p.(4 * !k + 3) in
+      let px = if a >= 0. then data.{3*n + i} else data.{i} in
+      let py = if b >= 0. then data.{4*n + i} else data.{n + i} in
+      let pz = if c >= 0. then data.{5*n + i} else data.{2*n + i} in
+      if a *. px +. b *. py +. c *. pz +. d < 0. then visible := false;
+      incr k
+    done;
+    Visibility.unsafe_set vis i !visible
+  done
+
+let cull_spheres_ml t spheres vis =
+  let p = t.planes in
+  let n = spheres.Spheres.capacity in
+  let data = spheres.Spheres.data in
+  for i = 0 to n - 1 do
+    let visible = ref true in
+    let k = ref 0 in
+    while !visible && !k < 6 do
+      let a, b, c, d = p.(4 * !k), p.(4 * !k + 1), p.(4 * !k + 2), p.(4 * !k + 3) in
+      let dist = a *. data.{i} +. b *. data.{n + i} +. c *. data.{2*n + i} +. d in
+      if dist < -. data.{3*n + i} then visible := false;
+      incr k
+    done;
+    Visibility.unsafe_set vis i !visible
+  done
+
+let check_visibility vis n =
+  if Visibility.length vis <> n then
+    raise (Frustum_exception "Visibility set and volumes have different lengths")
+
+let cull_boxes_into ?native:(native = true) t boxes vis =
+  check_visibility vis boxes.Boxes.capacity;
+  if native then cull_boxes_stub t.planes boxes.Boxes.data boxes.Boxes.capacity vis.Visibility.bits
+  else cull_boxes_ml t boxes vis
+
+let cull_spheres_into ?native:(native = true) t spheres vis =
+  check_visibility vis spheres.Spheres.capacity;
+  if native then cull_spheres_stub t.planes spheres.Spheres.data spheres.Spheres.capacity vis.Visibility.bits
+  else cull_spheres_ml t spheres vis
+
+let cull_boxes ?native t boxes =
+  let vis = Visibility.create boxes.Boxes.capacity in
+  cull_boxes_into ?native t boxes vis;
+  vis
+
+let cull_spheres ?native t spheres =
+  let vis = Visibility.create spheres.Spheres.capacity in
+  cull_spheres_into ?native t spheres vis;
+  vis
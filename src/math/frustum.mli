@@ -0,0 +1,78 @@
+
+(* View frustums and visibility culling *)
+
+exception Frustum_exception of string
+
+type t
+
+type visibility = Outside | Intersect | Inside
+
+val from_matrix : Matrix3D.t -> t
+
+val create : view:Matrix3D.t -> projection:Matrix3D.t -> t
+
+val plane : t -> int -> (Vector3f.t * float)
+
+val contains : t -> Vector3f.t -> bool
+
+val classify_sphere : t -> Vector3f.t -> float -> visibility
+
+val intersects_sphere : t -> Vector3f.t -> float -> bool
+
+val classify_box : t -> FloatBox.t -> visibility
+
+val intersects_box : t -> FloatBox.t -> bool
+
+module Visibility : sig
+
+  type t
+
+  val create : int -> t
+
+  val length : t -> int
+
+  val get : t -> int -> bool
+
+  val count : t -> int
+
+  val iter : t -> (int -> unit) -> unit
+
+end
+
+module Boxes : sig
+
+  type t
+
+  val create : int -> t
+
+  val length : t -> int
+
+  val set : t -> int -> FloatBox.t -> unit
+
+  val set_bounds : t -> int -> min:Vector3f.t -> max:Vector3f.t -> unit
+
+  val get : t -> int -> FloatBox.t
+
+end
+
+module Spheres : sig
+
+  type t
+
+  val create : int -> t
+
+  val length : t -> int
+
+  val set : t -> int -> Vector3f.t -> float -> unit
+
+  val get : t -> int -> (Vector3f.t * float)
+
+end
+
+val cull_boxes : ?native:bool -> t -> Boxes.t -> Visibility.t
+
+val cull_boxes_into : ?native:bool -> t -> Boxes.t -> Visibility.t -> unit
+
+val cull_spheres : ?native:bool -> t -> Spheres.t -> Visibility.t
+
+val cull_spheres_into : ?native:bool -> t -> Spheres.t -> Visibility.t -> unit
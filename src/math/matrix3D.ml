@@ -76,24 +76,35 @@ let rotation v t =
   set 2 2 m (z *. z +. (1. -. z *. z) *. c);
   m
 
+let product_into m1 m2 dst = 
+  let a0 = m1.{0} and a1 = m1.{1} and a2 = m1.{2} and a3 = m1.{3} in
+  let a4 = m1.{4} and a5 = m1.{5} and a6 = m1.{6} and a7 = m1.{7} in
+  let a8 = m1.{8} and a9 = m1.{9} and a10 = m1.{10} and a11 = m1.{11} in
+  let a12 = m1.{12} and a13 = m1.{13} and a14 = m1.{14} and a15 = m1.{15} in
+  let b0 = m2.{0} and b1 = m2.{1} and b2 = m2.{2} and b3 = m2.{3} in
+  let b4 = m2.{4} and b5 = m2.{5} and b6 = m2.{6} and b7 = m2.{7} in
+  let b8 = m2.{8} and b9 = m2.{9} and b10 = m2.{10} and b11 = m2.{11} in
+  let b12 = m2.{12} and b13 = m2.{13} and b14 = m2.{14} and b15 = m2.{15} in
+  dst.{0}  <- a0 *. b0 +. a4 *. b1 +. a8 *. b2 +. a12 *. b3;
+  dst.{1}  <- a1 *. b0 +. a5 *. b1 +. a9 *. b2 +. a13 *. b3;
+  dst.{2}  <- a2 *. b0 +. a6 *. b1 +. a10 *. b2 +. a14 *. b3;
+  dst.{3}  <- a3 *. b0 +. a7 *. b1 +. a11 *. b2 +. a15 *. b3;
+  dst.{4}  <- a0 *. b4 +. a4 *. b5 +. a8 *. b6 +. a12 *. b7;
+  dst.{5}  <- a1 *. b4 +. a5 *. b5 +. a9 *. b6 +. a13 *. b7;
+  dst.{6}  <- a2 *. b4 +. a6 *. b5 +. a10 *. b6 +. a14 *. b7;
+  dst.{7}  <- a3 *. b4 +. a7 *. b5 +. a11 *. b6 +. a15 *. b7;
+  dst.{8}  <- a0 *. b8 +. a4 *. b9 +. a8 *. b10 +. a12 *. b11;
+  dst.{9}  <- a1 *. b8 +. a5 *. b9 +. a9 *. b10 +. a13 *. b11;
+  dst.{10} <- a2 *. b8 +. a6 *. b9 +. a10 *. b10 +. a14 *. b11;
+  dst.{11} <- a3 *. b8 +. a7 *. b9 +. a11 *. b10 +. a15 *. b11;
+  dst.{12} <- a0 *. b12 +. a4 *. b13 +. a8 *. b14 +. a12 *. b15;
+  dst.{13} <- a1 *. b12 +. a5 *. b13 +. a9 *. b14 +. a13 *. b15;
+  dst.{14} <- a2 *. b12 +. a6 *. b13 +. a10 *. b14 +. a14 *. b15;
+  dst.{15} <- a3 *. b12 +. a7 *. b13 +. a11 *. b14 +. a15 *. b15
+
 let product m1 m2 = 
   let m = create () in
-  m.{0}  <- m1.{0} *. m2.{0}  +. m1.{4} *. m2.{1}  +. m1.{8}  *. m2.{2}  +. m1.{12} *. m2.{3};
-  m.{1}  <- m1.{1} *. m2.{0}  +. m1.{5} *. m2.{1}  +. m1.{9}  *. m2.{2}  +. m1.{13} *. m2.{3};
-  m.{2}  <- m1.{2} *. m2.{0}  +. m1.{6} *. m2.{1}  +. m1.{10} *. m2.{2}  +. m1.{14} *. m2.{3};
-  m.{3}  <- m1.{3} *. m2.{0}  +. m1.{7} *. m2.{1}  +. m1.{11} *. m2.{2}  +. m1.{15} *. m2.{3};
-  m.{4}  <- m1.{0} *. m2.{4}  +. m1.{4} *. m2.{5}  +. m1.{8}  *. m2.{6}  +. m1.{12} *. m2.{7};
-  m.{5}  <- m1.{1} *. m2.{4}  +. m1.{5} *. m2.{5}  +. m1.{9}  *. m2.{6}  +. m1.{13} *. m2.{7};
-  m.{6}  <- m1.{2} *. m2.{4}  +. m1.{6} *. m2.{5}  +. m1.{10} *. m2.{6}  +. m1.{14} *. m2.{7};
-  m.{7}  <- m1.{3} *. m2.{4}  +. m1.{7} *. m2.{5}  +. m1.{11} *. m2.{6}  +. m1.{15} *. m2.{7};
-  m.{8}  <- m1.{0} *. m2.{8}  +. m1.{4} *. m2.{9}  +. m1.{8}  *. m2.{10} +. m1.{12} *. m2.{11};
-  m.{9}  <- m1.{1} *. m2.{8}  +. m1.{5} *. m2.{9}  +. m1.{9}  *. m2.{10} +. m1.{13} *. m2.{11};
-  m.{10} <- m1.{2} *. m2.{8}  +. m1.{6} *. m2.{9}  +. m1.{10} *. m2.{10} +. m1.{14} *. m2.{11};
-  m.{11} <- m1.{3} *. m2.{8}  +. m1.{7} *. m2.{9}  +. m1.{11} *. m2.{10} +. m1.{15} *. m2.{11};
-  m.{12} <- m1.{0} *. m2.{12} +. m1.{4} *. m2.{13} +. m1.{8}  *. m2.{14} +. m1.{12} *. m2.{15};
-  m.{13} <- m1.{1} *. m2.{12} +. m1.{5} *. m2.{13} +. m1.{9}  *. m2.{14} +. m1.{13} *. m2.{15};
-  m.{14} <- m1.{2} *. m2.{12} +. m1.{6} *. m2.{13} +. m1.{10} *. m2.{14} +. m1.{14} *. m2.{15};
-  m.{15} <- m1.{3} *. m2.{12} +. m1.{7} *. m2.{13} +. m1.{11} *. m2.{14} +. m1.{15} *. m2.{15};
+  product_into m1 m2 m;
   m
 
 let transpose m' = 
@@ -104,11 +115,63 @@ let transpose m' =
   m.{12} <- m'.{3}; m.{13} <- m'.{7}; m.{14} <- m'.{11}; m.{15} <- m'.{15};
   m
 
-let translate v m = product (translation v) m
+let translate_into v m dst = 
+  let open Vector3f in
+  for c = 0 to 3 do
+    let w = m.{3 + 4*c} in
+    dst.{4*c}     <- m.{4*c}     +. v.x *. w;
+    dst.{1 + 4*c} <- m.{1 + 4*c} +. v.y *. w;
+    dst.{2 + 4*c} <- m.{2 + 4*c} +. v.z *. w;
+    dst.{3 + 4*c} <- w
+  done
+
+let scale_into v m dst = 
+  let open Vector3f in
+  for c = 0 to 3 do
+    dst.{4*c}     <- m.{4*c}     *. v.x;
+    dst.{1 + 4*c} <- m.{1 + 4*c} *. v.y;
+    dst.{2 + 4*c} <- m.{2 + 4*c} *. v.z;
+    dst.{3 + 4*c} <- m.{3 + 4*c}
+  done
 
-let scale v m = product (scaling v) m
+let rotate_into v t m dst = 
+  let open Vector3f in
+  let c = cos t in
+  let ic = 1. -. c in
+  let s = sin t in
+  let vn = 
+    try normalize v 
+    with Vector3f_exception _ -> raise (Matrix3D_exception "Cannot rotate matrix : zero axis")
+  in
+  let (x,y,z) = (vn.x, vn.y, vn.z) in
+  let r00 = x *. x +. (1. -. x *. x) *. c
+  and r01 = ic *. x *. y -. z *. s
+  and r02 = ic *. x *. z +. y *. s
+  and r10 = ic *. x *. y +. z *. s
+  and r11 = y *. y +. (1. -. y *. y) *. c
+  and r12 = ic *. y *. z -. x *. s
+  and r20 = ic *. x *. z -. y *. s
+  and r21 = ic *. y *. z +. x *. s
+  and r22 = z *. z +. (1. -. z *. z) *. c in
+  for k = 0 to 3 do
+    let mx = m.{4*k} and my = m.{1 + 4*k} and mz = m.{2 + 4*k} in
+    dst.{4*k}     <- r00 *. mx +. r01 *. my +. r02 *. mz;
+    dst.{1 + 4*k} <- r10 *. mx +. r11 *. my +. r12 *. mz;
+    dst.{2 + 4*k} <- r20 *. mx +. r21 *. my +. r22 *. mz;
+    dst.{3 + 4*k} <- m.{3 + 4*k}
+  done
 
-let rotate v t m = product (rotation v t) m
+let translate v m = 
+  let dst = create () in
+  translate_into v m dst; dst
+
+let scale v m = 
+  let dst = create () in
+  scale_into v m dst; dst
+
+let rotate v t m = 
+  let dst = create () in
+  rotate_into v t m dst; dst
 
 let times m ?perspective:(p = true) v = 
   let open Vector3f in
@@ -125,6 +188,41 @@ let times m ?perspective:(p = true) v =
       z = v.x *. m.{2} +. v.y *. m.{6} +. v.z *. m.{10}
     }   
 
+let times_into m ?perspective:(p = true) v dst i = 
+  let open Vector3f in
+  let w = if p then 1. else 0. in
+  dst.{3*i}     <- v.x *. m.{0} +. v.y *. m.{4} +. v.z *. m.{8}  +. w *. m.{12};
+  dst.{3*i + 1} <- v.x *. m.{1} +. v.y *. m.{5} +. v.z *. m.{9}  +. w *. m.{13};
+  dst.{3*i + 2} <- v.x *. m.{2} +. v.y *. m.{6} +. v.z *. m.{10} +. w *. m.{14}
+
+(* Batched transformations, see stubs/transform_stubs.c *)
+external transform_points_stub : t -> bool -> t -> t -> unit 
+  = "caml_matrix3D_transform_points"
+
+external transform_normals_stub : t -> t -> t -> unit 
+  = "caml_matrix3D_transform_normals"
+
+let check_batch name src dst = 
+  let len = Bigarray.Array1.dim src in
+  if len mod 3 <> 0 then 
+    raise (Matrix3D_exception (Printf.sprintf "Cannot transform %s : length is not a multiple of 3" name));
+  if Bigarray.Array1.dim dst < len then
+    raise (Matrix3D_exception (Printf.sprintf "Cannot transform %s : destination is too small" name))
+
+let transform_points m ?perspective:(p = true) src dst = 
+  check_batch "points" src dst;
+  transform_points_stub m p src dst
+
+let transform_normals m src dst = 
+  check_batch "normals" src dst;
+  transform_normals_stub m src dst
+
+let blit src dst = Bigarray.Array1.blit src dst
+
+let copy m = 
+  let m' = create () in
+  blit m m'; m'
+
 let from_quaternion q = 
   let mat = zero () in Quaternion.(
   set 0 0 mat (1. -. 2. *. q.j *. q.j -. 2. *. q.k *. q.k);
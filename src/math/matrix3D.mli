@@ -41,6 +41,33 @@ val rotate : Vector3f.t -> float -> t -> t
 (* Vector right-product *)
 val times : t -> ?perspective:bool -> Vector3f.t -> Vector3f.t
 
+(* Copies a matrix *)
+val copy : t -> t
+
+(* Copies a matrix into another one *)
+val blit : t -> t -> unit
+
+(* Destination-passing variants, the destination may alias an operand *)
+val product_into : t -> t -> t -> unit
+
+val translate_into : Vector3f.t -> t -> t -> unit
+
+val scale_into : Vector3f.t -> t -> t -> unit
+
+val rotate_into : Vector3f.t -> float -> t -> t -> unit
+
+val times_into : t -> ?perspective:bool -> Vector3f.t -> 
+    (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> int -> unit
+
+(* Batched transformations of packed (x,y,z) bigarrays *)
+val transform_points : t -> ?perspective:bool -> 
+    (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> unit
+
+val transform_normals : t -> 
+    (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+    (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> unit
+
 (* Rotation matrix from a quaternion *)
 val from_quaternion : Quaternion.t -> t
 
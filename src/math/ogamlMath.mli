@@ -1044,6 +1044,64 @@ module Matrix3D : sig
   (** Returns a pretty-printed string (not for serialization) *)
   val to_string : t -> string
 
+  (** Returns a copy of a matrix *)
+  val copy : t -> t
+
+  (** $blit src dst$ copies the matrix $src$ into $dst$ *)
+  val blit : t -> t -> unit
+
+
+  (*** In-place Operations *)
+
+  (** These functions write their result into a destination matrix
+    * instead of allocating a new one. The destination may be one of 
+    * the operands. *)
+
+  (** $product_into m1 m2 dst$ stores the product of $m1$ and $m2$ in $dst$ *)
+  val product_into : t -> t -> t -> unit
+
+  (** $translate_into v m dst$ stores $translate v m$ in $dst$ 
+    * @see:OgamlMath.Vector3f *)
+  val translate_into : Vector3f.t -> t -> t -> unit
+
+  (** $scale_into v m dst$ stores $scale v m$ in $dst$ 
+    * @see:OgamlMath.Vector3f *)
+  val scale_into : Vector3f.t -> t -> t -> unit
+
+  (** $rotate_into v t m dst$ stores $rotate v t m$ in $dst$.
+    * Raises Matrix3D_exception if $v = zero$.
+    * @see:OgamlMath.Vector3f *)
+  val rotate_into : Vector3f.t -> float -> t -> t -> unit
+
+  (** $times_into m v dst i$ stores the coordinates of $times m v$ 
+    * at indices $3i$, $3i+1$ and $3i+2$ of $dst$ 
+    * @see:OgamlMath.Vector3f *)
+  val times_into : t -> ?perspective:bool -> Vector3f.t -> 
+      (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> int -> unit
+
+
+  (*** Batched Transformations *)
+
+  (** These functions transform whole arrays of packed (x,y,z) coordinates 
+    * using a native (SIMD when available) kernel. The source and the 
+    * destination may be the same array. 
+    *
+    * Raise Matrix3D_exception if the length of the source is not a multiple
+    * of 3 or if the destination is smaller than the source. *)
+
+  (** $transform_points m src dst$ stores the product of $m$ with each point
+    * of $src$ in $dst$. $perspective$ has the same meaning as in $times$. *)
+  val transform_points : t -> ?perspective:bool -> 
+      (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> unit
+
+  (** $transform_normals m src dst$ stores the normalized product of $m$ 
+    * (without its translation) with each vector of $src$ in $dst$. 
+    * $m$ should usually be the inverse transpose of the model matrix. *)
+  val transform_normals : t -> 
+      (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t ->
+      (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t -> unit
+
 
   (*** Rendering Matrices Creation *)
 
@@ -1179,3 +1237,162 @@ module Matrix2D : sig
 
 
 end
+
+
+(** View frustums and visibility culling *)
+module Frustum : sig
+
+  (** This module provides view frustums extracted from projection matrices,
+    * and batch culling of bounding volumes against them. *)
+
+  (** Raised when an error occurs (degenerate matrix, invalid index) *)
+  exception Frustum_exception of string
+
+
+  (*** Frustum creation *)
+
+  (** Type of a frustum, made of 6 planes *)
+  type t
+
+  (** Result of a visibility test *)
+  type visibility = Outside | Intersect | Inside
+
+  (** Extracts the frustum of a (view-)projection matrix.
+    * The planes are expressed in the space preceding the matrix : 
+    * a view-projection matrix gives a frustum in world space.
+    *
+    * Raises Frustum_exception if the matrix is degenerate.
+    * @see:OgamlMath.Matrix3D *)
+  val from_matrix : Matrix3D.t -> t
+
+  (** $create ~view ~projection$ is equivalent to 
+    * $from_matrix (Matrix3D.product projection view)$
+    * @see:OgamlMath.Matrix3D *)
+  val create : view:Matrix3D.t -> projection:Matrix3D.t -> t
+
+  (** Returns the normal (pointing inwards) and the offset of the ith plane, 
+    * in the order left, right, bottom, top, near, far.
+    * @see:OgamlMath.Vector3f *)
+  val plane : t -> int -> (Vector3f.t * float)
+
+
+  (*** Individual tests *)
+
+  (** Returns $true$ iff a point lies inside a frustum 
+    * @see:OgamlMath.Vector3f *)
+  val contains : t -> Vector3f.t -> bool
+
+  (** $classify_sphere f center radius$ classifies a sphere against a frustum 
+    * @see:OgamlMath.Vector3f *)
+  val classify_sphere : t -> Vector3f.t -> float -> visibility
+
+  (** Returns $true$ iff a sphere is not outside of a frustum.
+    * @see:OgamlMath.Vector3f *)
+  val intersects_sphere : t -> Vector3f.t -> float -> bool
+
+  (** Classifies a box against a frustum 
+    * @see:OgamlMath.FloatBox *)
+  val classify_box : t -> FloatBox.t -> visibility
+
+  (** Returns $true$ iff a box is not outside of a frustum. 
+    * This test is conservative : some boxes near the corners of the frustum
+    * may be reported as visible. 
+    * @see:OgamlMath.FloatBox *)
+  val intersects_box : t -> FloatBox.t -> bool
+
+
+  (*** Batch culling *)
+
+  (** Sets of visible objects, stored as bitsets *)
+  module Visibility : sig
+
+    (** Type of a visibility set *)
+    type t
+
+    (** Creates an empty visibility set of a given length *)
+    val create : int -> t
+
+    (** Returns the length of a set *)
+    val length : t -> int
+
+    (** Returns $true$ iff the ith object is visible. 
+      * Raises Frustum_exception if $i$ is out of bounds. *)
+    val get : t -> int -> bool
+
+    (** Returns the number of visible objects *)
+    val count : t -> int
+
+    (** Iterates through the indices of the visible objects, in increasing order *)
+    val iter : t -> (int -> unit) -> unit
+
+  end
+
+  (** Structure-of-arrays of axis-aligned boxes *)
+  module Boxes : sig
+
+    (** Type of an array of boxes *)
+    type t
+
+    (** Creates an array of $n$ (empty) boxes *)
+    val create : int -> t
+
+    (** Returns the length of an array of boxes *)
+    val length : t -> int
+
+    (** Sets the ith box. Raises Frustum_exception if $i$ is out of bounds. 
+      * @see:OgamlMath.FloatBox *)
+    val set : t -> int -> FloatBox.t -> unit
+
+    (** Sets the ith box from its minimal and maximal points. 
+      * Raises Frustum_exception if $i$ is out of bounds. 
+      * @see:OgamlMath.Vector3f *)
+    val set_bounds : t -> int -> min:Vector3f.t -> max:Vector3f.t -> unit
+
+    (** Returns the ith box (normalized) 
+      * @see:OgamlMath.FloatBox *)
+    val get : t -> int -> FloatBox.t
+
+  end
+
+  (** Structure-of-arrays of spheres *)
+  module Spheres : sig
+
+    (** Type of an array of spheres *)
+    type t
+
+    (** Creates an array of $n$ (empty) spheres *)
+    val create : int -> t
+
+    (** Returns the length of an array of spheres *)
+    val length : t -> int
+
+    (** $set s i center radius$ sets the ith sphere.
+      * Raises Frustum_exception if $i$ is out of bounds. 
+      * @see:OgamlMath.Vector3f *)
+    val set : t -> int -> Vector3f.t -> float -> unit
+
+    (** Returns the center and the radius of the ith sphere 
+      * @see:OgamlMath.Vector3f *)
+    val get : t -> int -> (Vector3f.t * float)
+
+  end
+
+  (** Returns the set of the boxes that are not outside of a frustum.
+    *
+    * If $native$ is true (default), the test runs in a vectorized native 
+    * kernel. Otherwise it runs in OCaml. Both return the same results. *)
+  val cull_boxes : ?native:bool -> t -> Boxes.t -> Visibility.t
+
+  (** Same as $cull_boxes$ but writes the result in an existing set.
+    * Raises Frustum_exception if the lengths do not match. *)
+  val cull_boxes_into : ?native:bool -> t -> Boxes.t -> Visibility.t -> unit
+
+  (** Returns the set of the spheres that are not outside of a frustum.
+    * See $cull_boxes$ for the meaning of $native$. *)
+  val cull_spheres : ?native:bool -> t -> Spheres.t -> Visibility.t
+
+  (** Same as $cull_spheres$ but writes the result in an existing set.
+    * Raises Frustum_exception if the lengths do not match. *)
+  val cull_spheres_into : ?native:bool -> t -> Spheres.t -> Visibility.t -> unit
+
+end
@@ -0,0 +1,123 @@
+#define CAML_NAME_SPACE
+
+#include <caml/mlvalues.h>
+#include <caml/memory.h>
+#include <caml/bigarray.h>
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define OGAML_SSE2
+#endif
+
+// Distances are computed in double precision, in the same order as the
+// OCaml fallback of Frustum, so that both paths return the same bits.
+
+#ifdef OGAML_SSE2
+// Returns a 2-bit mask of the lanes lying outside of the plane
+static inline int outside2(__m128d a, __m128d b, __m128d c, __m128d d,
+                           __m128d x, __m128d y, __m128d z, __m128d bound)
+{
+  __m128d dist = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(a, x), _mm_mul_pd(b, y)),
+                                       _mm_mul_pd(c, z)), d);
+  return _mm_movemask_pd(_mm_cmplt_pd(dist, bound));
+}
+
+#define LO(v) _mm_cvtps_pd(v)
+#define HI(v) _mm_cvtps_pd(_mm_movehl_ps(v, v))
+#endif
+
+static inline int box_visible(const double* p, const float* data, intnat n, intnat i)
+{
+  int k;
+  for(k = 0; k < 6; k++) {
+    double a = p[4*k], b = p[4*k+1], c = p[4*k+2], d = p[4*k+3];
+    double px = a >= 0. ? data[3*n + i] : data[i];
+    double py = b >= 0. ? data[4*n + i] : data[n + i];
+    double pz = c >= 0. ? data[5*n + i] : data[2*n + i];
+    if(a * px + b * py + c * pz + d < 0.) return 0;
+  }
+  return 1;
+}
+
+static inline int sphere_visible(const double* p, const float* data, intnat n, intnat i)
+{
+  int k;
+  for(k = 0; k < 6; k++) {
+    double dist = p[4*k] * data[i] + p[4*k+1] * data[n + i] + p[4*k+2] * data[2*n + i] + p[4*k+3];
+    if(dist < -(double)data[3*n + i]) return 0;
+  }
+  return 1;
+}
+
+static void write_bit(unsigned char* bits, intnat i, int b)
+{
+  if(b) bits[i >> 3] |= (unsigned char)(1 << (i & 7));
+  else  bits[i >> 3] &= (unsigned char)~(1 << (i & 7));
+}
+
+
+// INPUT   the planes of a frustum, a SoA of boxes, its length and a bitset
+// OUTPUT  nothing, sets the bit of each box that intersects the frustum
+CAMLprim value
+caml_frustum_cull_boxes(value planes, value boxes, value len, value bits)
+{
+  CAMLparam4(planes, boxes, len, bits);
+  double p[24];
+  intnat n = Long_val(len);
+  intnat i = 0;
+  int k;
+  const float* data = (const float*)Caml_ba_data_val(boxes);
+  unsigned char* out = (unsigned char*)String_val(bits);
+  for(k = 0; k < 24; k++) p[k] = Double_field(planes, k);
+#ifdef OGAML_SSE2
+  for(; i + 4 <= n; i += 4) {
+    int mask = 0;
+    for(k = 0; k < 6; k++) {
+      double a = p[4*k], b = p[4*k+1], c = p[4*k+2];
+      __m128 vx = _mm_loadu_ps(data + (a >= 0. ? 3*n : 0) + i);
+      __m128 vy = _mm_loadu_ps(data + (b >= 0. ? 4*n : n) + i);
+      __m128 vz = _mm_loadu_ps(data + (c >= 0. ? 5*n : 2*n) + i);
+      __m128d pa = _mm_set1_pd(a), pb = _mm_set1_pd(b), pc = _mm_set1_pd(c);
+      __m128d pd = _mm_set1_pd(p[4*k+3]), zero = _mm_setzero_pd();
+      mask |= outside2(pa, pb, pc, pd, LO(vx), LO(vy), LO(vz), zero);
+      mask |= outside2(pa, pb, pc, pd, HI(vx), HI(vy), HI(vz), zero) << 2;
+    }
+    for(k = 0; k < 4; k++) write_bit(out, i + k, !(mask & (1 << k)));
+  }
+#endif
+  for(; i < n; i++) write_bit(out, i, box_visible(p, data, n, i));
+  CAMLreturn(Val_unit);
+}
+
+
+// INPUT   the planes of a frustum, a SoA of spheres, its length and a bitset
+// OUTPUT  nothing, sets the bit of each sphere that intersects the frustum
+CAMLprim value
+caml_frustum_cull_spheres(value planes, value spheres, value len, value bits)
+{
+  CAMLparam4(planes, spheres, len, bits);
+  double p[24];
+  intnat n = Long_val(len);
+  intnat i = 0;
+  int k;
+  const float* data = (const float*)Caml_ba_data_val(spheres);
+  unsigned char* out = (unsigned char*)String_val(bits);
+  for(k = 0; k < 24; k++) p[k] = Double_field(planes, k);
+#ifdef OGAML_SSE2
+  for(; i + 4 <= n; i += 4) {
+    int mask = 0;
+    __m128 vx = _mm_loadu_ps(data + i);
+    __m128 vy = _mm_loadu_ps(data + n + i);
+    __m128 vz = _mm_loadu_ps(data + 2*n + i);
+    __m128 vr = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(data + 3*n + i));
+    for(k = 0; k < 6; k++) {
+      __m128d pa = _mm_set1_pd(p[4*k]), pb = _mm_set1_pd(p[4*k+1]);
+      __m128d pc = _mm_set1_pd(p[4*k+2]), pd = _mm_set1_pd(p[4*k+3]);
+      mask |= outside2(pa, pb, pc, pd, LO(vx), LO(vy), LO(vz), LO(vr));
+      mask |= outside2(pa, pb, pc, pd, HI(vx), HI(vy), HI(vz), HI(vr)) << 2;
+    }
+    for(k = 0; k < 4; k++) write_bit(out, i + k, !(mask & (1 << k)));
+  }
+#endif
+  for(; i < n; i++) write_bit(out, i, sphere_visible(p, data, n, i));
+  CAMLreturn(Val_unit);
+}
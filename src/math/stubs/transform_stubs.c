@@ -0,0 +1,81 @@
+#define CAML_NAME_SPACE
+
+#include <caml/mlvalues.h>
+#include <caml/memory.h>
+#include <caml/bigarray.h>
+#include <math.h>
+#if defined(__SSE__) || defined(_M_X64)
+  #include <xmmintrin.h>
+  #define OGAML_SSE
+#endif
+
+
+// Transforms n packed 3D points (or directions if w = 0)
+// by the column-major 4x4 matrix m
+static void transform_points(const float* m, float w, const float* src, float* dst, intnat n)
+{
+  intnat i;
+#ifdef OGAML_SSE
+  __m128 c0 = _mm_loadu_ps(m);
+  __m128 c1 = _mm_loadu_ps(m + 4);
+  __m128 c2 = _mm_loadu_ps(m + 8);
+  __m128 c3 = _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(w));
+  float res[4];
+  for(i = 0; i < n; i++) {
+    __m128 r = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(src[3*i])),
+                 _mm_mul_ps(c1, _mm_set1_ps(src[3*i+1]))),
+      _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(src[3*i+2])), c3));
+    _mm_storeu_ps(res, r);
+    dst[3*i]   = res[0];
+    dst[3*i+1] = res[1];
+    dst[3*i+2] = res[2];
+  }
+#else
+  for(i = 0; i < n; i++) {
+    float x = src[3*i], y = src[3*i+1], z = src[3*i+2];
+    dst[3*i]   = x * m[0] + y * m[4] + z * m[8]  + w * m[12];
+    dst[3*i+1] = x * m[1] + y * m[5] + z * m[9]  + w * m[13];
+    dst[3*i+2] = x * m[2] + y * m[6] + z * m[10] + w * m[14];
+  }
+#endif
+}
+
+
+// INPUT   a matrix, a boolean (perspective), a source and a destination bigarray
+// OUTPUT  nothing, transforms all the points of the source into the destination
+CAMLprim value
+caml_matrix3D_transform_points(value mat, value persp, value src, value dst)
+{
+  CAMLparam4(mat, persp, src, dst);
+  intnat n = Caml_ba_array_val(src)->dim[0] / 3;
+  transform_points((float*)Caml_ba_data_val(mat),
+                   Bool_val(persp) ? 1.f : 0.f,
+                   (float*)Caml_ba_data_val(src),
+                   (float*)Caml_ba_data_val(dst), n);
+  CAMLreturn(Val_unit);
+}
+
+
+// INPUT   a matrix, a source and a destination bigarray
+// OUTPUT  nothing, transforms and renormalizes all the normals of the source
+CAMLprim value
+caml_matrix3D_transform_normals(value mat, value src, value dst)
+{
+  CAMLparam3(mat, src, dst);
+  intnat i;
+  intnat n = Caml_ba_array_val(src)->dim[0] / 3;
+  float* d = (float*)Caml_ba_data_val(dst);
+  transform_points((float*)Caml_ba_data_val(mat), 0.f,
+                   (float*)Caml_ba_data_val(src), d, n);
+  for(i = 0; i < n; i++) {
+    float len = sqrtf(d[3*i] * d[3*i] + d[3*i+1] * d[3*i+1] + d[3*i+2] * d[3*i+2]);
+    if(len > 0.f) {
+      float inv = 1.f / len;
+      d[3*i]   *= inv;
+      d[3*i+1] *= inv;
+      d[3*i+2] *= inv;
+    }
+  }
+  CAMLreturn(Val_unit);
+}
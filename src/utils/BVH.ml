@@ -0,0 +1,544 @@
+open OgamlMath
+
+exception BVH_error of string
+
+type primitive =
+  | Triangle of Vector3f.t * Vector3f.t * Vector3f.t
+  | Sphere   of Vector3f.t * float
+  | Box      of FloatBox.t
+
+type hit = {
+  primitive : int;
+  distance  : float;
+  point     : Vector3f.t
+}
+
+(* Nodes are stored in flat arrays. Node 0 is the root, the children of an
+ * inner node are stored consecutively (right = left + 1), and always after
+ * their parent, so that a reverse scan visits children before parents. *)
+type t = {
+  prims   : primitive array;
+  bounds  : float array;   (* 6 floats per node : min x y z, max x y z *)
+  first   : int array;     (* left child, or offset in [indices] for leaves *)
+  count   : int array;     (* 0 for inner nodes, number of primitives for leaves *)
+  parent  : int array;
+  leaf    : int array;     (* leaf of each primitive *)
+  indices : int array;     (* primitives sorted by leaf *)
+  mutable nodes : int;
+  mutable depth : int
+}
+
+let leaf_size = 4
+
+let bins = 12
+
+let fmin (a : float) b = if a < b then a else b
+
+let fmax (a : float) b = if a > b then a else b
+
+
+(* Bounds *)
+let prim_bounds p arr o =
+  let open Vector3f in
+  let set minx miny minz maxx maxy maxz =
+    arr.(o)   <- minx; arr.(o+1) <- miny; arr.(o+2) <- minz;
+    arr.(o+3) <- maxx; arr.(o+4) <- maxy; arr.(o+5) <- maxz
+  in
+  match p with
+  | Triangle (a, b, c) ->
+    set (fmin a.x (fmin b.x c.x)) (fmin a.y (fmin b.y c.y)) (fmin a.z (fmin b.z c.z))
+        (fmax a.x (fmax b.x c.x)) (fmax a.y (fmax b.y c.y)) (fmax a.z (fmax b.z c.z))
+  | Sphere (c, r) ->
+    set (c.x -. r) (c.y -. r) (c.z -. r) (c.x +. r) (c.y +. r) (c.z +. r)
+  | Box b ->
+    let p1 = FloatBox.abs_position b and p2 = FloatBox.abs_corner b in
+    set p1.x p1.y p1.z p2.x p2.y p2.z
+
+let empty_bounds arr o =
+  for k = 0 to 2 do
+    arr.(o+k)   <- infinity;
+    arr.(o+3+k) <- neg_infinity
+  done
+
+let grow_bounds dst d src s =
+  for k = 0 to 2 do
+    dst.(d+k)   <- fmin dst.(d+k)   src.(s+k);
+    dst.(d+3+k) <- fmax dst.(d+3+k) src.(s+3+k)
+  done
+
+let half_area arr o =
+  let dx = arr.(o+3) -. arr.(o)
+  and dy = arr.(o+4) -. arr.(o+1)
+  and dz = arr.(o+5) -. arr.(o+2) in
+  if dx < 0. then 0. else dx *. dy +. dy *. dz +. dz *. dx
+
+
+(* SAH construction *)
+let create prims =
+  let n = Array.length prims in
+  if n = 0 then raise (BVH_error "Cannot build a BVH without primitives");
+  let maxnodes = 2 * n - 1 in
+  let t = {
+    prims   = Array.copy prims;
+    bounds  = Array.make (6 * maxnodes) 0.;
+    first   = Array.make maxnodes 0;
+    count   = Array.make maxnodes 0;
+    parent  = Array.make maxnodes (-1);
+    leaf    = Array.make n 0;
+    indices = Array.init n (fun i -> i);
+    nodes   = 1;
+    depth   = 0
+  } in
+  let pbounds = Array.make (6 * n) 0. in
+  let centroids = Array.make (3 * n) 0. in
+  Array.iteri (fun i p ->
+    prim_bounds p pbounds (6*i);
+    for k = 0 to 2 do
+      centroids.(3*i+k) <- (pbounds.(6*i+k) +. pbounds.(6*i+3+k)) /. 2.
+    done
+  ) t.prims;
+  let bin_bounds = Array.make (6 * bins) 0. in
+  let bin_count  = Array.make bins 0 in
+  let acc = Array.make 6 0. in
+  let left_cost = Array.make bins 0. in
+  let cbounds = Array.make 6 0. in
+  let make_leaf node start len =
+    t.first.(node) <- start;
+    t.count.(node) <- len;
+    for i = start to start + len - 1 do
+      t.leaf.(t.indices.(i)) <- node
+    done
+  in
+  let rec build node start len depth =
+    t.depth <- max t.depth depth;
+    empty_bounds t.bounds (6*node);
+    empty_bounds cbounds 0;
+    for i = start to start + len - 1 do
+      let p = t.indices.(i) in
+      grow_bounds t.bounds (6*node) pbounds (6*p);
+      for k = 0 to 2 do
+        cbounds.(k)   <- fmin cbounds.(k)   centroids.(3*p+k);
+        cbounds.(3+k) <- fmax cbounds.(3+k) centroids.(3*p+k)
+      done
+    done;
+    if len <= leaf_size then make_leaf node start len
+    else begin
+      (* Binned SAH : find the best axis and split bin *)
+      let best_cost = ref infinity and best_axis = ref (-1) and best_bin = ref 0 in
+      for axis = 0 to 2 do
+        let cmin = cbounds.(axis) and cmax = cbounds.(3+axis) in
+        if cmax > cmin then begin
+          let scale = float_of_int bins /. (cmax -. cmin) in
+          let bin_of p = min (bins - 1) (int_of_float ((centroids.(3*p+axis) -. cmin) *. scale)) in
+          for b = 0 to bins - 1 do
+            empty_bounds bin_bounds (6*b);
+            bin_count.(b) <- 0
+          done;
+          for i = start to start + len - 1 do
+            let p = t.indices.(i) in
+            let b = bin_of p in
+            bin_count.(b) <- bin_count.(b) + 1;
+            grow_bounds bin_bounds (6*b) pbounds (6*p)
+          done;
+          (* Sweep from the left, then from the right *)
+          empty_bounds acc 0;
+          let cnt = ref 0 in
+          for b = 0 to bins - 2 do
+            grow_bounds acc 0 bin_bounds (6*b);
+            cnt := !cnt + bin_count.(b);
+            left_cost.(b) <- half_area acc 0 *. float_of_int !cnt
+          done;
+          empty_bounds acc 0;
+          cnt := 0;
+          for b = bins - 1 downto 1 do
+            grow_bounds acc 0 bin_bounds (6*b);
+            cnt := !cnt + bin_count.(b);
+            let cost = left_cost.(b-1) +. half_area acc 0 *. float_of_int !cnt in
+            if cost < !best_cost then begin
+              best_cost := cost;
+              best_axis := axis;
+              best_bin  := b
+            end
+          done
+        end
+      done;
+      let leaf_cost = half_area t.bounds (6*node) *. float_of_int len in
+      if !best_axis < 0 then make_leaf node start len
+      else if !best_cost >= leaf_cost && len <= 2 * leaf_size then make_leaf node start len
+      else begin
+        let axis = !best_axis in
+        let cmin = cbounds.(axis) and cmax = cbounds.(3+axis) in
+        let scale = float_of_int bins /. (cmax -. cmin) in
+        let goes_left p =
+          min (bins - 1) (int_of_float ((centroids.(3*p+axis) -. cmin) *. scale)) < !best_bin
+        in
+        (* In-place partition of the indices *)
+        let i = ref start and j = ref (start + len - 1) in
+        while !i <= !j do
+          if goes_left t.indices.(!i) then incr i
+          else begin
+            let tmp = t.indices.(!i) in
+            t.indices.(!i) <- t.indices.(!j);
+            t.indices.(!j) <- tmp;
+            decr j
+          end
+        done;
+        let nleft =
+          if !i = start || !i = start + len then len / 2 else !i - start
+        in
+        let left = t.nodes in
+        t.nodes <- t.nodes + 2;
+        t.first.(node) <- left;
+        t.count.(node) <- 0;
+        t.parent.(left) <- node;
+        t.parent.(left+1) <- node;
+        build left start nleft (depth + 1);
+        build (left+1) (start + nleft) (len - nleft) (depth + 1)
+      end
+    end
+  in
+  build 0 0 n 0;
+  t
+
+let length t = Array.length t.prims
+
+let nodes t = t.nodes
+
+let depth t = t.depth
+
+let get t i =
+  if i < 0 || i >= Array.length t.prims then raise (BVH_error "Primitive index out of bounds");
+  t.prims.(i)
+
+let bounds t =
+  FloatBox.create_from_points
+    (Vector3f.make t.bounds.(0) t.bounds.(1) t.bounds.(2))
+    (Vector3f.make t.bounds.(3) t.bounds.(4) t.bounds.(5))
+
+
+(* Refitting *)
+let refit_node t tmp node =
+  let o = 6 * node in
+  empty_bounds t.bounds o;
+  if t.count.(node) = 0 then begin
+    grow_bounds t.bounds o t.bounds (6 * t.first.(node));
+    grow_bounds t.bounds o t.bounds (6 * (t.first.(node) + 1))
+  end else begin
+    for i = t.first.(node) to t.first.(node) + t.count.(node) - 1 do
+      prim_bounds t.prims.(t.indices.(i)) tmp 0;
+      grow_bounds t.bounds o tmp 0
+    done
+  end
+
+let set t i p =
+  if i < 0 || i >= Array.length t.prims then raise (BVH_error "Primitive index out of bounds");
+  t.prims.(i) <- p
+
+let refit t =
+  let tmp = Array.make 6 0. in
+  for node = t.nodes - 1 downto 0 do
+    refit_node t tmp node
+  done
+
+let update t i p =
+  set t i p;
+  let tmp = Array.make 6 0. in
+  let rec up node =
+    if node >= 0 then begin
+      refit_node t tmp node;
+      up t.parent.(node)
+    end
+  in
+  up t.leaf.(i)
+
+
+(* Intersection tests *)
+let ray_box t node ox oy oz ix iy iz tmax =
+  let b = t.bounds and o = 6 * node in
+  let tx1 = (b.(o)   -. ox) *. ix and tx2 = (b.(o+3) -. ox) *. ix in
+  let ty1 = (b.(o+1) -. oy) *. iy and ty2 = (b.(o+4) -. oy) *. iy in
+  let tz1 = (b.(o+2) -. oz) *. iz and tz2 = (b.(o+5) -. oz) *. iz in
+  let tmin = fmax (fmax (fmin tx1 tx2) (fmin ty1 ty2)) (fmax (fmin tz1 tz2) 0.) in
+  let tmax = fmin (fmin (fmax tx1 tx2) (fmax ty1 ty2)) (fmin (fmax tz1 tz2) tmax) in
+  if tmin <= tmax then tmin else infinity
+
+(* Returns the distance along the ray, or infinity *)
+let ray_prim origin dir p =
+  let open Vector3f in
+  match p with
+  | Triangle (a, b, c) ->
+    (* Möller-Trumbore *)
+    let e1 = sub b a and e2 = sub c a in
+    let pv = cross dir e2 in
+    let det = dot e1 pv in
+    if abs_float det < 1e-12 then infinity
+    else begin
+      let inv = 1. /. det in
+      let tv = sub origin a in
+      let u = dot tv pv *. inv in
+      if u < 0. || u > 1. then infinity
+      else begin
+        let qv = cross tv e1 in
+        let v = dot dir qv *. inv in
+        if v < 0. || u +. v > 1. then infinity
+        else begin
+          let d = dot e2 qv *. inv in
+          if d >= 0. then d else infinity
+        end
+      end
+    end
+  | Sphere (c, r) ->
+    let oc = sub origin c in
+    let a = dot dir dir in
+    let b = dot oc dir in
+    let cc = dot oc oc -. r *. r in
+    let disc = b *. b -. a *. cc in
+    if disc < 0. then infinity
+    else begin
+      let s = sqrt disc in
+      let t1 = (-. b -. s) /. a and t2 = (-. b +. s) /. a in
+      if t1 >= 0. then t1 else if t2 >= 0. then 0. else infinity
+    end
+  | Box box ->
+    let p1 = FloatBox.abs_position box and p2 = FloatBox.abs_corner box in
+    let slab o d mn mx =
+      let i = 1. /. d in
+      let t1 = (mn -. o) *. i and t2 = (mx -. o) *. i in
+      (fmin t1 t2, fmax t1 t2)
+    in
+    let (xa, xb) = slab origin.x dir.x p1.x p2.x in
+    let (ya, yb) = slab origin.y dir.y p1.y p2.y in
+    let (za, zb) = slab origin.z dir.z p1.z p2.z in
+    let tmin = fmax (fmax xa ya) (fmax za 0.) in
+    let tmax = fmin xb (fmin yb zb) in
+    if tmin <= tmax then tmin else infinity
+
+let closest_on_triangle p a b c =
+  let open Vector3f in
+  (* Ericson, Real-Time Collision Detection, 5.1.5 *)
+  let ab = sub b a and ac = sub c a and ap = sub p a in
+  let d1 = dot ab ap and d2 = dot ac ap in
+  if d1 <= 0. && d2 <= 0. then a
+  else begin
+    let bp = sub p b in
+    let d3 = dot ab bp and d4 = dot ac bp in
+    if d3 >= 0. && d4 <= d3 then b
+    else begin
+      let vc = d1 *. d4 -. d3 *. d2 in
+      if vc <= 0. && d1 >= 0. && d3 <= 0. then endpoint a ab (d1 /. (d1 -. d3))
+      else begin
+        let cp = sub p c in
+        let d5 = dot ab cp and d6 = dot ac cp in
+        if d6 >= 0. && d5 <= d6 then c
+        else begin
+          let vb = d5 *. d2 -. d1 *. d6 in
+          if vb <= 0. && d2 >= 0. && d6 <= 0. then endpoint a ac (d2 /. (d2 -. d6))
+          else begin
+            let va = d3 *. d6 -. d5 *. d4 in
+            if va <= 0. && (d4 -. d3) >= 0. && (d5 -. d6) >= 0. then
+              endpoint b (sub c b) ((d4 -. d3) /. ((d4 -. d3) +. (d5 -. d6)))
+            else begin
+              let denom = 1. /. (va +. vb +. vc) in
+              add a (add (prop (vb *. denom) ab) (prop (vc *. denom) ac))
+            end
+          end
+        end
+      end
+    end
+  end
+
+let clamp_to_box p (b : FloatBox.t) =
+  let p1 = FloatBox.abs_position b and p2 = FloatBox.abs_corner b in
+  Vector3f.clamp p p1 p2
+
+(* Separating axis test between a triangle and a box (Akenine-Möller) *)
+let triangle_box a b c box =
+  let open Vector3f in
+  let p1 = FloatBox.abs_position box and p2 = FloatBox.abs_corner box in
+  let center = div 2. (add p1 p2) in
+  let h = div 2. (sub p2 p1) in
+  let v0 = sub a center and v1 = sub b center and v2 = sub c center in
+  let separated axis =
+    let d0 = dot v0 axis and d1 = dot v1 axis and d2 = dot v2 axis in
+    let r = h.x *. abs_float axis.x +. h.y *. abs_float axis.y +. h.z *. abs_float axis.z in
+    fmin d0 (fmin d1 d2) > r || fmax d0 (fmax d1 d2) < -. r
+  in
+  let e0 = sub v1 v0 and e1 = sub v2 v1 and e2 = sub v0 v2 in
+  let edges = [e0; e1; e2] in
+  let axes = [unit_x; unit_y; unit_z] in
+  not (
+    List.exists separated axes
+    || separated (cross e0 e1)
+    || List.exists (fun e -> List.exists (fun u -> separated (cross u e)) axes) edges
+  )
+
+(* Separating axis test between two triangles. The axes are the normals,
+ * the cross products of the edges, and the in-plane normals of the edges
+ * for coplanar triangles. *)
+let triangle_triangle a1 b1 c1 a2 b2 c2 =
+  let open Vector3f in
+  let separated axis =
+    let d0 = dot a1 axis and d1 = dot b1 axis and d2 = dot c1 axis in
+    let d3 = dot a2 axis and d4 = dot b2 axis and d5 = dot c2 axis in
+    fmin d0 (fmin d1 d2) > fmax d3 (fmax d4 d5) || fmax d0 (fmax d1 d2) < fmin d3 (fmin d4 d5)
+  in
+  let edges1 = [sub b1 a1; sub c1 b1; sub a1 c1] in
+  let edges2 = [sub b2 a2; sub c2 b2; sub a2 c2] in
+  let n1 = cross (sub b1 a1) (sub c1 a1) and n2 = cross (sub b2 a2) (sub c2 a2) in
+  not (
+    separated n1 || separated n2
+    || List.exists (fun u -> List.exists (fun v -> separated (cross u v)) edges2) edges1
+    || List.exists (fun e -> separated (cross n1 e)) edges1
+    || List.exists (fun e -> separated (cross n2 e)) edges2
+  )
+
+let prim_sphere p center radius =
+  let open Vector3f in
+  let r2 = radius *. radius in
+  match p with
+  | Triangle (a, b, c) -> squared_dist (closest_on_triangle center a b c) center <= r2
+  | Sphere (c, r) -> squared_dist c center <= (r +. radius) *. (r +. radius)
+  | Box b -> squared_dist (clamp_to_box center b) center <= r2
+
+let prim_box p box =
+  match p with
+  | Triangle (a, b, c) -> triangle_box a b c box
+  | Sphere (c, r) -> Vector3f.squared_dist (clamp_to_box c box) c <= r *. r
+  | Box b -> FloatBox.intersects b box
+
+
+(* Queries *)
+let stack t = Array.make (t.depth + 2) 0
+
+let raycast t ?max_dist:(max_dist = infinity) ~origin ~direction () =
+  let open Vector3f in
+  if squared_norm direction = 0. then raise (BVH_error "Cannot cast a ray with a zero direction");
+  let dir = normalize direction in
+  let ix = 1. /. dir.x and iy = 1. /. dir.y and iz = 1. /. dir.z in
+  let ox = origin.x and oy = origin.y and oz = origin.z in
+  let best = ref max_dist and best_prim = ref (-1) in
+  let st = stack t in
+  let sp = ref 0 in
+  if ray_box t 0 ox oy oz ix iy iz !best < infinity then begin
+    st.(0) <- 0; sp := 1
+  end;
+  while !sp > 0 do
+    decr sp;
+    let node = st.(!sp) in
+    (* The node may have been pushed before a closer hit was found *)
+    if ray_box t node ox oy oz ix iy iz !best < infinity then begin
+      if t.count.(node) > 0 then begin
+        for i = t.first.(node) to t.first.(node) + t.count.(node) - 1 do
+          let p = t.indices.(i) in
+          let d = ray_prim origin dir t.prims.(p) in
+          if d < !best then begin
+            best := d;
+            best_prim := p
+          end
+        done
+      end else begin
+        (* Visit the closest child first *)
+        let l = t.first.(node) in
+        let dl = ray_box t l ox oy oz ix iy iz !best in
+        let dr = ray_box t (l+1) ox oy oz ix iy iz !best in
+        let push n = st.(!sp) <- n; incr sp in
+        if dl <= dr then begin
+          if dr < infinity then push (l+1);
+          if dl < infinity then push l
+        end else begin
+          if dl < infinity then push l;
+          if dr < infinity then push (l+1)
+        end
+      end
+    end
+  done;
+  if !best_prim < 0 then None
+  else Some {primitive = !best_prim; distance = !best; point = endpoint origin dir !best}
+
+let raycast_all t ?max_dist:(max_dist = infinity) ~origin ~direction () =
+  let open Vector3f in
+  if squared_norm direction = 0. then raise (BVH_error "Cannot cast a ray with a zero direction");
+  let dir = normalize direction in
+  let ix = 1. /. dir.x and iy = 1. /. dir.y and iz = 1. /. dir.z in
+  let hits = ref [] in
+  let rec visit node =
+    if ray_box t node origin.x origin.y origin.z ix iy iz max_dist < infinity then begin
+      if t.count.(node) > 0 then
+        for i = t.first.(node) to t.first.(node) + t.count.(node) - 1 do
+          let p = t.indices.(i) in
+          let d = ray_prim origin dir t.prims.(p) in
+          if d <= max_dist then
+            hits := {primitive = p; distance = d; point = endpoint origin dir d} :: !hits
+        done
+      else begin
+        visit t.first.(node);
+        visit (t.first.(node) + 1)
+      end
+    end
+  in
+  visit 0;
+  List.sort (fun h1 h2 -> compare h1.distance h2.distance) !hits
+
+let query t node_test prim_test f =
+  let st = stack t in
+  let sp = ref 1 in
+  st.(0) <- 0;
+  while !sp > 0 do
+    decr sp;
+    let node = st.(!sp) in
+    if node_test node then begin
+      if t.count.(node) > 0 then
+        for i = t.first.(node) to t.first.(node) + t.count.(node) - 1 do
+          let p = t.indices.(i) in
+          if prim_test t.prims.(p) then f p
+        done
+      else begin
+        st.(!sp) <- t.first.(node);
+        st.(!sp + 1) <- t.first.(node) + 1;
+        sp := !sp + 2
+      end
+    end
+  done
+
+let box_node_test t box =
+  let p1 = FloatBox.abs_position box and p2 = FloatBox.abs_corner box in
+  fun node ->
+    let b = t.bounds and o = 6 * node in
+    let open Vector3f in
+    b.(o)   <= p2.x && b.(o+3) >= p1.x &&
+    b.(o+1) <= p2.y && b.(o+4) >= p1.y &&
+    b.(o+2) <= p2.z && b.(o+5) >= p1.z
+
+let overlap_box t box f =
+  query t (box_node_test t box) (fun p -> prim_box p box) f
+
+let overlap_sphere t center radius f =
+  let open Vector3f in
+  let node_test node =
+    let b = t.bounds and o = 6 * node in
+    let clamp v mn mx = if v < mn then mn else if v > mx then mx else v in
+    let dx = clamp center.x b.(o)   b.(o+3) -. center.x in
+    let dy = clamp center.y b.(o+1) b.(o+4) -. center.y in
+    let dz = clamp center.z b.(o+2) b.(o+5) -. center.z in
+    dx *. dx +. dy *. dy +. dz *. dz <= radius *. radius
+  in
+  query t node_test (fun p -> prim_sphere p center radius) f
+
+let overlap t prim f =
+  match prim with
+  | Sphere (c, r) -> overlap_sphere t c r f
+  | Box b -> overlap_box t b f
+  | Triangle (a, b, c) ->
+    let arr = Array.make 6 0. in
+    prim_bounds prim arr 0;
+    let box = FloatBox.create_from_points
+      (Vector3f.make arr.(0) arr.(1) arr.(2))
+      (Vector3f.make arr.(3) arr.(4) arr.(5))
+    in
+    let prim_test = function
+      | Sphere (center, r) -> prim_sphere prim center r
+      | Box b' -> triangle_box a b c b'
+      (* The bounding box discards most triangles before the exact test *)
+      | Triangle (a', b', c') as p -> prim_box p box && triangle_triangle a b c a' b' c'
+    in
+    query t (box_node_test t box) prim_test f
@@ -0,0 +1,44 @@
+open OgamlMath
+
+exception BVH_error of string
+
+type primitive =
+  | Triangle of Vector3f.t * Vector3f.t * Vector3f.t
+  | Sphere   of Vector3f.t * float
+  | Box      of FloatBox.t
+
+type hit = {
+  primitive : int;
+  distance  : float;
+  point     : Vector3f.t
+}
+
+type t
+
+val create : primitive array -> t
+
+val length : t -> int
+
+val nodes : t -> int
+
+val depth : t -> int
+
+val get : t -> int -> primitive
+
+val bounds : t -> FloatBox.t
+
+val set : t -> int -> primitive -> unit
+
+val refit : t -> unit
+
+val update : t -> int -> primitive -> unit
+
+val raycast : t -> ?max_dist:float -> origin:Vector3f.t -> direction:Vector3f.t -> unit -> hit option
+
+val raycast_all : t -> ?max_dist:float -> origin:Vector3f.t -> direction:Vector3f.t -> unit -> hit list
+
+val overlap_box : t -> FloatBox.t -> (int -> unit) -> unit
+
+val overlap_sphere : t -> Vector3f.t -> float -> (int -> unit) -> unit
+
+val overlap : t -> primitive -> (int -> unit) -> unit
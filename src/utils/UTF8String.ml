@@ -1,133 +1,228 @@
 
 type code = int
 
-type t = code array
+(* Strings keep their UTF-8 bytes, which are validated once when the string
+ * is created. The bytes are private : they are copied from and to strings,
+ * so the decoders can trust them. Random accesses to non-ASCII strings go through a sparse index
+ * of the byte offsets of every [stride]th code point, built on first use. *)
+type t = {
+  mutable bytes  : Bytes.t;
+          length : int;
+  mutable ascii  : bool;
+  mutable index  : int array
+}
 
 exception UTF8_error of string
 
 exception Out_of_bounds of string
 
-let empty () = [||]
-
-let make l c = 
-  if c < 0 || c > 0b1111111111111111111111111111111 then
-    raise (UTF8_error "Make : invalid code")
-  else Array.make l c
-
-let get s i = 
-  if i >= Array.length s || i < 0 then
-    raise (Out_of_bounds (Printf.sprintf "Accessing %i, length %i" i (Array.length s)))
-  else
-    s.(i)
-
-let set s i c = 
-  if i >= Array.length s || i < 0 then
-    raise (Out_of_bounds (Printf.sprintf "Setting %i, length %i" i (Array.length s)))
-  else if c < 0 || c > 0b1111111111111111111111111111111 then
-    raise (UTF8_error "Set : invalid code")
-  else
-    s.(i) <- c
-
-let length s = Array.length s
-
-let byte_length s = 
-  Array.fold_left (fun v c ->
-    if c <= 0b01111111 then (v+1)
-    else if c <= 0b11111111111 then (v+2)
-    else if c <= 0b1111111111111111 then (v+3)
-    else if c <= 0b111111111111111111111 then (v+4)
-    else if c <= 0b11111111111111111111111111 then (v+5)
-    else (v+6)
-  ) 0 s 
-
-let from_string s = 
-  let rec get_6bit_values i j = 
-    if i > j then 0
-    else if i >= String.length s || ((Char.code s.[i]) land 0b11000000 <> 0b10000000) then
-      raise (UTF8_error "Bad UTF-8 format, invalid byte sequence")
-    else begin
-      (((Char.code s.[i]) land 0b00111111) lsl ((j-i)*6)) + (get_6bit_values (i+1) j)
-    end
-  in
-  let rec iter i = 
-    if i >= String.length s then []
-    else begin
-      let c = Char.code s.[i] in
-      if c <= 127 then c :: (iter (i+1))
-      else if c land 0b11100000 = 0b11000000 then 
-        (((c land 0b00011111) lsl 6)  + (get_6bit_values (i+1) (i+1))) :: (iter (i+2))
-      else if c land 0b11110000 = 0b11100000 then
-        (((c land 0b00001111) lsl 12) + (get_6bit_values (i+1) (i+2))) :: (iter (i+3))
-      else if c land 0b11111000 = 0b11110000 then
-        (((c land 0b00000111) lsl 18) + (get_6bit_values (i+1) (i+3))) :: (iter (i+4))
-      else if c land 0b11111100 = 0b11111000 then
-        (((c land 0b00000011) lsl 24) + (get_6bit_values (i+1) (i+4))) :: (iter (i+5))
-      else if c land 0b11111110 = 0b11111100 then
-        (((c land 0b00000001) lsl 30) + (get_6bit_values (i+1) (i+5))) :: (iter (i+6))
-      else raise (UTF8_error "Bad UTF-8 format, invalid leading byte")
-    end
-  in
-  Array.of_list (iter 0)
-
-let to_string s = 
-  let str = Bytes.create (byte_length s) in
-  let rec iter i curr = 
-    if i >= Array.length s then ()
-    else begin
-      if s.(i) <= 0b01111111 then begin
-        Bytes.set str curr (Char.chr s.(i));
-        iter (i+1) (curr+1)
-      end
-      else if s.(i) <= 0b11111111111 then begin
-        Bytes.set str curr (Char.chr (0b11000000 lor (s.(i) lsr 6)));
-        Bytes.set str (curr+1) (Char.chr (0b10000000 lor (s.(i) land 0b111111)));
-        iter (i+1) (curr+2)
-      end
-      else if s.(i) <= 0b1111111111111111 then begin
-        Bytes.set str curr (Char.chr (0b11100000 lor (s.(i) lsr 12)));
-        Bytes.set str (curr+1) (Char.chr (0b10000000 lor ((s.(i) lsr 6) land 0b111111)));
-        Bytes.set str (curr+2) (Char.chr (0b10000000 lor (s.(i) land 0b111111)));
-        iter (i+1) (curr+3)
-      end
-      else if s.(i) <= 0b111111111111111111111 then begin
-        Bytes.set str curr (Char.chr (0b11110000 lor (s.(i) lsr 18)));
-        Bytes.set str (curr+1) (Char.chr (0b10000000 lor ((s.(i) lsr 12) land 0b111111)));
-        Bytes.set str (curr+2) (Char.chr (0b10000000 lor ((s.(i) lsr 6) land 0b111111)));
-        Bytes.set str (curr+3) (Char.chr (0b10000000 lor (s.(i) land 0b111111)));
-        iter (i+1) (curr+4)
-      end
-      else if s.(i) <= 0b11111111111111111111111111 then begin
-        Bytes.set str curr (Char.chr (0b11111000 lor (s.(i) lsr 24)));
-        Bytes.set str (curr+1) (Char.chr (0b10000000 lor ((s.(i) lsr 18) land 0b111111)));
-        Bytes.set str (curr+2) (Char.chr (0b10000000 lor ((s.(i) lsr 12) land 0b111111)));
-        Bytes.set str (curr+3) (Char.chr (0b10000000 lor ((s.(i) lsr 6) land 0b111111)));
-        Bytes.set str (curr+4) (Char.chr (0b10000000 lor (s.(i) land 0b111111)));
-        iter (i+1) (curr+5)
-      end
-      else begin
-        Bytes.set str curr (Char.chr (0b11111100 lor (s.(i) lsr 30)));
-        Bytes.set str (curr+1) (Char.chr (0b10000000 lor ((s.(i) lsr 24) land 0b111111)));
-        Bytes.set str (curr+2) (Char.chr (0b10000000 lor ((s.(i) lsr 18) land 0b111111)));
-        Bytes.set str (curr+3) (Char.chr (0b10000000 lor ((s.(i) lsr 12) land 0b111111)));
-        Bytes.set str (curr+4) (Char.chr (0b10000000 lor ((s.(i) lsr 6) land 0b111111)));
-        Bytes.set str (curr+5) (Char.chr (0b10000000 lor (s.(i) land 0b111111)));
-        iter (i+1) (curr+6)
-      end
-    end
-  in 
-  iter 0 0;
-  str
-
-let iter s f = Array.iter f s
-
-let fold s f v = Array.fold_left (fun a c -> f c a) v s
-
-let map s f = 
-  Array.map (fun c -> 
+let stride = 32
+
+external validate_stub : string -> int = "caml_utf8_validate"
+
+let is_code c = c >= 0 && c <= 0x10ffff && (c < 0xd800 || c > 0xdfff)
+
+let check_code name c =
+  if not (is_code c) then
+    raise (UTF8_error (Printf.sprintf "%s : invalid code" name))
+
+
+(* Encoding and decoding of valid sequences *)
+let code_width c =
+  if c < 0x80 then 1
+  else if c < 0x800 then 2
+  else if c < 0x10000 then 3
+  else 4
+
+let encode buf c =
+  if c < 0x80 then
+    Buffer.add_char buf (Char.unsafe_chr c)
+  else if c < 0x800 then begin
+    Buffer.add_char buf (Char.unsafe_chr (0xc0 lor (c lsr 6)));
+    Buffer.add_char buf (Char.unsafe_chr (0x80 lor (c land 0x3f)))
+  end else if c < 0x10000 then begin
+    Buffer.add_char buf (Char.unsafe_chr (0xe0 lor (c lsr 12)));
+    Buffer.add_char buf (Char.unsafe_chr (0x80 lor ((c lsr 6) land 0x3f)));
+    Buffer.add_char buf (Char.unsafe_chr (0x80 lor (c land 0x3f)))
+  end else begin
+    Buffer.add_char buf (Char.unsafe_chr (0xf0 lor (c lsr 18)));
+    Buffer.add_char buf (Char.unsafe_chr (0x80 lor ((c lsr 12) land 0x3f)));
+    Buffer.add_char buf (Char.unsafe_chr (0x80 lor ((c lsr 6) land 0x3f)));
+    Buffer.add_char buf (Char.unsafe_chr (0x80 lor (c land 0x3f)))
+  end
+
+let byte_width b =
+  if b < 0x80 then 1
+  else if b < 0xe0 then 2
+  else if b < 0xf0 then 3
+  else 4
+
+let cont s i = Char.code (Bytes.unsafe_get s i) land 0x3f
+
+(* Decodes the sequence of width [w] starting at byte [i], whose first byte is [b] *)
+let decode s i b w =
+  match w with
+  | 1 -> b
+  | 2 -> ((b land 0x1f) lsl 6) lor (cont s (i + 1))
+  | 3 -> ((b land 0x0f) lsl 12) lor ((cont s (i + 1)) lsl 6) lor (cont s (i + 2))
+  | _ -> ((b land 0x07) lsl 18) lor ((cont s (i + 1)) lsl 12)
+         lor ((cont s (i + 2)) lsl 6) lor (cont s (i + 3))
+
+let of_valid bytes length =
+  {bytes; length; ascii = (length = Bytes.length bytes); index = [||]}
+
+
+(* Random access *)
+let build_index s =
+  let b = s.bytes in
+  let index = Array.make ((s.length + stride - 1) / stride) 0 in
+  let i = ref 0 in
+  for k = 0 to s.length - 1 do
+    if k mod stride = 0 then index.(k / stride) <- !i;
+    i := !i + byte_width (Char.code (Bytes.unsafe_get b !i))
+  done;
+  s.index <- index
+
+let offset s k =
+  if s.ascii then k
+  else begin
+    if Array.length s.index = 0 then build_index s;
+    let b = s.bytes in
+    let i = ref s.index.(k / stride) in
+    for _i = 1 to k mod stride do
+      i := !i + byte_width (Char.code (Bytes.unsafe_get b !i))
+    done;
+    !i
+  end
+
+let check_bounds name s i =
+  if i >= s.length || i < 0 then
+    raise (Out_of_bounds (Printf.sprintf "%s %i, length %i" name i s.length))
+
+
+(* Exposed functions *)
+let validate s =
+  let r = validate_stub s in
+  if r >= 0 then None else Some (- r - 1)
+
+let empty () = of_valid Bytes.empty 0
+
+let make l c =
+  check_code "Make" c;
+  let buf = Buffer.create (max 0 l * code_width c) in
+  for _i = 1 to l do encode buf c done;
+  of_valid (Buffer.to_bytes buf) (max 0 l)
+
+let get s i =
+  check_bounds "Accessing" s i;
+  if s.ascii then Char.code (Bytes.unsafe_get s.bytes i)
+  else begin
+    let o = offset s i in
+    let b = Char.code (Bytes.unsafe_get s.bytes o) in
+    decode s.bytes o b (byte_width b)
+  end
+
+(* Codes of the same width are written in place. Other codes move the
+ * following bytes, so the index is invalidated and rebuilt on the next
+ * access *)
+let set s i c =
+  check_bounds "Setting" s i;
+  check_code "Set" c;
+  let o = offset s i in
+  let w = byte_width (Char.code (Bytes.unsafe_get s.bytes o)) in
+  let w' = code_width c in
+  let buf = Buffer.create w' in
+  encode buf c;
+  if w = w' then
+    Buffer.blit buf 0 s.bytes o w
+  else begin
+    let n = Bytes.length s.bytes in
+    let bytes = Bytes.create (n - w + w') in
+    Bytes.blit s.bytes 0 bytes 0 o;
+    Buffer.blit buf 0 bytes o w';
+    Bytes.blit s.bytes (o + w) bytes (o + w') (n - o - w);
+    s.bytes <- bytes;
+    s.ascii <- Bytes.length bytes = s.length;
+    s.index <- [||]
+  end
+
+let length s = s.length
+
+let byte_length s = Bytes.length s.bytes
+
+let is_ascii s = s.ascii
+
+let byte_offset s i =
+  if i = s.length then Bytes.length s.bytes
+  else begin
+    check_bounds "Offset of" s i;
+    offset s i
+  end
+
+let from_string s =
+  let r = validate_stub s in
+  if r < 0 then
+    raise (UTF8_error (Printf.sprintf
+      "Bad UTF-8 format, invalid byte sequence at byte %i" (- r - 1)));
+  of_valid (Bytes.of_string s) r
+
+let to_string s = Bytes.to_string s.bytes
+
+(* The bytes are decoded in place, without allocating *)
+let iter s f =
+  let b = s.bytes in
+  let n = Bytes.length b in
+  if s.ascii then
+    for i = 0 to n - 1 do f (Char.code (Bytes.unsafe_get b i)) done
+  else begin
+    let i = ref 0 in
+    while !i < n do
+      let c = Char.code (Bytes.unsafe_get b !i) in
+      let w = byte_width c in
+      f (decode b !i c w);
+      i := !i + w
+    done
+  end
+
+let iteri s f =
+  let b = s.bytes in
+  let n = Bytes.length b in
+  if s.ascii then
+    for i = 0 to n - 1 do f i (Char.code (Bytes.unsafe_get b i)) done
+  else begin
+    let i = ref 0 and k = ref 0 in
+    while !i < n do
+      let c = Char.code (Bytes.unsafe_get b !i) in
+      let w = byte_width c in
+      f !k (decode b !i c w);
+      i := !i + w;
+      incr k
+    done
+  end
+
+let fold s f v =
+  let b = s.bytes in
+  let n = Bytes.length b in
+  let acc = ref v in
+  if s.ascii then
+    for i = 0 to n - 1 do acc := f (Char.code (Bytes.unsafe_get b i)) !acc done
+  else begin
+    let i = ref 0 in
+    while !i < n do
+      let c = Char.code (Bytes.unsafe_get b !i) in
+      let w = byte_width c in
+      acc := f (decode b !i c w) !acc;
+      i := !i + w
+    done
+  end;
+  !acc
+
+let map s f =
+  let buf = Buffer.create (Bytes.length s.bytes) in
+  iter s (fun c ->
     let c' = f c in
-    if c' < 0 || c' > 0b1111111111111111111111111111111 then
-      raise (UTF8_error "Map : invalid code")
-    else c'
-  ) s
-
+    check_code "Map" c';
+    encode buf c'
+  );
+  of_valid (Buffer.to_bytes buf) s.length
 
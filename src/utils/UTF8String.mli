@@ -7,6 +7,8 @@ exception UTF8_error of string
 
 exception Out_of_bounds of string
 
+val validate : string -> int option
+
 val empty : unit -> t
 
 val make : int -> code -> t
@@ -19,12 +21,18 @@ val length : t -> int
 
 val byte_length : t -> int
 
+val is_ascii : t -> bool
+
+val byte_offset : t -> int -> int
+
 val from_string : string -> t
 
 val to_string : t -> string
 
 val iter : t -> (code -> unit) -> unit
 
+val iteri : t -> (int -> code -> unit) -> unit
+
 val fold : t -> (code -> 'a -> 'a) -> 'a -> 'a
 
 val map : t -> (code -> code) -> t
@@ -0,0 +1,352 @@
+open OgamlMath
+
+exception Animation_error of string
+
+type buffer = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+
+(* Segment lookup in sorted key times. [locate times cursor t] returns s such
+ * that times.(s) <= t < times.(s + 1), clamped to the first and last
+ * segments, starting from the segment of the previous lookup. *)
+let locate times cursor t =
+  let n = Array.length times in
+  if n < 2 || t < times.(1) then (cursor := 0; 0)
+  else if t >= times.(n - 2) then (cursor := n - 2; n - 2)
+  else begin
+    let c = !cursor in
+    if times.(c) <= t && t < times.(c + 1) then c
+    else if times.(c + 1) <= t && t < times.(c + 2) then (cursor := c + 1; c + 1)
+    else begin
+      (* Invariant : times.(lo) <= t < times.(hi) *)
+      let lo = ref 1 and hi = ref (n - 2) in
+      while !hi - !lo > 1 do
+        let mid = (!lo + !hi) / 2 in
+        if times.(mid) <= t then lo := mid else hi := mid
+      done;
+      cursor := !lo;
+      !lo
+    end
+  end
+
+(* Local parameter in [0;1] of t in the segment s *)
+let local times inv s t =
+  if Array.length times < 2 then 0.
+  else if t >= times.(s + 1) then 1.
+  else if t <= times.(s) then 0.
+  else (t -. times.(s)) *. inv.(s)
+
+
+module Track = struct
+
+  type interpolation = Step | Linear | Cubic | Slerp
+
+  (* Coefficients of each segment, for each component :
+   * - Step and Linear : start value and difference (2 floats)
+   * - Cubic : polynomial of the local parameter (4 floats)
+   * - Slerp : both quaternions, the angle and its inverse sine (10 floats,
+   *   only one component) *)
+  type t = {
+    times  : float array;
+    inv    : float array;   (* Inverse durations of the segments *)
+    dim    : int;
+    interp : interpolation;
+    coeffs : float array;
+    cursor : int ref
+  }
+
+  let check_times name times =
+    if Array.length times = 0 then
+      raise (Animation_error (name ^ " : no key"));
+    for i = 1 to Array.length times - 1 do
+      if not (times.(i - 1) <= times.(i)) then
+        raise (Animation_error (name ^ " : key times must be sorted"))
+    done
+
+  let segments times = max 1 (Array.length times - 1)
+
+  let inverses times =
+    Array.init (segments times) (fun s ->
+      if s + 1 >= Array.length times then 0.
+      else begin
+        let dt = times.(s + 1) -. times.(s) in
+        if dt > 0. then 1. /. dt else 0.
+      end)
+
+  (* Index of the last key of the segment s *)
+  let next times s = min (s + 1) (Array.length times - 1)
+
+  let make name interp ?dimension:(dim = 1) times values =
+    check_times name times;
+    if dim < 1 then raise (Animation_error (name ^ " : dimension must be positive"));
+    if Array.length values <> dim * Array.length times then
+      raise (Animation_error (name ^ " : wrong number of values"));
+    let times = Array.copy times in
+    let coeffs = Array.make (2 * dim * segments times) 0. in
+    for s = 0 to segments times - 1 do
+      let s' = next times s in
+      for c = 0 to dim - 1 do
+        let v0 = values.(s * dim + c) and v1 = values.(s' * dim + c) in
+        coeffs.(2 * (s * dim + c))     <- v0;
+        coeffs.(2 * (s * dim + c) + 1) <- v1 -. v0
+      done
+    done;
+    {times; inv = inverses times; dim; interp; coeffs; cursor = ref 0}
+
+  let step ?dimension times values = make "Step" Step ?dimension times values
+
+  let linear ?dimension times values = make "Linear" Linear ?dimension times values
+
+  let cubic ?dimension:(dim = 1) ?tangents times values =
+    check_times "Cubic" times;
+    if dim < 1 then raise (Animation_error "Cubic : dimension must be positive");
+    let n = Array.length times in
+    if Array.length values <> dim * n then
+      raise (Animation_error "Cubic : wrong number of values");
+    (* Default tangents are the means of the slopes of the adjacent segments *)
+    let slope i c =
+      let dt = times.(i + 1) -. times.(i) in
+      if dt > 0. then (values.((i + 1) * dim + c) -. values.(i * dim + c)) /. dt
+      else 0.
+    in
+    let tangents =
+      match tangents with
+      | Some tg ->
+        if Array.length tg <> dim * n then
+          raise (Animation_error "Cubic : wrong number of tangents");
+        tg
+      | None ->
+        Array.init (dim * n) (fun k ->
+          let i = k / dim and c = k mod dim in
+          if n < 2 then 0.
+          else if i = 0 then slope 0 c
+          else if i = n - 1 then slope (n - 2) c
+          else (slope (i - 1) c +. slope i c) /. 2.)
+    in
+    let times = Array.copy times in
+    let coeffs = Array.make (4 * dim * segments times) 0. in
+    for s = 0 to segments times - 1 do
+      let s' = next times s in
+      let dt = times.(s') -. times.(s) in
+      for c = 0 to dim - 1 do
+        let p1 = values.(s * dim + c) and p2 = values.(s' * dim + c) in
+        let m1 = tangents.(s * dim + c) *. dt and m2 = tangents.(s' * dim + c) *. dt in
+        let k = 4 * (s * dim + c) in
+        coeffs.(k)     <- p1;
+        coeffs.(k + 1) <- m1;
+        coeffs.(k + 2) <- 3. *. (p2 -. p1) -. 2. *. m1 -. m2;
+        coeffs.(k + 3) <- 2. *. (p1 -. p2) +. m1 +. m2
+      done
+    done;
+    {times; inv = inverses times; dim; interp = Cubic; coeffs; cursor = ref 0}
+
+  (* The keys are normalized and the second quaternion of each segment is
+   * negated if needed, so that rotations take the shortest path *)
+  let rotation times keys =
+    check_times "Rotation" times;
+    if Array.length keys <> Array.length times then
+      raise (Animation_error "Rotation : wrong number of keys");
+    let keys = Array.map (fun q ->
+      try Quaternion.normalize q
+      with Quaternion.Quaternion_exception _ ->
+        raise (Animation_error "Rotation : zero quaternion")) keys
+    in
+    let times = Array.copy times in
+    let coeffs = Array.make (10 * segments times) 0. in
+    for s = 0 to segments times - 1 do
+      let q0 = keys.(s) and q1 = keys.(next times s) in
+      let open Quaternion in
+      let d = q0.r *. q1.r +. q0.i *. q1.i +. q0.j *. q1.j +. q0.k *. q1.k in
+      let q1 = if d < 0. then prop (-1.) q1 else q1 in
+      let theta = acos (min 1. (abs_float d)) in
+      let k = 10 * s in
+      coeffs.(k)     <- q0.r;
+      coeffs.(k + 1) <- q0.i;
+      coeffs.(k + 2) <- q0.j;
+      coeffs.(k + 3) <- q0.k;
+      coeffs.(k + 4) <- q1.r;
+      coeffs.(k + 5) <- q1.i;
+      coeffs.(k + 6) <- q1.j;
+      coeffs.(k + 7) <- q1.k;
+      coeffs.(k + 8) <- theta;
+      coeffs.(k + 9) <- if theta > 1e-6 then 1. /. sin theta else 0.
+    done;
+    {times; inv = inverses times; dim = 4; interp = Slerp; coeffs; cursor = ref 0}
+
+  let dimension t = t.dim
+
+  let keys t = Array.length t.times
+
+  let start t = t.times.(0)
+
+  let stop t = t.times.(Array.length t.times - 1)
+
+  let duration t = stop t -. start t
+
+  (* Weights of both quaternions of the segment starting at coefficient k *)
+  let slerp_weights co k u =
+    let theta = co.(k + 8) in
+    if theta > 1e-6 then
+      (sin ((1. -. u) *. theta) *. co.(k + 9), sin (u *. theta) *. co.(k + 9))
+    else begin
+      (* Almost equal keys : normalized linear interpolation *)
+      let x c = (1. -. u) *. co.(k + c) +. u *. co.(k + 4 + c) in
+      let n = sqrt (x 0 *. x 0 +. x 1 *. x 1 +. x 2 *. x 2 +. x 3 *. x 3) in
+      ((1. -. u) /. n, u /. n)
+    end
+
+  (* Component c of the value of the segment s at the local parameter u *)
+  let component t s u c =
+    let co = t.coeffs in
+    match t.interp with
+    | Step ->
+      let k = 2 * (s * t.dim + c) in
+      if u >= 1. then co.(k) +. co.(k + 1) else co.(k)
+    | Linear ->
+      let k = 2 * (s * t.dim + c) in
+      co.(k) +. u *. co.(k + 1)
+    | Cubic ->
+      let k = 4 * (s * t.dim + c) in
+      co.(k) +. u *. (co.(k + 1) +. u *. (co.(k + 2) +. u *. co.(k + 3)))
+    | Slerp ->
+      let k = 10 * s in
+      let (a, b) = slerp_weights co k u in
+      a *. co.(k + c) +. b *. co.(k + 4 + c)
+
+  (* Same as component, for all the components at once. The buffer type is
+   * given so that the accesses are specialized. *)
+  let eval t s u (buf : buffer) o =
+    let dim = t.dim and co = t.coeffs in
+    match t.interp with
+    | Step ->
+      for c = 0 to dim - 1 do
+        let k = 2 * (s * dim + c) in
+        Bigarray.Array1.unsafe_set buf (o + c)
+          (if u >= 1. then co.(k) +. co.(k + 1) else co.(k))
+      done
+    | Linear ->
+      for c = 0 to dim - 1 do
+        let k = 2 * (s * dim + c) in
+        Bigarray.Array1.unsafe_set buf (o + c) (co.(k) +. u *. co.(k + 1))
+      done
+    | Cubic ->
+      for c = 0 to dim - 1 do
+        let k = 4 * (s * dim + c) in
+        Bigarray.Array1.unsafe_set buf (o + c)
+          (co.(k) +. u *. (co.(k + 1) +. u *. (co.(k + 2) +. u *. co.(k + 3))))
+      done
+    | Slerp ->
+      let k = 10 * s in
+      let (a, b) = slerp_weights co k u in
+      for c = 0 to 3 do
+        Bigarray.Array1.unsafe_set buf (o + c) (a *. co.(k + c) +. b *. co.(k + 4 + c))
+      done
+
+  let sample t time buf offset =
+    if offset < 0 || offset + t.dim > Bigarray.Array1.dim buf then
+      raise (Animation_error "Sample : buffer too small");
+    let s = locate t.times t.cursor time in
+    eval t s (local t.times t.inv s time) buf offset
+
+  let get t time =
+    let s = locate t.times t.cursor time in
+    component t s (local t.times t.inv s time) 0
+
+  let quaternion t time =
+    if t.interp <> Slerp then
+      raise (Animation_error "Quaternion : not a rotation track");
+    let s = locate t.times t.cursor time in
+    let u = local t.times t.inv s time in
+    {Quaternion.r = component t s u 0;
+     i = component t s u 1;
+     j = component t s u 2;
+     k = component t s u 3}
+
+end
+
+
+(* Tracks whose keys are at the same times share their segment lookup,
+ * which is done once per group for each sample *)
+type t = {
+  tracks  : Track.t array;
+  offsets : int array;
+  size    : int;
+  group   : int array;         (* Group of each track *)
+  times   : float array array; (* Key times of each group *)
+  inv     : float array array;
+  cursors : int ref array;
+  segment : int array;         (* Segment and local parameter of each group *)
+  param   : float array;
+  start   : float;
+  stop    : float
+}
+
+let create tracks =
+  let tracks = Array.of_list tracks in
+  if Array.length tracks = 0 then raise (Animation_error "Create : no track");
+  let offsets = Array.make (Array.length tracks) 0 in
+  let size = ref 0 in
+  Array.iteri (fun i tr ->
+    offsets.(i) <- !size;
+    size := !size + tr.Track.dim) tracks;
+  let groups = Hashtbl.create 16 and firsts = ref [] in
+  let group = Array.map (fun tr ->
+    try Hashtbl.find groups tr.Track.times
+    with Not_found ->
+      let g = Hashtbl.length groups in
+      Hashtbl.add groups tr.Track.times g;
+      firsts := tr :: !firsts;
+      g) tracks
+  in
+  let firsts = Array.of_list (List.rev !firsts) in
+  let ngroups = Array.length firsts in
+  {
+    tracks; offsets; group;
+    size    = !size;
+    times   = Array.map (fun tr -> tr.Track.times) firsts;
+    inv     = Array.map (fun tr -> tr.Track.inv) firsts;
+    cursors = Array.init ngroups (fun _ -> ref 0);
+    segment = Array.make ngroups 0;
+    param   = Array.make ngroups 0.;
+    start   = Array.fold_left (fun m tr -> min m (Track.start tr)) infinity tracks;
+    stop    = Array.fold_left (fun m tr -> max m (Track.stop tr)) neg_infinity tracks
+  }
+
+let tracks t = Array.length t.tracks
+
+let size t = t.size
+
+let offset t i =
+  if i < 0 || i >= Array.length t.tracks then
+    raise (Animation_error "Offset : invalid track");
+  t.offsets.(i)
+
+let start t = t.start
+
+let stop t = t.stop
+
+let duration t = t.stop -. t.start
+
+let buffer t =
+  let buf = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout t.size in
+  Bigarray.Array1.fill buf 0.;
+  buf
+
+let sample ?loop:(loop = false) t time buf =
+  if Bigarray.Array1.dim buf < t.size then
+    raise (Animation_error "Sample : buffer too small");
+  let time =
+    let d = t.stop -. t.start in
+    if loop && d > 0. then begin
+      let x = mod_float (time -. t.start) d in
+      t.start +. (if x < 0. then x +. d else x)
+    end else time
+  in
+  for g = 0 to Array.length t.times - 1 do
+    let s = locate t.times.(g) t.cursors.(g) time in
+    t.segment.(g) <- s;
+    t.param.(g) <- local t.times.(g) t.inv.(g) s time
+  done;
+  for i = 0 to Array.length t.tracks - 1 do
+    let g = t.group.(i) and o = t.offsets.(i) in
+    Track.eval t.tracks.(i) t.segment.(g) t.param.(g) buf o
+  done
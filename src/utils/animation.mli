@@ -0,0 +1,53 @@
+exception Animation_error of string
+
+type buffer = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+module Track : sig
+
+  type t
+
+  val step : ?dimension:int -> float array -> float array -> t
+
+  val linear : ?dimension:int -> float array -> float array -> t
+
+  val cubic : ?dimension:int -> ?tangents:float array -> float array -> float array -> t
+
+  val rotation : float array -> OgamlMath.Quaternion.t array -> t
+
+  val dimension : t -> int
+
+  val keys : t -> int
+
+  val start : t -> float
+
+  val stop : t -> float
+
+  val duration : t -> float
+
+  val sample : t -> float -> buffer -> int -> unit
+
+  val get : t -> float -> float
+
+  val quaternion : t -> float -> OgamlMath.Quaternion.t
+
+end
+
+type t
+
+val create : Track.t list -> t
+
+val tracks : t -> int
+
+val size : t -> int
+
+val offset : t -> int -> int
+
+val start : t -> float
+
+val stop : t -> float
+
+val duration : t -> float
+
+val buffer : t -> buffer
+
+val sample : ?loop:bool -> t -> float -> buffer -> unit
@@ -1,25 +1,42 @@
+external monotonic_ns : unit -> int = "caml_clock_monotonic_ns"
 
 type t = 
   {
     mutable ticks : int;
-    mutable start : float
+    mutable start : int
   }
 
+let now_ns () = monotonic_ns ()
+
+let now () = float_of_int (monotonic_ns ()) *. 1e-9
+
+(* Thread.delay overshoots by up to the scheduler granularity (several
+ * milliseconds on some systems), so it is only used for the bulk of the wait
+ * and the last [spin] seconds are spent yielding *)
+let sleep_until ?spin:(spin = 0.002) deadline =
+  let margin = int_of_float (spin *. 1e9) in
+  let remaining = deadline - monotonic_ns () in
+  if remaining > margin then
+    Thread.delay (float_of_int (remaining - margin) *. 1e-9);
+  while monotonic_ns () < deadline do
+    Thread.yield ()
+  done
+
 let create () = 
   {
     ticks = 0;
-    start = Unix.gettimeofday ()
+    start = monotonic_ns ()
   }
 
 let restart t = 
   t.ticks <- 0;
-  t.start <- Unix.gettimeofday ()
+  t.start <- monotonic_ns ()
 
 let tick t = 
   t.ticks <- t.ticks + 1
 
 let time t = 
-  Unix.gettimeofday () -. t.start
+  float_of_int (monotonic_ns () - t.start) *. 1e-9
 
 let ticks t = 
   t.ticks
@@ -29,4 +46,3 @@ let tps t =
 
 let spt t = 
   (time t) /. (float_of_int t.ticks)
-
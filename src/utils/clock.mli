@@ -1,6 +1,12 @@
 
 type t
 
+val now_ns : unit -> int
+
+val now : unit -> float
+
+val sleep_until : ?spin:float -> int -> unit
+
 val create : unit -> t
 
 val restart : t -> unit
@@ -0,0 +1,212 @@
+open OgamlMath
+
+exception FlowField_exception of string
+
+module FHeap = PriorityQueue.Indexed (struct
+
+  type t = float
+
+  let compare (f1 : float) (f2 : float) = compare f1 f2
+
+end)
+
+(* Handles are recycled, so a handle is only valid if it still holds v *)
+let queued heap hd (v : int) = FHeap.mem heap hd && FHeap.value heap hd = v
+
+module Grid = Pathfinding.Grid
+
+type t = {
+  grid   : Grid.t;
+  width  : int;
+  goal   : Bytes.t;
+  dist   : float array; (* Integration field : distance to the closest goal *)
+  next   : int array;   (* Next cell towards the goal, or -1 *)
+  handle : int array;
+  hstamp : int array;
+  mutable gen : int;
+  heap   : int FHeap.t;
+  mutable listener : Grid.listener option
+}
+
+let neighbour t v dx dy =
+  let x = v mod t.width + dx and y = v / t.width + dy in
+  if x >= 0 && y >= 0 && x < t.width && y < Grid.height t.grid then y * t.width + x
+  else -1
+
+let walkable t v =
+  Grid.walkable t.grid (v mod t.width) (v / t.width)
+
+let is_goal t v =
+  Bytes.get t.goal v <> '\000'
+
+let push t v d p =
+  t.dist.(v) <- d;
+  t.next.(v) <- p;
+  if t.hstamp.(v) = t.gen && queued t.heap t.handle.(v) v then
+    FHeap.decrease_key t.heap t.handle.(v) d
+  else begin
+    t.handle.(v) <- FHeap.insert t.heap d v;
+    t.hstamp.(v) <- t.gen
+  end
+
+(* Dijkstra from the cells in the heap. The moves of a grid are symmetric,
+ * so the distances from the goals are the distances to the goals. *)
+let propagate t =
+  while not (FHeap.is_empty t.heap) do
+    let v = FHeap.extract t.heap in
+    let dv = t.dist.(v) in
+    Grid.iter_moves t.grid (v mod t.width) (v / t.width) (fun x y c ->
+      let u = y * t.width + x in
+      if dv +. c < t.dist.(u) then push t u (dv +. c) v)
+  done;
+  t.gen <- t.gen + 1;
+  FHeap.clear t.heap
+
+(* Takes the best distance through the neighbours of a cell *)
+let relax t v =
+  if walkable t v then
+    Grid.iter_moves t.grid (v mod t.width) (v / t.width) (fun x y c ->
+      let u = y * t.width + x in
+      if t.dist.(u) +. c < t.dist.(v) then push t v (t.dist.(u) +. c) u)
+
+(* Blocking a cell removes its moves and the diagonal moves passing by it.
+ * Only the cells whose path used one of these moves are affected : they
+ * are reset, then recomputed from the unaffected cells around them. *)
+let block t c =
+  let seeds = ref [c] in
+  let pair a b =
+    if a >= 0 && b >= 0 then begin
+      if t.next.(a) = b then seeds := a :: !seeds;
+      if t.next.(b) = a then seeds := b :: !seeds
+    end
+  in
+  let left = neighbour t c (-1) 0 and right = neighbour t c 1 0 in
+  let up = neighbour t c 0 (-1) and down = neighbour t c 0 1 in
+  pair left up; pair left down; pair right up; pair right down;
+  let reset = ref [] in
+  let rec invalidate = function
+    | [] -> ()
+    | v :: stack when t.next.(v) = -2 -> invalidate stack
+    | v :: stack ->
+      t.dist.(v) <- infinity;
+      t.next.(v) <- -2;
+      reset := v :: !reset;
+      let stack = ref stack in
+      for dy = -1 to 1 do
+        for dx = -1 to 1 do
+          let u = neighbour t v dx dy in
+          if u >= 0 && t.next.(u) = v then stack := u :: !stack
+        done
+      done;
+      invalidate !stack
+  in
+  invalidate !seeds;
+  List.iter (fun v -> t.next.(v) <- -1) !reset;
+  List.iter (relax t) !reset;
+  propagate t
+
+(* Unblocking a cell adds moves between the cell and its neighbours, and
+ * diagonal moves between its orthogonal neighbours *)
+let unblock t c =
+  if is_goal t c then push t c 0. (-1);
+  relax t c;
+  for dy = -1 to 1 do
+    for dx = -1 to 1 do
+      let u = neighbour t c dx dy in
+      if u >= 0 then relax t u
+    done
+  done;
+  propagate t
+
+let create grid goals =
+  let width = Grid.width grid and height = Grid.height grid in
+  let n = width * height in
+  let t = {
+    grid; width;
+    goal   = Bytes.make n '\000';
+    dist   = Array.make n infinity;
+    next   = Array.make n (-1);
+    handle = Array.make n 0;
+    hstamp = Array.make n (-1);
+    gen    = 0;
+    heap   = FHeap.create ();
+    listener = None
+  } in
+  List.iter (fun (v : Vector2i.t) ->
+    if v.x < 0 || v.x >= width || v.y < 0 || v.y >= height then
+      raise (FlowField_exception "Goal out of bounds");
+    let i = Grid.index grid v in
+    Bytes.set t.goal i '\001';
+    if not (Grid.is_blocked grid v) && t.dist.(i) > 0. then push t i 0. (-1)
+  ) goals;
+  propagate t;
+  t.listener <- Some (Grid.on_change grid (fun x y ->
+    let c = y * width + x in
+    if walkable t c then unblock t c else block t c));
+  t
+
+let release t =
+  match t.listener with
+  | Some l -> Grid.remove_listener t.grid l; t.listener <- None
+  | None -> ()
+
+let distance t v =
+  t.dist.(Grid.index t.grid v)
+
+let next t v =
+  let n = t.next.(Grid.index t.grid v) in
+  if n < 0 then None else Some (Grid.cell t.grid n)
+
+let direction t v =
+  let i = Grid.index t.grid v in
+  let n = t.next.(i) in
+  if n < 0 then Vector2i.zero
+  else Vector2i.make (n mod t.width - i mod t.width) (n / t.width - i / t.width)
+
+
+module CSR = struct
+
+  type t = {
+    dist : float array;
+    next : int array
+  }
+
+  let create g goals =
+    let n = Graph.CSR.vertices g in
+    (* Distances to the goals are distances from the goals in the reversed graph *)
+    let b = Graph.CSR.Builder.create ~vertices:n () in
+    Graph.CSR.iter_edges g (fun v u c -> Graph.CSR.Builder.add_edge b ~cost:c u v);
+    let rev = Graph.CSR.Builder.freeze b in
+    let dist = Array.make n infinity and next = Array.make n (-1) in
+    let handle = Array.make n (-1) in
+    let heap = FHeap.create () in
+    let push v d p =
+      dist.(v) <- d;
+      next.(v) <- p;
+      if handle.(v) >= 0 && queued heap handle.(v) v then FHeap.decrease_key heap handle.(v) d
+      else handle.(v) <- FHeap.insert heap d v
+    in
+    List.iter (fun v ->
+      if v < 0 || v >= n then raise (FlowField_exception "Goal out of bounds");
+      if dist.(v) > 0. then push v 0. (-1)
+    ) goals;
+    while not (FHeap.is_empty heap) do
+      let v = FHeap.extract heap in
+      let dv = dist.(v) in
+      Graph.CSR.iter_neighbours rev v (fun u c ->
+        if dv +. c < dist.(u) then push u (dv +. c) v)
+    done;
+    {dist; next}
+
+  let check t v =
+    if v < 0 || v >= Array.length t.dist then raise (FlowField_exception "Vertex out of bounds")
+
+  let distance t v =
+    check t v;
+    t.dist.(v)
+
+  let next t v =
+    check t v;
+    if t.next.(v) < 0 then None else Some t.next.(v)
+
+end
@@ -0,0 +1,26 @@
+exception FlowField_exception of string
+
+type t
+
+val create : Pathfinding.Grid.t -> OgamlMath.Vector2i.t list -> t
+
+val distance : t -> OgamlMath.Vector2i.t -> float
+
+val next : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t option
+
+val direction : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t
+
+val release : t -> unit
+
+
+module CSR : sig
+
+  type t
+
+  val create : Graph.CSR.t -> int list -> t
+
+  val distance : t -> int -> float
+
+  val next : t -> int -> int option
+
+end
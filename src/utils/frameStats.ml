@@ -0,0 +1,121 @@
+exception FrameStats_exception of string
+
+type t = {
+  window : int;
+  factor : float;
+  ring   : float array;  (* Last frames, in the order of arrival *)
+  sorted : float array;  (* Same frames, sorted *)
+  mutable next   : int;  (* Slot of the next frame in [ring] *)
+  mutable length : int;
+  mutable sum    : float;
+  mutable total  : int;
+  mutable hitches : int;
+  mutable hitch  : bool
+}
+
+let create ?window:(window = 240) ?hitch_factor:(factor = 2.) () =
+  if window < 1 then raise (FrameStats_exception "Window must contain at least one frame");
+  if not (factor > 1.) then raise (FrameStats_exception "Hitch factor must be greater than 1");
+  {
+    window; factor;
+    ring   = Array.make window 0.;
+    sorted = Array.make window 0.;
+    next   = 0;
+    length = 0;
+    sum    = 0.;
+    total  = 0;
+    hitches = 0;
+    hitch  = false
+  }
+
+let reset t =
+  t.next <- 0;
+  t.length <- 0;
+  t.sum <- 0.;
+  t.total <- 0;
+  t.hitches <- 0;
+  t.hitch <- false
+
+let window t = t.window
+
+let frames t = t.length
+
+let total t = t.total
+
+(* First index of [sorted] whose value is not less than [v] *)
+let lower_bound t v =
+  let lo = ref 0 and hi = ref t.length in
+  while !lo < !hi do
+    let mid = (!lo + !hi) / 2 in
+    if t.sorted.(mid) < v then lo := mid + 1 else hi := mid
+  done;
+  !lo
+
+let percentile t p =
+  if t.length = 0 then 0.
+  else begin
+    let p = if p < 0. then 0. else if p > 1. then 1. else p in
+    (* Nearest rank *)
+    let k = int_of_float (ceil (p *. float_of_int t.length)) - 1 in
+    t.sorted.(max 0 k)
+  end
+
+let median t = percentile t 0.5
+
+(* The sorted copy is kept up to date by moving the frames between the old
+ * and the new value by one slot, which is linear in the window but does not
+ * allocate, and makes percentiles constant-time *)
+let add t dt =
+  t.hitch <- t.length > 0 && dt > t.factor *. median t;
+  if t.hitch then t.hitches <- t.hitches + 1;
+  t.total <- t.total + 1;
+  if t.length = t.window then begin
+    let old = t.ring.(t.next) in
+    t.sum <- t.sum -. old;
+    let i = lower_bound t old in
+    Array.blit t.sorted (i + 1) t.sorted i (t.length - i - 1);
+    t.length <- t.length - 1
+  end;
+  let i = lower_bound t dt in
+  Array.blit t.sorted i t.sorted (i + 1) (t.length - i);
+  t.sorted.(i) <- dt;
+  t.length <- t.length + 1;
+  t.sum <- t.sum +. dt;
+  t.ring.(t.next) <- dt;
+  t.next <- (t.next + 1) mod t.window
+
+let last t =
+  if t.length = 0 then 0.
+  else t.ring.((t.next + t.window - 1) mod t.window)
+
+let mean t =
+  if t.length = 0 then 0. else t.sum /. float_of_int t.length
+
+let min t = if t.length = 0 then 0. else t.sorted.(0)
+
+let max t = if t.length = 0 then 0. else t.sorted.(t.length - 1)
+
+let fps t =
+  let m = mean t in
+  if m > 0. then 1. /. m else 0.
+
+let p50 t = percentile t 0.50
+
+let p95 t = percentile t 0.95
+
+let p99 t = percentile t 0.99
+
+let hitch t = t.hitch
+
+let hitches t = t.hitches
+
+let histogram t ~bucket ~buckets =
+  if not (bucket > 0.) || buckets < 1 then
+    raise (FrameStats_exception "Invalid histogram buckets");
+  let h = Array.make buckets 0 in
+  for i = 0 to t.length - 1 do
+    let b = int_of_float (t.sorted.(i) /. bucket) in
+    let b = if b >= buckets then buckets - 1 else if b < 0 then 0 else b in
+    h.(b) <- h.(b) + 1
+  done;
+  h
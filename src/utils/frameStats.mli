@@ -0,0 +1,41 @@
+exception FrameStats_exception of string
+
+type t
+
+val create : ?window:int -> ?hitch_factor:float -> unit -> t
+
+val reset : t -> unit
+
+val add : t -> float -> unit
+
+val window : t -> int
+
+val frames : t -> int
+
+val total : t -> int
+
+val last : t -> float
+
+val mean : t -> float
+
+val min : t -> float
+
+val max : t -> float
+
+val fps : t -> float
+
+val percentile : t -> float -> float
+
+val median : t -> float
+
+val p50 : t -> float
+
+val p95 : t -> float
+
+val p99 : t -> float
+
+val hitch : t -> bool
+
+val hitches : t -> int
+
+val histogram : t -> bucket:float -> buckets:int -> int array
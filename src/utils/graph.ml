@@ -8,6 +8,287 @@ module type Vertex = sig
 end
 
 
+module CSR = struct
+
+  exception CSR_exception of string
+
+  module FHeap = PriorityQueue.Indexed (struct
+
+    type t = float
+
+    let compare (f1 : float) (f2 : float) = compare f1 f2
+
+  end)
+
+  (* Handles are recycled, so a handle is only valid if it still holds v *)
+  let queued heap hd (v : int) = FHeap.mem heap hd && FHeap.value heap hd = v
+
+  (* The edges of a vertex v are targets.(offsets.(v)) .. targets.(offsets.(v+1) - 1) *)
+  type t = {
+    offsets : int array;
+    targets : int array;
+    costs   : float array;
+    mutable work : work option
+  }
+
+  (* Scratch space reused by searches. An entry of dist/parent/handle is only 
+   * valid if its stamp equals the current generation, so that a search does 
+   * not need to clear the arrays of the previous one. *)
+  and work = {
+    stamp  : int array;
+    dist   : float array;
+    parent : int array;
+    handle : int array;
+    mutable gen : int;
+    heap   : int FHeap.t
+  }
+
+  type builder = {
+    mutable nvertices : int;
+    mutable nedges : int;
+    mutable src  : int array;
+    mutable dst  : int array;
+    mutable cost : float array
+  }
+
+  let vertices g = Array.length g.offsets - 1
+
+  let edges g = Array.length g.targets
+
+  let check g v = 
+    if v < 0 || v >= vertices g then raise (CSR_exception "Vertex out of bounds")
+
+  let degree g v = 
+    check g v;
+    g.offsets.(v+1) - g.offsets.(v)
+
+  let iter_neighbours g v f = 
+    check g v;
+    for i = g.offsets.(v) to g.offsets.(v+1) - 1 do
+      f g.targets.(i) g.costs.(i)
+    done
+
+  let fold_neighbours g v f acc = 
+    check g v;
+    let acc = ref acc in
+    for i = g.offsets.(v) to g.offsets.(v+1) - 1 do
+      acc := f g.targets.(i) g.costs.(i) !acc
+    done;
+    !acc
+
+  let neighbours g v = 
+    fold_neighbours g v (fun u _ l -> u :: l) [] |> List.rev
+
+  let iter_edges g f = 
+    for v = 0 to vertices g - 1 do
+      for i = g.offsets.(v) to g.offsets.(v+1) - 1 do
+        f v g.targets.(i) g.costs.(i)
+      done
+    done
+
+
+  (* Construction *)
+  module Builder = struct
+
+    type csr = t
+
+    type t = builder
+
+    let create ?vertices:(n = 0) () = 
+      if n < 0 then raise (CSR_exception "Negative number of vertices");
+      {nvertices = n; nedges = 0; src = Array.make 16 0; dst = Array.make 16 0; 
+       cost = Array.make 16 0.}
+
+    let vertices b = b.nvertices
+
+    let edges b = b.nedges
+
+    let add_vertex b = 
+      b.nvertices <- b.nvertices + 1;
+      b.nvertices - 1
+
+    let grow b = 
+      let n = 2 * Array.length b.src in
+      let extend arr def = 
+        let arr' = Array.make n def in
+        Array.blit arr 0 arr' 0 b.nedges; arr'
+      in
+      b.src  <- extend b.src 0;
+      b.dst  <- extend b.dst 0;
+      b.cost <- extend b.cost 0.
+
+    let add_edge b ?cost:(cost = 1.) v1 v2 = 
+      if v1 < 0 || v2 < 0 then raise (CSR_exception "Negative vertex id");
+      if b.nedges = Array.length b.src then grow b;
+      b.src.(b.nedges)  <- v1;
+      b.dst.(b.nedges)  <- v2;
+      b.cost.(b.nedges) <- cost;
+      b.nedges <- b.nedges + 1;
+      b.nvertices <- max b.nvertices (max v1 v2 + 1)
+
+    (* Counting sort on the source vertex, which keeps the insertion order
+     * of the edges of each vertex *)
+    let freeze b = 
+      let n = b.nvertices and m = b.nedges in
+      let offsets = Array.make (n + 1) 0 in
+      for i = 0 to m - 1 do
+        offsets.(b.src.(i) + 1) <- offsets.(b.src.(i) + 1) + 1
+      done;
+      for v = 0 to n - 1 do
+        offsets.(v+1) <- offsets.(v+1) + offsets.(v)
+      done;
+      let fill = Array.sub offsets 0 (max n 1) in
+      let targets = Array.make m 0 in
+      let costs = Array.make m 0. in
+      for i = 0 to m - 1 do
+        let s = b.src.(i) in
+        targets.(fill.(s)) <- b.dst.(i);
+        costs.(fill.(s)) <- b.cost.(i);
+        fill.(s) <- fill.(s) + 1
+      done;
+      {offsets; targets; costs; work = None}
+
+  end
+
+
+  (* Visited sets *)
+  let bitset n = Bytes.make ((n + 7) / 8) '\000'
+
+  let is_set bits i = 
+    (Char.code (Bytes.unsafe_get bits (i lsr 3))) land (1 lsl (i land 7)) <> 0
+
+  let set bits i = 
+    let c = Char.code (Bytes.unsafe_get bits (i lsr 3)) in
+    Bytes.unsafe_set bits (i lsr 3) (Char.unsafe_chr (c lor (1 lsl (i land 7))))
+
+
+  (* Traversals, in the same order as G.bfs and G.dfs *)
+  let bfs g s f = 
+    check g s;
+    let visited = bitset (vertices g) in
+    let queue = Array.make (vertices g) 0 in
+    let head = ref 0 and tail = ref 1 in
+    queue.(0) <- s;
+    set visited s;
+    while !head < !tail do
+      let v = queue.(!head) in
+      incr head;
+      f v;
+      for i = g.offsets.(v) to g.offsets.(v+1) - 1 do
+        let u = g.targets.(i) in
+        if not (is_set visited u) then begin
+          set visited u;
+          queue.(!tail) <- u;
+          incr tail
+        end
+      done
+    done
+
+  let dfs g s f = 
+    check g s;
+    let visited = bitset (vertices g) in
+    let stack = ref (Array.make 64 0) in
+    let sp = ref 1 in
+    !stack.(0) <- s;
+    while !sp > 0 do
+      decr sp;
+      let v = !stack.(!sp) in
+      if not (is_set visited v) then begin
+        set visited v;
+        f v;
+        let d = g.offsets.(v+1) - g.offsets.(v) in
+        if !sp + d > Array.length !stack then begin
+          let st = Array.make (2 * (!sp + d)) 0 in
+          Array.blit !stack 0 st 0 !sp;
+          stack := st
+        end;
+        (* Pushed in reverse so that the first neighbour is visited first *)
+        for i = g.offsets.(v+1) - 1 downto g.offsets.(v) do
+          let u = g.targets.(i) in
+          if not (is_set visited u) then begin
+            !stack.(!sp) <- u;
+            incr sp
+          end
+        done
+      end
+    done
+
+
+  (* Shortest paths *)
+  let workspace g = 
+    let n = vertices g in
+    let w = 
+      match g.work with
+      | Some w -> w
+      | None -> 
+        let w = {stamp = Array.make n 0; dist = Array.make n infinity; 
+                 parent = Array.make n (-1); handle = Array.make n 0; gen = 0; 
+                 heap = FHeap.create ()} in
+        g.work <- Some w; w
+    in
+    w.gen <- w.gen + 1;
+    FHeap.clear w.heap;
+    w
+
+  let distance w v = 
+    if w.stamp.(v) = w.gen then w.dist.(v) else infinity
+
+  (* Improves the distance of a vertex, and decreases its key if it is 
+   * still in the open set *)
+  let relax w v d p prio = 
+    if w.stamp.(v) = w.gen && queued w.heap w.handle.(v) v then
+      FHeap.decrease_key w.heap w.handle.(v) prio
+    else
+      w.handle.(v) <- FHeap.insert w.heap prio v;
+    w.stamp.(v) <- w.gen;
+    w.dist.(v) <- d;
+    w.parent.(v) <- p
+
+  let astar g v1 v2 eval = 
+    check g v1; check g v2;
+    let w = workspace g in
+    relax w v1 0. (-1) 0.;
+    let found = ref false in
+    while not !found && not (FHeap.is_empty w.heap) do
+      let v = FHeap.extract w.heap in
+      if v = v2 then found := true
+      else begin
+        let dv = w.dist.(v) in
+        for i = g.offsets.(v) to g.offsets.(v+1) - 1 do
+          let u = g.targets.(i) in
+          let du = dv +. g.costs.(i) in
+          if du < distance w u then relax w u du v (du +. eval u)
+        done
+      end
+    done;
+    if not !found then None
+    else begin
+      let rec path v acc = 
+        if v = v1 then v :: acc else path w.parent.(v) (v :: acc)
+      in
+      Some (w.dist.(v2), path v2 [])
+    end
+
+  let dijkstra g v1 v2 = astar g v1 v2 (fun _ -> 0.)
+
+  let distances g s = 
+    check g s;
+    let w = workspace g in
+    relax w s 0. (-1) 0.;
+    while not (FHeap.is_empty w.heap) do
+      let v = FHeap.extract w.heap in
+      let dv = w.dist.(v) in
+      for i = g.offsets.(v) to g.offsets.(v+1) - 1 do
+        let u = g.targets.(i) in
+        let du = dv +. g.costs.(i) in
+        if du < distance w u then relax w u du v du
+      done
+    done;
+    Array.init (vertices g) (distance w)
+
+end
+
+
 module type G = sig
 
   type t
@@ -50,6 +331,8 @@ module type G = sig
 
   val astar : t -> vertex -> vertex -> (vertex -> float) -> (float * vertex list) option
 
+  val to_csr : t -> CSR.t * (vertex -> int) * (int -> vertex)
+
 end
 
 
@@ -57,7 +340,7 @@ module Make (V : Vertex) : G with type vertex = V.t = struct
 
   module VMap = Map.Make(V)
 
-  module FQueue = PriorityQueue.Make (struct 
+  module FHeap = PriorityQueue.Indexed (struct 
 
     type t = float 
     
@@ -158,35 +441,80 @@ module Make (V : Vertex) : G with type vertex = V.t = struct
       end
     in bfs_aux VMap.empty (Dequeue.singleton v)
 
+  (* The search uses a local heap with decrease-key : each vertex is queued
+   * at most once at a time, and the graph is left untouched *)
   let astar g v1 v2 eval =
-    let distance i dists = if VMap.mem i dists then VMap.find i dists else infinity in
-    let rec extract_path v path acc = 
+    let dists = ref (VMap.singleton v1 0.) and path = ref VMap.empty in
+    let handles = ref VMap.empty in
+    let heap = FHeap.create () in
+    let distance i = try VMap.find i !dists with Not_found -> infinity in
+    (* Handles are recycled, so a handle is only valid if it still holds v *)
+    let queued v = 
+      try 
+        let hd = VMap.find v !handles in
+        FHeap.mem heap hd && V.compare (FHeap.value heap hd) v = 0
+      with Not_found -> false
+    in
+    let rec extract_path v acc = 
       if V.compare v v1 = 0 then v::acc
-      else (extract_path (VMap.find v path) path (v::acc))
+      else extract_path (VMap.find v !path) (v::acc)
     in
-    let rec d_aux (path,dists,queue) =
-      if FQueue.is_empty queue then None
+    let rec d_aux () =
+      if FHeap.is_empty heap then None
       else begin
-        let (v,queue) = FQueue.extract queue in
-        if V.compare v v2 = 0 then Some (distance v dists, extract_path v2 path [])
+        let v = FHeap.extract heap in
+        if V.compare v v2 = 0 then Some (distance v, extract_path v2 [])
         else begin
-          let edges = if VMap.mem v g then VMap.find v g else [] in
-          let distv = distance v dists in
-          List.fold_left (fun (p,d,q) e ->
-            if distv +. e.cost < distance e.e_point dists then
-              (VMap.add e.e_point v p, 
-               VMap.add e.e_point (distv +. e.cost) d, 
-               FQueue.insert q (distv +. e.cost +. (eval e.e_point)) e.e_point)
-            else (p,d,q)
-          ) (path,dists,queue) edges
-          |> d_aux  
+          let edges = try VMap.find v g with Not_found -> [] in
+          let distv = distance v in
+          List.iter (fun e ->
+            let d = distv +. e.cost in
+            if d < distance e.e_point then begin
+              path  := VMap.add e.e_point v !path;
+              dists := VMap.add e.e_point d !dists;
+              let prio = d +. eval e.e_point in
+              if queued e.e_point then
+                FHeap.decrease_key heap (VMap.find e.e_point !handles) prio
+              else 
+                handles := VMap.add e.e_point (FHeap.insert heap prio e.e_point) !handles
+            end
+          ) edges;
+          d_aux ()
         end
       end
-    in d_aux (VMap.empty,VMap.singleton v1 0.,FQueue.singleton 0. v1)
+    in
+    handles := VMap.singleton v1 (FHeap.insert heap 0. v1);
+    d_aux ()
 
   let dijkstra g v1 v2 = astar g v1 v2 (fun _ -> 0.)
 
-end
-
-
+  let to_csr g = 
+    let ids = ref VMap.empty and rev = ref [] and n = ref 0 in
+    let id v = 
+      try VMap.find v !ids 
+      with Not_found -> begin
+        ids := VMap.add v !n !ids;
+        rev := v :: !rev;
+        incr n;
+        !n - 1
+      end
+    in
+    (* Vertices without outgoing edges are not keys of the map, 
+     * but they always are the target of an edge *)
+    VMap.iter (fun v _ -> ignore (id v)) g;
+    let b = CSR.Builder.create ~vertices:(VMap.cardinal g) () in
+    VMap.iter (fun v l -> 
+      let i = id v in
+      List.iter (fun e -> CSR.Builder.add_edge b ~cost:e.cost i (id e.e_point)) l
+    ) g;
+    let ids = !ids in
+    let vertices = Array.of_list (List.rev !rev) in
+    (CSR.Builder.freeze b,
+     (fun v -> 
+       try VMap.find v ids 
+       with Not_found -> raise (CSR.CSR_exception "Unknown vertex")),
+     (fun i -> 
+       if i < 0 || i >= Array.length vertices then raise (CSR.CSR_exception "Vertex out of bounds");
+       vertices.(i)))
 
+end
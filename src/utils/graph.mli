@@ -8,6 +8,59 @@ module type Vertex = sig
 end
 
 
+module CSR : sig
+
+  exception CSR_exception of string
+
+  type t
+
+  module Builder : sig
+
+    type csr = t
+
+    type t
+
+    val create : ?vertices:int -> unit -> t
+
+    val vertices : t -> int
+
+    val edges : t -> int
+
+    val add_vertex : t -> int
+
+    val add_edge : t -> ?cost:float -> int -> int -> unit
+
+    val freeze : t -> csr
+
+  end
+
+  val vertices : t -> int
+
+  val edges : t -> int
+
+  val degree : t -> int -> int
+
+  val neighbours : t -> int -> int list
+
+  val iter_neighbours : t -> int -> (int -> float -> unit) -> unit
+
+  val fold_neighbours : t -> int -> (int -> float -> 'a -> 'a) -> 'a -> 'a
+
+  val iter_edges : t -> (int -> int -> float -> unit) -> unit
+
+  val dfs : t -> int -> (int -> unit) -> unit
+
+  val bfs : t -> int -> (int -> unit) -> unit
+
+  val dijkstra : t -> int -> int -> (float * int list) option
+
+  val astar : t -> int -> int -> (int -> float) -> (float * int list) option
+
+  val distances : t -> int -> float array
+
+end
+
+
 module type G = sig
 
   type t
@@ -50,6 +103,8 @@ module type G = sig
 
   val astar : t -> vertex -> vertex -> (vertex -> float) -> (float * vertex list) option
 
+  val to_csr : t -> CSR.t * (vertex -> int) * (int -> vertex)
+
 end
 
 
@@ -23,11 +23,11 @@ let clamp t = min (max t 0.) 1.
 
 let get ip t = ip.func t
 
-let current ip =
+let at ip date =
   if ip.duration = 0. then get ip 0.
-  else
-    let dt = (Unix.gettimeofday () -. ip.start) /. ip.duration in
-    get ip dt
+  else get ip ((date -. ip.start) /. ip.duration)
+
+let current ip = at ip (Unix.gettimeofday ())
 
 let start ip t dt =
   {ip with start = t; duration = dt}
@@ -88,44 +88,75 @@ let rec append_tangents pb tb l pe =
     let mk = (pos2 -. pos1)/.(2.*.(t2 -. t1)) -. (pos1 -. pb)/.(2.*.(t1 -. tb)) in
     (t1,(pos1,mk))::(append_tangents pos1 t1 ((t2,pos2)::tail) pe)
 
-let points b l e t =
-  let rec points_aux b l =
-    match l with
-    |[] -> (b, (1.,e))
-    |(cur_t, pt)::_ when t <= cur_t -> (b, (cur_t, pt))
-    |h::tail -> points_aux h tail
-  in
-  points_aux (0.,b) l
-
-let h00 t = 2. *. t *. t *. t -. 3. *. t *. t +. 1.
-
-let h10 t = t *. t *. t -. 2. *. t *. t +. t
-
-let h01 t = -. 2. *. t *. t *. t +. 3. *. t *. t
-
-let h11 t = t *. t *. t -. t *. t
+(* Compiled splines : the key times are kept sorted in an array, and the
+ * segment of the last evaluation is cached since successive evaluations
+ * are usually close. Other segments are found by binary search. *)
+let key_times l =
+  let times = Array.of_list (0. :: List.map fst l @ [1.]) in
+  for i = 1 to Array.length times - 1 do
+    if not (times.(i - 1) <= times.(i)) then
+      raise (Invalid_interpolator "Steps must be sorted by time in [0;1]")
+  done;
+  times
+
+(* Returns s such that times.(s) < t <= times.(s + 1) (or 0 if t <= 0) *)
+let locate times cursor t =
+  let n = Array.length times in
+  let c = !cursor in
+  if times.(c) < t && t <= times.(c + 1) then c
+  else if t <= times.(1) then (cursor := 0; 0)
+  else if t > times.(n - 2) then (cursor := n - 2; n - 2)
+  else begin
+    let lo = ref 1 and hi = ref (n - 2) in
+    while !hi - !lo > 0 do
+      let mid = (!lo + !hi) / 2 in
+      if times.(mid + 1) < t then lo := mid + 1 else hi := mid
+    done;
+    cursor := !lo;
+    !lo
+  end
+
+(* Segments of zero duration take the value of their end *)
+let local times s t =
+  let dx = times.(s + 1) -. times.(s) in
+  if dx = 0. then 1. else (t -. times.(s)) /. dx
 
 let linear b l e =
+  let times = key_times l in
+  let values = Array.of_list (b :: List.map snd l @ [e]) in
+  let cursor = ref 0 in
   let func = fun t ->
-    let (t1, p1), (t2, p2) = points b l e t in
-    let fact =
-      if t2 = t1 then 1.
-      else (t -. t1) /. (t2 -. t1)
-    in
-    (1. -. fact) *. p1 +. fact *. p2
+    let s = locate times cursor t in
+    let fact = local times s t in
+    (1. -. fact) *. values.(s) +. fact *. values.(s + 1)
   in
   custom func 0. 1.
 
 let cst_linear b l e =
   linear b (append_times b l e) e
 
+(* The Hermite basis of each segment is expanded once into the coefficients
+ * of a polynomial of the local parameter, evaluated with Horner's scheme *)
 let cubic b l e =
   let l' = append_tangents (fst b) 0. l (fst e) in
+  let times = key_times l in
+  let keys = Array.of_list (b :: List.map snd l' @ [e]) in
+  let coeffs = Array.make (4 * (Array.length times - 1)) 0. in
+  for s = 0 to Array.length times - 2 do
+    let dx = times.(s + 1) -. times.(s) in
+    let (p1, tg1) = keys.(s) and (p2, tg2) = keys.(s + 1) in
+    let m1 = tg1 *. dx and m2 = tg2 *. dx in
+    coeffs.(4 * s)     <- p1;
+    coeffs.(4 * s + 1) <- m1;
+    coeffs.(4 * s + 2) <- 3. *. (p2 -. p1) -. 2. *. m1 -. m2;
+    coeffs.(4 * s + 3) <- 2. *. (p1 -. p2) +. m1 +. m2
+  done;
+  let cursor = ref 0 in
   let func = fun t ->
-    let (t1, (p1, tg1)), (t2, (p2, tg2)) = points b l' e t in
-    let fact = (t -. t1) /. (t2 -. t1) in
-    let dx = t2 -. t1 in
-    (h00 fact) *. p1 +. (h10 fact) *. tg1 *. dx +. (h01 fact) *. p2 +. (h11 fact) *. tg2 *. dx
+    let s = locate times cursor t in
+    let u = local times s t in
+    let c = 4 * s in
+    coeffs.(c) +. u *. (coeffs.(c + 1) +. u *. (coeffs.(c + 2) +. u *. coeffs.(c + 3)))
   in
   custom func 0. 1.
 
@@ -33,6 +33,13 @@ val get : 'a t -> float -> 'a
   * If $ip$ is not time-based then the result is $ip(0)$. *)
 val current : 'a t -> 'a
 
+(** $at ip date$ returns the value of a time-based interpolator at the
+  * date $date$, given in seconds. Many interpolators can be sampled at
+  * the same date while reading the clock only once.
+  *
+  * If $ip$ is not time-based then the result is $ip(0)$. *)
+val at : 'a t -> float -> 'a
+
 (** $start ip t dt$ returns a new time-based interpolator 
   * $tip$ such that :
   *
@@ -91,7 +98,10 @@ val constant : float -> float t
 
 (** $linear start steps end$ creates a linear interpolator
   * going from $start$ to $end$ passing through each point
-  * $(dt, pos)$ of $steps$ at time $dt$ *)
+  * $(dt, pos)$ of $steps$ at time $dt$
+  *
+  * @raise Invalid_interpolator if the times of $steps$ are not sorted
+  * in [0;1] *)
 val linear : float -> (float * float) list -> float -> float t
 
 (** $cst_linear start steps end$ creates a linear interpolator 
@@ -101,7 +111,10 @@ val cst_linear : float -> float list -> float -> float t
 
 (** $cubic (start, sm) steps (end, em)$ creates a cubic spline interpolator
   * going from $start$ with tangent $sm$ to $end$ with tangeant $em$
-  * passing through each point $(dt, pos)$ of $steps$ at time $dt$ *)
+  * passing through each point $(dt, pos)$ of $steps$ at time $dt$
+  *
+  * @raise Invalid_interpolator if the times of $steps$ are not sorted
+  * in [0;1] *)
 val cubic : float * float -> (float * float) list -> float * float -> float t
 
 (** $cubic (start, sm) steps (end, em)$ creates a cubic spline interpolator
@@ -1,7 +1,54 @@
 
 type level = Debug | Warn | Error | Info | Fatal
 
-type t = {chan : out_channel; debug : bool; color : bool; short : bool}
+(* Levels below this rank are compiled out, by building the library with
+ * LOG_DEFINES="-D OGAML_LOG_NO_DEBUG" or LOG_DEFINES="-D OGAML_LOG_NO_INFO" *)
+#ifdef OGAML_LOG_NO_INFO
+let compiled_rank = 2
+#else
+#ifdef OGAML_LOG_NO_DEBUG
+let compiled_rank = 1
+#else
+let compiled_rank = 0
+#endif
+#endif
+
+(* Output shared by a log and its sub-logs. Asynchronous outputs store
+ * fixed-size records (level, time, module, message) in a ring of flat
+ * arrays, which are formatted and written by a background thread. *)
+type sink = {
+  chan  : out_channel;
+  color : bool;
+  short : bool;
+  async : bool;
+  lock  : Mutex.t;        (* Protects head, tail and dropped *)
+  flush_lock : Mutex.t;   (* Only one thread writes at a time *)
+  levels : level array;
+  times  : float array;
+  names  : string array;
+  msgs   : string array;
+  mutable head : int;     (* Next record to write *)
+  mutable tail : int;     (* Next record to output *)
+  mutable dropped : int;
+  mutable last_sec : float;
+  mutable last_ts  : string
+}
+
+type t = {
+  sink : sink;
+  name : string;
+  mutable level : int;
+  rate : int;
+  mutable tokens : float;
+  mutable refill : float
+}
+
+let rank = function
+  | Debug -> 0
+  | Info  -> 1
+  | Warn  -> 2
+  | Error -> 3
+  | Fatal -> 4
 
 let string_of_lvl = function
   | Debug -> "[DEBUG]"
@@ -17,64 +64,215 @@ let color_of_lvl = function
   | Info  -> "\027[34m"
   | Fatal -> "\027[31;1m"
 
-let timestamp () =
-  let ts = Unix.gettimeofday() in
+let timestamp ts =
   let tm = Unix.localtime ts in
-  let us, _s = modf ts in
-  Printf.sprintf "%04d-%02d-%02d %02d:%02d:%02d.%03d : "
+  Printf.sprintf "%04d-%02d-%02d %02d:%02d:%02d"
     (1900 + tm.Unix.tm_year)
     (1    + tm.Unix.tm_mon)
     tm.Unix.tm_mday
     tm.Unix.tm_hour
     tm.Unix.tm_min
     tm.Unix.tm_sec
-    (int_of_float (1_000. *. us))
 
-let short_timestamp () =
-  let ts = Unix.gettimeofday() in
+let short_timestamp ts =
   let tm = Unix.localtime ts in
-  let us, _s = modf ts in
-  Printf.sprintf "%02d:%02d:%02d.%03d : "
+  Printf.sprintf "%02d:%02d:%02d"
     tm.Unix.tm_hour
     tm.Unix.tm_min
     tm.Unix.tm_sec
-    (int_of_float (1_000. *. us))
 
 let default_color = "\027[0m"
 
 let timestamp_color = "\027[37m"
 
-let create ?output:(output = stderr) 
-           ?debug:(debug = true) 
-           ?color:(color = true) 
-           ?short:(short = false) () = 
-  {chan = output; debug; color; short}
+
+(* Output *)
+
+(* The date only changes once per second, so it is cached by the sink *)
+let write s lvl ts name msg =
+  let sec = floor ts in
+  if sec <> s.last_sec then begin
+    s.last_sec <- sec;
+    s.last_ts <- if s.short then short_timestamp ts else timestamp ts
+  end;
+  let ms = int_of_float (1_000. *. (ts -. sec)) in
+  if s.color then
+    Printf.fprintf s.chan "%s%s %s%s%s.%03d : %s"
+      (color_of_lvl lvl) (string_of_lvl lvl) default_color
+      timestamp_color s.last_ts ms default_color
+  else
+    Printf.fprintf s.chan "%s %s.%03d : " (string_of_lvl lvl) s.last_ts ms;
+  if name <> "" then Printf.fprintf s.chan "[%s] " name;
+  output_string s.chan msg;
+  output_char s.chan '\n'
+
+let write_dropped s =
+  Mutex.lock s.lock;
+  let dropped = s.dropped in
+  s.dropped <- 0;
+  Mutex.unlock s.lock;
+  if dropped > 0 then
+    write s Warn (Unix.gettimeofday ()) ""
+      (Printf.sprintf "%i messages dropped" dropped)
+
+(* Records between tail and head are not overwritten by the writers until
+ * tail has been moved, so they are output without holding the lock. Output
+ * errors (closed channel, full disk) lose the records. *)
+let flush_sink s =
+  Mutex.lock s.flush_lock;
+  let head = s.head in
+  let n = Array.length s.msgs in
+  begin try
+    for i = s.tail to head - 1 do
+      let k = i mod n in
+      write s s.levels.(k) s.times.(k) s.names.(k) s.msgs.(k);
+      s.msgs.(k) <- ""
+    done;
+    write_dropped s;
+    flush s.chan
+  with Sys_error _ -> ()
+  end;
+  Mutex.lock s.lock;
+  s.tail <- head;
+  Mutex.unlock s.lock;
+  Mutex.unlock s.flush_lock
+
+let push s lvl name msg =
+  let ts = Unix.gettimeofday () in
+  if not s.async then begin
+    Mutex.lock s.flush_lock;
+    begin try
+      write_dropped s;
+      write s lvl ts name msg;
+      flush s.chan
+    with e -> Mutex.unlock s.flush_lock; raise e
+    end;
+    Mutex.unlock s.flush_lock
+  end else begin
+    Mutex.lock s.lock;
+    let n = Array.length s.msgs in
+    if s.head - s.tail >= n then s.dropped <- s.dropped + 1
+    else begin
+      let k = s.head mod n in
+      s.levels.(k) <- lvl;
+      s.times.(k)  <- ts;
+      s.names.(k)  <- name;
+      s.msgs.(k)   <- msg;
+      s.head <- s.head + 1
+    end;
+    Mutex.unlock s.lock;
+    (* Fatal errors are usually followed by an exit, which must not lose them *)
+    if lvl = Fatal then flush_sink s
+  end
+
+(* Background flusher, shared by all asynchronous sinks *)
+let sinks = ref []
+
+let sinks_lock = Mutex.create ()
+
+let flusher = ref None
+
+let flush_all () =
+  Mutex.lock sinks_lock;
+  let l = !sinks in
+  Mutex.unlock sinks_lock;
+  List.iter (fun s -> if s.head <> s.tail || s.dropped > 0 then flush_sink s) l
+
+let register s =
+  Mutex.lock sinks_lock;
+  sinks := s :: !sinks;
+  begin match !flusher with
+  | Some _ -> ()
+  | None ->
+    flusher := Some (Thread.create (fun () ->
+      while true do
+        Thread.delay 0.01;
+        flush_all ()
+      done) ());
+    at_exit flush_all
+  end;
+  Mutex.unlock sinks_lock
+
+
+(* Logs *)
+let create ?output:(output = stderr)
+           ?debug:(debug = true)
+           ?color:(color = true)
+           ?short:(short = false)
+           ?async:(async = false)
+           ?capacity:(capacity = 4096)
+           ?rate:(rate = 0) () =
+  let capacity = if async then max 1 capacity else 0 in
+  let sink = {
+    chan = output; color; short; async;
+    lock = Mutex.create ();
+    flush_lock = Mutex.create ();
+    levels = Array.make capacity Debug;
+    times  = Array.make capacity 0.;
+    names  = Array.make capacity "";
+    msgs   = Array.make capacity "";
+    head = 0;
+    tail = 0;
+    dropped  = 0;
+    last_sec = -1.;
+    last_ts  = ""
+  } in
+  if async then register sink;
+  {
+    sink; name = "";
+    level  = if debug then 0 else 1;
+    rate   = max 0 rate;
+    tokens = float_of_int rate;
+    refill = Clock.now ()
+  }
 
 let stdout = create ~output:stdout ()
 
 let stderr = create ()
 
-let log t lvl fmt = 
-  let ts = 
-    if t.short then short_timestamp () 
-    else timestamp ()
-  in
-  let prefix = 
-    if t.color then 
-      Printf.sprintf "%s%s %s%s%s%s" 
-        (color_of_lvl lvl) (string_of_lvl lvl) default_color 
-        timestamp_color ts default_color
-    else
-      Printf.sprintf "%s %s" (string_of_lvl lvl) ts
-  in
-  match lvl with
-  | Debug -> 
-    if t.debug then 
-      Printf.fprintf t.chan ("%s" ^^ fmt ^^ "\n%!") prefix
-    else 
-      Printf.fprintf t.chan ("%s" ^^ fmt ^^ "\n%!") prefix
-  | _     -> 
-      Printf.fprintf t.chan ("%s" ^^ fmt ^^ "\n%!") prefix
+let sub t name =
+  {t with
+    name = if t.name = "" then name else t.name ^ "." ^ name;
+    tokens = float_of_int t.rate;
+    refill = Clock.now ()}
+
+let set_level t lvl = t.level <- rank lvl
+
+let enabled t lvl =
+  rank lvl >= compiled_rank && rank lvl >= t.level
+
+(* Token bucket refilled at [rate] messages per second, with a burst of one
+ * second of messages. Fatal errors are never limited. *)
+let allowed t lvl =
+  if t.rate = 0 || lvl = Fatal then true
+  else begin
+    let now = Clock.now () in
+    let r = float_of_int t.rate in
+    t.tokens <- min r (t.tokens +. (now -. t.refill) *. r);
+    t.refill <- now;
+    if t.tokens >= 1. then begin
+      t.tokens <- t.tokens -. 1.;
+      true
+    end else begin
+      Mutex.lock t.sink.lock;
+      t.sink.dropped <- t.sink.dropped + 1;
+      Mutex.unlock t.sink.lock;
+      false
+    end
+  end
+
+let flush t =
+  if t.sink.async then flush_sink t.sink
+
+let dropped t = t.sink.dropped
+
+(* Disabled messages never reach the sink. They are still formatted, as
+ * ikfprintf cannot take a string format before OCaml 4.03 *)
+let log t lvl fmt =
+  if enabled t lvl && allowed t lvl then
+    Printf.ksprintf (push t.sink lvl t.name) fmt
+  else
+    Printf.ksprintf (fun _ -> ()) fmt
 
 let debug t fmt = log t Debug fmt
 
@@ -85,4 +283,3 @@ let error t fmt = log t Error fmt
 let info  t fmt = log t Info  fmt
 
 let fatal t fmt = log t Fatal fmt
-
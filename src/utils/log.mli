@@ -3,21 +3,31 @@ type level = Debug | Warn | Error | Info | Fatal
 
 type t
 
-val create : ?output:out_channel -> ?debug:bool -> ?color:bool -> ?short:bool -> unit -> t
+val create : ?output:out_channel -> ?debug:bool -> ?color:bool -> ?short:bool ->
+             ?async:bool -> ?capacity:int -> ?rate:int -> unit -> t
 
 val stdout : t
 
 val stderr : t
 
-val log : t -> level -> ('a, out_channel, unit) format -> 'a
+val sub : t -> string -> t
 
-val debug : t -> ('a, out_channel, unit) format -> 'a
+val set_level : t -> level -> unit
 
-val warn  : t -> ('a, out_channel, unit) format -> 'a
+val enabled : t -> level -> bool
 
-val error : t -> ('a, out_channel, unit) format -> 'a
+val flush : t -> unit
 
-val info  : t -> ('a, out_channel, unit) format -> 'a
+val dropped : t -> int
 
-val fatal : t -> ('a, out_channel, unit) format -> 'a
+val log : t -> level -> ('a, unit, string, unit) format4 -> 'a
 
+val debug : t -> ('a, unit, string, unit) format4 -> 'a
+
+val warn  : t -> ('a, unit, string, unit) format4 -> 'a
+
+val error : t -> ('a, unit, string, unit) format4 -> 'a
+
+val info  : t -> ('a, unit, string, unit) format4 -> 'a
+
+val fatal : t -> ('a, unit, string, unit) format4 -> 'a
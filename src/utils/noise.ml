@@ -1,5 +1,7 @@
 open OgamlMath
 
+exception Noise_exception of string
+
 (* Generate a random permutation *)
 let rec fuse_rnd r = function
   |([],l) |(l,[]) -> l
@@ -54,13 +56,13 @@ module Perlin2D = struct
     else if h = 2 then (y -. x)
     else 0. -. (x +. y)
 
-  let get p vec = 
-    let open Vector2f in
-    let vec = Vector2f.map vec abs_float in
-    let x1 = (int_of_float vec.x) land 255 and
-        y1 = (int_of_float vec.y) land 255 and
-        xi = vec.x -. (float (int_of_float vec.x)) and
-        yi = vec.y -. (float (int_of_float vec.y)) in
+  (* See stubs/noise_stubs.c for the native version *)
+  let get_xy p x y =
+    let x = abs_float x and y = abs_float y in
+    let x1 = (int_of_float x) land 255 and
+        y1 = (int_of_float y) land 255 and
+        xi = x -. (float (int_of_float x)) and
+        yi = y -. (float (int_of_float y)) in
     let u = fade xi and
         v = fade yi and
         a = p.(x1) + y1 and
@@ -74,6 +76,9 @@ module Perlin2D = struct
             lerp(u, (grad(p.(ab), xi    , yi-.1.)),
                     (grad(p.(bb), xi-.1., yi-.1.))))
 
+  let get p vec =
+    get_xy p vec.Vector2f.x vec.Vector2f.y
+
 end
 
 
@@ -96,13 +101,13 @@ module Perlin3D = struct
 
   let get p vec = 
     let open Vector3f in
-    let vec = Vector3f.map vec abs_float in
-    let x1 = (int_of_float vec.x) land 255 and
-        y1 = (int_of_float vec.y) land 255 and
-        z1 = (int_of_float vec.z) land 255 and
-        xi = vec.x -. (float (int_of_float vec.x)) and
-        yi = vec.y -. (float (int_of_float vec.y)) and
-        zi = vec.z -. (float (int_of_float vec.z)) in
+    let x = abs_float vec.x and y = abs_float vec.y and z = abs_float vec.z in
+    let x1 = (int_of_float x) land 255 and
+        y1 = (int_of_float y) land 255 and
+        z1 = (int_of_float z) land 255 and
+        xi = x -. (float (int_of_float x)) and
+        yi = y -. (float (int_of_float y)) and
+        zi = z -. (float (int_of_float z)) in
     let u  = fade xi and
         v  = fade yi and
         w  = fade zi and
@@ -124,6 +129,269 @@ module Perlin3D = struct
 end
 
 
+(* Shuffled permutation of 0..255, repeated twice to avoid wrapping indices *)
+let permutation rng =
+  let p = Array.init 512 (fun i -> i land 255) in
+  for i = 255 downto 1 do
+    let j = Random.State.int rng (i + 1) in
+    let tmp = p.(i) in
+    p.(i) <- p.(j);
+    p.(j) <- tmp
+  done;
+  Array.blit p 0 p 256 256;
+  p
+
+
+(* Skewing factors of the 2D simplex grid : (sqrt 3 - 1) / 2 and (3 - sqrt 3) / 6 *)
+let f2 = 0.36602540378443864676
+
+let g2 = 0.21132486540518711775
+
+(* 12 gradients of the classic simplex noise *)
+let grad12 = [|
+  1.; 1.;  -1.; 1.;  1.; -1.;  -1.; -1.;
+  1.; 0.;  -1.; 0.;  1.;  0.;  -1.;  0.;
+  0.; 1.;   0.; -1.; 0.;  1.;   0.; -1.
+|]
+
+(* 24 gradients evenly spread on the circle, as in OpenSimplex2 *)
+let grad24 = [|
+  0.9914448613738104; 0.13052619222005157;
+  0.9238795325112867; 0.3826834323650898;
+  0.7933533402912352; 0.6087614290087207;
+  0.6087614290087207; 0.7933533402912352;
+  0.38268343236508984; 0.9238795325112867;
+  0.1305261922200517; 0.9914448613738104;
+  -0.1305261922200516; 0.9914448613738104;
+  -0.3826834323650897; 0.9238795325112867;
+  -0.6087614290087207; 0.7933533402912352;
+  -0.793353340291235; 0.6087614290087209;
+  -0.9238795325112867; 0.3826834323650899;
+  -0.9914448613738104; 0.13052619222005157;
+  -0.9914448613738105; -0.13052619222005132;
+  -0.9238795325112868; -0.38268343236508967;
+  -0.7933533402912352; -0.6087614290087207;
+  -0.6087614290087209; -0.7933533402912349;
+  -0.3826834323650895; -0.9238795325112868;
+  -0.13052619222005163; -0.9914448613738104;
+  0.13052619222005127; -0.9914448613738105;
+  0.38268343236509; -0.9238795325112866;
+  0.6087614290087205; -0.7933533402912352;
+  0.7933533402912349; -0.6087614290087209;
+  0.9238795325112868; -0.38268343236508956;
+  0.9914448613738104; -0.13052619222005168;
+|]
+
+(* Contribution of a corner of a simplex.
+ * The attenuation is (0.5 - d^2)^4 for both 2D noises. *)
+let corner2 grads i x y =
+  let a = 0.5 -. x *. x -. y *. y in
+  if a <= 0. then 0.
+  else begin
+    let a = a *. a in
+    a *. a *. (grads.(2 * i) *. x +. grads.(2 * i + 1) *. y)
+  end
+
+(* See stubs/noise_stubs.c for the native version *)
+let simplex2 grads modulo p x y =
+  let s = (x +. y) *. f2 in
+  let i = floor (x +. s) and j = floor (y +. s) in
+  let t = (i +. j) *. g2 in
+  let x0 = x -. (i -. t) and y0 = y -. (j -. t) in
+  let i1 = if x0 > y0 then 1 else 0 in
+  let j1 = 1 - i1 in
+  let x1 = x0 -. float i1 +. g2 and y1 = y0 -. float j1 +. g2 in
+  let x2 = x0 -. 1. +. 2. *. g2 and y2 = y0 -. 1. +. 2. *. g2 in
+  let ii = (int_of_float i) land 255 and jj = (int_of_float j) land 255 in
+  let h0 = p.(ii + p.(jj)) mod modulo in
+  let h1 = p.(ii + i1 + p.(jj + j1)) mod modulo in
+  let h2 = p.(ii + 1 + p.(jj + 1)) mod modulo in
+  corner2 grads h0 x0 y0 +. corner2 grads h1 x1 y1 +. corner2 grads h2 x2 y2
+
+
+module Simplex2D = struct
+
+  type t = int array
+
+  let create () =
+    permutation (Random.get_state ())
+
+  let create_with_seed rng =
+    permutation rng
+
+  let get_xy p x y =
+    70. *. simplex2 grad12 12 p x y
+
+  let get p vec =
+    get_xy p vec.Vector2f.x vec.Vector2f.y
+
+end
+
+
+module OpenSimplex2D = struct
+
+  type t = int array
+
+  let create () =
+    permutation (Random.get_state ())
+
+  let create_with_seed rng =
+    permutation rng
+
+  let get_xy p x y =
+    99. *. simplex2 grad24 24 p x y
+
+  let get p vec =
+    get_xy p vec.Vector2f.x vec.Vector2f.y
+
+end
+
+
+module Simplex3D = struct
+
+  type t = int array
+
+  let create () =
+    permutation (Random.get_state ())
+
+  let create_with_seed rng =
+    permutation rng
+
+  (* 12 gradients towards the edges of a cube *)
+  let grad = [|
+    1; 1; 0;  -1; 1; 0;  1; -1; 0;  -1; -1; 0;
+    1; 0; 1;  -1; 0; 1;  1; 0; -1;  -1; 0; -1;
+    0; 1; 1;  0; -1; 1;  0; 1; -1;  0; -1; -1
+  |]
+
+  let corner h x y z =
+    let a = 0.6 -. x *. x -. y *. y -. z *. z in
+    if a <= 0. then 0.
+    else begin
+      let a = a *. a in
+      a *. a *. (float grad.(3 * h) *. x +. float grad.(3 * h + 1) *. y +. float grad.(3 * h + 2) *. z)
+    end
+
+  let get p vec =
+    let x = vec.Vector3f.x and y = vec.Vector3f.y and z = vec.Vector3f.z in
+    let f3 = 1. /. 3. and g3 = 1. /. 6. in
+    let s = (x +. y +. z) *. f3 in
+    let i = floor (x +. s) and j = floor (y +. s) and k = floor (z +. s) in
+    let t = (i +. j +. k) *. g3 in
+    let x0 = x -. (i -. t) and y0 = y -. (j -. t) and z0 = z -. (k -. t) in
+    (* Offsets of the second and third corners of the simplex *)
+    let i1, j1, k1, i2, j2, k2 =
+      if x0 >= y0 then begin
+        if y0 >= z0 then (1, 0, 0, 1, 1, 0)
+        else if x0 >= z0 then (1, 0, 0, 1, 0, 1)
+        else (0, 0, 1, 1, 0, 1)
+      end else begin
+        if y0 < z0 then (0, 0, 1, 0, 1, 1)
+        else if x0 < z0 then (0, 1, 0, 0, 1, 1)
+        else (0, 1, 0, 1, 1, 0)
+      end
+    in
+    let x1 = x0 -. float i1 +. g3 and y1 = y0 -. float j1 +. g3 and z1 = z0 -. float k1 +. g3 in
+    let x2 = x0 -. float i2 +. 2. *. g3 and y2 = y0 -. float j2 +. 2. *. g3
+    and z2 = z0 -. float k2 +. 2. *. g3 in
+    let x3 = x0 -. 1. +. 3. *. g3 and y3 = y0 -. 1. +. 3. *. g3 and z3 = z0 -. 1. +. 3. *. g3 in
+    let ii = (int_of_float i) land 255 and jj = (int_of_float j) land 255
+    and kk = (int_of_float k) land 255 in
+    let h0 = p.(ii + p.(jj + p.(kk))) mod 12 in
+    let h1 = p.(ii + i1 + p.(jj + j1 + p.(kk + k1))) mod 12 in
+    let h2 = p.(ii + i2 + p.(jj + j2 + p.(kk + k2))) mod 12 in
+    let h3 = p.(ii + 1 + p.(jj + 1 + p.(kk + 1))) mod 12 in
+    32. *. (corner h0 x0 y0 z0 +. corner h1 x1 y1 z1 +. corner h2 x2 y2 z2 +. corner h3 x3 y3 z3)
+
+end
+
+
+module Fractal = struct
+
+  type bigarray = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  type noise =
+    | Perlin of Perlin2D.t
+    | Simplex of Simplex2D.t
+    | OpenSimplex of OpenSimplex2D.t
+
+  type t = {
+    kind : int; (* 0 : Perlin, 1 : Simplex, 2 : OpenSimplex *)
+    perm : int array;
+    octaves : int;
+    frequency : float;
+    lacunarity : float;
+    gain : float;
+    ridged : bool;
+    warp : float
+  }
 
+  let create ?octaves:(octaves = 6) ?frequency:(frequency = 1.) ?lacunarity:(lacunarity = 2.)
+             ?gain:(gain = 0.5) ?ridged:(ridged = false) ?warp:(warp = 0.) noise =
+    if octaves < 1 then raise (Noise_exception "Fractal noises need at least one octave");
+    let kind, perm =
+      match noise with
+      | Perlin p -> 0, p
+      | Simplex p -> 1, p
+      | OpenSimplex p -> 2, p
+    in
+    {kind; perm; octaves; frequency; lacunarity; gain; ridged; warp}
 
+  let base t x y =
+    match t.kind with
+    | 0 -> Perlin2D.get_xy t.perm x y
+    | 1 -> Simplex2D.get_xy t.perm x y
+    | _ -> OpenSimplex2D.get_xy t.perm x y
 
+  (* The operations are done in the same order as in stubs/noise_stubs.c,
+   * so that both paths return the same bits *)
+  let get_xy t x y =
+    let wx =
+      if t.warp = 0. then x
+      else x +. t.warp *. base t (x *. t.frequency +. 5.2) (y *. t.frequency +. 1.3)
+    in
+    let wy =
+      if t.warp = 0. then y
+      else y +. t.warp *. base t (x *. t.frequency +. 1.7) (y *. t.frequency +. 9.2)
+    in
+    let sum = ref 0. and amp = ref 1. and norm = ref 0. and freq = ref t.frequency in
+    for _i = 1 to t.octaves do
+      let n = base t (wx *. !freq) (wy *. !freq) in
+      let n = if t.ridged then (let r = 1. -. abs_float n in r *. r) else n in
+      sum := !sum +. n *. !amp;
+      norm := !norm +. !amp;
+      amp := !amp *. t.gain;
+      freq := !freq *. t.lacunarity
+    done;
+    !sum /. !norm
+
+  let get t vec =
+    get_xy t vec.Vector2f.x vec.Vector2f.y
+
+  external fill_stub : int array -> float array -> int array -> bigarray -> unit
+    = "caml_noise_fill"
+
+  let fill_ml t dst ~stride ~ox ~oy ~step ~x ~y ~width ~height =
+    for j = y to y + height - 1 do
+      let py = oy +. float j *. step in
+      for i = x to x + width - 1 do
+        dst.{j * stride + i} <- get_xy t (ox +. float i *. step) py
+      done
+    done
+
+  let fill ?native:(native = true) t dst ~stride ~origin ~step (r : IntRect.t) =
+    let r = IntRect.normalize r in
+    let open IntRect in
+    if r.x < 0 || r.y < 0 || r.x + r.width > stride
+       || (r.y + r.height) * stride > Bigarray.Array1.dim dst then
+      raise (Noise_exception "Region out of bounds");
+    let ox = origin.Vector2f.x and oy = origin.Vector2f.y in
+    if native then
+      fill_stub t.perm
+        [|t.frequency; t.lacunarity; t.gain; t.warp; ox; oy; step|]
+        [|t.kind; t.octaves; (if t.ridged then 1 else 0); stride; r.x; r.y; r.width; r.height|]
+        dst
+    else
+      fill_ml t dst ~stride ~ox ~oy ~step ~x:r.x ~y:r.y ~width:r.width ~height:r.height
+
+end
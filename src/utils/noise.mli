@@ -1,3 +1,4 @@
+exception Noise_exception of string
 
 module Perlin2D : sig
 
@@ -9,6 +10,8 @@ module Perlin2D : sig
 
   val get : t -> OgamlMath.Vector2f.t -> float
 
+  val get_xy : t -> float -> float -> float
+
 end
 
 
@@ -23,3 +26,70 @@ module Perlin3D : sig
   val get : t -> OgamlMath.Vector3f.t -> float
 
 end
+
+
+module Simplex2D : sig
+
+  type t
+
+  val create : unit -> t
+
+  val create_with_seed : Random.State.t -> t
+
+  val get : t -> OgamlMath.Vector2f.t -> float
+
+  val get_xy : t -> float -> float -> float
+
+end
+
+
+module OpenSimplex2D : sig
+
+  type t
+
+  val create : unit -> t
+
+  val create_with_seed : Random.State.t -> t
+
+  val get : t -> OgamlMath.Vector2f.t -> float
+
+  val get_xy : t -> float -> float -> float
+
+end
+
+
+module Simplex3D : sig
+
+  type t
+
+  val create : unit -> t
+
+  val create_with_seed : Random.State.t -> t
+
+  val get : t -> OgamlMath.Vector3f.t -> float
+
+end
+
+
+module Fractal : sig
+
+  type bigarray = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  type noise =
+    | Perlin of Perlin2D.t
+    | Simplex of Simplex2D.t
+    | OpenSimplex of OpenSimplex2D.t
+
+  type t
+
+  val create : ?octaves:int -> ?frequency:float -> ?lacunarity:float -> ?gain:float ->
+               ?ridged:bool -> ?warp:float -> noise -> t
+
+  val get : t -> OgamlMath.Vector2f.t -> float
+
+  val get_xy : t -> float -> float -> float
+
+  val fill : ?native:bool -> t -> bigarray -> stride:int -> origin:OgamlMath.Vector2f.t ->
+             step:float -> OgamlMath.IntRect.t -> unit
+
+end
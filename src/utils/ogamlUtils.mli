@@ -3,7 +3,17 @@
 (** Log system *)
 module Log : sig
 
-  (** This module provides a very simple log system to use with Ogaml *)
+  (** This module provides a very simple log system to use with Ogaml
+    *
+    * Messages are written synchronously by default. Asynchronous logs store
+    * the messages in a ring buffer of fixed-size records, and a background
+    * thread formats the timestamps and writes them every 10ms, so logging
+    * from a render loop only costs the formatting of the message.
+    *
+    * Messages whose level is disabled are formatted but never written. Debug (and
+    * info) messages can also be removed at compile time by building the
+    * library with $LOG_DEFINES="-D OGAML_LOG_NO_DEBUG"$ (resp.
+    * $OGAML_LOG_NO_INFO$). *)
 
   (** Enumeration of log message levels *)
   type level = Debug | Warn | Error | Info | Fatal
@@ -19,8 +29,22 @@ module Log : sig
     *
     * - color : if false, messages will not be colored (defaults to true)
     *
-    * - short : if true, timestamps will be shortened (defaults to false) *)
-  val create : ?output:out_channel -> ?debug:bool -> ?color:bool -> ?short:bool -> unit -> t
+    * - short : if true, timestamps will be shortened (defaults to false)
+    *
+    * - async : if true, messages are written by a background thread
+    *   (defaults to false). Fatal messages are always written immediately,
+    *   and pending messages are written when the program exits.
+    *
+    * - capacity : number of messages an asynchronous log can hold before
+    *   dropping them (defaults to 4096)
+    *
+    * - rate : maximal number of messages per second, with bursts of up to
+    *   one second of messages (defaults to 0, no limit). Fatal messages are
+    *   never dropped.
+    *
+    * The number of dropped messages is reported with the next written one. *)
+  val create : ?output:out_channel -> ?debug:bool -> ?color:bool -> ?short:bool ->
+               ?async:bool -> ?capacity:int -> ?rate:int -> unit -> t
 
   (** Log to the standard output, that would be obtained by calling $create ~output:stdout ()$ *)
   val stdout : t
@@ -28,23 +52,42 @@ module Log : sig
   (** Log to the standard error, that would be obtained by calling $create ()$ *)
   val stderr : t
 
-  (** Logs a message *)
-  val log : t -> level -> ('a, out_channel, unit) format -> 'a
+  (** $sub t name$ returns a log for the module $name$, which writes to the
+    * same output as $t$ with its messages prefixed by $[name]$. Its level
+    * can be set independently, and it has its own rate limit. *)
+  val sub : t -> string -> t
+
+  (** Sets the minimal level of the messages of a log, in the order
+    * $Debug$, $Info$, $Warn$, $Error$, $Fatal$ *)
+  val set_level : t -> level -> unit
+
+  (** Returns true iff the messages of a given level are written by a log *)
+  val enabled : t -> level -> bool
+
+  (** Writes the pending messages of an asynchronous log *)
+  val flush : t -> unit
+
+  (** Returns the number of messages dropped and not yet reported *)
+  val dropped : t -> int
+
+  (** Logs a message. Custom printers ($%a$) return strings, as in
+    * $Printf.sprintf$. *)
+  val log : t -> level -> ('a, unit, string, unit) format4 -> 'a
 
   (** Logs a debug message *)
-  val debug : t -> ('a, out_channel, unit) format -> 'a
+  val debug : t -> ('a, unit, string, unit) format4 -> 'a
 
   (** Logs a warn message *)
-  val warn  : t -> ('a, out_channel, unit) format -> 'a
+  val warn  : t -> ('a, unit, string, unit) format4 -> 'a
 
   (** Logs an error message *)
-  val error : t -> ('a, out_channel, unit) format -> 'a
+  val error : t -> ('a, unit, string, unit) format4 -> 'a
 
   (** Logs an info message *)
-  val info  : t -> ('a, out_channel, unit) format -> 'a
+  val info  : t -> ('a, unit, string, unit) format4 -> 'a
 
   (** Logs a fatal error message *)
-  val fatal : t -> ('a, out_channel, unit) format -> 'a
+  val fatal : t -> ('a, unit, string, unit) format4 -> 'a
 
 end
 
@@ -52,11 +95,27 @@ end
 (** Simple clocks and counters *)
 module Clock : sig
 
-  (** Small utility to make clocks and counters (ex. FPS counter) *)
+  (** Small utility to make clocks and counters (ex. FPS counter)
+    *
+    * Clocks use a monotonic clock of the system, with a nanosecond
+    * resolution, which is not affected by changes of the wall-clock time *)
 
   (** Type of a clock *)
   type t
 
+  (** Returns the value of the monotonic clock in nanoseconds, from an
+    * unspecified origin *)
+  val now_ns : unit -> int
+
+  (** Returns the value of the monotonic clock in seconds *)
+  val now : unit -> float
+
+  (** $sleep_until ~spin deadline$ waits until $now_ns ()$ reaches $deadline$.
+    * The thread sleeps until $spin$ seconds (defaults to 0.002) before the
+    * deadline, then yields in a loop, which is more precise than sleeping
+    * for the whole duration. *)
+  val sleep_until : ?spin:float -> int -> unit
+
   (** Creates a clock *)
   val create : unit -> t
 
@@ -81,9 +140,103 @@ module Clock : sig
 end
 
 
+
+(** Frame time statistics *)
+module FrameStats : sig
+
+  (** This module keeps statistics over the durations of the last frames of
+    * an application : percentiles, histogram and hitches. Adding a frame
+    * does not allocate, and percentiles are computed in constant time. *)
+
+  (** Raised when an error occurs *)
+  exception FrameStats_exception of string
+
+  (** Type of frame statistics *)
+  type t
+
+  (** $create ~window ~hitch_factor ()$ creates statistics over the last
+    * $window$ frames (defaults to 240). A frame is a hitch if it lasts more
+    * than $hitch_factor$ (defaults to 2) times the median of the window.
+    *
+    * @raise FrameStats_exception if $window$ is less than 1 or $hitch_factor$
+    * is not greater than 1 *)
+  val create : ?window:int -> ?hitch_factor:float -> unit -> t
+
+  (** Removes all the frames and resets the counters *)
+  val reset : t -> unit
+
+  (** Adds the duration of a frame, in seconds *)
+  val add : t -> float -> unit
+
+  (** Returns the maximal number of frames of the window *)
+  val window : t -> int
+
+  (** Returns the number of frames in the window *)
+  val frames : t -> int
+
+  (** Returns the number of frames added since the creation or the last reset *)
+  val total : t -> int
+
+  (** Returns the duration of the last frame (0 if there is none) *)
+  val last : t -> float
+
+  (** Returns the mean duration of the frames of the window *)
+  val mean : t -> float
+
+  (** Returns the shortest frame of the window *)
+  val min : t -> float
+
+  (** Returns the longest frame of the window *)
+  val max : t -> float
+
+  (** Returns the number of frames per second, computed from the mean *)
+  val fps : t -> float
+
+  (** $percentile t p$ returns the duration under which a fraction $p$
+    * (between 0 and 1) of the frames of the window lie (nearest rank) *)
+  val percentile : t -> float -> float
+
+  (** Returns the median duration of the frames of the window *)
+  val median : t -> float
+
+  (** $percentile t 0.50$ *)
+  val p50 : t -> float
+
+  (** $percentile t 0.95$ *)
+  val p95 : t -> float
+
+  (** $percentile t 0.99$ *)
+  val p99 : t -> float
+
+  (** Returns true iff the last frame was a hitch *)
+  val hitch : t -> bool
+
+  (** Returns the number of hitches since the creation or the last reset *)
+  val hitches : t -> int
+
+  (** $histogram t ~bucket ~buckets$ counts the frames of the window in
+    * $buckets$ buckets of $bucket$ seconds, starting at 0. The last bucket
+    * also counts the longer frames.
+    *
+    * @raise FrameStats_exception if there is no bucket or $bucket$ is not
+    * positive *)
+  val histogram : t -> bucket:float -> buckets:int -> int array
+
+end
+
+
 (** UTF-8 String representation and manipulation *)
 module UTF8String : sig
 
+  (** This module provides UTF-8 encoded strings.
+    *
+    * A UTF-8 string keeps its encoded bytes, which are validated once when
+    * it is created (RFC 3629 : overlong sequences, surrogates and codes
+    * above 0x10FFFF are rejected). Iterations decode the bytes in place.
+    * Random accesses are O(1) for ASCII strings ; other strings build an
+    * index of the offsets of every 32nd character on their first random
+    * access, after which an access decodes at most 32 characters. *)
+
   (** Type of a UTF-8 character code *)
   type code = int
 
@@ -96,46 +249,67 @@ module UTF8String : sig
   (** Raised when an operation violates the bounds of the string *)
   exception Out_of_bounds of string
 
+  (** $validate s$ returns $None$ if $s$ is valid UTF-8, or the byte offset
+    * of its first invalid sequence *)
+  val validate : string -> int option
+
   (** Empty UTF-8 string *)
   val empty : unit -> t
 
   (** Makes a UTF-8 string filled with one character
     * 
-    * Raises UTF8_error if the code is not a valid UTF-8 character code *)
+    * @raise UTF8_error if the code is not a valid UTF-8 character code *)
   val make : int -> code -> t
 
-  (** Returns the ith character of a UTF-8 string *)
+  (** Returns the ith character of a UTF-8 string
+    *
+    * @raise Out_of_bounds if the index is out of the bounds of the string *)
   val get : t -> int -> code
 
   (** Sets the ith character of a UTF-8 string.
+    * A character is replaced in place by a character of the same encoded
+    * width ; otherwise this is O(n) since the following bytes are moved.
     *
-    * Raises UTF8_error if the code is not a valid UTF-8 character code *)
+    * @raise UTF8_error if the code is not a valid UTF-8 character code
+    * @raise Out_of_bounds if the index is out of the bounds of the string *)
   val set : t -> int -> code -> unit
 
-  (** Returns the length of a UTF-8 string *)
+  (** Returns the length of a UTF-8 string, in characters *)
   val length : t -> int
 
   (** Returns the byte length of a UTF-8 string
     * (the number of bytes required to encode it) *)
   val byte_length : t -> int
 
-  (** Returns a UTF-8 encoded string from a string.
+  (** Returns true if a UTF-8 string only contains ASCII characters *)
+  val is_ascii : t -> bool
+
+  (** $byte_offset s i$ returns the offset of the ith character of $s$ in
+    * its bytes. The offset of the character $length s$ is $byte_length s$.
+    *
+    * @raise Out_of_bounds if the index is out of the bounds of the string *)
+  val byte_offset : t -> int -> int
+
+  (** Returns a UTF-8 encoded string from a copy of a string
     * 
-    * Raises UTF8_error if the string is not a valid UTF-8 encoding *)
+    * @raise UTF8_error if the string is not a valid UTF-8 encoding *)
   val from_string : string -> t
 
-  (** Returns a string from a UTF-8 encoded string *)
+  (** Returns a copy of the bytes of a UTF-8 encoded string *)
   val to_string : t -> string
 
   (** Iterates through a UTF-8 string *)
   val iter : t -> (code -> unit) -> unit
 
+  (** Iterates through a UTF-8 string, with the index of each character *)
+  val iteri : t -> (int -> code -> unit) -> unit
+
   (** Folds a UTF-8 string *)
   val fold : t -> (code -> 'a -> 'a) -> 'a -> 'a
 
   (** Maps a UTF-8 string
     *
-    * Raises UTF8_error if the function returns an invalid UTF-8 code *)
+    * @raise UTF8_error if the function returns an invalid UTF-8 code *)
   val map : t -> (code -> code) -> t
 
 end
@@ -179,6 +353,13 @@ module Interpolator : sig
     * If $ip$ is not time-based then the result is $ip(0)$. *)
   val current : 'a t -> 'a
 
+  (** $at ip date$ returns the value of a time-based interpolator at the
+    * date $date$, given in seconds. Many interpolators can be sampled at
+    * the same date while reading the clock only once.
+    *
+    * If $ip$ is not time-based then the result is $ip(0)$. *)
+  val at : 'a t -> float -> 'a
+
   (** $start ip t dt$ returns a new time-based interpolator 
     * $tip$ such that :
     *
@@ -237,7 +418,13 @@ module Interpolator : sig
 
   (** $linear start steps endt$ creates a linear interpolator
     * going from $start$ to $endt$ passing through each point
-    * $(dt, pos)$ of $steps$ at time $dt < 1.0$ *)
+    * $(dt, pos)$ of $steps$ at time $dt < 1.0$
+    *
+    * Evaluations are done by binary search on the sorted times, starting
+    * from the segment of the previous evaluation.
+    *
+    * @raise Invalid_interpolator if the times of $steps$ are not sorted
+    * in [0;1] *)
   val linear : float -> (float * float) list -> float -> float t
 
   (** $cst_linear start steps endt$ creates a linear interpolator 
@@ -247,7 +434,12 @@ module Interpolator : sig
 
   (** $cubic (start, sm) steps (endt, em)$ creates a cubic spline interpolator
     * going from $start$ with tangent $sm$ to $endt$ with tangent $em$
-    * passing through each point $(dt, pos)$ of $steps$ at time $dt < 1.0$ *)
+    * passing through each point $(dt, pos)$ of $steps$ at time $dt < 1.0$
+    *
+    * The polynomial of each segment is computed once, at creation.
+    *
+    * @raise Invalid_interpolator if the times of $steps$ are not sorted
+    * in [0;1] *)
   val cubic : (float * float) -> (float * float) list -> (float * float) -> float t
 
   (** $cubic (start, sm) steps (endt, em)$ creates a cubic spline interpolator
@@ -298,10 +490,148 @@ module Interpolator : sig
 end
 
 
+
+(** Compiled keyframe animations *)
+module Animation : sig
+
+  (** This module provides animation tracks compiled for fast evaluation :
+    * the times of the keys are kept sorted in an array, and the coefficients
+    * of each segment are computed once at creation. Successive evaluations
+    * start from the segment of the previous one, and fall back to a binary
+    * search.
+    *
+    * An animation groups many tracks and samples them all at once in a
+    * float bigarray. Tracks whose keys are at the same times share a single
+    * segment lookup.
+    *
+    * Before the first key and after the last one, tracks take the value of
+    * the nearest key. *)
+
+  (** Raised when an error occurs *)
+  exception Animation_error of string
+
+  (** Type of the buffers in which tracks are sampled *)
+  type buffer = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+  (** Animation tracks *)
+  module Track : sig
+
+    (** Type of a track *)
+    type t
+
+    (** $step ~dimension times values$ creates a track that takes the
+      * value of the last key reached. Each key has $dimension$ components
+      * (defaults to 1), $values$ gives the components of each key one after
+      * the other.
+      *
+      * @raise Animation_error if there is no key, the times are not sorted
+      * or the number of values is not $dimension$ times the number of keys *)
+    val step : ?dimension:int -> float array -> float array -> t
+
+    (** Same as $step$, with linear interpolation between the keys *)
+    val linear : ?dimension:int -> float array -> float array -> t
+
+    (** Same as $step$, with cubic Hermite interpolation between the keys.
+      * $tangents$ gives the derivative of each component at each key, and
+      * defaults to the mean of the slopes of the adjacent segments.
+      *
+      * @raise Animation_error if the number of tangents is wrong *)
+    val cubic : ?dimension:int -> ?tangents:float array -> float array -> float array -> t
+
+    (** $rotation times keys$ creates a track of rotations, spherically
+      * interpolated along the shortest path. The keys are normalized, and
+      * the track has 4 components : $r$, $i$, $j$ and $k$.
+      *
+      * @raise Animation_error if there is no key, the times are not sorted,
+      * the number of keys is wrong or a key is zero *)
+    val rotation : float array -> OgamlMath.Quaternion.t array -> t
+
+    (** Returns the number of components of a track *)
+    val dimension : t -> int
+
+    (** Returns the number of keys of a track *)
+    val keys : t -> int
+
+    (** Returns the time of the first key *)
+    val start : t -> float
+
+    (** Returns the time of the last key *)
+    val stop : t -> float
+
+    (** Returns the time between the first and the last keys *)
+    val duration : t -> float
+
+    (** $sample track time buf offset$ writes the components of the value of
+      * $track$ at $time$ in $buf$, starting at $offset$
+      *
+      * @raise Animation_error if the buffer is too small *)
+    val sample : t -> float -> buffer -> int -> unit
+
+    (** $get track time$ returns the first component of the value of $track$
+      * at $time$, in double precision *)
+    val get : t -> float -> float
+
+    (** $quaternion track time$ returns the value of a rotation track
+      *
+      * @raise Animation_error if $track$ is not a rotation track *)
+    val quaternion : t -> float -> OgamlMath.Quaternion.t
+
+  end
+
+  (** Type of an animation *)
+  type t
+
+  (** Creates an animation from a list of tracks. The components of the
+    * tracks are laid out in their order in the sampling buffers.
+    *
+    * @raise Animation_error if there is no track *)
+  val create : Track.t list -> t
+
+  (** Returns the number of tracks of an animation *)
+  val tracks : t -> int
+
+  (** Returns the number of components of all the tracks *)
+  val size : t -> int
+
+  (** $offset anim i$ returns the position of the first component of the
+    * $i$th track in the sampling buffers
+    *
+    * @raise Animation_error if there is no such track *)
+  val offset : t -> int -> int
+
+  (** Returns the time of the first key of the tracks *)
+  val start : t -> float
+
+  (** Returns the time of the last key of the tracks *)
+  val stop : t -> float
+
+  (** Returns the time between $start$ and $stop$ *)
+  val duration : t -> float
+
+  (** Creates a sampling buffer of size $size anim$ *)
+  val buffer : t -> buffer
+
+  (** $sample ~loop anim time buf$ writes the values of all the tracks at
+    * $time$ in $buf$. If $loop$ is true (defaults to false), $time$ is
+    * wrapped between $start$ and $stop$.
+    *
+    * $sample$ does not allocate.
+    *
+    * @raise Animation_error if the buffer is too small *)
+  val sample : ?loop:bool -> t -> float -> buffer -> unit
+
+end
+
+
+
 (** Various noises *)
 module Noise : sig 
 
-  (** This module provides various 2D and 3D noises *)
+  (** This module provides various 2D and 3D noises, and fractal compositions
+    * of 2D noises that can fill large fields natively *)
+
+  (** Raised when an error occurs *)
+  exception Noise_exception of string
 
   (** 2D Perlin noise *)
   module Perlin2D : sig
@@ -318,6 +648,9 @@ module Noise : sig
     (** Gets the value of a 2D noise at a given point *)
     val get : t -> OgamlMath.Vector2f.t -> float
 
+    (** $get_xy t x y$ is $get t (Vector2f.make x y)$ *)
+    val get_xy : t -> float -> float -> float
+
   end
 
 
@@ -338,6 +671,139 @@ module Noise : sig
 
   end
 
+
+  (** 2D simplex noise *)
+  module Simplex2D : sig
+
+    (** Simplex noise has fewer directional artifacts than Perlin noise and
+      * is cheaper to compute. Its values lie in [-1;1]. *)
+
+    (** Type of a 2D simplex noise *)
+    type t
+
+    (** Creates a 2D simplex noise with the current random state *)
+    val create : unit -> t
+
+    (** Creates a 2D simplex noise with a custom random state *)
+    val create_with_seed : Random.State.t -> t
+
+    (** Gets the value of a 2D noise at a given point *)
+    val get : t -> OgamlMath.Vector2f.t -> float
+
+    (** $get_xy t x y$ is $get t (Vector2f.make x y)$ *)
+    val get_xy : t -> float -> float -> float
+
+  end
+
+
+  (** 2D OpenSimplex2-style noise *)
+  module OpenSimplex2D : sig
+
+    (** A simplex noise using the 24 evenly spread gradients and the
+      * attenuation of OpenSimplex2, which removes the remaining axis-aligned
+      * artifacts of $Simplex2D$. Its values lie approximately in [-1;1]. *)
+
+    (** Type of a 2D OpenSimplex2 noise *)
+    type t
+
+    (** Creates a 2D OpenSimplex2 noise with the current random state *)
+    val create : unit -> t
+
+    (** Creates a 2D OpenSimplex2 noise with a custom random state *)
+    val create_with_seed : Random.State.t -> t
+
+    (** Gets the value of a 2D noise at a given point *)
+    val get : t -> OgamlMath.Vector2f.t -> float
+
+    (** $get_xy t x y$ is $get t (Vector2f.make x y)$ *)
+    val get_xy : t -> float -> float -> float
+
+  end
+
+
+  (** 3D simplex noise *)
+  module Simplex3D : sig
+
+    (** Type of a 3D simplex noise *)
+    type t
+
+    (** Creates a 3D simplex noise with the current random state *)
+    val create : unit -> t
+
+    (** Creates a 3D simplex noise with a custom random state *)
+    val create_with_seed : Random.State.t -> t
+
+    (** Gets the value of a 3D noise at a given point *)
+    val get : t -> OgamlMath.Vector3f.t -> float
+
+  end
+
+
+  (** Fractal 2D noises *)
+  module Fractal : sig
+
+    (** Fractal noises sum several octaves of a base noise, each one with a
+      * higher frequency and a lower amplitude than the previous one.
+      *
+      * Fields of values (heightmaps for example) can be filled natively, with
+      * a kernel that computes two samples at once on SSE2 machines. Both 
+      * paths return exactly the same values. The native kernel releases the
+      * runtime lock, so bands of rows can be filled from several threads. *)
+
+    (** Type of the bigarrays filled by $fill$ *)
+    type bigarray = (float, Bigarray.float32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+    (** Base noises *)
+    type noise =
+      | Perlin of Perlin2D.t
+      | Simplex of Simplex2D.t
+      | OpenSimplex of OpenSimplex2D.t
+
+    (** Type of a fractal noise *)
+    type t
+
+    (** $create ~octaves ~frequency ~lacunarity ~gain ~ridged ~warp noise$ 
+      * creates a fractal noise.
+      *
+      * $octaves$ (defaults to 6) octaves are summed, starting at frequency
+      * $frequency$ (defaults to 1) with amplitude 1. Each octave multiplies
+      * the frequency by $lacunarity$ (defaults to 2) and the amplitude by
+      * $gain$ (defaults to 0.5). The sum is divided by the sum of the
+      * amplitudes (fractal brownian motion).
+      *
+      * If $ridged$ is true (defaults to false), each octave $n$ is replaced
+      * by $(1 - |n|)^2$, which creates sharp ridges.
+      *
+      * If $warp$ is not zero (the default), the input point is first moved by
+      * $warp$ times two samples of the base noise (domain warping).
+      *
+      * @raise Noise_exception if $octaves$ is less than 1 *)
+    val create : ?octaves:int -> ?frequency:float -> ?lacunarity:float -> ?gain:float ->
+                 ?ridged:bool -> ?warp:float -> noise -> t
+
+    (** Gets the value of a fractal noise at a given point *)
+    val get : t -> OgamlMath.Vector2f.t -> float
+
+    (** $get_xy t x y$ is $get t (Vector2f.make x y)$ *)
+    val get_xy : t -> float -> float -> float
+
+    (** $fill t field ~stride ~origin ~step rect$ fills a region of a field
+      * of $stride$ columns stored by rows : for every cell of $rect$, the
+      * value at column $i$ and row $j$ of the field is the noise at
+      * $origin + step * (i,j)$.
+      *
+      * Values only depend on the position of the cell in the field, so a
+      * field can be filled in several bands with the same result.
+      *
+      * If $native$ is false (defaults to true), the OCaml implementation is
+      * used instead of the native one.
+      *
+      * @raise Noise_exception if the region does not fit in the field *)
+    val fill : ?native:bool -> t -> bigarray -> stride:int -> origin:OgamlMath.Vector2f.t ->
+               step:float -> OgamlMath.IntRect.t -> unit
+
+  end
+
 end
 
 
@@ -411,6 +877,120 @@ module PriorityQueue : sig
   (** Priority queue functor *)
   module Make : functor (P : Priority) -> Q with type priority = P.t
 
+
+  (** Type of PriorityQueue.Indexed *)
+  module type IQ = sig
+
+    (** This module provides mutable priority queues implemented as 
+      * array-based d-ary heaps. 
+      *
+      * Each inserted element is identified by a handle, which can be used to
+      * change its priority or to remove it in logarithmic time. The handle
+      * of an element that has left the queue is invalid, and may be given
+      * to a later insertion : check the value of an element before using an
+      * old handle. *)
+
+    (** Raised when a queue is empty *)
+    exception Empty
+
+    (** Raised when using the handle of an element that is not in the queue *)
+    exception Invalid_handle
+
+    (** Raised by $decrease_key$ when the new priority is greater than the old one *)
+    exception Invalid_priority
+
+    (** Priorities used by the queue *)
+    type priority
+
+    (** Handle of an element *)
+    type handle = int
+
+    (** Type of a queue storing elements of type $'a$ *)
+    type 'a t
+
+    (** Creates an empty queue. $arity$ is the number of children of each 
+      * node of the heap (defaults to 4), and $capacity$ the initial size
+      * of the queue (defaults to 16). 
+      *
+      * Raises $Invalid_argument$ if $arity < 2$ *)
+    val create : ?arity:int -> ?capacity:int -> unit -> 'a t
+
+    (** Creates a queue from an array of elements in linear time. The handle 
+      * of each element is its index in the array. *)
+    val heapify : ?arity:int -> (priority * 'a) array -> 'a t
+
+    (** Returns the number of elements of a queue *)
+    val length : 'a t -> int
+
+    (** Returns $true$ iff the queue is empty *)
+    val is_empty : 'a t -> bool
+
+    (** Returns the number of elements a queue can hold before growing.
+      * It only depends on the largest number of elements the queue has
+      * held, not on the number of insertions. *)
+    val capacity : 'a t -> int
+
+    (** Removes all the elements of a queue and invalidates their handles *)
+    val clear : 'a t -> unit
+
+    (** Inserts an element with a given priority and returns its handle *)
+    val insert : 'a t -> priority -> 'a -> handle
+
+    (** Returns the top element of a queue
+      *
+      * Raises $Empty$ if the queue is empty *)
+    val top : 'a t -> 'a
+
+    (** Returns the priority of the top element of a queue
+      *
+      * Raises $Empty$ if the queue is empty *)
+    val top_priority : 'a t -> priority
+
+    (** Removes the top element of a queue
+      *
+      * Raises $Empty$ if the queue is empty *)
+    val pop : 'a t -> unit
+
+    (** Removes and returns the top element of a queue
+      *
+      * Raises $Empty$ if the queue is empty *)
+    val extract : 'a t -> 'a
+
+    (** Returns $true$ iff the element of a handle is still in the queue *)
+    val mem : 'a t -> handle -> bool
+
+    (** Returns the priority of an element
+      *
+      * Raises $Invalid_handle$ if the element is not in the queue *)
+    val priority : 'a t -> handle -> priority
+
+    (** Returns the value of an element
+      *
+      * Raises $Invalid_handle$ if the element is not in the queue *)
+    val value : 'a t -> handle -> 'a
+
+    (** Decreases the priority of an element
+      *
+      * Raises $Invalid_handle$ if the element is not in the queue, and 
+      * $Invalid_priority$ if the new priority is greater than the old one *)
+    val decrease_key : 'a t -> handle -> priority -> unit
+
+    (** Changes the priority of an element
+      *
+      * Raises $Invalid_handle$ if the element is not in the queue *)
+    val update : 'a t -> handle -> priority -> unit
+
+    (** Removes an element from a queue
+      *
+      * Raises $Invalid_handle$ if the element is not in the queue *)
+    val remove : 'a t -> handle -> unit
+
+  end
+
+
+  (** Mutable priority queue functor *)
+  module Indexed : functor (P : Priority) -> IQ with type priority = P.t
+
 end
 
 
@@ -433,6 +1013,97 @@ module Graph : sig
   end
 
 
+  (** Compact graphs with integer vertices *)
+  module CSR : sig
+
+    (** This module provides frozen graphs in compressed sparse row format :
+      * the vertices are the integers $0 .. n-1$ and the edges of all the vertices
+      * are stored contiguously in flat arrays.
+      *
+      * These graphs cannot be modified, but searches run on mutable arrays
+      * and allocate very little, which makes them suitable for large navigation
+      * graphs. They are built with a $Builder$ or from a graph with $G.to_csr$. *)
+
+    (** Raised when an error occurs *)
+    exception CSR_exception of string
+
+    (** Type of a frozen graph *)
+    type t
+
+    (** Graph builder *)
+    module Builder : sig
+
+      (** Type of a frozen graph *)
+      type csr = t
+
+      (** Type of a builder *)
+      type t
+
+      (** Creates a builder with an initial number of vertices (defaults to 0) *)
+      val create : ?vertices:int -> unit -> t
+
+      (** Returns the number of vertices of a builder *)
+      val vertices : t -> int
+
+      (** Returns the number of edges of a builder *)
+      val edges : t -> int
+
+      (** Adds a vertex and returns its id *)
+      val add_vertex : t -> int
+
+      (** $add_edge b ~cost v1 v2$ adds an edge from $v1$ to $v2$ (cost defaults to 1).
+        * The number of vertices grows if needed. Parallel edges are kept. 
+        *
+        * @raise CSR_exception if a vertex id is negative *)
+      val add_edge : t -> ?cost:float -> int -> int -> unit
+
+      (** Creates a frozen graph. The neighbours of each vertex are
+        * stored in the order in which their edges were added. *)
+      val freeze : t -> csr
+
+    end
+
+    (** Returns the number of vertices of a graph *)
+    val vertices : t -> int
+
+    (** Returns the number of edges of a graph *)
+    val edges : t -> int
+
+    (** Returns the number of outgoing edges of a vertex. All the functions taking
+      * a vertex raise CSR_exception if it is out of bounds. *)
+    val degree : t -> int -> int
+
+    (** Returns the list of the neighbours of a vertex *)
+    val neighbours : t -> int -> int list
+
+    (** $iter_neighbours g v f$ iterates $f u cost$ on all the edges from $v$ *)
+    val iter_neighbours : t -> int -> (int -> float -> unit) -> unit
+
+    (** Folds through all the edges from a vertex *)
+    val fold_neighbours : t -> int -> (int -> float -> 'a -> 'a) -> 'a -> 'a
+
+    (** $iter_edges g f$ iterates $f v u cost$ on all the edges of a graph *)
+    val iter_edges : t -> (int -> int -> float -> unit) -> unit
+
+    (** Same as $G.dfs$ *)
+    val dfs : t -> int -> (int -> unit) -> unit
+
+    (** Same as $G.bfs$ *)
+    val bfs : t -> int -> (int -> unit) -> unit
+
+    (** Same as $G.dijkstra$ *)
+    val dijkstra : t -> int -> int -> (float * int list) option
+
+    (** Same as $G.astar$ *)
+    val astar : t -> int -> int -> (int -> float) -> (float * int list) option
+
+    (** $distances g v$ returns the distances from $v$ to all the vertices of $g$ 
+      * (infinity for unreachable vertices) *)
+    val distances : t -> int -> float array
+
+  end
+
+
   (** Output of Graph.Make *)
   module type G = sig
 
@@ -502,9 +1173,696 @@ module Graph : sig
       * distance between $v1$ and $v2$, or $None$ if $v1$ and $v2$ are not connected *)
     val astar : t -> vertex -> vertex -> (vertex -> float) -> (float * vertex list) option
 
+    (** $to_csr g$ returns a compact copy of $g$, along with the mappings 
+      * between the vertices of $g$ and those of the copy. The traversals 
+      * of the copy visit the vertices in the same order as those of $g$. *)
+    val to_csr : t -> CSR.t * (vertex -> int) * (int -> vertex)
+
   end
 
   (** Graph functor *)
   module Make : functor (V : Vertex) -> G with type vertex = V.t
 
 end
+
+
+(** Bounding volume hierarchies *)
+module BVH : sig
+
+  (** This module provides a static bounding volume hierarchy over triangles,
+    * spheres and boxes, built with the surface area heuristic.
+    *
+    * Nodes are stored in flat arrays, which keeps traversals cache-friendly
+    * and allocation-free. Moving primitives can be handled by refitting the
+    * hierarchy rather than rebuilding it (the quality of the tree then slowly
+    * degrades, so a rebuild is advised after large displacements). *)
+
+  (** Raised when an error occurs *)
+  exception BVH_error of string
+
+  (** Type of the primitives stored in a BVH *)
+  type primitive =
+    | Triangle of OgamlMath.Vector3f.t * OgamlMath.Vector3f.t * OgamlMath.Vector3f.t
+    | Sphere   of OgamlMath.Vector3f.t * float (* Center, radius *)
+    | Box      of OgamlMath.FloatBox.t
+
+  (** Type of a ray hit : index of the primitive, distance along the
+    * (normalized) ray, and hit point *)
+  type hit = {
+    primitive : int;
+    distance  : float;
+    point     : OgamlMath.Vector3f.t
+  }
+
+  (** Type of a BVH *)
+  type t
+
+  (** Builds a BVH from an array of primitives. The primitives are then
+    * referred to by their index in this array.
+    *
+    * @raise BVH_error if the array is empty *)
+  val create : primitive array -> t
+
+  (** Returns the number of primitives of a BVH *)
+  val length : t -> int
+
+  (** Returns the number of nodes of a BVH *)
+  val nodes : t -> int
+
+  (** Returns the depth of a BVH *)
+  val depth : t -> int
+
+  (** Returns the primitive at a given index
+    *
+    * @raise BVH_error if the index is out of bounds *)
+  val get : t -> int -> primitive
+
+  (** Returns the bounding box of all the primitives of a BVH *)
+  val bounds : t -> OgamlMath.FloatBox.t
+
+  (** $set t i p$ replaces the $i$-th primitive by $p$ without updating the
+    * bounds of the hierarchy. $refit$ must be called before the next query.
+    *
+    * @raise BVH_error if the index is out of bounds *)
+  val set : t -> int -> primitive -> unit
+
+  (** Recomputes the bounds of all the nodes in a single linear pass,
+    * to be used after a batch of $set$ *)
+  val refit : t -> unit
+
+  (** $update t i p$ replaces the $i$-th primitive by $p$ and refits
+    * its ancestors only
+    *
+    * @raise BVH_error if the index is out of bounds *)
+  val update : t -> int -> primitive -> unit
+
+  (** $raycast t ~origin ~direction ()$ returns the closest primitive hit by
+    * a ray, if any, whose distance is at most $max_dist$ (defaults to infinity).
+    * Rays starting inside a sphere or a box hit it at distance 0.
+    *
+    * @raise BVH_error if the direction is zero *)
+  val raycast : t -> ?max_dist:float -> origin:OgamlMath.Vector3f.t -> 
+    direction:OgamlMath.Vector3f.t -> unit -> hit option
+
+  (** Returns all the primitives hit by a ray, sorted by distance
+    *
+    * @raise BVH_error if the direction is zero *)
+  val raycast_all : t -> ?max_dist:float -> origin:OgamlMath.Vector3f.t -> 
+    direction:OgamlMath.Vector3f.t -> unit -> hit list
+
+  (** $overlap_box t box f$ iterates $f$ on the indices of all the primitives
+    * intersecting $box$ *)
+  val overlap_box : t -> OgamlMath.FloatBox.t -> (int -> unit) -> unit
+
+  (** $overlap_sphere t center radius f$ iterates $f$ on the indices of all
+    * the primitives intersecting a sphere *)
+  val overlap_sphere : t -> OgamlMath.Vector3f.t -> float -> (int -> unit) -> unit
+
+  (** $overlap t p f$ iterates $f$ on the indices of all the primitives
+    * intersecting $p$ *)
+  val overlap : t -> primitive -> (int -> unit) -> unit
+
+end
+
+
+(** Pathfinding on grids *)
+module Pathfinding : sig
+
+  (** This module provides pathfinding algorithms specialized for tile maps.
+    *
+    * Grids are 8-connected : straight moves cost 1 and diagonal moves cost 
+    * $sqrt 2$. A diagonal move is only allowed if both cells it passes 
+    * by are walkable (no corner cutting). 
+    *
+    * Searchers own their scratch space and are not thread-safe, but several
+    * searchers can share the same grid. *)
+
+  (** Raised when an error occurs *)
+  exception Pathfinding_exception of string
+
+  (** Grids of walkable or blocked cells *)
+  module Grid : sig
+
+    (** Type of a grid *)
+    type t
+
+    (** Type of a callback registered on a grid *)
+    type listener
+
+    (** Creates a grid in which all the cells are walkable
+      *
+      * @raise Pathfinding_exception if a dimension is not positive *)
+    val create : width:int -> height:int -> t
+
+    (** Returns the width of a grid *)
+    val width : t -> int
+
+    (** Returns the height of a grid *)
+    val height : t -> int
+
+    (** $walkable g x y$ returns $true$ iff $(x,y)$ is inside $g$ and not blocked *)
+    val walkable : t -> int -> int -> bool
+
+    (** Returns the index $y * width + x$ of a cell
+      *
+      * @raise Pathfinding_exception if the cell is out of bounds *)
+    val index : t -> OgamlMath.Vector2i.t -> int
+
+    (** Returns the cell of an index
+      *
+      * @raise Pathfinding_exception if the index is out of bounds *)
+    val cell : t -> int -> OgamlMath.Vector2i.t
+
+    (** Returns $true$ iff a cell is blocked
+      *
+      * @raise Pathfinding_exception if the cell is out of bounds *)
+    val is_blocked : t -> OgamlMath.Vector2i.t -> bool
+
+    (** Blocks or unblocks a cell, and notifies the structures built on the grid
+      *
+      * @raise Pathfinding_exception if the cell is out of bounds *)
+    val set_blocked : t -> OgamlMath.Vector2i.t -> bool -> unit
+
+    (** $on_change g f$ registers $f$ to be called with $x$ and $y$ each time 
+      * the cell $(x,y)$ is blocked or unblocked. The grid keeps $f$ alive
+      * until it is removed. *)
+    val on_change : t -> (int -> int -> unit) -> listener
+
+    (** Removes a callback from a grid (does nothing if it was already removed) *)
+    val remove_listener : t -> listener -> unit
+
+    (** $iter_moves g x y f$ iterates $f x' y' cost$ on all the moves from $(x,y)$ *)
+    val iter_moves : t -> int -> int -> (int -> int -> float -> unit) -> unit
+
+    (** Iterates through the neighbours of a walkable cell and the cost to reach them
+      *
+      * @raise Pathfinding_exception if the cell is out of bounds *)
+    val iter_neighbours : t -> OgamlMath.Vector2i.t -> (OgamlMath.Vector2i.t -> float -> unit) -> unit
+
+    (** Returns the graph of the moves of a grid, whose vertices are 
+      * the indices of the cells *)
+    val to_csr : t -> Graph.CSR.t
+
+  end
+
+
+  (** Jump point search *)
+  module JPS : sig
+
+    (** Jump point search is an optimal A* for uniform-cost grids that skips
+      * the cells of straight and diagonal runs, only expanding the cells
+      * where the optimal path may turn. It needs no preprocessing. *)
+
+    (** Type of a searcher *)
+    type t
+
+    (** Creates a searcher on a grid *)
+    val create : Grid.t -> t
+
+    (** $find_path t start goal$ returns the length of a shortest path from 
+      * $start$ to $goal$ and the cells of this path, or $None$ if $goal$
+      * is not reachable
+      *
+      * @raise Pathfinding_exception if a cell is out of bounds *)
+    val find_path : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t -> 
+      (float * OgamlMath.Vector2i.t list) option
+
+  end
+
+
+  (** Hierarchical pathfinding *)
+  module HPA : sig
+
+    (** HPA* divides a grid into square clusters and precomputes the shortest
+      * paths between the entrances of each cluster. Searches run on this small
+      * abstract graph and are then refined inside each cluster.
+      *
+      * When cells of the grid change, only the clusters around them are
+      * recomputed, lazily, before the next search.
+      *
+      * By default, each entrance between two clusters only has one or two
+      * transitions, and paths are usually a few percent longer than optimal.
+      * In exact mode, all the cells on cluster borders are entrances : the 
+      * abstract graph is larger but the paths are optimal. *)
+
+    (** Type of a hierarchical searcher *)
+    type t
+
+    (** Creates a searcher on a grid, with square clusters of side
+      * $cluster_size$ (defaults to 16) 
+      *
+      * @raise Pathfinding_exception if $cluster_size < 2$ *)
+    val create : ?cluster_size:int -> ?exact:bool -> Grid.t -> t
+
+    (** Returns the number of nodes of the abstract graph *)
+    val nodes : t -> int
+
+    (** Same as $JPS.find_path$, but the path is not necessarily optimal
+      * if the searcher was not created in exact mode *)
+    val find_path : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t -> 
+      (float * OgamlMath.Vector2i.t list) option
+
+    (** Unregisters a searcher from its grid. It must not be used afterwards,
+      * since it does not follow the changes of the grid anymore. *)
+    val release : t -> unit
+
+  end
+
+end
+
+
+(** Flow fields *)
+module FlowField : sig
+
+  (** This module provides flow fields, which guide any number of units 
+    * towards a common goal.
+    *
+    * A flow field stores the distance from each cell of a grid to the closest
+    * goal (the integration field), and the next cell on a shortest path to it.
+    * Looking up the direction of a unit is then done in constant time.
+    *
+    * Flow fields follow the changes of their grid : when a cell is blocked,
+    * only the cells whose path went through it are recomputed, and when a 
+    * cell is unblocked, only the distances it improves are propagated. 
+    * A flow field stays registered to its grid until it is released. *)
+
+  (** Raised when an error occurs *)
+  exception FlowField_exception of string
+
+  (** Type of a flow field on a grid *)
+  type t
+
+  (** $create grid goals$ creates the flow field of a list of goal cells.
+    * The moves are those of $Pathfinding.Grid$.
+    *
+    * @raise FlowField_exception if a goal is out of bounds *)
+  val create : Pathfinding.Grid.t -> OgamlMath.Vector2i.t list -> t
+
+  (** Returns the distance from a cell to the closest goal, or infinity if no goal
+    * is reachable
+    *
+    * @raise Pathfinding.Pathfinding_exception if the cell is out of bounds *)
+  val distance : t -> OgamlMath.Vector2i.t -> float
+
+  (** Returns the next cell on a shortest path to a goal, or $None$ for
+    * goals and cells from which no goal is reachable
+    *
+    * @raise Pathfinding.Pathfinding_exception if the cell is out of bounds *)
+  val next : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t option
+
+  (** Returns the move towards the next cell, or zero if there is none
+    *
+    * @raise Pathfinding.Pathfinding_exception if the cell is out of bounds *)
+  val direction : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t
+
+  (** Unregisters a flow field from its grid, so that the grid does not keep
+    * it alive nor update it anymore. The field keeps its last state. *)
+  val release : t -> unit
+
+
+  (** Flow fields on arbitrary graphs *)
+  module CSR : sig
+
+    (** Flow fields on frozen graphs (see $Graph.G.to_csr$). They are computed
+      * once and do not support updates. *)
+
+    (** Type of a flow field on a graph *)
+    type t
+
+    (** $create g goals$ creates the flow field of a list of goal vertices,
+      * following the direction of the edges of $g$
+      *
+      * @raise FlowField_exception if a goal is out of bounds *)
+    val create : Graph.CSR.t -> int list -> t
+
+    (** Returns the distance from a vertex to the closest goal
+      *
+      * @raise FlowField_exception if the vertex is out of bounds *)
+    val distance : t -> int -> float
+
+    (** Returns the next vertex on a shortest path to a goal
+      *
+      * @raise FlowField_exception if the vertex is out of bounds *)
+    val next : t -> int -> int option
+
+  end
+
+end
+
+
+
+(** Loose quadtrees and octrees *)
+module SpatialTree : sig
+
+  (** This module provides loose quadtrees and octrees, functorized over the
+    * bounds and points of a space, to index moving objects.
+    *
+    * Each node of a loose tree stores the objects that fit in its cell
+    * enlarged twice around its center. Objects are therefore placed by their
+    * center and size only : moving an object inside its enlarged cell costs
+    * a few comparisons, and moving it further relinks it from the closest
+    * ancestor that can hold it.
+    *
+    * Nodes and objects are stored in flat arrays which are recycled when
+    * objects are removed or subtrees collapse, so that updating a tree every
+    * frame does not allocate once it has reached its working size. *)
+
+  (** Raised when an error occurs *)
+  exception SpatialTree_exception of string
+
+  (** Space of a tree *)
+  module type Space = sig
+
+    (** This module describes the bounds and points of a space *)
+
+    (** Type of the bounds of the objects *)
+    type bounds
+
+    (** Type of a point *)
+    type point
+
+    (** Number of dimensions (2 for quadtrees, 3 for octrees) *)
+    val dim : int
+
+    (** $write b a o$ writes the $dim$ minimal coordinates of $b$ followed by
+      * its $dim$ maximal coordinates in $a$ at offset $o$ *)
+    val write : bounds -> float array -> int -> unit
+
+    (** Dual of $write$ *)
+    val read : float array -> int -> bounds
+
+    (** $coord p k$ returns the $k$-th coordinate of $p$ *)
+    val coord : point -> int -> float
+
+  end
+
+  (** Space of rectangles *)
+  module Rect : Space with type bounds = OgamlMath.FloatRect.t
+                      and type point = OgamlMath.Vector2f.t
+
+  (** Space of boxes *)
+  module Box : Space with type bounds = OgamlMath.FloatBox.t
+                     and type point = OgamlMath.Vector3f.t
+
+
+  (** Type of SpatialTree.Make *)
+  module type S = sig
+
+    (** Type of the bounds of the objects *)
+    type bounds
+
+    (** Type of a point *)
+    type point
+
+    (** Type of a tree containing values of type 'a *)
+    type 'a t
+
+    (** Type of the handle of an object, used to update or remove it.
+      * Handles of removed objects are reused. *)
+    type handle = int
+
+    (** $create ~max_depth ~leaf_size bounds$ creates an empty tree covering
+      * $bounds$ (enlarged to a square or a cube). Objects outside of these
+      * bounds are accepted, but are kept in the root and tested by every query.
+      *
+      * Leaves are split when they hold more than $leaf_size$ objects
+      * (defaults to 8), up to depth $max_depth$ (defaults to 16).
+      *
+      * @raise SpatialTree_exception if the bounds are empty, or if a parameter
+      * is not positive *)
+    val create : ?max_depth:int -> ?leaf_size:int -> bounds -> 'a t
+
+    (** Returns the number of objects of a tree *)
+    val length : 'a t -> int
+
+    (** Returns the number of nodes of a tree *)
+    val nodes : 'a t -> int
+
+    (** Returns the depth of a tree *)
+    val depth : 'a t -> int
+
+    (** Removes all the objects of a tree, keeping its storage *)
+    val clear : 'a t -> unit
+
+    (** $insert t bounds v$ inserts an object and returns its handle *)
+    val insert : 'a t -> bounds -> 'a -> handle
+
+    (** Removes an object
+      *
+      * @raise SpatialTree_exception if the handle is invalid *)
+    val remove : 'a t -> handle -> unit
+
+    (** Sets the bounds of an object
+      *
+      * @raise SpatialTree_exception if the handle is invalid *)
+    val update : 'a t -> handle -> bounds -> unit
+
+    (** Returns true iff a handle refers to an object of the tree *)
+    val mem : 'a t -> handle -> bool
+
+    (** Returns the (normalized) bounds of an object
+      *
+      * @raise SpatialTree_exception if the handle is invalid *)
+    val bounds : 'a t -> handle -> bounds
+
+    (** Returns the value of an object
+      *
+      * @raise SpatialTree_exception if the handle is invalid *)
+    val value : 'a t -> handle -> 'a
+
+    (** Iterates through all the objects of a tree *)
+    val iter : 'a t -> (handle -> 'a -> unit) -> unit
+
+    (** $range t bounds f$ calls $f$ on every object whose bounds intersect
+      * $bounds$. The tree must not be modified by $f$. *)
+    val range : 'a t -> bounds -> (handle -> 'a -> unit) -> unit
+
+    (** $point t p f$ calls $f$ on every object whose bounds contain $p$.
+      * The tree must not be modified by $f$. *)
+    val point : 'a t -> point -> (handle -> 'a -> unit) -> unit
+
+    (** $nearest t ~max_dist p k$ returns the (at most) $k$ objects closest
+      * to $p$, with their distances, sorted by increasing distance. The
+      * distance to an object is the distance to its bounds, and objects
+      * farther than $max_dist$ (defaults to infinity) are ignored.
+      *
+      * @raise SpatialTree_exception if $k$ is negative *)
+    val nearest : 'a t -> ?max_dist:float -> point -> int -> (handle * float) list
+
+  end
+
+  (** Functor to create loose trees over any space *)
+  module Make : functor (S : Space) -> S with type bounds = S.bounds and type point = S.point
+
+  (** Loose quadtrees of rectangles *)
+  module Quadtree : S with type bounds = OgamlMath.FloatRect.t
+                      and type point = OgamlMath.Vector2f.t
+
+  (** Loose octrees of boxes *)
+  module Octree : sig
+
+    (** Loose octrees of boxes, with frustum queries *)
+
+    include S with type bounds = OgamlMath.FloatBox.t
+               and type point = OgamlMath.Vector3f.t
+
+    (** $frustum t f g$ calls $g$ on every object whose bounds intersect the
+      * frustum $f$ (as defined by $Frustum.intersects_box$). Whole subtrees
+      * inside the frustum are reported without further tests. *)
+    val frustum : 'a t -> OgamlMath.Frustum.t -> (handle -> 'a -> unit) -> unit
+
+  end
+
+end
+
+
+
+(** Uniform grids for 2D broad-phase collision detection *)
+module SpatialHash2D : sig
+
+  (** This module provides a uniform grid of square cells, stored in a hash
+    * table, to find the pairs of overlapping rectangles among many moving
+    * objects of similar sizes. Use $SpatialTree$ when the sizes vary a lot.
+    *
+    * The grid is meant to be cleared and filled again every frame. The table
+    * is a flat open-addressing table whose slots are tagged with a
+    * generation, so clearing it is done in constant time and filling it
+    * does not allocate once it has reached its working size. *)
+
+  (** Raised when an error occurs *)
+  exception SpatialHash2D_exception of string
+
+  (** Type of a grid *)
+  type t
+
+  (** $create ~capacity ~cell_size ()$ creates an empty grid of cells of size
+    * $cell_size$, with room for about $capacity$ objects (defaults to 64).
+    * The cells should be about as large as the objects.
+    *
+    * @raise SpatialHash2D_exception if the cell size is not positive *)
+  val create : ?capacity:int -> cell_size:float -> unit -> t
+
+  (** Returns the size of the cells of a grid *)
+  val cell_size : t -> float
+
+  (** Returns the number of objects of a grid *)
+  val length : t -> int
+
+  (** Returns the number of non-empty cells of a grid *)
+  val cells : t -> int
+
+  (** Removes all the objects of a grid in constant time *)
+  val clear : t -> unit
+
+  (** $add t id rect$ adds an object with identifier $id$ to all the cells
+    * overlapped by $rect$ *)
+  val add : t -> int -> OgamlMath.FloatRect.t -> unit
+
+  (** Returns the cell containing a point *)
+  val cell : t -> OgamlMath.Vector2f.t -> OgamlMath.Vector2i.t
+
+  (** Iterates through the identifiers of the objects overlapping a cell *)
+  val iter_cell : t -> OgamlMath.Vector2i.t -> (int -> unit) -> unit
+
+  (** $iter_pairs t f$ calls $f a b$ once for every pair of objects whose
+    * rectangles intersect (as defined by $FloatRect.intersects$). The order
+    * of $a$ and $b$ is unspecified. *)
+  val iter_pairs : t -> (int -> int -> unit) -> unit
+
+  (** Returns the list of pairs of $iter_pairs$ *)
+  val pairs : t -> (int * int) list
+
+  (** $query t rect f$ calls $f$ once on every object whose rectangle
+    * intersects $rect$ *)
+  val query : t -> OgamlMath.FloatRect.t -> (int -> unit) -> unit
+
+end
+
+
+
+(** Work-stealing task scheduler *)
+module Scheduler : sig
+
+  (** This module provides a pool of worker threads that share tasks through
+    * work stealing : every worker owns a deque of tasks, runs the last task
+    * it has pushed, and takes the oldest task of another worker when its
+    * deque is empty. Tasks submitted from outside the pool go to a common
+    * queue. Subsystems should use the pool returned by $shared$ rather than
+    * creating their own threads.
+    *
+    * Workers are system threads, which share a single runtime lock : tasks
+    * only run simultaneously while they are in code that releases it, such
+    * as IO or $Noise.Fractal.fill$. Pure OCaml tasks are interleaved. *)
+
+  (** Raised when an error occurs *)
+  exception Scheduler_exception of string
+
+  (** Work-stealing deques *)
+  module Deque : sig
+
+    (** This module provides the mutable deques of the workers, laid out as
+      * Chase-Lev deques : a growable circular buffer indexed by two
+      * counters. Without atomics, the counters are protected by a mutex,
+      * which empty deques do not take when popped or stolen from. *)
+
+    (** Type of a deque containing values of type 'a *)
+    type 'a t
+
+    (** Creates an empty deque *)
+    val create : unit -> 'a t
+
+    (** Returns the number of elements of a deque *)
+    val length : 'a t -> int
+
+    (** Returns true iff a deque is empty *)
+    val is_empty : 'a t -> bool
+
+    (** Pushes an element at the bottom of a deque (owner side) *)
+    val push : 'a t -> 'a -> unit
+
+    (** Removes the element at the bottom of a deque, that is the last pushed
+      * one, if any (owner side) *)
+    val pop : 'a t -> 'a option
+
+    (** Removes the element at the top of a deque, that is the oldest one, if
+      * any (thief side) *)
+    val steal : 'a t -> 'a option
+
+  end
+
+  (** Type of a pool of workers *)
+  type t
+
+  (** Type of the result of a task that may not be finished yet *)
+  type 'a promise
+
+  (** Statistics of a worker since the creation of the pool or the last call
+    * to $reset_stats$ *)
+  type stats = {
+    tasks  : int;   (* Number of tasks run *)
+    steals : int;   (* Number of tasks taken from other workers *)
+    busy   : float; (* Time spent running tasks, in seconds *)
+    idle   : float  (* Time spent looking for tasks or sleeping, in seconds *)
+  }
+
+  (** $create ~workers ()$ creates a pool of $workers$ threads (defaults to 4)
+    *
+    * @raise Scheduler_exception if $workers$ is less than 1 *)
+  val create : ?workers:int -> unit -> t
+
+  (** Returns the pool shared by the library, created on the first call *)
+  val shared : unit -> t
+
+  (** Returns the number of workers of a pool *)
+  val workers : t -> int
+
+  (** Runs the remaining tasks of a pool, then stops its workers
+    *
+    * @raise Scheduler_exception if called from a task of the pool *)
+  val shutdown : t -> unit
+
+  (** $async t f$ submits the task $f$ to the pool and returns immediately
+    *
+    * @raise Scheduler_exception if the pool has been shut down *)
+  val async : t -> (unit -> 'a) -> 'a promise
+
+  (** Waits for a task to finish and returns its result. A worker waiting
+    * for a task runs other tasks in the meantime, so tasks can wait for
+    * their subtasks.
+    *
+    * @raise any exception raised by the task *)
+  val await : t -> 'a promise -> 'a
+
+  (** Returns true if the task of a promise has finished, in which case
+    * $await$ returns immediately *)
+  val is_ready : 'a promise -> bool
+
+  (** $parallel_for t ~chunk_size ~start ~finish f$ calls $f i$ for every $i$
+    * from $start$ to $finish$ (included) and waits for all the calls to
+    * finish. The range is split in halves until the parts are smaller than
+    * $chunk_size$ (defaults to the length of the range divided by eight
+    * times the number of workers), and idle workers steal the largest parts.
+    *
+    * @raise any exception raised by $f$ *)
+  val parallel_for : t -> ?chunk_size:int -> start:int -> finish:int -> (int -> unit) -> unit
+
+  (** $parallel_reduce t ~chunk_size ~start ~finish combine init f$ returns
+    * the combination of the values $f i$ for $i$ from $start$ to $finish$,
+    * split as in $parallel_for$. $combine$ must be associative and $init$
+    * must be neutral for it. Values are combined in the order of the range,
+    * so $combine$ does not have to be commutative.
+    *
+    * @raise any exception raised by $f$ *)
+  val parallel_reduce : t -> ?chunk_size:int -> start:int -> finish:int ->
+                        ('a -> 'a -> 'a) -> 'a -> (int -> 'a) -> 'a
+
+  (** Returns the statistics of each worker of a pool *)
+  val stats : t -> stats array
+
+  (** Returns the fraction of time a worker spent running tasks *)
+  val utilization : stats -> float
+
+  (** Resets the statistics of the workers of a pool *)
+  val reset_stats : t -> unit
+
+end
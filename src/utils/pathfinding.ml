@@ -0,0 +1,578 @@
+open OgamlMath
+
+exception Pathfinding_exception of string
+
+module FHeap = PriorityQueue.Indexed (struct
+
+  type t = float
+
+  let compare (f1 : float) (f2 : float) = compare f1 f2
+
+end)
+
+(* Handles are recycled, so a handle is only valid if it still holds v *)
+let queued heap hd (v : int) = FHeap.mem heap hd && FHeap.value heap hd = v
+
+let sqrt2 = sqrt 2.
+
+(* Cost of the shortest path between two cells of an empty grid *)
+let octile dx dy =
+  let dx = abs dx and dy = abs dy in
+  let m = min dx dy in
+  float_of_int (max dx dy - m) +. sqrt2 *. float_of_int m
+
+let sign i = compare i 0
+
+
+(* Scratch space of a search, see Graph.CSR *)
+type scratch = {
+  stamp  : int array;
+  dist   : float array;
+  parent : int array;
+  handle : int array;
+  mutable gen : int;
+  heap   : int FHeap.t
+}
+
+let scratch n = {
+  stamp  = Array.make n 0;
+  dist   = Array.make n infinity;
+  parent = Array.make n (-1);
+  handle = Array.make n 0;
+  gen    = 0;
+  heap   = FHeap.create ()
+}
+
+let reset s =
+  s.gen <- s.gen + 1;
+  FHeap.clear s.heap
+
+let distance s v =
+  if s.stamp.(v) = s.gen then s.dist.(v) else infinity
+
+let relax s v d p prio =
+  if s.stamp.(v) = s.gen && queued s.heap s.handle.(v) v then
+    FHeap.decrease_key s.heap s.handle.(v) prio
+  else
+    s.handle.(v) <- FHeap.insert s.heap prio v;
+  s.stamp.(v) <- s.gen;
+  s.dist.(v) <- d;
+  s.parent.(v) <- p
+
+
+module Grid = struct
+
+  type listener = int
+
+  type t = {
+    width   : int;
+    height  : int;
+    blocked : Bytes.t;
+    mutable listeners : (listener * (int -> int -> unit)) list;
+    mutable next_listener : listener
+  }
+
+  let create ~width ~height =
+    if width <= 0 || height <= 0 then raise (Pathfinding_exception "Invalid grid size");
+    {width; height; blocked = Bytes.make (width * height) '\000';
+     listeners = []; next_listener = 0}
+
+  let width g = g.width
+
+  let height g = g.height
+
+  let inside g x y = x >= 0 && y >= 0 && x < g.width && y < g.height
+
+  let walkable g x y =
+    inside g x y && Bytes.unsafe_get g.blocked (y * g.width + x) = '\000'
+
+  let index g (v : Vector2i.t) =
+    if not (inside g v.Vector2i.x v.Vector2i.y) then
+      raise (Pathfinding_exception "Cell out of bounds");
+    v.Vector2i.y * g.width + v.Vector2i.x
+
+  let cell g i =
+    if i < 0 || i >= g.width * g.height then
+      raise (Pathfinding_exception "Cell index out of bounds");
+    Vector2i.make (i mod g.width) (i / g.width)
+
+  let is_blocked g v =
+    Bytes.get g.blocked (index g v) <> '\000'
+
+  let set_blocked g v b =
+    let i = index g v in
+    if (Bytes.get g.blocked i <> '\000') <> b then begin
+      Bytes.set g.blocked i (if b then '\001' else '\000');
+      List.iter (fun (_, f) -> f v.Vector2i.x v.Vector2i.y) g.listeners
+    end
+
+  let on_change g f =
+    let l = g.next_listener in
+    g.next_listener <- l + 1;
+    g.listeners <- (l, f) :: g.listeners;
+    l
+
+  let remove_listener g l =
+    g.listeners <- List.filter (fun (l', _) -> l' <> l) g.listeners
+
+  (* 8-connected moves. Diagonal moves cannot cut corners. *)
+  let iter_moves g x y f =
+    for dy = -1 to 1 do
+      for dx = -1 to 1 do
+        if (dx <> 0 || dy <> 0) && walkable g (x + dx) (y + dy) then begin
+          if dx = 0 || dy = 0 then f (x + dx) (y + dy) 1.
+          else if walkable g (x + dx) y && walkable g x (y + dy) then
+            f (x + dx) (y + dy) sqrt2
+        end
+      done
+    done
+
+  let iter_neighbours g v f =
+    let i = index g v in
+    if Bytes.get g.blocked i = '\000' then
+      iter_moves g v.Vector2i.x v.Vector2i.y (fun x y c -> f (Vector2i.make x y) c)
+
+  let to_csr g =
+    let b = Graph.CSR.Builder.create ~vertices:(g.width * g.height) () in
+    for y = 0 to g.height - 1 do
+      for x = 0 to g.width - 1 do
+        if walkable g x y then
+          iter_moves g x y (fun x' y' c ->
+            Graph.CSR.Builder.add_edge b ~cost:c (y * g.width + x) (y' * g.width + x'))
+      done
+    done;
+    Graph.CSR.Builder.freeze b
+
+end
+
+
+module JPS = struct
+
+  type t = {grid : Grid.t; work : scratch}
+
+  let create grid =
+    {grid; work = scratch (grid.Grid.width * grid.Grid.height)}
+
+  (* [jumper g gx gy x y dx dy] follows the direction (dx,dy) from (x,y)
+   * and returns the first jump point, or -1. Straight moves stop next to 
+   * the obstacles that create forced neighbours, and diagonal moves stop 
+   * where a straight move would. *)
+  let jumper g gx gy =
+    let walkable = Grid.walkable g and w = g.Grid.width in
+    let rec jump x y dx dy =
+      if not (walkable x y) then -1
+      else if x = gx && y = gy then y * w + x
+      else if dx <> 0 && dy <> 0 then begin
+        if jump (x + dx) y dx 0 >= 0 || jump x (y + dy) 0 dy >= 0 then y * w + x
+        else if walkable (x + dx) y && walkable x (y + dy) then
+          jump (x + dx) (y + dy) dx dy
+        else -1
+      end else if dx <> 0 then begin
+        if (walkable x (y - 1) && not (walkable (x - dx) (y - 1)))
+        || (walkable x (y + 1) && not (walkable (x - dx) (y + 1))) then y * w + x
+        else jump (x + dx) y dx dy
+      end else begin
+        if (walkable (x - 1) y && not (walkable (x - 1) (y - dy)))
+        || (walkable (x + 1) y && not (walkable (x + 1) (y - dy))) then y * w + x
+        else jump x (y + dy) dx dy
+      end
+    in
+    jump
+
+  (* Iterates through the pruned directions of a node given its parent *)
+  let iter_directions g x y parent f =
+    let walkable = Grid.walkable g in
+    if parent < 0 then Grid.iter_moves g x y (fun x' y' _ -> f (x' - x) (y' - y))
+    else begin
+      let dx = sign (x - parent mod g.Grid.width)
+      and dy = sign (y - parent / g.Grid.width) in
+      if dx <> 0 && dy <> 0 then begin
+        let vert = walkable x (y + dy) and horiz = walkable (x + dx) y in
+        if vert then f 0 dy;
+        if horiz then f dx 0;
+        if vert && horiz then f dx dy
+      end else if dx <> 0 then begin
+        let next = walkable (x + dx) y
+        and up = walkable x (y + 1) and down = walkable x (y - 1) in
+        if next then begin
+          f dx 0;
+          if up then f dx 1;
+          if down then f dx (-1)
+        end;
+        if up then f 0 1;
+        if down then f 0 (-1)
+      end else begin
+        let next = walkable x (y + dy)
+        and right = walkable (x + 1) y and left = walkable (x - 1) y in
+        if next then begin
+          f 0 dy;
+          if right then f 1 dy;
+          if left then f (-1) dy
+        end;
+        if right then f 1 0;
+        if left then f (-1) 0
+      end
+    end
+
+  (* Jump points are joined by straight or diagonal segments *)
+  let expand g points =
+    let w = g.Grid.width in
+    let rec aux acc = function
+      | a :: (b :: _ as rest) ->
+        let ax = a mod w and ay = a / w and bx = b mod w and by = b / w in
+        let dx = sign (bx - ax) and dy = sign (by - ay) in
+        let acc = ref acc in
+        for k = 1 to max (abs (bx - ax)) (abs (by - ay)) do
+          acc := Vector2i.make (ax + k * dx) (ay + k * dy) :: !acc
+        done;
+        aux !acc rest
+      | _ -> acc
+    in
+    match points with
+    | [] -> []
+    | a :: _ -> List.rev (aux [Grid.cell g a] points)
+
+  let find_path t start goal =
+    let g = t.grid and w = t.grid.Grid.width in
+    let s = Grid.index g start and e = Grid.index g goal in
+    if Grid.is_blocked g start || Grid.is_blocked g goal then None
+    else begin
+      let work = t.work in
+      let gx = goal.Vector2i.x and gy = goal.Vector2i.y in
+      let heuristic i = octile (i mod w - gx) (i / w - gy) in
+      let jump = jumper g gx gy in
+      reset work;
+      relax work s 0. (-1) (heuristic s);
+      let found = ref false in
+      while not !found && not (FHeap.is_empty work.heap) do
+        let v = FHeap.extract work.heap in
+        if v = e then found := true
+        else begin
+          let x = v mod w and y = v / w in
+          let dv = work.dist.(v) in
+          iter_directions g x y work.parent.(v) (fun dx dy ->
+            let j = jump (x + dx) (y + dy) dx dy in
+            if j >= 0 then begin
+              let dj = dv +. octile (j mod w - x) (j / w - y) in
+              if dj < distance work j then relax work j dj v (dj +. heuristic j)
+            end)
+        end
+      done;
+      if not !found then None
+      else begin
+        let rec points v acc =
+          if v = s then v :: acc else points work.parent.(v) (v :: acc)
+        in
+        Some (work.dist.(e), expand g (points e []))
+      end
+    end
+
+end
+
+
+module HPA = struct
+
+  type t = {
+    grid : Grid.t;
+    size : int;
+    exact : bool;
+    cw : int;
+    ch : int;
+    (* Sparse mode : entrances of the east (2k) and south (2k+1) borders
+     * of each cluster k, and the corresponding inter-cluster edges *)
+    transitions : (int * int) list array;
+    inter : (int, int list) Hashtbl.t;
+    (* Abstract nodes of each cluster, and shortest paths between them *)
+    nodes : int list array;
+    intra : (int, (int * float) list) Hashtbl.t array;
+    dirty_borders  : bool array;
+    dirty_clusters : bool array;
+    mutable dirty  : bool;
+    mutable listener : Grid.listener option;
+    local : scratch;
+    work  : scratch
+  }
+
+  let cluster h x y = (y / h.size) * h.cw + x / h.size
+
+  let bounds h k =
+    let cx = k mod h.cw and cy = k / h.cw in
+    (cx * h.size, cy * h.size,
+     min h.grid.Grid.width ((cx + 1) * h.size), min h.grid.Grid.height ((cy + 1) * h.size))
+
+  let invalidate h x y =
+    let k = cluster h x y in
+    let cx = k mod h.cw and cy = k / h.cw in
+    if h.exact then begin
+      (* Nodes of the neighbouring clusters depend on the moves leaving them *)
+      for dy = -1 to 1 do
+        for dx = -1 to 1 do
+          if cx + dx >= 0 && cx + dx < h.cw && cy + dy >= 0 && cy + dy < h.ch then
+            h.dirty_clusters.((cy + dy) * h.cw + cx + dx) <- true
+        done
+      done
+    end else begin
+      h.dirty_clusters.(k) <- true;
+      h.dirty_borders.(2 * k) <- true;
+      h.dirty_borders.(2 * k + 1) <- true;
+      if cx > 0 then h.dirty_borders.(2 * (k - 1)) <- true;
+      if cy > 0 then h.dirty_borders.(2 * (k - h.cw) + 1) <- true
+    end;
+    h.dirty <- true
+
+  let find_inter h a =
+    try Hashtbl.find h.inter a with Not_found -> []
+
+  let remove_inter h a b =
+    match List.filter (fun c -> c <> b) (find_inter h a) with
+    | [] -> Hashtbl.remove h.inter a
+    | l  -> Hashtbl.replace h.inter a l
+
+  let add_inter h a b =
+    Hashtbl.replace h.inter a (b :: find_inter h a)
+
+  (* Entrances are maximal segments of walkable cells on both sides of a
+   * border, with one transition in the middle of short segments and
+   * two at the ends of longer ones *)
+  let build_border h b =
+    let g = h.grid and w = h.grid.Grid.width in
+    List.iter (fun (a, c) -> remove_inter h a c; remove_inter h c a) h.transitions.(b);
+    let k = b / 2 and south = b mod 2 = 1 in
+    let cx = k mod h.cw and cy = k / h.cw in
+    let (x0, y0, x1, y1) = bounds h k in
+    let res = ref [] in
+    if (south && cy < h.ch - 1) || (not south && cx < h.cw - 1) then begin
+      let len = if south then x1 - x0 else y1 - y0 in
+      let pair i =
+        if south then ((y1 - 1) * w + x0 + i, y1 * w + x0 + i)
+        else ((y0 + i) * w + x1 - 1, (y0 + i) * w + x1)
+      in
+      let is_open i =
+        let (a, c) = pair i in
+        Grid.walkable g (a mod w) (a / w) && Grid.walkable g (c mod w) (c / w)
+      in
+      let start = ref (-1) in
+      for i = 0 to len do
+        if i < len && is_open i then begin
+          if !start < 0 then start := i
+        end else if !start >= 0 then begin
+          let l = i - !start in
+          if l < 6 then res := pair (!start + l / 2) :: !res
+          else res := pair !start :: pair (i - 1) :: !res;
+          start := -1
+        end
+      done;
+      h.dirty_clusters.(if south then k + h.cw else k + 1) <- true
+    end;
+    h.dirty_clusters.(k) <- true;
+    h.transitions.(b) <- !res;
+    List.iter (fun (a, c) -> add_inter h a c; add_inter h c a) !res
+
+  let cluster_nodes h k =
+    let g = h.grid and w = h.grid.Grid.width in
+    let (x0, y0, x1, y1) = bounds h k in
+    let res = ref [] in
+    if h.exact then begin
+      (* All the cells with a move leaving the cluster *)
+      for y = y0 to y1 - 1 do
+        for x = x0 to x1 - 1 do
+          if (x = x0 || x = x1 - 1 || y = y0 || y = y1 - 1) && Grid.walkable g x y then begin
+            let crossing = ref false in
+            Grid.iter_moves g x y (fun x' y' _ ->
+              if cluster h x' y' <> k then crossing := true);
+            if !crossing then res := (y * w + x) :: !res
+          end
+        done
+      done
+    end else begin
+      let cx = k mod h.cw and cy = k / h.cw in
+      let borders =
+        [2 * k; 2 * k + 1]
+        @ (if cx > 0 then [2 * (k - 1)] else [])
+        @ (if cy > 0 then [2 * (k - h.cw) + 1] else [])
+      in
+      let add c =
+        if cluster h (c mod w) (c / w) = k && not (List.mem c !res) then res := c :: !res
+      in
+      List.iter (fun b -> List.iter (fun (a, c) -> add a; add c) h.transitions.(b)) borders
+    end;
+    !res
+
+  let local_index h k c =
+    let (x0, y0, _, _) = bounds h k in
+    let w = h.grid.Grid.width in
+    (c / w - y0) * h.size + c mod w - x0
+
+  let global_index h k i =
+    let (x0, y0, _, _) = bounds h k in
+    (y0 + i / h.size) * h.grid.Grid.width + x0 + i mod h.size
+
+  (* Dijkstra restricted to a cluster, stopping at target if target >= 0 *)
+  let local_search h k src target =
+    let (x0, y0, x1, y1) = bounds h k in
+    let l = h.local in
+    reset l;
+    let t = if target < 0 then -1 else local_index h k target in
+    relax l (local_index h k src) 0. (-1) 0.;
+    let stop = ref false in
+    while not !stop && not (FHeap.is_empty l.heap) do
+      let v = FHeap.extract l.heap in
+      if v = t then stop := true
+      else begin
+        let dv = l.dist.(v) in
+        Grid.iter_moves h.grid (x0 + v mod h.size) (y0 + v / h.size) (fun x y c ->
+          if x >= x0 && x < x1 && y >= y0 && y < y1 then begin
+            let u = (y - y0) * h.size + x - x0 in
+            let du = dv +. c in
+            if du < distance l u then relax l u du v du
+          end)
+      end
+    done
+
+  let local_distance h k c =
+    distance h.local (local_index h k c)
+
+  let build_cluster h k =
+    let nodes = cluster_nodes h k in
+    let tbl = h.intra.(k) in
+    h.nodes.(k) <- nodes;
+    Hashtbl.reset tbl;
+    List.iter (fun a ->
+      local_search h k a (-1);
+      List.fold_left (fun acc b ->
+        let d = local_distance h k b in
+        if b <> a && d < infinity then (b, d) :: acc else acc
+      ) [] nodes
+      |> Hashtbl.replace tbl a
+    ) nodes
+
+  let refresh h =
+    if h.dirty then begin
+      if not h.exact then
+        Array.iteri (fun b d ->
+          if d then begin
+            build_border h b;
+            h.dirty_borders.(b) <- false
+          end) h.dirty_borders;
+      Array.iteri (fun k d ->
+        if d then begin
+          build_cluster h k;
+          h.dirty_clusters.(k) <- false
+        end) h.dirty_clusters;
+      h.dirty <- false
+    end
+
+  let create ?cluster_size:(size = 16) ?exact:(exact = false) grid =
+    if size < 2 then raise (Pathfinding_exception "Cluster size must be at least 2");
+    let cw = (grid.Grid.width + size - 1) / size
+    and ch = (grid.Grid.height + size - 1) / size in
+    let n = cw * ch in
+    let h = {
+      grid; size; exact; cw; ch;
+      transitions    = Array.make (2 * n) [];
+      inter          = Hashtbl.create 97;
+      nodes          = Array.make n [];
+      intra          = Array.init n (fun _ -> Hashtbl.create 16);
+      dirty_borders  = Array.make (2 * n) true;
+      dirty_clusters = Array.make n true;
+      dirty          = true;
+      listener       = None;
+      local          = scratch (size * size);
+      work           = scratch (grid.Grid.width * grid.Grid.height)
+    } in
+    h.listener <- Some (Grid.on_change grid (invalidate h));
+    refresh h;
+    h
+
+  let release h =
+    match h.listener with
+    | Some l -> Grid.remove_listener h.grid l; h.listener <- None
+    | None -> ()
+
+  let nodes h =
+    refresh h;
+    Array.fold_left (fun n l -> n + List.length l) 0 h.nodes
+
+  let find_path h start goal =
+    let g = h.grid and w = h.grid.Grid.width in
+    let s = Grid.index g start and e = Grid.index g goal in
+    if Grid.is_blocked g start || Grid.is_blocked g goal then None
+    else begin
+      refresh h;
+      let gx = goal.Vector2i.x and gy = goal.Vector2i.y in
+      let ks = cluster h start.Vector2i.x start.Vector2i.y and ke = cluster h gx gy in
+      (* Temporary edges from the start and to the goal *)
+      local_search h ks s (-1);
+      let sedges =
+        List.fold_left (fun acc b ->
+          let d = local_distance h ks b in
+          if d < infinity then (b, d) :: acc else acc
+        ) [] h.nodes.(ks)
+      in
+      let sedges =
+        let d = if ks = ke then local_distance h ks e else infinity in
+        if d < infinity then (e, d) :: sedges else sedges
+      in
+      local_search h ke e (-1);
+      let gedges = Hashtbl.create 16 in
+      List.iter (fun b ->
+        let d = local_distance h ke b in
+        if d < infinity then Hashtbl.replace gedges b d
+      ) h.nodes.(ke);
+      (* A* on the abstract graph *)
+      let work = h.work in
+      let heuristic i = octile (i mod w - gx) (i / w - gy) in
+      reset work;
+      relax work s 0. (-1) (heuristic s);
+      let found = ref false in
+      while not !found && not (FHeap.is_empty work.heap) do
+        let v = FHeap.extract work.heap in
+        if v = e then found := true
+        else begin
+          let dv = work.dist.(v) in
+          let visit u c =
+            let du = dv +. c in
+            if du < distance work u then relax work u du v (du +. heuristic u)
+          in
+          let vx = v mod w and vy = v / w in
+          let k = cluster h vx vy in
+          List.iter (fun (u, c) -> visit u c)
+            (try Hashtbl.find h.intra.(k) v with Not_found -> []);
+          if h.exact then
+            Grid.iter_moves g vx vy (fun x y c ->
+              if cluster h x y <> k then visit (y * w + x) c)
+          else
+            List.iter (fun u -> visit u 1.) (find_inter h v);
+          if v = s then List.iter (fun (u, c) -> visit u c) sedges;
+          (try visit e (Hashtbl.find gedges v) with Not_found -> ())
+        end
+      done;
+      if not !found then None
+      else begin
+        let rec abstract v acc =
+          if v = s then v :: acc else abstract work.parent.(v) (v :: acc)
+        in
+        (* Refines the edges inside clusters, the others are single moves *)
+        let path = ref [s] in
+        let rec refine = function
+          | a :: (b :: _ as rest) ->
+            let k = cluster h (a mod w) (a / w) in
+            if k <> cluster h (b mod w) (b / w) then path := b :: !path
+            else begin
+              local_search h k a b;
+              let la = local_index h k a in
+              let rec back i acc =
+                if i = la then acc
+                else back h.local.parent.(i) (global_index h k i :: acc)
+              in
+              path := List.rev_append (back (local_index h k b) []) !path
+            end;
+            refine rest
+          | _ -> ()
+        in
+        refine (abstract e []);
+        Some (work.dist.(e), List.rev_map (Grid.cell g) !path)
+      end
+    end
+
+end
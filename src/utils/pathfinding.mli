@@ -0,0 +1,63 @@
+exception Pathfinding_exception of string
+
+module Grid : sig
+
+  type t
+
+  type listener
+
+  val create : width:int -> height:int -> t
+
+  val width : t -> int
+
+  val height : t -> int
+
+  val walkable : t -> int -> int -> bool
+
+  val index : t -> OgamlMath.Vector2i.t -> int
+
+  val cell : t -> int -> OgamlMath.Vector2i.t
+
+  val is_blocked : t -> OgamlMath.Vector2i.t -> bool
+
+  val set_blocked : t -> OgamlMath.Vector2i.t -> bool -> unit
+
+  val on_change : t -> (int -> int -> unit) -> listener
+
+  val remove_listener : t -> listener -> unit
+
+  val iter_moves : t -> int -> int -> (int -> int -> float -> unit) -> unit
+
+  val iter_neighbours : t -> OgamlMath.Vector2i.t -> (OgamlMath.Vector2i.t -> float -> unit) -> unit
+
+  val to_csr : t -> Graph.CSR.t
+
+end
+
+
+module JPS : sig
+
+  type t
+
+  val create : Grid.t -> t
+
+  val find_path : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t -> 
+    (float * OgamlMath.Vector2i.t list) option
+
+end
+
+
+module HPA : sig
+
+  type t
+
+  val create : ?cluster_size:int -> ?exact:bool -> Grid.t -> t
+
+  val nodes : t -> int
+
+  val find_path : t -> OgamlMath.Vector2i.t -> OgamlMath.Vector2i.t -> 
+    (float * OgamlMath.Vector2i.t list) option
+
+  val release : t -> unit
+
+end
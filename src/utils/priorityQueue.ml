@@ -35,6 +35,57 @@ module type Q = sig
 end
 
 
+module type IQ = sig
+
+  exception Empty
+
+  exception Invalid_handle
+
+  exception Invalid_priority
+
+  type priority
+
+  type handle = int
+
+  type 'a t
+
+  val create : ?arity:int -> ?capacity:int -> unit -> 'a t
+
+  val heapify : ?arity:int -> (priority * 'a) array -> 'a t
+
+  val length : 'a t -> int
+
+  val is_empty : 'a t -> bool
+
+  val capacity : 'a t -> int
+
+  val clear : 'a t -> unit
+
+  val insert : 'a t -> priority -> 'a -> handle
+
+  val top : 'a t -> 'a
+
+  val top_priority : 'a t -> priority
+
+  val pop : 'a t -> unit
+
+  val extract : 'a t -> 'a
+
+  val mem : 'a t -> handle -> bool
+
+  val priority : 'a t -> handle -> priority
+
+  val value : 'a t -> handle -> 'a
+
+  val decrease_key : 'a t -> handle -> priority -> unit
+
+  val update : 'a t -> handle -> priority -> unit
+
+  val remove : 'a t -> handle -> unit
+
+end
+
+
 module Make (P : Priority) : Q with type priority = P.t = struct
 
   exception Empty
@@ -79,4 +130,200 @@ module Make (P : Priority) : Q with type priority = P.t = struct
 end
 
 
+module Indexed (P : Priority) : IQ with type priority = P.t = struct
+
+  exception Empty
+
+  exception Invalid_handle
+
+  exception Invalid_priority
+
+  type priority = P.t
 
+  type handle = int
+
+  (* The heap is stored in prios, values and handles (indexed by position).
+   * pos maps a live handle to its position. The handles that are not in
+   * the queue form a free list threaded through pos : the free handle hd
+   * stores -2 - n where n is the next free handle, or -1 at the end.
+   * Handles are only created when the free list is empty, so pos is
+   * bounded by the largest size of the queue.
+   * The heap arrays are allocated on the first insertion since we need 
+   * an element to fill them. *)
+  type 'a t = {
+    arity : int;
+    capacity : int;
+    mutable size    : int;
+    mutable next    : int;
+    mutable free    : int;
+    mutable prios   : priority array;
+    mutable values  : 'a array;
+    mutable handles : int array;
+    mutable pos     : int array
+  }
+
+  let create ?arity:(arity = 4) ?capacity:(capacity = 16) () = 
+    if arity < 2 then raise (Invalid_argument "PriorityQueue.Indexed.create : arity < 2");
+    let capacity = max capacity 1 in
+    {arity; capacity; size = 0; next = 0; free = -1; prios = [||]; values = [||];
+     handles = [||]; pos = Array.make capacity (-1)}
+
+  let length h = h.size
+
+  let is_empty h = h.size = 0
+
+  let capacity h = max (Array.length h.prios) (Array.length h.pos)
+
+  let clear h = 
+    Array.fill h.pos 0 h.next (-1);
+    h.size <- 0;
+    h.next <- 0;
+    h.free <- -1
+
+  let extend arr n def = 
+    let arr' = Array.make n def in
+    Array.blit arr 0 arr' 0 (Array.length arr);
+    arr'
+
+  let reserve h p v = 
+    if h.size = Array.length h.prios then begin
+      let n = max h.capacity (2 * h.size) in
+      h.prios   <- extend h.prios n p;
+      h.values  <- extend h.values n v;
+      h.handles <- extend h.handles n 0
+    end;
+    if h.free < 0 && h.next = Array.length h.pos then
+      h.pos <- extend h.pos (2 * h.next) (-1)
+
+  let new_handle h = 
+    if h.free >= 0 then begin
+      let hd = h.free in
+      h.free <- -2 - h.pos.(hd);
+      hd
+    end else begin
+      let hd = h.next in
+      h.next <- h.next + 1;
+      hd
+    end
+
+  let free_handle h hd = 
+    h.pos.(hd) <- -2 - h.free;
+    h.free <- hd
+
+  let set h i p v hd = 
+    h.prios.(i)   <- p;
+    h.values.(i)  <- v;
+    h.handles.(i) <- hd;
+    h.pos.(hd)    <- i
+
+  let move h src dst = 
+    set h dst h.prios.(src) h.values.(src) h.handles.(src)
+
+  (* Both sifts move a hole and only write the element once *)
+  let sift_up h i p v hd = 
+    let i = ref i in
+    while !i > 0 && P.compare p h.prios.((!i - 1) / h.arity) < 0 do
+      let parent = (!i - 1) / h.arity in
+      move h parent !i;
+      i := parent
+    done;
+    set h !i p v hd
+
+  let sift_down h i p v hd = 
+    let i = ref i and continue = ref true in
+    while !continue do
+      let first = h.arity * !i + 1 in
+      if first >= h.size then continue := false
+      else begin
+        let last = min (first + h.arity - 1) (h.size - 1) in
+        let m = ref first in
+        for c = first + 1 to last do
+          if P.compare h.prios.(c) h.prios.(!m) < 0 then m := c
+        done;
+        if P.compare h.prios.(!m) p < 0 then begin
+          move h !m !i;
+          i := !m
+        end else continue := false
+      end
+    done;
+    set h !i p v hd
+
+  let heapify ?arity:(arity = 4) arr = 
+    let n = Array.length arr in
+    let h = create ~arity ~capacity:n () in
+    if n > 0 then begin
+      h.prios   <- Array.map fst arr;
+      h.values  <- Array.map snd arr;
+      h.handles <- Array.init n (fun i -> i);
+      h.pos     <- Array.init n (fun i -> i);
+      h.size <- n;
+      h.next <- n;
+      h.free <- -1;
+      for i = (n - 2) / arity downto 0 do
+        sift_down h i h.prios.(i) h.values.(i) h.handles.(i)
+      done
+    end;
+    h
+
+  let insert h p v = 
+    reserve h p v;
+    let hd = new_handle h in
+    h.size <- h.size + 1;
+    sift_up h (h.size - 1) p v hd;
+    hd
+
+  let top h = 
+    if h.size = 0 then raise Empty;
+    h.values.(0)
+
+  let top_priority h = 
+    if h.size = 0 then raise Empty;
+    h.prios.(0)
+
+  (* Removes the element at position i, and fills the hole with the last one *)
+  let remove_at h i = 
+    free_handle h h.handles.(i);
+    h.size <- h.size - 1;
+    let n = h.size in
+    if i < n then begin
+      let p = h.prios.(n) and v = h.values.(n) and hd = h.handles.(n) in
+      if i > 0 && P.compare p h.prios.((i - 1) / h.arity) < 0 then sift_up h i p v hd
+      else sift_down h i p v hd
+    end;
+    (* Do not keep the removed value alive *)
+    if n > 0 then h.values.(n) <- h.values.(0)
+
+  let pop h = 
+    if h.size = 0 then raise Empty;
+    remove_at h 0
+
+  let extract h = 
+    let v = top h in
+    remove_at h 0;
+    v
+
+  let mem h hd = 
+    hd >= 0 && hd < h.next && h.pos.(hd) >= 0
+
+  let position h hd = 
+    if not (mem h hd) then raise Invalid_handle;
+    h.pos.(hd)
+
+  let priority h hd = h.prios.(position h hd)
+
+  let value h hd = h.values.(position h hd)
+
+  let decrease_key h hd p = 
+    let i = position h hd in
+    if P.compare p h.prios.(i) > 0 then raise Invalid_priority;
+    sift_up h i p h.values.(i) hd
+
+  let update h hd p = 
+    let i = position h hd in
+    if P.compare p h.prios.(i) <= 0 then sift_up h i p h.values.(i) hd
+    else sift_down h i p h.values.(i) hd
+
+  let remove h hd = 
+    remove_at h (position h hd)
+
+end
@@ -37,3 +37,57 @@ end
 
 module Make : functor (P : Priority) -> Q with type priority = P.t
 
+
+module type IQ = sig
+
+  exception Empty
+
+  exception Invalid_handle
+
+  exception Invalid_priority
+
+  type priority
+
+  type handle = int
+
+  type 'a t
+
+  val create : ?arity:int -> ?capacity:int -> unit -> 'a t
+
+  val heapify : ?arity:int -> (priority * 'a) array -> 'a t
+
+  val length : 'a t -> int
+
+  val is_empty : 'a t -> bool
+
+  val capacity : 'a t -> int
+
+  val clear : 'a t -> unit
+
+  val insert : 'a t -> priority -> 'a -> handle
+
+  val top : 'a t -> 'a
+
+  val top_priority : 'a t -> priority
+
+  val pop : 'a t -> unit
+
+  val extract : 'a t -> 'a
+
+  val mem : 'a t -> handle -> bool
+
+  val priority : 'a t -> handle -> priority
+
+  val value : 'a t -> handle -> 'a
+
+  val decrease_key : 'a t -> handle -> priority -> unit
+
+  val update : 'a t -> handle -> priority -> unit
+
+  val remove : 'a t -> handle -> unit
+
+end
+
+
+module Indexed : functor (P : Priority) -> IQ with type priority = P.t
+
@@ -0,0 +1,331 @@
+exception Scheduler_exception of string
+
+module Deque = struct
+
+  (* Chase-Lev layout : a circular buffer of power-of-two size indexed by two
+   * increasing counters. The owner pushes and pops at the bottom, thieves
+   * take from the top. The compilers we support have no atomics, so the
+   * counters are updated under a mutex instead of a compare-and-swap. It is
+   * only held for a few instructions, never while running a task. *)
+  type 'a t = {
+    mutable buf    : 'a array;
+    mutable top    : int;
+    mutable bottom : int;
+    lock : Mutex.t
+  }
+
+  let create () = {buf = [||]; top = 0; bottom = 0; lock = Mutex.create ()}
+
+  let length d = max 0 (d.bottom - d.top)
+
+  let is_empty d = d.bottom <= d.top
+
+  let grow d x =
+    let n = Array.length d.buf in
+    let buf = Array.make (max 16 (2 * n)) x in
+    let mask = Array.length buf - 1 in
+    for i = d.top to d.bottom - 1 do
+      buf.(i land mask) <- d.buf.(i land (n - 1))
+    done;
+    d.buf <- buf
+
+  let push d x =
+    Mutex.lock d.lock;
+    if d.bottom - d.top >= Array.length d.buf then grow d x;
+    d.buf.(d.bottom land (Array.length d.buf - 1)) <- x;
+    d.bottom <- d.bottom + 1;
+    Mutex.unlock d.lock
+
+  let pop d =
+    if is_empty d then None
+    else begin
+      Mutex.lock d.lock;
+      let res =
+        if d.bottom <= d.top then None
+        else begin
+          d.bottom <- d.bottom - 1;
+          Some d.buf.(d.bottom land (Array.length d.buf - 1))
+        end
+      in
+      Mutex.unlock d.lock;
+      res
+    end
+
+  let steal d =
+    if is_empty d then None
+    else begin
+      Mutex.lock d.lock;
+      let res =
+        if d.bottom <= d.top then None
+        else begin
+          let x = d.buf.(d.top land (Array.length d.buf - 1)) in
+          d.top <- d.top + 1;
+          Some x
+        end
+      in
+      Mutex.unlock d.lock;
+      res
+    end
+
+end
+
+
+type stats = {
+  tasks  : int;
+  steals : int;
+  busy   : float;
+  idle   : float
+}
+
+type worker = {
+  deque : (unit -> unit) Deque.t;
+  mutable tasks  : int;
+  mutable steals : int;
+  mutable busy   : float;
+  mutable idle   : float;
+  mutable depth  : int  (* Number of nested tasks being run *)
+}
+
+type t = {
+  workers : worker array;
+  ids     : int array;              (* Thread ids of the workers *)
+  inject  : (unit -> unit) Deque.t; (* Tasks submitted from outside the pool *)
+  lock    : Mutex.t;
+  wake    : Condition.t;
+  mutable sleeping : int;
+  mutable stopped  : bool;
+  mutable threads  : Thread.t list
+}
+
+type 'a state = Pending | Done of 'a | Failed of exn
+
+type 'a promise = {mutable state : 'a state}
+
+
+(* Workers *)
+let current t =
+  let id = Thread.id (Thread.self ()) in
+  let rec aux i =
+    if i >= Array.length t.ids then -1
+    else if t.ids.(i) = id then i
+    else aux (i + 1)
+  in
+  aux 0
+
+let has_work t =
+  let rec aux i =
+    i < Array.length t.workers && (not (Deque.is_empty t.workers.(i).deque) || aux (i + 1))
+  in
+  not (Deque.is_empty t.inject) || aux 0
+
+(* Wakes the sleeping threads up. A sleeper registers itself before checking
+ * the queues one last time, so a task pushed before the check is seen by the
+ * check, and a task pushed after it sees the sleeper. *)
+let notify t =
+  if t.sleeping > 0 then begin
+    Mutex.lock t.lock;
+    Condition.broadcast t.wake;
+    Mutex.unlock t.lock
+  end
+
+let sleep t ready =
+  Mutex.lock t.lock;
+  t.sleeping <- t.sleeping + 1;
+  if not (ready () || t.stopped || has_work t) then Condition.wait t.wake t.lock;
+  t.sleeping <- t.sleeping - 1;
+  Mutex.unlock t.lock
+
+(* Takes a task from the own deque of a worker, then from the tasks submitted
+ * from outside, then from the other workers *)
+let find t i =
+  let own = if i >= 0 then Deque.pop t.workers.(i).deque else None in
+  match own with
+  | Some _ -> own
+  | None ->
+    match Deque.steal t.inject with
+    | Some _ as task -> task
+    | None ->
+      let n = Array.length t.workers in
+      let rec aux k =
+        if k >= n then None
+        else begin
+          let v = (i + 1 + k) mod n in
+          if v = i then aux (k + 1)
+          else match Deque.steal t.workers.(v).deque with
+            | Some _ as task ->
+              if i >= 0 then t.workers.(i).steals <- t.workers.(i).steals + 1;
+              task
+            | None -> aux (k + 1)
+        end
+      in
+      aux 0
+
+(* Tasks never raise : exceptions are stored in their promise *)
+let run t i task =
+  if i < 0 then task ()
+  else begin
+    let w = t.workers.(i) in
+    w.tasks <- w.tasks + 1;
+    if w.depth > 0 then task ()
+    else begin
+      let t0 = Clock.now () in
+      w.depth <- 1;
+      task ();
+      w.depth <- 0;
+      w.busy <- w.busy +. (Clock.now () -. t0)
+    end
+  end
+
+let worker_loop (t, i) =
+  let w = t.workers.(i) in
+  let continue = ref true in
+  while !continue do
+    match find t i with
+    | Some task -> run t i task
+    | None when t.stopped -> continue := false
+    | None ->
+      let t0 = Clock.now () in
+      sleep t (fun () -> false);
+      w.idle <- w.idle +. (Clock.now () -. t0)
+  done
+
+
+(* Pools *)
+let create ?workers:(n = 4) () =
+  if n < 1 then raise (Scheduler_exception "A pool needs at least one worker");
+  let t = {
+    workers = Array.init n (fun _ ->
+      {deque = Deque.create (); tasks = 0; steals = 0; busy = 0.; idle = 0.; depth = 0});
+    ids     = Array.make n (-1);
+    inject  = Deque.create ();
+    lock    = Mutex.create ();
+    wake    = Condition.create ();
+    sleeping = 0;
+    stopped  = false;
+    threads  = []
+  } in
+  for i = 0 to n - 1 do
+    let th = Thread.create worker_loop (t, i) in
+    t.ids.(i) <- Thread.id th;
+    t.threads <- th :: t.threads
+  done;
+  t
+
+let shared_pool = ref None
+
+let shared_lock = Mutex.create ()
+
+let shared () =
+  Mutex.lock shared_lock;
+  let t =
+    match !shared_pool with
+    | Some t -> t
+    | None -> let t = create () in shared_pool := Some t; t
+  in
+  Mutex.unlock shared_lock;
+  t
+
+let workers t = Array.length t.workers
+
+let shutdown t =
+  if current t >= 0 then raise (Scheduler_exception "Cannot shut a pool down from one of its tasks");
+  if not t.stopped then begin
+    Mutex.lock t.lock;
+    t.stopped <- true;
+    Condition.broadcast t.wake;
+    Mutex.unlock t.lock;
+    List.iter Thread.join t.threads;
+    t.threads <- []
+  end
+
+
+(* Tasks *)
+let async t f =
+  if t.stopped then raise (Scheduler_exception "Pool has been shut down");
+  let p = {state = Pending} in
+  let task () =
+    p.state <- (try Done (f ()) with e -> Failed e);
+    notify t
+  in
+  let i = current t in
+  Deque.push (if i >= 0 then t.workers.(i).deque else t.inject) task;
+  notify t;
+  p
+
+let is_pending p =
+  match p.state with
+  | Pending -> true
+  | _ -> false
+
+let is_ready p = not (is_pending p)
+
+(* A worker runs other tasks until the promise is resolved, starting with its
+ * own deque, so tasks can wait for their subtasks without blocking a worker.
+ * Other threads only sleep : they would otherwise run any task of the pool
+ * on top of their stack. *)
+let await t p =
+  let i = current t in
+  let rec aux () =
+    match p.state with
+    | Done v -> v
+    | Failed e -> raise e
+    | Pending ->
+      let task = if i >= 0 then find t i else None in
+      begin match task with
+      | Some task -> run t i task
+      | None -> sleep t (fun () -> not (is_pending p))
+      end;
+      aux ()
+  in
+  aux ()
+
+let default_chunk t n =
+  max 1 (n / (8 * Array.length t.workers))
+
+(* Ranges are split in halves until they are smaller than the chunk size. The
+ * second half is left to thieves while the first one is being processed. *)
+let rec reduce_range t chunk lo hi combine init f =
+  if hi - lo <= chunk then begin
+    let acc = ref init in
+    for i = lo to hi - 1 do acc := combine !acc (f i) done;
+    !acc
+  end else begin
+    let mid = lo + (hi - lo) / 2 in
+    let right = async t (fun () -> reduce_range t chunk mid hi combine init f) in
+    let left =
+      try Done (reduce_range t chunk lo mid combine init f)
+      with e -> Failed e
+    in
+    let right = await t right in
+    match left with
+    | Done left -> combine left right
+    | Failed e -> raise e
+    | Pending -> assert false
+  end
+
+let parallel_reduce t ?chunk_size ~start ~finish combine init f =
+  let n = finish - start + 1 in
+  if n <= 0 then init
+  else begin
+    let chunk = match chunk_size with Some c -> max 1 c | None -> default_chunk t n in
+    if current t >= 0 then reduce_range t chunk start (finish + 1) combine init f
+    else await t (async t (fun () -> reduce_range t chunk start (finish + 1) combine init f))
+  end
+
+let parallel_for t ?chunk_size ~start ~finish f =
+  parallel_reduce t ?chunk_size ~start ~finish (fun () () -> ()) () f
+
+
+(* Statistics *)
+let stats t =
+  Array.map (fun w ->
+    ({tasks = w.tasks; steals = w.steals; busy = w.busy; idle = w.idle} : stats)
+  ) t.workers
+
+let utilization (s : stats) =
+  if s.busy +. s.idle > 0. then s.busy /. (s.busy +. s.idle) else 0.
+
+let reset_stats t =
+  Array.iter (fun w ->
+    w.tasks <- 0; w.steals <- 0; w.busy <- 0.; w.idle <- 0.
+  ) t.workers
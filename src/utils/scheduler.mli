@@ -0,0 +1,55 @@
+exception Scheduler_exception of string
+
+module Deque : sig
+
+  type 'a t
+
+  val create : unit -> 'a t
+
+  val length : 'a t -> int
+
+  val is_empty : 'a t -> bool
+
+  val push : 'a t -> 'a -> unit
+
+  val pop : 'a t -> 'a option
+
+  val steal : 'a t -> 'a option
+
+end
+
+type t
+
+type 'a promise
+
+type stats = {
+  tasks  : int;
+  steals : int;
+  busy   : float;
+  idle   : float
+}
+
+val create : ?workers:int -> unit -> t
+
+val shared : unit -> t
+
+val workers : t -> int
+
+val shutdown : t -> unit
+
+val async : t -> (unit -> 'a) -> 'a promise
+
+val await : t -> 'a promise -> 'a
+
+val is_ready : 'a promise -> bool
+
+val parallel_for : t -> ?chunk_size:int -> start:int -> finish:int -> (int -> unit) -> unit
+
+val parallel_reduce : t -> ?chunk_size:int -> start:int -> finish:int ->
+                      ('a -> 'a -> 'a) -> 'a -> (int -> 'a) -> 'a
+
+val stats : t -> stats array
+
+val utilization : stats -> float
+
+val reset_stats : t -> unit
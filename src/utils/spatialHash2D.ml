@@ -0,0 +1,236 @@
+open OgamlMath
+
+exception SpatialHash2D_exception of string
+
+type t = {
+  size : float;
+  (* Open-addressing table of cells. A slot is free unless its stamp is the
+   * current generation, so clearing the table only increments [gen]. *)
+  mutable stamp : int array;
+  mutable kx    : int array;
+  mutable ky    : int array;
+  mutable head  : int array;   (* First entry of the cell, or -1 *)
+  mutable used  : int array;   (* Occupied slots, in insertion order *)
+  mutable cells : int;
+  mutable gen   : int;
+  (* Entries : one per object and per cell it overlaps *)
+  mutable eobj  : int array;
+  mutable enext : int array;
+  mutable entries : int;
+  (* Objects : ids, bounds (min x, min y, max x, max y) and cell ranges *)
+  mutable ids    : int array;
+  mutable bounds : float array;
+  mutable range  : int array;
+  mutable length : int
+}
+
+let rec pow2 n k = if k >= n then k else pow2 n (2 * k)
+
+let create ?capacity:(capacity = 64) ~cell_size () =
+  if not (cell_size > 0.) then raise (SpatialHash2D_exception "Cell size must be positive");
+  let capacity = max capacity 1 in
+  let cap = pow2 (2 * capacity) 16 in
+  {
+    size  = cell_size;
+    stamp = Array.make cap (-1);
+    kx    = Array.make cap 0;
+    ky    = Array.make cap 0;
+    head  = Array.make cap (-1);
+    used  = Array.make (cap / 2) 0;
+    cells = 0;
+    gen   = 0;
+    eobj  = Array.make capacity 0;
+    enext = Array.make capacity 0;
+    entries = 0;
+    ids    = Array.make capacity 0;
+    bounds = Array.make (4 * capacity) 0.;
+    range  = Array.make (4 * capacity) 0;
+    length = 0
+  }
+
+let cell_size t = t.size
+
+let length t = t.length
+
+let cells t = t.cells
+
+let clear t =
+  t.gen <- t.gen + 1;
+  t.cells <- 0;
+  t.entries <- 0;
+  t.length <- 0
+
+let grow a n v =
+  let a' = Array.make n v in
+  Array.blit a 0 a' 0 (Array.length a);
+  a'
+
+let coord t f =
+  int_of_float (floor (f /. t.size))
+
+let cell t (p : Vector2f.t) =
+  Vector2i.make (coord t p.Vector2f.x) (coord t p.Vector2f.y)
+
+
+(* Table *)
+let hash x y =
+  let h = (x * 0x27d4eb2d) lxor (y * 0x165667b1) in
+  h lxor (h lsr 15)
+
+let find t x y =
+  let mask = Array.length t.stamp - 1 in
+  let i = ref (hash x y land mask) and res = ref (-2) in
+  while !res = -2 do
+    if t.stamp.(!i) <> t.gen then res := -1
+    else if t.kx.(!i) = x && t.ky.(!i) = y then res := !i
+    else i := (!i + 1) land mask
+  done;
+  !res
+
+let claim t x y =
+  let mask = Array.length t.stamp - 1 in
+  let i = ref (hash x y land mask) in
+  while t.stamp.(!i) = t.gen && (t.kx.(!i) <> x || t.ky.(!i) <> y) do
+    i := (!i + 1) land mask
+  done;
+  if t.stamp.(!i) <> t.gen then begin
+    t.stamp.(!i) <- t.gen;
+    t.kx.(!i) <- x;
+    t.ky.(!i) <- y;
+    t.head.(!i) <- -1;
+    t.used.(t.cells) <- !i;
+    t.cells <- t.cells + 1
+  end;
+  !i
+
+(* Doubles the table, keeping it at most half full *)
+let rehash t =
+  let cap = 2 * Array.length t.stamp in
+  let kx = t.kx and ky = t.ky and head = t.head and used = t.used in
+  let n = t.cells in
+  t.stamp <- Array.make cap (-1);
+  t.kx    <- Array.make cap 0;
+  t.ky    <- Array.make cap 0;
+  t.head  <- Array.make cap (-1);
+  t.used  <- Array.make (cap / 2) 0;
+  t.cells <- 0;
+  for k = 0 to n - 1 do
+    let i = used.(k) in
+    let j = claim t kx.(i) ky.(i) in
+    t.head.(j) <- head.(i)
+  done
+
+let add_entry t x y o =
+  if 2 * (t.cells + 1) > Array.length t.stamp then rehash t;
+  let i = claim t x y in
+  if t.entries >= Array.length t.eobj then begin
+    let cap = max 16 (2 * t.entries) in
+    t.eobj  <- grow t.eobj cap 0;
+    t.enext <- grow t.enext cap 0
+  end;
+  let e = t.entries in
+  t.eobj.(e) <- o;
+  t.enext.(e) <- t.head.(i);
+  t.head.(i) <- e;
+  t.entries <- e + 1
+
+
+(* Objects *)
+let add t id (r : FloatRect.t) =
+  let open FloatRect in
+  let o = t.length in
+  if o >= Array.length t.ids then begin
+    let cap = max 16 (2 * o) in
+    t.ids    <- grow t.ids cap 0;
+    t.bounds <- grow t.bounds (4 * cap) 0.;
+    t.range  <- grow t.range (4 * cap) 0
+  end;
+  let x0 = if r.width  >= 0. then r.x else r.x +. r.width in
+  let y0 = if r.height >= 0. then r.y else r.y +. r.height in
+  let x1 = if r.width  >= 0. then r.x +. r.width else r.x in
+  let y1 = if r.height >= 0. then r.y +. r.height else r.y in
+  t.ids.(o) <- id;
+  t.bounds.(4 * o)     <- x0;
+  t.bounds.(4 * o + 1) <- y0;
+  t.bounds.(4 * o + 2) <- x1;
+  t.bounds.(4 * o + 3) <- y1;
+  let cx0 = coord t x0 and cy0 = coord t y0 in
+  let cx1 = coord t x1 and cy1 = coord t y1 in
+  t.range.(4 * o)     <- cx0;
+  t.range.(4 * o + 1) <- cy0;
+  t.range.(4 * o + 2) <- cx1;
+  t.range.(4 * o + 3) <- cy1;
+  t.length <- o + 1;
+  for y = cy0 to cy1 do
+    for x = cx0 to cx1 do
+      add_entry t x y o
+    done
+  done
+
+let overlaps t a b =
+  let ba = t.bounds in
+  not (ba.(4 * a + 2) < ba.(4 * b) || ba.(4 * b + 2) < ba.(4 * a) ||
+       ba.(4 * a + 3) < ba.(4 * b + 1) || ba.(4 * b + 3) < ba.(4 * a + 1))
+
+let iter_cell t (c : Vector2i.t) f =
+  let i = find t c.Vector2i.x c.Vector2i.y in
+  if i >= 0 then begin
+    let e = ref t.head.(i) in
+    while !e >= 0 do
+      f t.ids.(t.eobj.(!e));
+      e := t.enext.(!e)
+    done
+  end
+
+(* Two objects meet in every cell of the intersection of their ranges. They
+ * are only reported from the lowest of these cells, which removes the
+ * duplicates without any additional storage. *)
+let iter_pairs t f =
+  let r = t.range in
+  for k = 0 to t.cells - 1 do
+    let i = t.used.(k) in
+    let x = t.kx.(i) and y = t.ky.(i) in
+    let e1 = ref t.head.(i) in
+    while !e1 >= 0 do
+      let a = t.eobj.(!e1) in
+      let e2 = ref t.enext.(!e1) in
+      while !e2 >= 0 do
+        let b = t.eobj.(!e2) in
+        if max r.(4 * a) r.(4 * b) = x && max r.(4 * a + 1) r.(4 * b + 1) = y
+           && overlaps t a b then
+          f t.ids.(a) t.ids.(b);
+        e2 := t.enext.(!e2)
+      done;
+      e1 := t.enext.(!e1)
+    done
+  done
+
+let pairs t =
+  let l = ref [] in
+  iter_pairs t (fun a b -> l := (a, b) :: !l);
+  List.rev !l
+
+let query t (q : FloatRect.t) f =
+  let open FloatRect in
+  let x0 = if q.width  >= 0. then q.x else q.x +. q.width in
+  let y0 = if q.height >= 0. then q.y else q.y +. q.height in
+  let x1 = if q.width  >= 0. then q.x +. q.width else q.x in
+  let y1 = if q.height >= 0. then q.y +. q.height else q.y in
+  let cx0 = coord t x0 and cy0 = coord t y0 in
+  let r = t.range and b = t.bounds in
+  for y = cy0 to coord t y1 do
+    for x = cx0 to coord t x1 do
+      let i = find t x y in
+      if i >= 0 then begin
+        let e = ref t.head.(i) in
+        while !e >= 0 do
+          let o = t.eobj.(!e) in
+          if max r.(4 * o) cx0 = x && max r.(4 * o + 1) cy0 = y
+             && not (b.(4 * o + 2) < x0 || x1 < b.(4 * o) ||
+                     b.(4 * o + 3) < y0 || y1 < b.(4 * o + 1)) then
+            f t.ids.(o);
+          e := t.enext.(!e)
+        done
+      end
+    done
+  done
@@ -0,0 +1,25 @@
+exception SpatialHash2D_exception of string
+
+type t
+
+val create : ?capacity:int -> cell_size:float -> unit -> t
+
+val cell_size : t -> float
+
+val length : t -> int
+
+val cells : t -> int
+
+val clear : t -> unit
+
+val add : t -> int -> OgamlMath.FloatRect.t -> unit
+
+val cell : t -> OgamlMath.Vector2f.t -> OgamlMath.Vector2i.t
+
+val iter_cell : t -> OgamlMath.Vector2i.t -> (int -> unit) -> unit
+
+val iter_pairs : t -> (int -> int -> unit) -> unit
+
+val pairs : t -> (int * int) list
+
+val query : t -> OgamlMath.FloatRect.t -> (int -> unit) -> unit
@@ -0,0 +1,697 @@
+open OgamlMath
+
+exception SpatialTree_exception of string
+
+module type Space = sig
+
+  type bounds
+
+  type point
+
+  val dim : int
+
+  val write : bounds -> float array -> int -> unit
+
+  val read : float array -> int -> bounds
+
+  val coord : point -> int -> float
+
+end
+
+module Rect = struct
+
+  type bounds = FloatRect.t
+
+  type point = Vector2f.t
+
+  let dim = 2
+
+  let write (r : FloatRect.t) a o =
+    let open FloatRect in
+    a.(o)     <- if r.width  >= 0. then r.x else r.x +. r.width;
+    a.(o + 1) <- if r.height >= 0. then r.y else r.y +. r.height;
+    a.(o + 2) <- if r.width  >= 0. then r.x +. r.width else r.x;
+    a.(o + 3) <- if r.height >= 0. then r.y +. r.height else r.y
+
+  let read a o =
+    FloatRect.create_from_points (Vector2f.make a.(o) a.(o + 1)) (Vector2f.make a.(o + 2) a.(o + 3))
+
+  let coord (p : Vector2f.t) k =
+    if k = 0 then p.Vector2f.x else p.Vector2f.y
+
+end
+
+module Box = struct
+
+  type bounds = FloatBox.t
+
+  type point = Vector3f.t
+
+  let dim = 3
+
+  let write (b : FloatBox.t) a o =
+    let open FloatBox in
+    a.(o)     <- if b.width  >= 0. then b.x else b.x +. b.width;
+    a.(o + 1) <- if b.height >= 0. then b.y else b.y +. b.height;
+    a.(o + 2) <- if b.depth  >= 0. then b.z else b.z +. b.depth;
+    a.(o + 3) <- if b.width  >= 0. then b.x +. b.width else b.x;
+    a.(o + 4) <- if b.height >= 0. then b.y +. b.height else b.y;
+    a.(o + 5) <- if b.depth  >= 0. then b.z +. b.depth else b.z
+
+  let read a o =
+    FloatBox.create_from_points
+      (Vector3f.make a.(o) a.(o + 1) a.(o + 2))
+      (Vector3f.make a.(o + 3) a.(o + 4) a.(o + 5))
+
+  let coord (p : Vector3f.t) k =
+    if k = 0 then p.Vector3f.x else if k = 1 then p.Vector3f.y else p.Vector3f.z
+
+end
+
+
+module type S = sig
+
+  type bounds
+
+  type point
+
+  type 'a t
+
+  type handle = int
+
+  val create : ?max_depth:int -> ?leaf_size:int -> bounds -> 'a t
+
+  val length : 'a t -> int
+
+  val nodes : 'a t -> int
+
+  val depth : 'a t -> int
+
+  val clear : 'a t -> unit
+
+  val insert : 'a t -> bounds -> 'a -> handle
+
+  val remove : 'a t -> handle -> unit
+
+  val update : 'a t -> handle -> bounds -> unit
+
+  val mem : 'a t -> handle -> bool
+
+  val bounds : 'a t -> handle -> bounds
+
+  val value : 'a t -> handle -> 'a
+
+  val iter : 'a t -> (handle -> 'a -> unit) -> unit
+
+  val range : 'a t -> bounds -> (handle -> 'a -> unit) -> unit
+
+  val point : 'a t -> point -> (handle -> 'a -> unit) -> unit
+
+  val nearest : 'a t -> ?max_dist:float -> point -> int -> (handle * float) list
+
+end
+
+
+(* Loose trees : each node has a tight cell of half size h, and stores the
+ * objects that fit in its loose cell, of half size 2h around the same center.
+ * An object whose center lies in a child cell and whose extent is at most
+ * the half size of this child always fits in the loose cell of the child,
+ * so objects are placed by their center and size only and never straddle.
+ *
+ * Nodes are allocated by blocks of 2^dim siblings, from a pool that grows
+ * by doubling and recycles the blocks of collapsed subtrees. Objects are
+ * stored in intrusive doubly-linked lists, one per node. *)
+module Make (S : Space) = struct
+
+  type bounds = S.bounds
+
+  type point = S.point
+
+  type handle = int
+
+  let dim = S.dim
+
+  let arity = 1 lsl dim
+
+  type 'a t = {
+    max_depth : int;
+    leaf_size : int;
+    (* Nodes, node 0 is the root and block b holds nodes 1 + b * arity ... *)
+    mutable center : float array; (* dim floats per node *)
+    mutable half   : float array; (* Half size of the tight cell *)
+    mutable child  : int array;   (* First child, or -1 for leaves *)
+    mutable parent : int array;
+    mutable level  : int array;
+    mutable head   : int array;   (* First object of the node, or -1 *)
+    mutable own    : int array;   (* Number of objects of the node *)
+    mutable total  : int array;   (* Number of objects of the subtree *)
+    mutable blocks : int;         (* Allocated blocks *)
+    mutable used   : int;         (* Blocks in use *)
+    mutable free_block : int;     (* Free blocks are chained through [child] *)
+    (* Objects, free handles are chained through [next] *)
+    mutable obounds : float array; (* min then max coordinates, 2 * dim floats per object *)
+    mutable values  : 'a array;
+    mutable node    : int array;   (* Node of the object, or -1 if free *)
+    mutable next    : int array;
+    mutable prev    : int array;
+    mutable size    : int;
+    mutable free    : int;
+    mutable length  : int
+  }
+
+  let create ?max_depth:(max_depth = 16) ?leaf_size:(leaf_size = 8) b =
+    if max_depth < 0 then raise (SpatialTree_exception "Negative maximal depth");
+    if leaf_size < 1 then raise (SpatialTree_exception "Leaf size must be positive");
+    let a = Array.make (2 * dim) 0. in
+    S.write b a 0;
+    let half = ref 0. in
+    for k = 0 to dim - 1 do
+      half := max !half ((a.(dim + k) -. a.(k)) /. 2.)
+    done;
+    if !half <= 0. then raise (SpatialTree_exception "Empty bounds");
+    {
+      max_depth; leaf_size;
+      center = Array.init dim (fun k -> (a.(k) +. a.(dim + k)) /. 2.);
+      half   = [|!half|];
+      child  = [|-1|];
+      parent = [|-1|];
+      level  = [|0|];
+      head   = [|-1|];
+      own    = [|0|];
+      total  = [|0|];
+      blocks = 0;
+      used   = 0;
+      free_block = -1;
+      obounds = [||];
+      values  = [||];
+      node    = [||];
+      next    = [||];
+      prev    = [||];
+      size    = 0;
+      free    = -1;
+      length  = 0
+    }
+
+  let length t = t.length
+
+  let nodes t = 1 + t.used * arity
+
+  let depth t =
+    let rec aux n =
+      if t.child.(n) < 0 then t.level.(n)
+      else begin
+        let d = ref 0 in
+        for i = 0 to arity - 1 do
+          d := max !d (aux (t.child.(n) + i))
+        done;
+        !d
+      end
+    in
+    aux 0
+
+  let clear t =
+    for h = 0 to t.size - 1 do
+      t.node.(h) <- -1
+    done;
+    t.size <- 0;
+    t.free <- -1;
+    t.length <- 0;
+    t.child.(0) <- -1;
+    t.head.(0) <- -1;
+    t.own.(0) <- 0;
+    t.total.(0) <- 0;
+    t.blocks <- 0;
+    t.used <- 0;
+    t.free_block <- -1
+
+  let grow a n v =
+    let a' = Array.make n v in
+    Array.blit a 0 a' 0 (Array.length a);
+    a'
+
+
+  (* Node pool *)
+  let reserve_nodes t n =
+    let cap = Array.length t.half in
+    if n > cap then begin
+      let cap = max n (2 * cap) in
+      t.center <- grow t.center (cap * dim) 0.;
+      t.half   <- grow t.half cap 0.;
+      t.child  <- grow t.child cap (-1);
+      t.parent <- grow t.parent cap (-1);
+      t.level  <- grow t.level cap 0;
+      t.head   <- grow t.head cap (-1);
+      t.own    <- grow t.own cap 0;
+      t.total  <- grow t.total cap 0
+    end
+
+  let alloc_block t =
+    t.used <- t.used + 1;
+    if t.free_block >= 0 then begin
+      let f = t.free_block in
+      t.free_block <- t.child.(f);
+      f
+    end else begin
+      let f = 1 + t.blocks * arity in
+      reserve_nodes t (f + arity);
+      t.blocks <- t.blocks + 1;
+      f
+    end
+
+  let release_block t f =
+    t.used <- t.used - 1;
+    t.child.(f) <- t.free_block;
+    t.free_block <- f
+
+
+  (* Object lists *)
+  let link t o n =
+    let h = t.head.(n) in
+    t.next.(o) <- h;
+    t.prev.(o) <- -1;
+    if h >= 0 then t.prev.(h) <- o;
+    t.head.(n) <- o;
+    t.node.(o) <- n;
+    t.own.(n) <- t.own.(n) + 1
+
+  let unlink t o =
+    let n = t.node.(o) in
+    let p = t.prev.(o) and q = t.next.(o) in
+    if p >= 0 then t.next.(p) <- q else t.head.(n) <- q;
+    if q >= 0 then t.prev.(q) <- p;
+    t.own.(n) <- t.own.(n) - 1
+
+  let rec add_total t n d =
+    if n >= 0 then begin
+      t.total.(n) <- t.total.(n) + d;
+      add_total t t.parent.(n) d
+    end
+
+
+  (* Placement *)
+
+  (* Does object o fit in the loose cell of node n ? *)
+  let fits t o n =
+    let b = t.obounds and ob = 2 * dim * o in
+    let h = 2. *. t.half.(n) in
+    let ok = ref true and k = ref 0 in
+    while !ok && !k < dim do
+      let c = t.center.(n * dim + !k) in
+      if b.(ob + !k) < c -. h || b.(ob + dim + !k) > c +. h then ok := false;
+      incr k
+    done;
+    !ok
+
+  (* Child of n whose tight cell contains the center of object o *)
+  let select t o n =
+    let b = t.obounds and ob = 2 * dim * o in
+    let i = ref 0 in
+    for k = 0 to dim - 1 do
+      if b.(ob + k) +. b.(ob + dim + k) >= 2. *. t.center.(n * dim + k) then
+        i := !i lor (1 lsl k)
+    done;
+    t.child.(n) + !i
+
+  let split t n =
+    let f = alloc_block t in
+    t.child.(n) <- f;
+    let h = t.half.(n) /. 2. in
+    for i = 0 to arity - 1 do
+      let c = f + i in
+      for k = 0 to dim - 1 do
+        t.center.(c * dim + k) <-
+          t.center.(n * dim + k) +. (if i land (1 lsl k) <> 0 then h else -. h)
+      done;
+      t.half.(c)   <- h;
+      t.child.(c)  <- -1;
+      t.parent.(c) <- n;
+      t.level.(c)  <- t.level.(n) + 1;
+      t.head.(c)   <- -1;
+      t.own.(c)    <- 0;
+      t.total.(c)  <- 0
+    done;
+    let o = ref t.head.(n) in
+    while !o >= 0 do
+      let next = t.next.(!o) in
+      let c = select t !o n in
+      if fits t !o c then begin
+        unlink t !o;
+        link t !o c;
+        t.total.(c) <- t.total.(c) + 1
+      end;
+      o := next
+    done
+
+  (* Descends from n to the deepest node that can hold o, splitting full leaves *)
+  let rec place t o n =
+    if t.child.(n) < 0 && (t.own.(n) < t.leaf_size || t.level.(n) >= t.max_depth) then n
+    else begin
+      if t.child.(n) < 0 then split t n;
+      let c = select t o n in
+      if fits t o c then place t o c else n
+    end
+
+  let insert_from t o n =
+    let n = place t o n in
+    link t o n;
+    add_total t n 1
+
+  (* Moves all the objects of the subtree of n into a and releases the blocks *)
+  let rec gather t a n =
+    if n <> a then begin
+      let o = ref t.head.(n) in
+      while !o >= 0 do
+        let next = t.next.(!o) in
+        unlink t !o;
+        link t !o a;
+        o := next
+      done
+    end;
+    let f = t.child.(n) in
+    if f >= 0 then begin
+      for i = 0 to arity - 1 do
+        gather t a (f + i)
+      done;
+      t.child.(n) <- -1;
+      release_block t f
+    end
+
+  (* Collapses the highest ancestor of n whose subtree became small enough.
+   * Collapsing at half the leaf size avoids splitting it again right away. *)
+  let shrink t n =
+    let best = ref (-1) and m = ref n in
+    while !m >= 0 do
+      if t.child.(!m) >= 0 && t.total.(!m) <= t.leaf_size / 2 then best := !m;
+      m := t.parent.(!m)
+    done;
+    if !best >= 0 then gather t !best !best
+
+
+  (* Objects *)
+  let reserve_objects t v =
+    let cap = Array.length t.node in
+    if t.size >= cap then begin
+      let cap = max 16 (2 * cap) in
+      t.obounds <- grow t.obounds (cap * 2 * dim) 0.;
+      t.values  <- if t.size = 0 then Array.make cap v else grow t.values cap v;
+      t.node    <- grow t.node cap (-1);
+      t.next    <- grow t.next cap (-1);
+      t.prev    <- grow t.prev cap (-1)
+    end
+
+  let mem t h =
+    h >= 0 && h < t.size && t.node.(h) >= 0
+
+  let check t h =
+    if not (mem t h) then raise (SpatialTree_exception "Invalid handle")
+
+  let insert t b v =
+    let h =
+      if t.free >= 0 then begin
+        let h = t.free in
+        t.free <- t.next.(h);
+        h
+      end else begin
+        reserve_objects t v;
+        t.size <- t.size + 1;
+        t.size - 1
+      end
+    in
+    S.write b t.obounds (2 * dim * h);
+    t.values.(h) <- v;
+    t.length <- t.length + 1;
+    insert_from t h 0;
+    h
+
+  let remove t h =
+    check t h;
+    let n = t.node.(h) in
+    unlink t h;
+    add_total t n (-1);
+    t.node.(h) <- -1;
+    t.next.(h) <- t.free;
+    t.free <- h;
+    t.length <- t.length - 1;
+    shrink t n
+
+  let update t h b =
+    check t h;
+    S.write b t.obounds (2 * dim * h);
+    let n = t.node.(h) in
+    if n = 0 || fits t h n then begin
+      (* Still in its loose cell : only move it down if a child can hold it *)
+      if t.child.(n) >= 0 && fits t h (select t h n) then begin
+        unlink t h;
+        add_total t n (-1);
+        insert_from t h (select t h n)
+      end
+    end else begin
+      unlink t h;
+      add_total t n (-1);
+      let a = ref t.parent.(n) in
+      while !a > 0 && not (fits t h !a) do
+        a := t.parent.(!a)
+      done;
+      insert_from t h !a;
+      shrink t n
+    end
+
+  let bounds t h =
+    check t h;
+    S.read t.obounds (2 * dim * h)
+
+  let value t h =
+    check t h;
+    t.values.(h)
+
+  let iter t f =
+    for h = 0 to t.size - 1 do
+      if t.node.(h) >= 0 then f h t.values.(h)
+    done
+
+
+  (* Queries *)
+
+  let rec report_all t n f =
+    let o = ref t.head.(n) in
+    while !o >= 0 do
+      let next = t.next.(!o) in
+      f !o t.values.(!o);
+      o := next
+    done;
+    let c = t.child.(n) in
+    if c >= 0 then
+      for i = 0 to arity - 1 do
+        if t.total.(c + i) > 0 then report_all t (c + i) f
+      done
+
+  (* Position of the loose cell of n relatively to a box q (min then max) :
+   * 0 if disjoint, 1 if intersecting, 2 if included in q *)
+  let relation t n q =
+    let h = 2. *. t.half.(n) in
+    let res = ref 2 and k = ref 0 in
+    while !res > 0 && !k < dim do
+      let c = t.center.(n * dim + !k) in
+      if c -. h > q.(dim + !k) || c +. h < q.(!k) then res := 0
+      else if c -. h < q.(!k) || c +. h > q.(dim + !k) then res := 1;
+      incr k
+    done;
+    !res
+
+  let overlaps t o q =
+    let b = t.obounds and ob = 2 * dim * o in
+    let ok = ref true and k = ref 0 in
+    while !ok && !k < dim do
+      if b.(ob + !k) > q.(dim + !k) || b.(ob + dim + !k) < q.(!k) then ok := false;
+      incr k
+    done;
+    !ok
+
+  (* Visits the objects overlapping q. The objects of the root may lie outside
+   * of its loose cell, so the root is always visited and tested. *)
+  let query t q f =
+    let rec visit n =
+      if n <> 0 && relation t n q = 2 then report_all t n f
+      else begin
+        let o = ref t.head.(n) in
+        while !o >= 0 do
+          let next = t.next.(!o) in
+          if overlaps t !o q then f !o t.values.(!o);
+          o := next
+        done;
+        let c = t.child.(n) in
+        if c >= 0 then
+          for i = 0 to arity - 1 do
+            if t.total.(c + i) > 0 && relation t (c + i) q > 0 then visit (c + i)
+          done
+      end
+    in
+    visit 0
+
+  let range t b f =
+    let q = Array.make (2 * dim) 0. in
+    S.write b q 0;
+    query t q f
+
+  let point t p f =
+    let q = Array.make (2 * dim) 0. in
+    for k = 0 to dim - 1 do
+      q.(k) <- S.coord p k;
+      q.(dim + k) <- q.(k)
+    done;
+    query t q f
+
+  let nearest t ?max_dist:(max_dist = infinity) p k =
+    if k < 0 then raise (SpatialTree_exception "Negative number of neighbours");
+    let p = Array.init dim (S.coord p) in
+    let max_sq = max_dist *. max_dist in
+    (* Max-heap of the k best squared distances *)
+    let dists = Array.make (max k 1) 0. and hs = Array.make (max k 1) 0 in
+    let count = ref 0 in
+    let accepts d = if !count < k then d <= max_sq else d < dists.(0) in
+    let swap i j =
+      let d = dists.(i) and h = hs.(i) in
+      dists.(i) <- dists.(j); hs.(i) <- hs.(j);
+      dists.(j) <- d; hs.(j) <- h
+    in
+    let rec sift_up i =
+      let p = (i - 1) / 2 in
+      if i > 0 && dists.(p) < dists.(i) then (swap i p; sift_up p)
+    in
+    let rec sift_down i =
+      let l = 2 * i + 1 in
+      let m = if l < !count && dists.(l) > dists.(i) then l else i in
+      let m = if l + 1 < !count && dists.(l + 1) > dists.(m) then l + 1 else m in
+      if m <> i then (swap i m; sift_down m)
+    in
+    let push d h =
+      if !count < k then begin
+        dists.(!count) <- d;
+        hs.(!count) <- h;
+        incr count;
+        sift_up (!count - 1)
+      end else begin
+        dists.(0) <- d;
+        hs.(0) <- h;
+        sift_down 0
+      end
+    in
+    let sq_dist lo hi =
+      let d = ref 0. in
+      for k = 0 to dim - 1 do
+        let x = p.(k) in
+        let e = if x < lo k then lo k -. x else if x > hi k then x -. hi k else 0. in
+        d := !d +. e *. e
+      done;
+      !d
+    in
+    let object_dist o =
+      let ob = 2 * dim * o in
+      sq_dist (fun k -> t.obounds.(ob + k)) (fun k -> t.obounds.(ob + dim + k))
+    in
+    let node_dist n =
+      let h = 2. *. t.half.(n) in
+      sq_dist (fun k -> t.center.(n * dim + k) -. h) (fun k -> t.center.(n * dim + k) +. h)
+    in
+    let rec visit n =
+      let o = ref t.head.(n) in
+      while !o >= 0 do
+        let d = object_dist !o in
+        if accepts d then push d !o;
+        o := t.next.(!o)
+      done;
+      let c = t.child.(n) in
+      if c >= 0 then begin
+        (* Visits the closest children first, to tighten the bound early *)
+        let ds = Array.init arity (fun i ->
+          if t.total.(c + i) > 0 then node_dist (c + i) else infinity)
+        in
+        let searching = ref true in
+        while !searching do
+          let best = ref 0 in
+          for i = 1 to arity - 1 do
+            if ds.(i) < ds.(!best) then best := i
+          done;
+          if ds.(!best) < infinity && accepts ds.(!best) then begin
+            ds.(!best) <- infinity;
+            visit (c + !best)
+          end else
+            searching := false
+        done
+      end
+    in
+    if k > 0 then visit 0;
+    Array.init !count (fun i -> (hs.(i), sqrt dists.(i)))
+    |> Array.to_list
+    |> List.sort (fun (_, d1) (_, d2) -> compare d1 d2)
+
+end
+
+
+module Quadtree = Make (Rect)
+
+module Octree = struct
+
+  include Make (Box)
+
+  let frustum t fr f =
+    let planes = Array.make 24 0. in
+    for i = 0 to 5 do
+      let (n, d) = Frustum.plane fr i in
+      planes.(4 * i)     <- n.Vector3f.x;
+      planes.(4 * i + 1) <- n.Vector3f.y;
+      planes.(4 * i + 2) <- n.Vector3f.z;
+      planes.(4 * i + 3) <- d
+    done;
+    (* Same as Frustum.classify_box on a box given by its min and max
+     * coordinates : 0 if outside, 1 if intersecting, 2 if inside *)
+    let classify b o =
+      let res = ref 2 and i = ref 0 in
+      while !res > 0 && !i < 6 do
+        let a = planes.(4 * !i) and bb = planes.(4 * !i + 1) and c = planes.(4 * !i + 2) in
+        let d = planes.(4 * !i + 3) in
+        let far =
+          a *. (if a >= 0. then b.(o + 3) else b.(o))
+          +. bb *. (if bb >= 0. then b.(o + 4) else b.(o + 1))
+          +. c *. (if c >= 0. then b.(o + 5) else b.(o + 2)) +. d
+        in
+        let near =
+          a *. (if a >= 0. then b.(o) else b.(o + 3))
+          +. bb *. (if bb >= 0. then b.(o + 1) else b.(o + 4))
+          +. c *. (if c >= 0. then b.(o + 2) else b.(o + 5)) +. d
+        in
+        if far < 0. then res := 0
+        else if near < 0. then res := 1;
+        incr i
+      done;
+      !res
+    in
+    let cell = Array.make 6 0. in
+    let classify_node n =
+      let h = 2. *. t.half.(n) in
+      for k = 0 to 2 do
+        cell.(k)     <- t.center.(3 * n + k) -. h;
+        cell.(3 + k) <- t.center.(3 * n + k) +. h
+      done;
+      classify cell 0
+    in
+    let rec visit n =
+      let r = if n = 0 then 1 else classify_node n in
+      if r = 2 then report_all t n f
+      else if r = 1 then begin
+        let o = ref t.head.(n) in
+        while !o >= 0 do
+          let next = t.next.(!o) in
+          if classify t.obounds (6 * !o) > 0 then f !o t.values.(!o);
+          o := next
+        done;
+        let c = t.child.(n) in
+        if c >= 0 then
+          for i = 0 to 7 do
+            if t.total.(c + i) > 0 then visit (c + i)
+          done
+      end
+    in
+    visit 0
+
+end
@@ -0,0 +1,76 @@
+exception SpatialTree_exception of string
+
+module type Space = sig
+
+  type bounds
+
+  type point
+
+  val dim : int
+
+  val write : bounds -> float array -> int -> unit
+
+  val read : float array -> int -> bounds
+
+  val coord : point -> int -> float
+
+end
+
+module Rect : Space with type bounds = OgamlMath.FloatRect.t and type point = OgamlMath.Vector2f.t
+
+module Box : Space with type bounds = OgamlMath.FloatBox.t and type point = OgamlMath.Vector3f.t
+
+
+module type S = sig
+
+  type bounds
+
+  type point
+
+  type 'a t
+
+  type handle = int
+
+  val create : ?max_depth:int -> ?leaf_size:int -> bounds -> 'a t
+
+  val length : 'a t -> int
+
+  val nodes : 'a t -> int
+
+  val depth : 'a t -> int
+
+  val clear : 'a t -> unit
+
+  val insert : 'a t -> bounds -> 'a -> handle
+
+  val remove : 'a t -> handle -> unit
+
+  val update : 'a t -> handle -> bounds -> unit
+
+  val mem : 'a t -> handle -> bool
+
+  val bounds : 'a t -> handle -> bounds
+
+  val value : 'a t -> handle -> 'a
+
+  val iter : 'a t -> (handle -> 'a -> unit) -> unit
+
+  val range : 'a t -> bounds -> (handle -> 'a -> unit) -> unit
+
+  val point : 'a t -> point -> (handle -> 'a -> unit) -> unit
+
+  val nearest : 'a t -> ?max_dist:float -> point -> int -> (handle * float) list
+
+end
+
+module Make : functor (S : Space) -> S with type bounds = S.bounds and type point = S.point
+
+module Quadtree : S with type bounds = OgamlMath.FloatRect.t and type point = OgamlMath.Vector2f.t
+
+module Octree : sig
+
+  include S with type bounds = OgamlMath.FloatBox.t and type point = OgamlMath.Vector3f.t
+
+  val frustum : 'a t -> OgamlMath.Frustum.t -> (handle -> 'a -> unit) -> unit
+
+end
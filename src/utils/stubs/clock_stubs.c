@@ -0,0 +1,36 @@
+#define CAML_NAME_SPACE
+
+#include <caml/mlvalues.h>
+#if defined(_WIN32)
+  #include <windows.h>
+#elif defined(__APPLE__)
+  #include <mach/mach_time.h>
+#else
+  #include <time.h>
+#endif
+
+
+// INPUT   nothing
+// OUTPUT  the value of a monotonic clock in nanoseconds, from an unspecified
+//         origin (usually the boot time)
+CAMLprim value
+caml_clock_monotonic_ns(value unit)
+{
+#if defined(_WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER count;
+  if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  // Split to avoid overflowing 64 bits after a few days of uptime
+  return Val_long((count.QuadPart / freq.QuadPart) * 1000000000LL +
+                  (count.QuadPart % freq.QuadPart) * 1000000000LL / freq.QuadPart);
+#elif defined(__APPLE__)
+  static mach_timebase_info_data_t base;
+  if (base.denom == 0) mach_timebase_info(&base);
+  return Val_long(mach_absolute_time() * base.numer / base.denom);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return Val_long((intnat)ts.tv_sec * 1000000000 + ts.tv_nsec);
+#endif
+}
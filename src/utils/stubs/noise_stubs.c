@@ -0,0 +1,355 @@
+#define CAML_NAME_SPACE
+
+#include <math.h>
+#include <caml/mlvalues.h>
+#include <caml/memory.h>
+#include <caml/bigarray.h>
+#include <caml/signals.h>
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define OGAML_SSE2
+#endif
+
+// Every noise is computed in double precision, with the operations done in
+// the same order as in noise.ml, so that the OCaml, scalar and SSE2 paths
+// return the same bits. This requires -ffp-contract=off.
+
+typedef struct {
+  int perm[512];
+  int kind;
+  int octaves;
+  int ridged;
+  double frequency;
+  double lacunarity;
+  double gain;
+  double warp;
+} noise_params;
+
+static const double F2 = 0.36602540378443864676;
+
+static const double G2 = 0.21132486540518711775;
+
+static const double grad12[24] = {
+  1., 1.,  -1., 1.,  1., -1.,  -1., -1.,
+  1., 0.,  -1., 0.,  1.,  0.,  -1.,  0.,
+  0., 1.,   0., -1., 0.,  1.,   0., -1.
+};
+
+static const double grad24[48] = {
+  0.9914448613738104, 0.13052619222005157,
+  0.9238795325112867, 0.3826834323650898,
+  0.7933533402912352, 0.6087614290087207,
+  0.6087614290087207, 0.7933533402912352,
+  0.38268343236508984, 0.9238795325112867,
+  0.1305261922200517, 0.9914448613738104,
+  -0.1305261922200516, 0.9914448613738104,
+  -0.3826834323650897, 0.9238795325112867,
+  -0.6087614290087207, 0.7933533402912352,
+  -0.793353340291235, 0.6087614290087209,
+  -0.9238795325112867, 0.3826834323650899,
+  -0.9914448613738104, 0.13052619222005157,
+  -0.9914448613738105, -0.13052619222005132,
+  -0.9238795325112868, -0.38268343236508967,
+  -0.7933533402912352, -0.6087614290087207,
+  -0.6087614290087209, -0.7933533402912349,
+  -0.3826834323650895, -0.9238795325112868,
+  -0.13052619222005163, -0.9914448613738104,
+  0.13052619222005127, -0.9914448613738105,
+  0.38268343236509, -0.9238795325112866,
+  0.6087614290087205, -0.7933533402912352,
+  0.7933533402912349, -0.6087614290087209,
+  0.9238795325112868, -0.38268343236508956,
+  0.9914448613738104, -0.13052619222005168
+};
+
+
+// Scalar noises
+
+static inline double fade(double t)
+{
+  return (t * t * t) * (t * (t * 6. - 15.) + 10.);
+}
+
+static inline double lerp(double t, double a, double b)
+{
+  return a + t * (b - a);
+}
+
+static inline double perlin_grad(int hash, double x, double y)
+{
+  switch(hash & 3) {
+    case 0:  return x + y;
+    case 1:  return x - y;
+    case 2:  return y - x;
+    default: return 0. - (x + y);
+  }
+}
+
+static double perlin(const int* p, double x, double y)
+{
+  intnat ix, iy;
+  int x1, y1, a, b, aa, ab, ba, bb;
+  double xi, yi, u, v;
+  x = fabs(x);
+  y = fabs(y);
+  ix = (intnat)x;
+  iy = (intnat)y;
+  x1 = (int)(ix & 255);
+  y1 = (int)(iy & 255);
+  xi = x - (double)ix;
+  yi = y - (double)iy;
+  u = fade(xi);
+  v = fade(yi);
+  a = p[x1] + y1;
+  b = p[x1 + 1] + y1;
+  aa = p[a];
+  ab = p[a + 1];
+  ba = p[b];
+  bb = p[b + 1];
+  return lerp(v, lerp(u, perlin_grad(p[aa], xi, yi), perlin_grad(p[ba], xi - 1., yi)),
+                 lerp(u, perlin_grad(p[ab], xi, yi - 1.), perlin_grad(p[bb], xi - 1., yi - 1.)));
+}
+
+static inline double corner2(const double* g, int h, double x, double y)
+{
+  double a = 0.5 - x * x - y * y;
+  if(a <= 0.) return 0.;
+  a = a * a;
+  return a * a * (g[2*h] * x + g[2*h + 1] * y);
+}
+
+static double simplex(const double* g, int modulo, const int* p, double x, double y)
+{
+  double s = (x + y) * F2;
+  double i = floor(x + s), j = floor(y + s);
+  double t = (i + j) * G2;
+  double x0 = x - (i - t), y0 = y - (j - t);
+  int i1 = x0 > y0 ? 1 : 0;
+  int j1 = 1 - i1;
+  double x1 = x0 - (double)i1 + G2, y1 = y0 - (double)j1 + G2;
+  double x2 = x0 - 1. + 2. * G2, y2 = y0 - 1. + 2. * G2;
+  int ii = (int)((intnat)i & 255), jj = (int)((intnat)j & 255);
+  int h0 = p[ii + p[jj]] % modulo;
+  int h1 = p[ii + i1 + p[jj + j1]] % modulo;
+  int h2 = p[ii + 1 + p[jj + 1]] % modulo;
+  return corner2(g, h0, x0, y0) + corner2(g, h1, x1, y1) + corner2(g, h2, x2, y2);
+}
+
+static inline double base(const noise_params* q, double x, double y)
+{
+  switch(q->kind) {
+    case 0:  return perlin(q->perm, x, y);
+    case 1:  return 70. * simplex(grad12, 12, q->perm, x, y);
+    default: return 99. * simplex(grad24, 24, q->perm, x, y);
+  }
+}
+
+static double fractal(const noise_params* q, double x, double y)
+{
+  double wx = x, wy = y;
+  double sum = 0., amp = 1., norm = 0., freq = q->frequency;
+  int k;
+  if(q->warp != 0.) {
+    wx = x + q->warp * base(q, x * q->frequency + 5.2, y * q->frequency + 1.3);
+    wy = y + q->warp * base(q, x * q->frequency + 1.7, y * q->frequency + 9.2);
+  }
+  for(k = 0; k < q->octaves; k++) {
+    double n = base(q, wx * freq, wy * freq);
+    if(q->ridged) {
+      double r = 1. - fabs(n);
+      n = r * r;
+    }
+    sum = sum + n * amp;
+    norm = norm + amp;
+    amp = amp * q->gain;
+    freq = freq * q->lacunarity;
+  }
+  return sum / norm;
+}
+
+
+// SSE2 noises : two samples at once. Lattice lookups are done per lane,
+// and the rest of the arithmetic on both lanes.
+
+#ifdef OGAML_SSE2
+static inline __m128d fade2(__m128d t)
+{
+  __m128d t3 = _mm_mul_pd(_mm_mul_pd(t, t), t);
+  __m128d s = _mm_sub_pd(_mm_mul_pd(t, _mm_set1_pd(6.)), _mm_set1_pd(15.));
+  return _mm_mul_pd(t3, _mm_add_pd(_mm_mul_pd(t, s), _mm_set1_pd(10.)));
+}
+
+static inline __m128d lerp2(__m128d t, __m128d a, __m128d b)
+{
+  return _mm_add_pd(a, _mm_mul_pd(t, _mm_sub_pd(b, a)));
+}
+
+static inline __m128d abs2(__m128d x)
+{
+  return _mm_andnot_pd(_mm_set1_pd(-0.), x);
+}
+
+static __m128d perlin2(const int* p, __m128d x, __m128d y)
+{
+  double ax[2], ay[2], fx[2], fy[2], xi[2], yi[2];
+  double gaa[2], gba[2], gab[2], gbb[2];
+  int l;
+  _mm_storeu_pd(ax, abs2(x));
+  _mm_storeu_pd(ay, abs2(y));
+  for(l = 0; l < 2; l++) {
+    intnat ix = (intnat)ax[l], iy = (intnat)ay[l];
+    fx[l] = (double)ix;
+    fy[l] = (double)iy;
+    xi[l] = ax[l] - fx[l];
+    yi[l] = ay[l] - fy[l];
+    {
+      int x1 = (int)(ix & 255), y1 = (int)(iy & 255);
+      int a = p[x1] + y1, b = p[x1 + 1] + y1;
+      gaa[l] = perlin_grad(p[p[a]], xi[l], yi[l]);
+      gba[l] = perlin_grad(p[p[b]], xi[l] - 1., yi[l]);
+      gab[l] = perlin_grad(p[p[a + 1]], xi[l], yi[l] - 1.);
+      gbb[l] = perlin_grad(p[p[b + 1]], xi[l] - 1., yi[l] - 1.);
+    }
+  }
+  {
+    __m128d u = fade2(_mm_loadu_pd(xi)), v = fade2(_mm_loadu_pd(yi));
+    return lerp2(v, lerp2(u, _mm_loadu_pd(gaa), _mm_loadu_pd(gba)),
+                    lerp2(u, _mm_loadu_pd(gab), _mm_loadu_pd(gbb)));
+  }
+}
+
+static inline __m128d corner2_sse(__m128d x, __m128d y, __m128d gx, __m128d gy)
+{
+  __m128d a = _mm_sub_pd(_mm_sub_pd(_mm_set1_pd(0.5), _mm_mul_pd(x, x)), _mm_mul_pd(y, y));
+  __m128d mask = _mm_cmpgt_pd(a, _mm_setzero_pd());
+  a = _mm_mul_pd(a, a);
+  return _mm_and_pd(mask, _mm_mul_pd(_mm_mul_pd(a, a),
+                                     _mm_add_pd(_mm_mul_pd(gx, x), _mm_mul_pd(gy, y))));
+}
+
+static __m128d simplex2(const double* g, int modulo, const int* p, __m128d x, __m128d y)
+{
+  double xs[2], ys[2], fi[2], fj[2], x0s[2], y0s[2], d1x[2], d1y[2];
+  double g0x[2], g0y[2], g1x[2], g1y[2], g2x[2], g2y[2];
+  __m128d s = _mm_mul_pd(_mm_add_pd(x, y), _mm_set1_pd(F2));
+  __m128d i, j, t, x0, y0, x1, y1, x2, y2, c;
+  __m128d vg2 = _mm_set1_pd(G2);
+  int l;
+  _mm_storeu_pd(xs, _mm_add_pd(x, s));
+  _mm_storeu_pd(ys, _mm_add_pd(y, s));
+  for(l = 0; l < 2; l++) {
+    fi[l] = floor(xs[l]);
+    fj[l] = floor(ys[l]);
+  }
+  i = _mm_loadu_pd(fi);
+  j = _mm_loadu_pd(fj);
+  t = _mm_mul_pd(_mm_add_pd(i, j), vg2);
+  x0 = _mm_sub_pd(x, _mm_sub_pd(i, t));
+  y0 = _mm_sub_pd(y, _mm_sub_pd(j, t));
+  _mm_storeu_pd(x0s, x0);
+  _mm_storeu_pd(y0s, y0);
+  for(l = 0; l < 2; l++) {
+    int i1 = x0s[l] > y0s[l] ? 1 : 0;
+    int j1 = 1 - i1;
+    int ii = (int)((intnat)fi[l] & 255), jj = (int)((intnat)fj[l] & 255);
+    int h0 = p[ii + p[jj]] % modulo;
+    int h1 = p[ii + i1 + p[jj + j1]] % modulo;
+    int h2 = p[ii + 1 + p[jj + 1]] % modulo;
+    d1x[l] = (double)i1;
+    d1y[l] = (double)j1;
+    g0x[l] = g[2*h0]; g0y[l] = g[2*h0 + 1];
+    g1x[l] = g[2*h1]; g1y[l] = g[2*h1 + 1];
+    g2x[l] = g[2*h2]; g2y[l] = g[2*h2 + 1];
+  }
+  x1 = _mm_add_pd(_mm_sub_pd(x0, _mm_loadu_pd(d1x)), vg2);
+  y1 = _mm_add_pd(_mm_sub_pd(y0, _mm_loadu_pd(d1y)), vg2);
+  x2 = _mm_add_pd(_mm_sub_pd(x0, _mm_set1_pd(1.)), _mm_set1_pd(2. * G2));
+  y2 = _mm_add_pd(_mm_sub_pd(y0, _mm_set1_pd(1.)), _mm_set1_pd(2. * G2));
+  c = corner2_sse(x0, y0, _mm_loadu_pd(g0x), _mm_loadu_pd(g0y));
+  c = _mm_add_pd(c, corner2_sse(x1, y1, _mm_loadu_pd(g1x), _mm_loadu_pd(g1y)));
+  return _mm_add_pd(c, corner2_sse(x2, y2, _mm_loadu_pd(g2x), _mm_loadu_pd(g2y)));
+}
+
+static inline __m128d base2(const noise_params* q, __m128d x, __m128d y)
+{
+  switch(q->kind) {
+    case 0:  return perlin2(q->perm, x, y);
+    case 1:  return _mm_mul_pd(_mm_set1_pd(70.), simplex2(grad12, 12, q->perm, x, y));
+    default: return _mm_mul_pd(_mm_set1_pd(99.), simplex2(grad24, 24, q->perm, x, y));
+  }
+}
+
+static __m128d fractal2(const noise_params* q, __m128d x, __m128d y)
+{
+  __m128d wx = x, wy = y, sum = _mm_setzero_pd();
+  double amp = 1., norm = 0., freq = q->frequency;
+  int k;
+  if(q->warp != 0.) {
+    __m128d f = _mm_set1_pd(q->frequency), w = _mm_set1_pd(q->warp);
+    __m128d sx = _mm_mul_pd(x, f), sy = _mm_mul_pd(y, f);
+    wx = _mm_add_pd(x, _mm_mul_pd(w, base2(q, _mm_add_pd(sx, _mm_set1_pd(5.2)),
+                                              _mm_add_pd(sy, _mm_set1_pd(1.3)))));
+    wy = _mm_add_pd(y, _mm_mul_pd(w, base2(q, _mm_add_pd(sx, _mm_set1_pd(1.7)),
+                                              _mm_add_pd(sy, _mm_set1_pd(9.2)))));
+  }
+  for(k = 0; k < q->octaves; k++) {
+    __m128d f = _mm_set1_pd(freq);
+    __m128d n = base2(q, _mm_mul_pd(wx, f), _mm_mul_pd(wy, f));
+    if(q->ridged) {
+      __m128d r = _mm_sub_pd(_mm_set1_pd(1.), abs2(n));
+      n = _mm_mul_pd(r, r);
+    }
+    sum = _mm_add_pd(sum, _mm_mul_pd(n, _mm_set1_pd(amp)));
+    norm = norm + amp;
+    amp = amp * q->gain;
+    freq = freq * q->lacunarity;
+  }
+  return _mm_div_pd(sum, _mm_set1_pd(norm));
+}
+#endif
+
+
+// INPUT   a permutation, the float parameters (frequency, lacunarity, gain,
+//         warp, origin x, origin y, step), the int parameters (kind, octaves,
+//         ridged, stride, x, y, width, height) and a float32 bigarray
+// OUTPUT  nothing, fills the region of the bigarray with the fractal noise
+CAMLprim value
+caml_noise_fill(value perm, value fparams, value iparams, value dst)
+{
+  CAMLparam4(perm, fparams, iparams, dst);
+  noise_params q;
+  float* data = (float*)Caml_ba_data_val(dst);
+  double ox = Double_field(fparams, 4), oy = Double_field(fparams, 5);
+  double step = Double_field(fparams, 6);
+  intnat stride = Long_val(Field(iparams, 3));
+  intnat x0 = Long_val(Field(iparams, 4)), y0 = Long_val(Field(iparams, 5));
+  intnat w = Long_val(Field(iparams, 6)), h = Long_val(Field(iparams, 7));
+  intnat i, j;
+  int k;
+  for(k = 0; k < 512; k++) q.perm[k] = (int)Long_val(Field(perm, k));
+  q.frequency  = Double_field(fparams, 0);
+  q.lacunarity = Double_field(fparams, 1);
+  q.gain       = Double_field(fparams, 2);
+  q.warp       = Double_field(fparams, 3);
+  q.kind       = (int)Long_val(Field(iparams, 0));
+  q.octaves    = (int)Long_val(Field(iparams, 1));
+  q.ridged     = (int)Long_val(Field(iparams, 2));
+  // Everything was copied out of the OCaml heap and the data of a bigarray
+  // does not move, so other threads can run meanwhile
+  caml_enter_blocking_section();
+  for(j = y0; j < y0 + h; j++) {
+    double py = oy + (double)j * step;
+    float* row = data + j * stride;
+    i = x0;
+#ifdef OGAML_SSE2
+    for(; i + 2 <= x0 + w; i += 2) {
+      __m128d px = _mm_set_pd(ox + (double)(i + 1) * step, ox + (double)i * step);
+      __m128 v = _mm_cvtpd_ps(fractal2(&q, px, _mm_set1_pd(py)));
+      _mm_storel_pi((__m64*)(row + i), v);
+    }
+#endif
+    for(; i < x0 + w; i++) row[i] = (float)fractal(&q, ox + (double)i * step, py);
+  }
+  caml_leave_blocking_section();
+  CAMLreturn(Val_unit);
+}
@@ -0,0 +1,85 @@
+#define CAML_NAME_SPACE
+
+#include <stdint.h>
+#include <string.h>
+#include <caml/mlvalues.h>
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define OGAML_SSE2
+#endif
+
+
+// Skips the ASCII bytes starting at i, 16 at a time with SSE2 or 8 at a
+// time otherwise, and returns the index of the first block containing a
+// non-ASCII byte
+static size_t skip_ascii(const unsigned char* s, size_t i, size_t n)
+{
+#if defined(OGAML_SSE2)
+  while (i + 16 <= n) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+    if (_mm_movemask_epi8(v) != 0) break;
+    i += 16;
+  }
+#else
+  while (i + 8 <= n) {
+    uint64_t w;
+    memcpy(&w, s + i, 8);
+    if ((w & 0x8080808080808080ULL) != 0) break;
+    i += 8;
+  }
+#endif
+  return i;
+}
+
+
+// INPUT   a string
+// OUTPUT  its number of code points if it is valid UTF-8 (RFC 3629 : no
+//         overlong sequences, surrogates or codes above 0x10FFFF), or
+//         -1 - the offset of the first invalid sequence
+CAMLprim value
+caml_utf8_validate(value str)
+{
+  const unsigned char* s = (const unsigned char*)String_val(str);
+  size_t n = caml_string_length(str);
+  size_t i = 0, j;
+  intnat count = 0;
+  unsigned char c, lo, hi;
+  int w, k;
+
+  while (i < n) {
+    j = skip_ascii(s, i, n);
+    count += j - i;
+    i = j;
+    if (i >= n) break;
+
+    c = s[i];
+    lo = 0x80;
+    hi = 0xBF;
+    if (c < 0x80) {
+      i++;
+      count++;
+      continue;
+    }
+    else if (c >= 0xC2 && c <= 0xDF) w = 2;
+    else if (c == 0xE0) { w = 3; lo = 0xA0; }
+    else if (c == 0xED) { w = 3; hi = 0x9F; }
+    else if (c >= 0xE1 && c <= 0xEF) w = 3;
+    else if (c == 0xF0) { w = 4; lo = 0x90; }
+    else if (c == 0xF4) { w = 4; hi = 0x8F; }
+    else if (c >= 0xF1 && c <= 0xF3) w = 4;
+    else return Val_long(-1 - (intnat)i);
+
+    // The range of the second byte excludes overlong sequences,
+    // surrogates and codes above 0x10FFFF
+    if (i + w > n || s[i+1] < lo || s[i+1] > hi)
+      return Val_long(-1 - (intnat)i);
+    for (k = 2; k < w; k++) {
+      if ((s[i+k] & 0xC0) != 0x80)
+        return Val_long(-1 - (intnat)i);
+    }
+    i += w;
+    count++;
+  }
+
+  return Val_long(count);
+}
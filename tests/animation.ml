@@ -0,0 +1,168 @@
+open OgamlMath
+open OgamlUtils
+
+let () =
+  Printf.printf "Beginning animation tests...\n%!"
+
+let close_to ?(eps = 1e-5) a b = abs_float (a -. b) < eps
+
+(* Compiled interpolators do not depend on the order of the evaluations *)
+let test_interpolator () =
+  let steps = [(0.2, 3.); (0.25, -1.); (0.7, 4.); (0.9, 0.)] in
+  let lin = Interpolator.linear 1. steps 2. in
+  let cub = Interpolator.cubic (1., 0.5) steps (2., -1.) in
+  List.iter (fun (t, v) ->
+    assert (close_to (Interpolator.get lin t) v);
+    assert (close_to (Interpolator.get cub t) v)) ((0., 1.) :: (1., 2.) :: steps);
+  assert (close_to (Interpolator.get lin 0.1) 2.);
+  assert (close_to (Interpolator.get lin 0.8) 2.);
+  let samples = Array.init 200 (fun i -> float_of_int i /. 199.) in
+  let forward = Array.map (Interpolator.get cub) samples in
+  let cub' = Interpolator.cubic (1., 0.5) steps (2., -1.) in
+  for _i = 1 to 1000 do
+    let k = Random.int 200 in
+    assert (Interpolator.get cub' samples.(k) = forward.(k))
+  done;
+  (try ignore (Interpolator.linear 0. [(0.5, 1.); (0.2, 0.)] 1.); assert false
+   with Interpolator.Invalid_interpolator _ -> ());
+  (* Time-based interpolators sampled at a given date *)
+  let ip = Interpolator.start lin 10. 2. in
+  assert (close_to (Interpolator.at ip 10.) 1.);
+  assert (close_to (Interpolator.at ip 11.) (Interpolator.get lin 0.5));
+  assert (close_to (Interpolator.at ip 13.) 2.)
+
+let () =
+  test_interpolator ();
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Tracks *)
+let test_tracks () =
+  let times = [|0.; 1.; 1.; 3.|] in
+  let values = [|0.; 10.; 20.; 40.|] in
+  let lin = Animation.Track.linear times values in
+  assert (Animation.Track.duration lin = 3.);
+  assert (Animation.Track.get lin (-1.) = 0.);
+  assert (close_to (Animation.Track.get lin 0.5) 5.);
+  (* Keys at the same time are a discontinuity *)
+  assert (close_to (Animation.Track.get lin 1.) 20.);
+  assert (close_to (Animation.Track.get lin 2.) 30.);
+  assert (Animation.Track.get lin 5. = 40.);
+  let step = Animation.Track.step times values in
+  assert (Animation.Track.get step 0.99 = 0.);
+  assert (Animation.Track.get step 2.5 = 20.);
+  assert (Animation.Track.get step 3. = 40.);
+  (* Cubic tracks go through their keys, and the default tangents keep
+   * aligned keys on a line *)
+  let times = [|0.; 0.5; 2.; 4.|] in
+  let cub = Animation.Track.cubic times [|1.; 2.; 5.; 9.|] in
+  Array.iteri (fun i t ->
+    assert (close_to (Animation.Track.get cub t) [|1.; 2.; 5.; 9.|].(i))) times;
+  let line = Animation.Track.cubic ~dimension:2 times
+    (Array.concat (Array.to_list (Array.map (fun t -> [|2. *. t; 1. -. t|]) times)))
+  in
+  let buf = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout 3 in
+  for i = 0 to 100 do
+    let t = float_of_int i *. 0.04 in
+    Animation.Track.sample line t buf 1;
+    assert (close_to ~eps:1e-4 buf.{1} (2. *. t));
+    assert (close_to ~eps:1e-4 buf.{2} (1. -. t))
+  done;
+  (* Random accesses match sequential ones *)
+  let times = Array.init 50 (fun i -> float_of_int i +. Random.float 0.5) in
+  let values = Array.init 50 (fun _ -> Random.float 10.) in
+  let seq = Animation.Track.cubic times values in
+  let rnd = Animation.Track.cubic times values in
+  let samples = Array.init 500 (fun i -> float_of_int i /. 10. -. 0.5) in
+  let expected = Array.map (Animation.Track.get seq) samples in
+  for _i = 1 to 2000 do
+    let k = Random.int 500 in
+    assert (Animation.Track.get rnd samples.(k) = expected.(k))
+  done;
+  (try ignore (Animation.Track.linear [|1.; 0.|] [|0.; 0.|]); assert false
+   with Animation.Animation_error _ -> ());
+  (try ignore (Animation.Track.linear ~dimension:2 [|0.; 1.|] [|0.; 0.; 1.|]); assert false
+   with Animation.Animation_error _ -> ());
+  (try Animation.Track.sample lin 0. buf 3; assert false
+   with Animation.Animation_error _ -> ())
+
+let () =
+  test_tracks ();
+  Printf.printf "\tTest 2 passed\n%!"
+
+(* Rotation tracks *)
+let test_rotations () =
+  let z = Vector3f.unit_z in
+  let q0 = Quaternion.rotation z 0. and q1 = Quaternion.rotation z (Constants.pi /. 2.) in
+  let rot = Animation.Track.rotation [|0.; 1.|] [|q0; q1|] in
+  let expect theta q =
+    let e = Quaternion.rotation z theta in
+    assert (close_to q.Quaternion.r e.Quaternion.r && close_to q.Quaternion.i e.Quaternion.i &&
+            close_to q.Quaternion.j e.Quaternion.j && close_to q.Quaternion.k e.Quaternion.k)
+  in
+  for i = 0 to 10 do
+    let u = float_of_int i /. 10. in
+    let q = Animation.Track.quaternion rot u in
+    assert (close_to (Quaternion.norm q) 1.);
+    expect (u *. Constants.pi /. 2.) q
+  done;
+  (* The opposite of a key is the same rotation, and is reached by the
+   * shortest path *)
+  let rot = Animation.Track.rotation [|0.; 1.|] [|q0; Quaternion.prop (-1.) q1|] in
+  expect (Constants.pi /. 4.) (Animation.Track.quaternion rot 0.5);
+  (* Almost equal keys *)
+  let rot = Animation.Track.rotation [|0.; 1.|] [|q0; Quaternion.rotation z 1e-9|] in
+  assert (close_to (Quaternion.norm (Animation.Track.quaternion rot 0.5)) 1.);
+  (try ignore (Animation.Track.rotation [|0.|] [|Quaternion.zero|]); assert false
+   with Animation.Animation_error _ -> ());
+  (try ignore (Animation.Track.quaternion (Animation.Track.linear [|0.|] [|0.|]) 0.); assert false
+   with Animation.Animation_error _ -> ())
+
+let () =
+  test_rotations ();
+  Printf.printf "\tTest 3 passed\n%!"
+
+(* Animations sample all their tracks like the tracks themselves *)
+let test_animations () =
+  let times = [|0.; 0.5; 1.5; 2.|] in
+  let other = [|0.5; 1.; 3.|] in
+  let tracks = [
+    Animation.Track.linear ~dimension:3 times (Array.init 12 float_of_int);
+    Animation.Track.cubic other [|1.; -1.; 2.|];
+    Animation.Track.rotation times (Array.init 4 (fun i ->
+      Quaternion.rotation Vector3f.unit_y (float_of_int i)));
+    Animation.Track.step (Array.copy times) [|4.; 3.; 2.; 1.|]
+  ] in
+  let anim = Animation.create tracks in
+  assert (Animation.tracks anim = 4);
+  assert (Animation.size anim = 3 + 1 + 4 + 1);
+  assert (Animation.offset anim 2 = 4);
+  assert (Animation.start anim = 0. && Animation.stop anim = 3.);
+  let buf = Animation.buffer anim in
+  let single = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (Animation.size anim) in
+  for i = -10 to 40 do
+    let t = float_of_int i /. 10. in
+    Animation.sample anim t buf;
+    List.iteri (fun k tr -> Animation.Track.sample tr t single (Animation.offset anim k)) tracks;
+    for c = 0 to Animation.size anim - 1 do
+      assert (buf.{c} = single.{c})
+    done
+  done;
+  (* Looping *)
+  let wrapped = Animation.buffer anim in
+  Animation.sample anim 1.25 buf;
+  Animation.sample ~loop:true anim 7.25 wrapped;
+  for c = 0 to Animation.size anim - 1 do
+    assert (close_to buf.{c} wrapped.{c})
+  done;
+  Animation.sample ~loop:true anim (-1.75) wrapped;
+  for c = 0 to Animation.size anim - 1 do
+    assert (close_to buf.{c} wrapped.{c})
+  done;
+  (try Animation.sample anim 0. (Bigarray.Array1.sub buf 0 3); assert false
+   with Animation.Animation_error _ -> ());
+  (try ignore (Animation.create []); assert false
+   with Animation.Animation_error _ -> ())
+
+let () =
+  test_animations ();
+  Printf.printf "\tTest 4 passed\n%!"
@@ -0,0 +1,131 @@
+open OgamlMath
+open OgamlUtils
+
+let () = 
+  Printf.printf "Beginning BVH tests...\n%!"
+
+let rnd () = Random.float 200. -. 100.
+
+let rnd_vec () = Vector3f.make (rnd ()) (rnd ()) (rnd ())
+
+let random_prim i = 
+  let p = rnd_vec () in
+  match i mod 3 with
+  | 0 -> BVH.Sphere (p, Random.float 5.)
+  | 1 -> BVH.Box (FloatBox.create p (Vector3f.make (Random.float 5.) (Random.float 5.) (Random.float 5.)))
+  | _ -> 
+    let d () = Vector3f.make (Random.float 10.) (Random.float 10.) (Random.float 10.) in
+    BVH.Triangle (p, Vector3f.add p (d ()), Vector3f.add p (d ()))
+
+let prims = Array.init 2000 random_prim
+
+let bvh = BVH.create prims
+
+(* Brute force closest hit, using a BVH of a single primitive *)
+let brute_raycast prims origin direction = 
+  let best = ref None in
+  Array.iteri (fun i p -> 
+    match BVH.raycast (BVH.create [|p|]) ~origin ~direction () with
+    | Some h -> 
+      begin match !best with
+      | Some (_, d) when d <= h.BVH.distance -> ()
+      | _ -> best := Some (i, h.BVH.distance)
+      end
+    | None -> ()
+  ) prims;
+  !best
+
+let test_raycasts bvh prims = 
+  for _i = 1 to 200 do
+    let origin = rnd_vec () in
+    let direction = rnd_vec () in
+    match BVH.raycast bvh ~origin ~direction (), brute_raycast prims origin direction with
+    | None, None -> ()
+    | Some h, Some (_, d) -> assert (abs_float (h.BVH.distance -. d) < 1e-9)
+    | _ -> assert false
+  done
+
+let testbvh1 () = 
+  assert (BVH.length bvh = 2000);
+  assert (BVH.nodes bvh < 2 * 2000);
+  assert (BVH.depth bvh < 64);
+  let hit = BVH.raycast (BVH.create [|BVH.Sphere (Vector3f.make 0. 0. (-10.), 1.)|])
+    ~origin:Vector3f.zero ~direction:(Vector3f.make 0. 0. (-2.)) () in
+  match hit with
+  | Some h -> assert (abs_float (h.BVH.distance -. 9.) < 1e-9)
+  | None -> assert false
+
+let testbvh2 () = 
+  test_raycasts bvh prims;
+  let hits = BVH.raycast_all bvh ~origin:(Vector3f.make (-100.) 0. 0.) ~direction:Vector3f.unit_x () in
+  let rec sorted = function
+    | h1 :: (h2 :: _ as t) -> h1.BVH.distance <= h2.BVH.distance && sorted t
+    | _ -> true
+  in
+  assert (sorted hits)
+
+let testbvh3 () = 
+  for _i = 1 to 50 do
+    let center = rnd_vec () and radius = Random.float 20. in
+    let found = Array.make (Array.length prims) false in
+    BVH.overlap_sphere bvh center radius (fun i -> found.(i) <- true);
+    Array.iteri (fun i p -> 
+      let single = ref false in
+      BVH.overlap_sphere (BVH.create [|p|]) center radius (fun _ -> single := true);
+      assert (found.(i) = !single)
+    ) prims;
+    let box = FloatBox.create center (Vector3f.make radius radius radius) in
+    let count = ref 0 in
+    BVH.overlap_box bvh box (fun i -> 
+      incr count;
+      match prims.(i) with
+      | BVH.Box b -> assert (FloatBox.intersects b box)
+      | _ -> ());
+    assert (!count <= Array.length prims)
+  done
+
+(* Moving primitives and refitting must give the same answers as a rebuild *)
+let testbvh4 () = 
+  let moved = Array.copy prims in
+  let bvh = BVH.create prims in
+  for i = 0 to 99 do
+    let p = random_prim i in
+    moved.(i) <- p;
+    BVH.update bvh i p
+  done;
+  test_raycasts bvh moved;
+  for i = 100 to 999 do
+    let p = random_prim i in
+    moved.(i) <- p;
+    BVH.set bvh i p
+  done;
+  BVH.refit bvh;
+  test_raycasts bvh moved
+
+(* Triangles are tested exactly, not on their bounding boxes *)
+let testbvh5 () = 
+  let v = Vector3f.make in
+  let tri a b c = BVH.Triangle (a, b, c) in
+  let others = [|
+    tri (v 0.9 0.9 (-0.5)) (v 0.9 0.9 0.5) (v 1. 1. 0.);
+    tri (v 0.2 0.2 (-1.)) (v 0.2 0.2 1.) (v 0.3 0.2 0.);
+    tri (v 0.1 0.1 0.) (v 2. 0.1 0.) (v 0.1 2. 0.);
+    tri (v 1. 1. 0.) (v 2. 1. 0.) (v 1. 2. 0.);
+    BVH.Sphere (v 0.9 0.9 0., 0.1)
+  |] in
+  let found = ref [] in
+  BVH.overlap (BVH.create others) (tri Vector3f.zero Vector3f.unit_x Vector3f.unit_y)
+    (fun i -> found := i :: !found);
+  assert (List.sort compare !found = [1; 2])
+
+let () = 
+  testbvh1 ();
+  Printf.printf "\tTest 1 passed\n%!";
+  testbvh2 ();
+  Printf.printf "\tTest 2 passed\n%!";
+  testbvh3 ();
+  Printf.printf "\tTest 3 passed\n%!";
+  testbvh4 ();
+  Printf.printf "\tTest 4 passed\n%!";
+  testbvh5 ();
+  Printf.printf "\tTest 5 passed\n%!"
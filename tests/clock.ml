@@ -0,0 +1,80 @@
+open OgamlUtils
+
+let () =
+  Printf.printf "Beginning clock tests...\n%!"
+
+(* Monotonic clock and sleeping *)
+let () =
+  let t0 = Clock.now_ns () in
+  let prev = ref t0 in
+  for _i = 1 to 1000 do
+    let t = Clock.now_ns () in
+    assert (t >= !prev);
+    prev := t
+  done;
+  let deadline = Clock.now_ns () + 5_000_000 in
+  Clock.sleep_until deadline;
+  assert (Clock.now_ns () >= deadline);
+  (* Deadlines in the past return immediately *)
+  Clock.sleep_until t0;
+  let c = Clock.create () in
+  Clock.sleep_until ~spin:0. (Clock.now_ns () + 2_000_000);
+  assert (Clock.time c >= 0.002);
+  assert (abs_float (Clock.now () -. float_of_int (Clock.now_ns ()) *. 1e-9) < 0.001)
+
+let () =
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Percentiles against a sorted copy of the window *)
+let () =
+  let stats = FrameStats.create ~window:50 () in
+  assert (FrameStats.frames stats = 0);
+  assert (FrameStats.p99 stats = 0. && FrameStats.mean stats = 0.);
+  let frames = Array.init 500 (fun i ->
+    if i mod 7 = 0 then 0.016 else 0.010 +. Random.float 0.010)
+  in
+  Array.iteri (fun i dt ->
+    FrameStats.add stats dt;
+    let n = min (i + 1) 50 in
+    let window = Array.sub frames (i + 1 - n) n in
+    Array.sort compare window;
+    assert (FrameStats.frames stats = n);
+    assert (FrameStats.total stats = i + 1);
+    assert (FrameStats.last stats = dt);
+    assert (FrameStats.min stats = window.(0));
+    assert (FrameStats.max stats = window.(n - 1));
+    List.iter (fun p ->
+      let k = max 0 (int_of_float (ceil (p *. float_of_int n)) - 1) in
+      assert (FrameStats.percentile stats p = window.(k))
+    ) [0.; 0.25; 0.5; 0.95; 0.99; 1.];
+    let mean = Array.fold_left (+.) 0. window /. float_of_int n in
+    assert (abs_float (FrameStats.mean stats -. mean) < 1e-9)
+  ) frames;
+  assert (FrameStats.hitches stats = 0)
+
+let () =
+  Printf.printf "\tTest 2 passed\n%!"
+
+(* Hitches and histogram *)
+let () =
+  let stats = FrameStats.create ~window:10 ~hitch_factor:2. () in
+  for _i = 1 to 10 do FrameStats.add stats 0.010 done;
+  assert (abs_float (FrameStats.fps stats -. 100.) < 1e-6);
+  FrameStats.add stats 0.019;
+  assert (not (FrameStats.hitch stats));
+  FrameStats.add stats 0.050;
+  assert (FrameStats.hitch stats);
+  FrameStats.add stats 0.011;
+  assert (not (FrameStats.hitch stats));
+  assert (FrameStats.hitches stats = 1);
+  let h = FrameStats.histogram stats ~bucket:0.005 ~buckets:4 in
+  assert (h = [|0; 0; 8; 2|]);
+  FrameStats.reset stats;
+  assert (FrameStats.frames stats = 0 && FrameStats.hitches stats = 0);
+  assert (try ignore (FrameStats.create ~window:0 ()); false
+          with FrameStats.FrameStats_exception _ -> true);
+  assert (try ignore (FrameStats.histogram stats ~bucket:0. ~buckets:4); false
+          with FrameStats.FrameStats_exception _ -> true)
+
+let () =
+  Printf.printf "\tTest 3 passed\n%!"
@@ -0,0 +1,113 @@
+open OgamlMath
+open OgamlUtils
+open Pathfinding
+
+let () = 
+  Printf.printf "Beginning flow field tests...\n%!"
+
+let w, h = 40, 30
+
+let grid = 
+  let grid = Grid.create ~width:w ~height:h in
+  for y = 0 to h - 1 do
+    for x = 0 to w - 1 do
+      if Random.float 1. < 0.2 then Grid.set_blocked grid (Vector2i.make x y) true
+    done
+  done;
+  grid
+
+let goal = Vector2i.make 20 15
+
+let () = Grid.set_blocked grid goal false
+
+let field = FlowField.create grid [goal]
+
+(* Compares the field with a full Dijkstra from the goal, 
+ * and follows it from every cell *)
+let check_field () = 
+  let expected = 
+    if Grid.is_blocked grid goal then Array.make (w * h) infinity
+    else Graph.CSR.distances (Grid.to_csr grid) (Grid.index grid goal) 
+  in
+  for y = 0 to h - 1 do
+    for x = 0 to w - 1 do
+      let v = Vector2i.make x y in
+      let d = FlowField.distance field v in
+      let e = expected.(Grid.index grid v) in
+      assert ((d = infinity && e = infinity) || abs_float (d -. e) < 1e-9);
+      if d < infinity && v <> goal then begin
+        let rec follow v acc = 
+          match FlowField.next field v with
+          | None -> assert (v = goal); acc
+          | Some u -> 
+            let cost = ref infinity in
+            Grid.iter_neighbours grid v (fun u' c -> if u' = u then cost := c);
+            assert (!cost < infinity);
+            assert (FlowField.direction field v = Vector2i.sub u v);
+            follow u (acc +. !cost)
+        in
+        assert (abs_float (follow v 0. -. d) < 1e-9)
+      end
+    done
+  done
+
+let testfield1 () = 
+  assert (FlowField.distance field goal = 0.);
+  assert (FlowField.direction field goal = Vector2i.zero);
+  check_field ()
+
+let testfield2 () = 
+  for _i = 1 to 100 do
+    let v = Vector2i.make (Random.int w) (Random.int h) in
+    Grid.set_blocked grid v (not (Grid.is_blocked grid v));
+    check_field ()
+  done;
+  Grid.set_blocked grid goal true;
+  check_field ();
+  Grid.set_blocked grid goal false;
+  check_field ()
+
+let testfield3 () = 
+  let b = Graph.CSR.Builder.create () in
+  let add v1 v2 c = Graph.CSR.Builder.add_edge b ~cost:c v1 v2 in
+  add 0 1 1.; add 1 2 1.; add 0 2 3.; add 2 3 1.; add 3 0 1.; add 4 0 1.;
+  let f = FlowField.CSR.create (Graph.CSR.Builder.freeze b) [2] in
+  assert (FlowField.CSR.distance f 0 = 2.);
+  assert (FlowField.CSR.next f 0 = Some 1);
+  assert (FlowField.CSR.distance f 3 = 3.);
+  assert (FlowField.CSR.distance f 4 = 3.);
+  assert (FlowField.CSR.next f 2 = None);
+  (try ignore (FlowField.CSR.create (Graph.CSR.Builder.freeze b) [5]); assert false
+   with FlowField.FlowField_exception _ -> ());
+  (try ignore (FlowField.create grid [Vector2i.make w 0]); assert false
+   with FlowField.FlowField_exception _ -> ())
+
+(* Released fields are not updated anymore *)
+let testfield4 () = 
+  let grid = Grid.create ~width:10 ~height:1 in
+  let calls = ref 0 in
+  let l = Grid.on_change grid (fun _ _ -> incr calls) in
+  let kept = FlowField.create grid [Vector2i.make 0 0] in
+  let released = FlowField.create grid [Vector2i.make 0 0] in
+  assert (FlowField.distance released (Vector2i.make 9 0) = 9.);
+  FlowField.release released;
+  FlowField.release released;
+  Grid.set_blocked grid (Vector2i.make 5 0) true;
+  assert (!calls = 1);
+  assert (FlowField.distance kept (Vector2i.make 9 0) = infinity);
+  assert (FlowField.distance released (Vector2i.make 9 0) = 9.);
+  Grid.remove_listener grid l;
+  Grid.set_blocked grid (Vector2i.make 5 0) false;
+  assert (!calls = 1);
+  assert (FlowField.distance kept (Vector2i.make 9 0) = 9.);
+  FlowField.release kept
+
+let () = 
+  testfield1 ();
+  Printf.printf "\tTest 1 passed\n%!";
+  testfield2 ();
+  Printf.printf "\tTest 2 passed\n%!";
+  testfield3 ();
+  Printf.printf "\tTest 3 passed\n%!";
+  testfield4 ();
+  Printf.printf "\tTest 4 passed\n%!"
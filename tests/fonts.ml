@@ -0,0 +1,182 @@
+open OgamlGraphics
+open OgamlMath
+
+let () =
+  Printf.printf "Beginning font tests...\n%!"
+
+let settings = OgamlCore.ContextSettings.create ()
+
+let window = Window.create ~width:100 ~height:100 ~settings ~title:"" ()
+
+let layers font =
+  (Texture.Texture2DArray.size (Font.texture (module Window) window font)).Vector3i.z
+
+let test_font1 () =
+  let font = Font.load "examples/font1.ttf" in
+  let a = Font.sdf_glyph font (`Char 'A') in
+  let a' = Font.sdf_glyph font (`Char 'A') in
+  assert (a == a');
+  let rect = Font.Glyph.rect a in
+  let box = Font.Glyph.rect (Font.glyph font (`Char 'A') Font.sdf_size false) in
+  (* The field extends around the outline *)
+  assert (rect.FloatRect.width >= box.FloatRect.width +. 2. *. Font.sdf_range -. 1.);
+  assert (rect.FloatRect.height >= box.FloatRect.height +. 2. *. Font.sdf_range -. 1.);
+  assert (abs_float (Font.Glyph.advance a
+                     -. Font.Glyph.advance (Font.glyph font (`Char 'A') Font.sdf_size false)) < 1e-3);
+  let space = Font.sdf_glyph font (`Char ' ') in
+  assert (Font.Glyph.advance space > 0.);
+  assert ((Font.Glyph.rect space).FloatRect.width = 0.)
+
+let test_font2 () =
+  (* Distance field texts of any size share a single layer *)
+  let font = Font.load "examples/font1.ttf" in
+  List.iter (fun size ->
+    let text = Text.create ~text:"Hello world" ~position:Vector2f.zero ~font ~size ~sdf:true () in
+    Text.draw (module Window) ~target:window ~text ()
+  ) [8; 13; 24; 57; 130];
+  assert (layers font = 1);
+  let text = Text.create ~text:"Hello" ~position:Vector2f.zero ~font ~size:20
+    ~outline:(`RGB Color.RGB.black, 2.) ()
+  in
+  Text.draw (module Window) ~target:window ~text ();
+  assert (layers font = 1);
+  ignore (Font.ascent font 71);
+  ignore (Font.spacing font 72);
+  assert (layers font = 1)
+
+let test_font3 () =
+  (* Advances scale linearly with the size *)
+  let font = Font.load "examples/font1.ttf" in
+  let advance size =
+    (Text.advance (Text.create ~text:"Wave" ~position:Vector2f.zero ~font ~size ~sdf:true ())).Vector2f.x
+  in
+  assert (abs_float (advance 96 -. 2. *. advance 48) < 1e-3);
+  assert (abs_float (advance 48 -. 4. *. advance 12) < 1e-3)
+
+let font = Font.load "examples/font1.ttf"
+
+let layout ?width ?alignment text =
+  TextLayout.create ~font ~size:20 ?width ?alignment ~text ()
+
+let test_layout1 () =
+  (* Quads skip spaces and newlines, and keep the indices of their chars *)
+  let l = layout "ab c\nd\xc3\xa9" in
+  assert (TextLayout.glyphs l = 5);
+  assert (TextLayout.indices l = [|0; 1; 3; 5; 6|]);
+  assert (TextLayout.lines l = 2);
+  assert (Array.length (TextLayout.quads l) = 40);
+  let q = TextLayout.quads l in
+  assert (q.(8 * 3 + 1) > q.(8 * 2 + 1));
+  assert ((TextLayout.advance l).Vector2f.y = Font.spacing font 20);
+  assert (TextLayout.glyphs (layout "") = 0);
+  assert (TextLayout.lines (layout "") = 1);
+  (try ignore (layout "\xc3"); assert false
+   with OgamlUtils.UTF8String.UTF8_error _ -> ())
+
+let test_layout2 () =
+  (* Word wrapping *)
+  let text = "the quick brown fox jumps over the lazy dog" in
+  let one = layout text in
+  assert (TextLayout.lines one = 1);
+  let w = (TextLayout.size one).Vector2f.x in
+  let l = layout ~width:(w /. 3.) text in
+  assert (TextLayout.lines l >= 3);
+  assert ((TextLayout.size l).Vector2f.x <= w /. 3.);
+  assert (TextLayout.glyphs l = TextLayout.glyphs one);
+  (* A word longer than the width is broken *)
+  let l = layout ~width:30. "abcdefghijklmnop" in
+  assert (TextLayout.lines l > 1);
+  (try ignore (layout ~width:0. text); assert false
+   with TextLayout.TextLayout_error _ -> ())
+
+let test_layout3 () =
+  (* Alignment *)
+  let text = "a b c d e f g h i j k l\nm" in
+  let left  = layout ~width:100. text in
+  let right = layout ~width:100. ~alignment:TextLayout.Right text in
+  let center = layout ~width:100. ~alignment:TextLayout.Center text in
+  let justify = layout ~width:100. ~alignment:TextLayout.Justify text in
+  let last l = (TextLayout.quads l).(8 * (TextLayout.glyphs l - 1)) in
+  let first l = (TextLayout.quads l).(0) in
+  assert (first right > first center && first center > first left);
+  assert (first justify = first left);
+  (* Justified lines end at the width, the last line of a paragraph is not justified *)
+  assert (last justify = last left);
+  assert (abs_float ((TextLayout.size justify).Vector2f.x -. 100.) < 1.);
+  assert (TextLayout.lines justify = TextLayout.lines left)
+
+let test_layout4 () =
+  (* Cache *)
+  TextLayout.clear_cache ();
+  ignore (layout "cached");
+  ignore (layout "cached");
+  assert (TextLayout.cached () = 1);
+  TextLayout.set_cache_capacity 2;
+  ignore (layout "a");
+  ignore (layout "b");
+  assert (TextLayout.cached () = 2);
+  TextLayout.set_cache_capacity 0;
+  assert (TextLayout.cached () = 0);
+  ignore (layout "c");
+  assert (TextLayout.cached () = 0);
+  TextLayout.set_cache_capacity 256
+
+let test_font4 () =
+  (* Kernings do not depend on the order in which the chars become known *)
+  let f1 = Font.load ~charset:`ASCII "examples/font1.ttf" in
+  let f2 = Font.load "examples/font1.ttf" in
+  let pairs = ["AV"; "To"; "Wa"; "ab"; "VA"; "LT"; "yo"] in
+  List.iter (fun p ->
+    let c1 = `Char p.[0] and c2 = `Char p.[1] in
+    assert (Font.kerning f1 c1 c2 24 = Font.kerning f2 c1 c2 24);
+    assert (abs_float (Font.kerning f1 c1 c2 48 -. 2. *. Font.kerning f1 c1 c2 24) < 1e-3);
+    assert (Font.sdf_kerning f2 c1 c2 = Font.kerning f2 c1 c2 Font.sdf_size)
+  ) pairs;
+  (* Preloaded glyphs are returned as is *)
+  Font.preload f1 20 `Latin;
+  let a = Font.glyph f1 (`Char 'a') 20 false in
+  assert (Font.glyph f1 (`Char 'a') 20 false == a);
+  assert (Font.glyph f1 (`Code 0xe9) 20 false == Font.glyph f1 (`Code 0xe9) 20 false);
+  Font.preload_sdf f1 (`Codes [`Char 'x'; `Code 0x20ac]);
+  assert (Font.sdf_glyph f1 (`Code 0x20ac) == Font.sdf_glyph f1 (`Code 0x20ac))
+
+let test_font5 () =
+  (* Glyphs rasterized by a pool are the ones rasterized on demand *)
+  let pool = OgamlUtils.Scheduler.create ~workers:2 () in
+  let f1 = Font.load "examples/font1.ttf" in
+  let f2 = Font.load "examples/font1.ttf" in
+  Font.prefetch f1 ~pool 30 `ASCII;
+  Font.prefetch_sdf f1 ~pool (`Codes [`Char 'g']);
+  ignore (Font.texture (module Window) window f1);
+  Font.preload f2 30 `ASCII;
+  List.iter (fun c ->
+    let g1 = Font.glyph f1 (`Char c) 30 false in
+    let g2 = Font.glyph f2 (`Char c) 30 false in
+    assert (Font.Glyph.advance g1 = Font.Glyph.advance g2);
+    assert (Font.Glyph.rect g1 = Font.Glyph.rect g2)
+  ) ['a'; 'W'; '&'; ' '];
+  assert (Font.Glyph.rect (Font.sdf_glyph f1 (`Char 'g'))
+          = Font.Glyph.rect (Font.sdf_glyph f2 (`Char 'g')));
+  Font.preload f1 ~pool 12 `Latin;
+  assert (layers f1 = 3);
+  OgamlUtils.Scheduler.shutdown pool
+
+let () =
+  test_font1 ();
+  Printf.printf "\tTest 1 passed\n%!";
+  test_font2 ();
+  Printf.printf "\tTest 2 passed\n%!";
+  test_font3 ();
+  Printf.printf "\tTest 3 passed\n%!";
+  test_font4 ();
+  Printf.printf "\tTest 4 passed\n%!";
+  test_font5 ();
+  Printf.printf "\tTest 5 passed\n%!";
+  test_layout1 ();
+  Printf.printf "\tTest 6 passed\n%!";
+  test_layout2 ();
+  Printf.printf "\tTest 7 passed\n%!";
+  test_layout3 ();
+  Printf.printf "\tTest 8 passed\n%!";
+  test_layout4 ();
+  Printf.printf "\tTest 9 passed\n%!"
@@ -0,0 +1,71 @@
+open OgamlMath
+
+let () = 
+  Printf.printf "Beginning frustum tests...\n%!"
+
+let view = 
+  Matrix3D.look_at ~from:Vector3f.zero ~at:(Vector3f.prop (-1.) Vector3f.unit_z) ~up:Vector3f.unit_y
+
+let projection = 
+  Matrix3D.perspective ~near:1. ~far:100. ~width:1. ~height:1. ~fov:(Constants.pi /. 2.)
+
+let frustum = Frustum.create ~view ~projection
+
+let testfrustum1 () = 
+  assert (Frustum.contains frustum (Vector3f.make 0. 0. (-10.)));
+  assert (not (Frustum.contains frustum (Vector3f.make 0. 0. 10.)));
+  assert (not (Frustum.contains frustum (Vector3f.make 0. 0. (-0.5))));
+  assert (not (Frustum.contains frustum (Vector3f.make 0. 0. (-101.))));
+  assert (not (Frustum.contains frustum (Vector3f.make 20. 0. (-10.))));
+  assert (Frustum.contains frustum (Vector3f.make 9. 9. (-10.)))
+
+let testfrustum2 () = 
+  let open Frustum in
+  assert (classify_sphere frustum (Vector3f.make 0. 0. (-10.)) 1. = Inside);
+  assert (classify_sphere frustum (Vector3f.make 10. 0. (-10.)) 1. = Intersect);
+  assert (classify_sphere frustum (Vector3f.make 20. 0. (-10.)) 1. = Outside);
+  let box p s = FloatBox.create p s in
+  assert (classify_box frustum (box (Vector3f.make (-1.) (-1.) (-11.)) (Vector3f.make 2. 2. 2.)) = Inside);
+  assert (classify_box frustum (box (Vector3f.make 9. (-1.) (-11.)) (Vector3f.make 2. 2. 2.)) = Intersect);
+  assert (classify_box frustum (box (Vector3f.make (-1.) (-1.) 5.) (Vector3f.make 2. 2. 2.)) = Outside)
+
+(* The native and OCaml batch paths must agree with each other 
+ * and with the individual tests *)
+let testfrustum3 () = 
+  let n = 10_003 in
+  let boxes = Frustum.Boxes.create n in
+  let spheres = Frustum.Spheres.create n in
+  let rnd () = Random.float 200. -. 100. in
+  for i = 0 to n - 1 do
+    let p = Vector3f.make (rnd ()) (rnd ()) (rnd ()) in
+    let s = Vector3f.make (Random.float 10.) (Random.float 10.) (Random.float 10.) in
+    Frustum.Boxes.set boxes i (FloatBox.create p s);
+    Frustum.Spheres.set spheres i p (Random.float 10.)
+  done;
+  let vb1 = Frustum.cull_boxes frustum boxes in
+  let vb2 = Frustum.cull_boxes ~native:false frustum boxes in
+  let vs1 = Frustum.cull_spheres frustum spheres in
+  let vs2 = Frustum.cull_spheres ~native:false frustum spheres in
+  for i = 0 to n - 1 do
+    assert (Frustum.Visibility.get vb1 i = Frustum.Visibility.get vb2 i);
+    assert (Frustum.Visibility.get vs1 i = Frustum.Visibility.get vs2 i);
+    let (c, r) = Frustum.Spheres.get spheres i in
+    assert (Frustum.Visibility.get vs1 i = Frustum.intersects_sphere frustum c r);
+    if Frustum.Visibility.get vb1 i then 
+      assert (Frustum.intersects_box frustum (Frustum.Boxes.get boxes i))
+  done;
+  assert (Frustum.Visibility.count vb1 = Frustum.Visibility.count vb2);
+  assert (Frustum.Visibility.count vb1 > 0);
+  assert (Frustum.Visibility.count vb1 < n);
+  let count = ref 0 in
+  Frustum.Visibility.iter vs1 (fun i -> 
+    assert (Frustum.Visibility.get vs1 i); incr count);
+  assert (!count = Frustum.Visibility.count vs1)
+
+let () = 
+  testfrustum1 ();
+  Printf.printf "\tTest 1 passed\n%!";
+  testfrustum2 ();
+  Printf.printf "\tTest 2 passed\n%!";
+  testfrustum3 ();
+  Printf.printf "\tTest 3 passed\n%!"
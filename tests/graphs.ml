@@ -148,6 +148,35 @@ let testgraph6 () =
   assert (assert_dfs cycle 4 [4;5;6;1;2;3]);
   assert (assert_bfs cycle 4 [4;5;1;6;2;3])
 
+(* Frozen graphs must behave as the graphs they are built from *)
+let testgraph7 () = 
+  List.iter (fun g -> 
+    let (csr, id, vertex) = G.to_csr g in
+    assert (Graph.CSR.vertices csr >= G.vertices g);
+    assert (Graph.CSR.edges csr = G.edges g);
+    G.iter_vertices g (fun s -> 
+      let l1 = ref [] and l2 = ref [] in
+      G.dfs g s (fun v -> l1 := v :: !l1);
+      Graph.CSR.dfs csr (id s) (fun v -> l2 := vertex v :: !l2);
+      assert (!l1 = !l2);
+      l1 := []; l2 := [];
+      G.bfs g s (fun v -> l1 := v :: !l1);
+      Graph.CSR.bfs csr (id s) (fun v -> l2 := vertex v :: !l2);
+      assert (!l1 = !l2);
+      let dists = Graph.CSR.distances csr (id s) in
+      G.iter_vertices g (fun t -> 
+        match G.dijkstra g s t, Graph.CSR.dijkstra csr (id s) (id t) with
+        | None, None -> assert (dists.(id t) = infinity)
+        | Some (d, _), Some (d', p) -> 
+          assert (d = d' && d = dists.(id t));
+          assert (List.hd p = id s)
+        | _ -> assert false))
+  ) [graph1; graph2; graph4; cycle; biggraph];
+  let (csr, id, vertex) = G.to_csr biggraph in
+  match Graph.CSR.astar csr (id 1) (id 17) (fun _ -> 0.) with
+  | Some (_, p) -> assert (List.map vertex p = [1;4;11;13;15;17])
+  | None -> assert false
+
 let () = 
   testgraph1 ();
   Printf.printf "\tTest 1 passed\n%!";
@@ -161,5 +190,5 @@ let () =
   Printf.printf "\tTest 5 passed\n%!";
   testgraph6 ();
   Printf.printf "\tTest 6 passed\n%!";
-
-
+  testgraph7 ();
+  Printf.printf "\tTest 7 passed\n%!";
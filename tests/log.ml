@@ -0,0 +1,102 @@
+open OgamlUtils
+
+let () =
+  Printf.printf "Beginning log tests...\n%!"
+
+let with_file f =
+  let name = Filename.temp_file "ogaml" ".log" in
+  let chan = open_out name in
+  f chan;
+  close_out chan;
+  let input = open_in name in
+  let lines = ref [] in
+  (try while true do lines := input_line input :: !lines done
+   with End_of_file -> ());
+  close_in input;
+  Sys.remove name;
+  List.rev !lines
+
+let ends_with s suffix =
+  let n = String.length s and k = String.length suffix in
+  n >= k && String.sub s (n - k) k = suffix
+
+let starts_with s prefix =
+  let k = String.length prefix in
+  String.length s >= k && String.sub s 0 k = prefix
+
+(* Text of a line after the timestamp *)
+let rec message s i =
+  if String.sub s i 3 = " : " then String.sub s (i + 3) (String.length s - i - 3)
+  else message s (i + 1)
+
+let message s = message s 0
+
+(* Synchronous logs, levels and modules *)
+let () =
+  let lines = with_file (fun chan ->
+    let log = Log.create ~output:chan ~color:false ~debug:false () in
+    Log.debug log "hidden %i" 1;
+    Log.info log "shown %i" 2;
+    assert (not (Log.enabled log Log.Debug));
+    let physics = Log.sub log "physics" in
+    Log.set_level physics Log.Error;
+    Log.warn physics "hidden";
+    Log.error physics "collision %s" "failed";
+    Log.set_level log Log.Debug;
+    Log.debug log "shown %.1f" 3.;
+    Log.error (Log.sub physics "broad") "%s" "nested")
+  in
+  match lines with
+  | [l1; l2; l3; l4] ->
+    assert (starts_with l1 "[INFO] " && ends_with l1 " : shown 2");
+    assert (starts_with l2 "[ERROR] " && ends_with l2 " : [physics] collision failed");
+    assert (starts_with l3 "[DEBUG] " && ends_with l3 " : shown 3.0");
+    assert (starts_with l4 "[ERROR] " && ends_with l4 " : [physics.broad] nested")
+  | _ -> assert false
+
+let () =
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Asynchronous logs *)
+let () =
+  let lines = with_file (fun chan ->
+    let log = Log.create ~output:chan ~color:false ~async:true () in
+    for i = 1 to 1000 do Log.info log "message %i" i done;
+    Log.flush log)
+  in
+  assert (List.length lines = 1000);
+  List.iteri (fun i l -> assert (ends_with l (Printf.sprintf " : message %i" (i + 1)))) lines;
+  (* Full buffers drop messages, fatal messages are written immediately. The
+   * background thread may write some messages before the buffer is full. *)
+  let lines = with_file (fun chan ->
+    let log = Log.create ~output:chan ~color:false ~async:true ~capacity:10 () in
+    for i = 1 to 20 do Log.info log "message %i" i done;
+    Log.fatal log "fatal")
+  in
+  let written = ref 0 and dropped = ref 0 and fatal = ref 0 in
+  List.iter (fun l ->
+    match message l with
+    | "fatal" -> incr fatal
+    | m when starts_with m "message " -> incr written
+    | m -> Scanf.sscanf m "%d messages dropped" (fun d -> dropped := !dropped + d)
+  ) lines;
+  assert (!fatal = 1 && !written >= 10 && !written + !dropped = 20)
+
+let () =
+  Printf.printf "\tTest 2 passed\n%!"
+
+(* Rate limiting *)
+let () =
+  let lines = with_file (fun chan ->
+    let log = Log.create ~output:chan ~color:false ~rate:5 () in
+    for i = 1 to 20 do Log.warn log "message %i" i done;
+    assert (Log.dropped log = 15);
+    Log.fatal log "fatal";
+    assert (Log.dropped log = 0))
+  in
+  assert (List.length lines = 7);
+  assert (ends_with (List.nth lines 5) " : 15 messages dropped");
+  assert (ends_with (List.nth lines 6) " : fatal")
+
+let () =
+  Printf.printf "\tTest 3 passed\n%!"
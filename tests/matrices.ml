@@ -0,0 +1,123 @@
+open OgamlMath
+
+let () =
+  Printf.printf "Beginning matrix tests...\n%!"
+
+let close_to a b = abs_float (a -. b) <= 1e-4 *. (1. +. abs_float a +. abs_float b)
+
+let random_vector () =
+  Vector3f.make (Random.float 4. -. 2.) (Random.float 4. -. 2.) (Random.float 4. -. 2.)
+
+(* Random matrices, with a projective part *)
+let random_matrix () =
+  let axis = Vector3f.add (random_vector ()) (Vector3f.make 0.1 0. 0.) in
+  Matrix3D.(product
+    (perspective ~near:0.5 ~far:100. ~width:4. ~height:3. ~fov:(0.5 +. Random.float 1.))
+    (product (translation (random_vector ()))
+    (product (rotation axis (Random.float 6.))
+             (scaling (Vector3f.add (random_vector ()) (Vector3f.make 3. 3. 3.))))))
+
+(* Column-major product computed from the coefficients *)
+let reference_product a b =
+  let a = Matrix3D.to_bigarray a and b = Matrix3D.to_bigarray b in
+  Array.init 16 (fun k ->
+    let r = k mod 4 and c = k / 4 in
+    let s = ref 0. in
+    for i = 0 to 3 do s := !s +. a.{r + 4 * i} *. b.{i + 4 * c} done;
+    !s)
+
+let assert_matrix m expected =
+  let m = Matrix3D.to_bigarray m in
+  Array.iteri (fun k e -> assert (close_to m.{k} e)) expected
+
+let assert_vector (v : Vector3f.t) buf i =
+  assert (close_to buf.{3 * i} v.Vector3f.x);
+  assert (close_to buf.{3 * i + 1} v.Vector3f.y);
+  assert (close_to buf.{3 * i + 2} v.Vector3f.z)
+
+(* Destination-passing operations match their definitions, even when the
+ * destination is an operand *)
+let test_into () =
+  for _i = 1 to 100 do
+    let a = random_matrix () and b = random_matrix () in
+    let v = random_vector () and t = Random.float 6. in
+    let dst = Matrix3D.zero () in
+    let expected = reference_product a b in
+    Matrix3D.product_into a b dst;
+    assert_matrix dst expected;
+    assert_matrix (Matrix3D.product a b) expected;
+    let a' = Matrix3D.copy a in
+    Matrix3D.product_into a' b a';
+    assert_matrix a' expected;
+    let b' = Matrix3D.copy b in
+    Matrix3D.product_into a b' b';
+    assert_matrix b' expected;
+    let a' = Matrix3D.copy a in
+    Matrix3D.product_into a' a' a';
+    assert_matrix a' (reference_product a a);
+    let check into alloc base =
+      let expected = reference_product base a in
+      into a dst;
+      assert_matrix dst expected;
+      assert_matrix (alloc a) expected;
+      let a' = Matrix3D.copy a in
+      into a' a';
+      assert_matrix a' expected
+    in
+    check (Matrix3D.translate_into v) (Matrix3D.translate v) (Matrix3D.translation v);
+    check (Matrix3D.scale_into v) (Matrix3D.scale v) (Matrix3D.scaling v);
+    check (Matrix3D.rotate_into v t) (Matrix3D.rotate v t) (Matrix3D.rotation v t);
+    let buf = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout 6 in
+    Matrix3D.times_into a v buf 0;
+    Matrix3D.times_into a ~perspective:false v buf 1;
+    assert_vector (Matrix3D.times a v) buf 0;
+    assert_vector (Matrix3D.times a ~perspective:false v) buf 1
+  done;
+  (try Matrix3D.rotate_into Vector3f.zero 1. (Matrix3D.identity ()) (Matrix3D.zero ());
+       assert false
+   with Matrix3D.Matrix3D_exception _ -> ())
+
+let () =
+  test_into ();
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Batched kernels match the scalar transformations, including on lengths
+ * that are not a multiple of the vector width *)
+let test_batch () =
+  List.iter (fun n ->
+    let m = random_matrix () in
+    let points = Array.init n (fun _ -> random_vector ()) in
+    let src = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (3 * n) in
+    Array.iteri (fun i v ->
+      src.{3 * i} <- v.Vector3f.x;
+      src.{3 * i + 1} <- v.Vector3f.y;
+      src.{3 * i + 2} <- v.Vector3f.z) points;
+    (* Use the rounded coordinates as the scalar inputs *)
+    let points = Array.init n (fun i ->
+      Vector3f.make src.{3 * i} src.{3 * i + 1} src.{3 * i + 2}) in
+    let dst = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (3 * n + 3) in
+    dst.{3 * n} <- 42.;
+    Matrix3D.transform_points m src dst;
+    Array.iteri (fun i v -> assert_vector (Matrix3D.times m v) dst i) points;
+    assert (dst.{3 * n} = 42.);
+    Matrix3D.transform_points m ~perspective:false src dst;
+    Array.iteri (fun i v -> assert_vector (Matrix3D.times m ~perspective:false v) dst i) points;
+    Matrix3D.transform_normals m src dst;
+    Array.iteri (fun i v ->
+      let t = Matrix3D.times m ~perspective:false v in
+      if Vector3f.norm t > 1e-3 then assert_vector (Vector3f.normalize t) dst i) points;
+    assert (dst.{3 * n} = 42.);
+    (* In place *)
+    Matrix3D.transform_points m src src;
+    Array.iteri (fun i v -> assert_vector (Matrix3D.times m v) src i) points
+  ) [0; 1; 2; 3; 4; 5; 7; 9; 17; 1023];
+  let buf = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout 7 in
+  (try Matrix3D.transform_points (Matrix3D.identity ()) buf buf; assert false
+   with Matrix3D.Matrix3D_exception _ -> ());
+  (try Matrix3D.transform_normals (Matrix3D.identity ()) (Bigarray.Array1.sub buf 0 6)
+         (Bigarray.Array1.sub buf 0 3); assert false
+   with Matrix3D.Matrix3D_exception _ -> ())
+
+let () =
+  test_batch ();
+  Printf.printf "\tTest 2 passed\n%!"
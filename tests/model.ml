@@ -0,0 +1,106 @@
+open OgamlGraphics
+open OgamlMath
+
+let () =
+  Printf.printf "Beginning model tests...\n%!"
+
+(* A square [0;1]x[0;1] made of n*n quads, lifted by height *)
+let surface n height =
+  let vertex i j =
+    let x = float_of_int i /. float_of_int n and y = float_of_int j /. float_of_int n in
+    Model.Vertex.create ~position:(Vector3f.make x y (height x y)) ()
+  in
+  let m = ref Model.empty in
+  for i = 0 to n - 1 do
+    for j = 0 to n - 1 do
+      let (f1, f2) = Model.Face.quad (vertex i j) (vertex (i + 1) j)
+                                     (vertex (i + 1) (j + 1)) (vertex i (j + 1)) in
+      m := Model.add_face (Model.add_face !m f1) f2
+    done
+  done;
+  !m
+
+let faces m = Model.fold m (fun n _ -> n + 1) 0
+
+let flat = surface 8 (fun _ _ -> 0.)
+
+let bumpy = surface 16 (fun x y -> 0.2 *. sin (6. *. x) *. cos (4. *. y))
+
+(* Area of the projection of a model on the xy plane, and its bounds *)
+let projection m =
+  Model.fold m (fun (area, x0, y0, x1, y1) f ->
+    let (a, b, c) = Model.Face.vertices f in
+    let a = Model.Vertex.position a and b = Model.Vertex.position b
+    and c = Model.Vertex.position c in
+    let cross = Vector3f.((b.x -. a.x) *. (c.y -. a.y) -. (c.x -. a.x) *. (b.y -. a.y)) in
+    let xs = Vector3f.([a.x; b.x; c.x]) and ys = Vector3f.([a.y; b.y; c.y]) in
+    (area +. abs_float cross /. 2.,
+     List.fold_left min x0 xs, List.fold_left min y0 ys,
+     List.fold_left max x1 xs, List.fold_left max y1 ys)
+  ) (0., infinity, infinity, neg_infinity, neg_infinity)
+
+let test_decimate () =
+  let n = faces bumpy in
+  assert (n = 512);
+  (* The number of faces follows the ratio *)
+  List.iter (fun r ->
+    let (m, _) = Model.decimate bumpy r in
+    let target = int_of_float (r *. float_of_int n) in
+    assert (faces m <= target && faces m >= target - 2)
+  ) [0.75; 0.5; 0.25; 0.1];
+  let (m, e) = Model.decimate bumpy 1. in
+  assert (faces m = n && e = 0.);
+  (* Collapses on a plane are free, and do not move its border nor fold it *)
+  let (m, e) = Model.decimate flat 0.1 in
+  assert (faces m < faces flat / 4);
+  assert (e < 1e-6);
+  let (area, x0, y0, x1, y1) = projection m in
+  assert (abs_float (area -. 1.) < 1e-6);
+  assert (x0 = 0. && y0 = 0. && x1 = 1. && y1 = 1.);
+  (* The border of a surface is kept *)
+  let (m, _) = Model.decimate bumpy 0.25 in
+  let (area, x0, y0, x1, y1) = projection m in
+  assert (abs_float (area -. 1.) < 1e-3);
+  assert (x0 = 0. && y0 = 0. && x1 = 1. && y1 = 1.);
+  (try ignore (Model.decimate bumpy 1.5); assert false
+   with Model.Error _ -> ());
+  (try ignore (Model.decimate bumpy (-0.1)); assert false
+   with Model.Error _ -> ())
+
+let () =
+  test_decimate ();
+  Printf.printf "\tTest 1 passed\n%!"
+
+let test_lod () =
+  let lod = Model.LOD.create bumpy in
+  assert (Model.LOD.levels lod = 4);
+  assert (Model.LOD.faces lod 0 = 512);
+  for i = 1 to 3 do
+    assert (Model.LOD.faces lod i < Model.LOD.faces lod (i - 1));
+    assert (Model.LOD.faces lod i = faces (Model.LOD.model lod i));
+    assert (Model.LOD.error lod i >= Model.LOD.error lod (i - 1))
+  done;
+  assert (Model.LOD.error lod 0 = 0.);
+  assert (Model.LOD.error lod 3 > 0.);
+  (* Farther models use coarser levels *)
+  let projection = Matrix3D.perspective ~near:0.1 ~far:1000. ~width:800. ~height:600.
+    ~fov:(Constants.pi /. 4.) in
+  let select d =
+    let view = Matrix3D.look_at ~from:(Vector3f.make 0.5 0.5 d)
+      ~at:(Vector3f.make 0.5 0.5 0.) ~up:Vector3f.unit_y in
+    Model.LOD.select lod ~view ~projection ~height:600. ()
+  in
+  let levels = List.map select [1.; 2.; 5.; 10.; 50.; 100.; 500.] in
+  ignore (List.fold_left (fun l l' -> assert (l' >= l); l') 0 levels);
+  assert (List.hd levels = 0);
+  assert (select 500. = 3);
+  (try ignore (Model.LOD.create ~ratios:[1.; 1.2] bumpy); assert false
+   with Model.Error _ -> ());
+  (try ignore (Model.LOD.create ~ratios:[] bumpy); assert false
+   with Model.Error _ -> ());
+  (try ignore (Model.LOD.model lod 4); assert false
+   with Model.Error _ -> ())
+
+let () =
+  test_lod ();
+  Printf.printf "\tTest 2 passed\n%!"
@@ -0,0 +1,97 @@
+open OgamlMath
+open OgamlUtils
+open Noise
+
+let () =
+  Printf.printf "Beginning noise tests...\n%!"
+
+let rng () = Random.State.make [|42|]
+
+let points = Array.init 10000 (fun _ ->
+  Vector2f.make (Random.float 200. -. 100.) (Random.float 200. -. 100.))
+
+(* Ranges and determinism of the base noises *)
+let () =
+  let s1 = Simplex2D.create_with_seed (rng ()) and s2 = Simplex2D.create_with_seed (rng ()) in
+  let o = OpenSimplex2D.create_with_seed (rng ()) in
+  let s3 = Simplex3D.create_with_seed (rng ()) in
+  Array.iter (fun p ->
+    let v = Simplex2D.get s1 p in
+    assert (v = Simplex2D.get s2 p);
+    assert (v >= -1. && v <= 1.);
+    assert (v = Simplex2D.get_xy s1 p.Vector2f.x p.Vector2f.y);
+    let v = OpenSimplex2D.get o p in
+    assert (v >= -1.05 && v <= 1.05);
+    let v = Simplex3D.get s3 (Vector3f.make p.Vector2f.x p.Vector2f.y (p.Vector2f.x *. 0.3)) in
+    assert (v >= -1.05 && v <= 1.05)
+  ) points;
+  (* Noises vanish on the lattice *)
+  assert (Simplex2D.get s1 Vector2f.zero = 0.);
+  assert (OpenSimplex2D.get o Vector2f.zero = 0.)
+
+let () =
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Fractal noises *)
+let fractals = [
+  Fractal.create ~octaves:1 (Fractal.Perlin (Perlin2D.create_with_seed (rng ())));
+  Fractal.create (Fractal.Simplex (Simplex2D.create_with_seed (rng ())));
+  Fractal.create ~ridged:true ~frequency:0.3 (Fractal.OpenSimplex (OpenSimplex2D.create_with_seed (rng ())));
+  Fractal.create ~octaves:3 ~warp:0.7 ~lacunarity:1.9 (Fractal.Simplex (Simplex2D.create_with_seed (rng ())));
+]
+
+let () =
+  (* A single octave is the base noise *)
+  let p = Perlin2D.create_with_seed (rng ()) in
+  Array.iter (fun v ->
+    assert (Fractal.get (List.hd fractals) v = Perlin2D.get p v)) points;
+  List.iter (fun f ->
+    Array.iter (fun v ->
+      let n = Fractal.get f v in
+      assert (n >= -1.05 && n <= 1.05)) points
+  ) fractals
+
+let () =
+  Printf.printf "\tTest 2 passed\n%!"
+
+(* The native and OCaml fills must return the same bits, and filling by
+ * bands must be the same as filling at once *)
+let () =
+  let w, h = 203, 61 in
+  let field () =
+    let a = Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (w * h) in
+    Bigarray.Array1.fill a nan;
+    a
+  in
+  let origin = Vector2f.make (-13.7) 4.2 and step = 0.037 in
+  List.iter (fun f ->
+    let a = field () and b = field () and c = field () in
+    let all = IntRect.create Vector2i.zero (Vector2i.make w h) in
+    Fractal.fill f a ~stride:w ~origin ~step all;
+    Fractal.fill ~native:false f b ~stride:w ~origin ~step all;
+    Fractal.fill f c ~stride:w ~origin ~step (IntRect.create Vector2i.zero (Vector2i.make w 20));
+    Fractal.fill f c ~stride:w ~origin ~step (IntRect.create (Vector2i.make 0 20) (Vector2i.make 77 41));
+    Fractal.fill f c ~stride:w ~origin ~step (IntRect.create (Vector2i.make 77 20) (Vector2i.make (w - 77) 41));
+    for j = 0 to h - 1 do
+      for i = 0 to w - 1 do
+        let k = j * w + i in
+        assert (Int32.bits_of_float a.{k} = Int32.bits_of_float b.{k});
+        assert (Int32.bits_of_float a.{k} = Int32.bits_of_float c.{k});
+        let v = Fractal.get f (Vector2f.make (-13.7 +. float i *. step) (4.2 +. float j *. step)) in
+        assert (Int32.bits_of_float a.{k} = Int32.bits_of_float v)
+      done
+    done
+  ) fractals;
+  let f = List.hd fractals in
+  let a = field () in
+  List.iter (fun r ->
+    try
+      Fractal.fill f a ~stride:w ~origin ~step r;
+      assert false
+    with Noise_exception _ -> ()
+  ) [IntRect.create (Vector2i.make (-1) 0) (Vector2i.make 10 10);
+     IntRect.create (Vector2i.make 200 0) (Vector2i.make 10 10);
+     IntRect.create (Vector2i.make 0 60) (Vector2i.make 10 2)]
+
+let () =
+  Printf.printf "\tTest 3 passed\n%!"
@@ -0,0 +1,114 @@
+open OgamlMath
+open OgamlUtils
+open Pathfinding
+
+let () = 
+  Printf.printf "Beginning pathfinding tests...\n%!"
+
+module G = Graph.Make (struct
+
+  type t = int
+
+  let compare (i : int) (j : int) = compare i j
+
+end)
+
+let random_grid w h p = 
+  let grid = Grid.create ~width:w ~height:h in
+  for y = 0 to h - 1 do
+    for x = 0 to w - 1 do
+      if Random.float 1. < p then Grid.set_blocked grid (Vector2i.make x y) true
+    done
+  done;
+  grid
+
+let to_graph grid = 
+  let g = ref G.empty in
+  for y = 0 to Grid.height grid - 1 do
+    for x = 0 to Grid.width grid - 1 do
+      let v = Vector2i.make x y in
+      g := G.add_vertex !g (Grid.index grid v);
+      Grid.iter_neighbours grid v (fun u c -> 
+        g := G.add_edge !g ~cost:c (Grid.index grid v) (Grid.index grid u))
+    done
+  done;
+  !g
+
+(* Checks that a path is made of valid moves and returns its length *)
+let path_length grid start goal path = 
+  assert (List.hd path = start);
+  let rec aux acc = function
+    | a :: (b :: _ as t) -> 
+      let cost = ref infinity in
+      Grid.iter_neighbours grid a (fun u c -> if u = b then cost := c);
+      assert (!cost < infinity);
+      aux (acc +. !cost) t
+    | [b] -> assert (b = goal); acc
+    | [] -> assert false
+  in
+  aux 0. path
+
+let random_cell grid = 
+  Vector2i.make (Random.int (Grid.width grid)) (Random.int (Grid.height grid))
+
+let check_searches grid graph jps hpa hpa_exact = 
+  for _i = 1 to 50 do
+    let s = random_cell grid and t = random_cell grid in
+    if not (Grid.is_blocked grid s || Grid.is_blocked grid t) then begin
+      let expected = G.dijkstra graph (Grid.index grid s) (Grid.index grid t) in
+      let check ~exact res = 
+        match expected, res with
+        | None, None -> ()
+        | Some (d, _), Some (d', p) -> 
+          assert (abs_float (path_length grid s t p -. d') < 1e-9);
+          if exact then assert (abs_float (d -. d') < 1e-9)
+          else assert (d' >= d -. 1e-9)
+        | _ -> assert false
+      in
+      check ~exact:true (JPS.find_path jps s t);
+      check ~exact:true (HPA.find_path hpa_exact s t);
+      check ~exact:false (HPA.find_path hpa s t)
+    end
+  done
+
+let testpath1 () = 
+  let grid = Grid.create ~width:10 ~height:10 in
+  let jps = JPS.create grid in
+  (match JPS.find_path jps (Vector2i.make 0 0) (Vector2i.make 9 4) with
+  | Some (d, p) -> 
+    assert (abs_float (d -. (5. +. 4. *. sqrt 2.)) < 1e-9);
+    assert (List.length p = 10)
+  | None -> assert false);
+  for y = 0 to 9 do Grid.set_blocked grid (Vector2i.make 5 y) true done;
+  assert (JPS.find_path jps (Vector2i.make 0 0) (Vector2i.make 9 4) = None)
+
+let testpath2 () = 
+  for _i = 1 to 20 do
+    let grid = random_grid (10 + Random.int 40) (10 + Random.int 40) (Random.float 0.4) in
+    let hpa = HPA.create ~cluster_size:(2 + Random.int 8) grid in
+    let hpa_exact = HPA.create ~cluster_size:(2 + Random.int 8) ~exact:true grid in
+    check_searches grid (to_graph grid) (JPS.create grid) hpa hpa_exact;
+    HPA.release hpa;
+    HPA.release hpa_exact
+  done
+
+(* The abstract graphs must follow the changes of the grid *)
+let testpath3 () = 
+  let grid = random_grid 40 40 0.25 in
+  let jps = JPS.create grid in
+  let hpa = HPA.create ~cluster_size:8 grid in
+  let hpa_exact = HPA.create ~cluster_size:8 ~exact:true grid in
+  for _i = 1 to 10 do
+    for _j = 1 to 20 do
+      Grid.set_blocked grid (random_cell grid) (Random.float 1. < 0.25)
+    done;
+    check_searches grid (to_graph grid) jps hpa hpa_exact
+  done
+
+let () = 
+  testpath1 ();
+  Printf.printf "\tTest 1 passed\n%!";
+  testpath2 ();
+  Printf.printf "\tTest 2 passed\n%!";
+  testpath3 ();
+  Printf.printf "\tTest 3 passed\n%!"
@@ -0,0 +1,85 @@
+open OgamlUtils
+
+let () = 
+  Printf.printf "Beginning priority queue tests...\n%!"
+
+module Prio = struct
+
+  type t = int
+
+  let compare (i : int) (j : int) = compare i j
+
+end
+
+module Q = PriorityQueue.Make (Prio)
+
+module IQ = PriorityQueue.Indexed (Prio)
+
+let rec drain_q q acc = 
+  if Q.is_empty q then List.rev acc
+  else let (x, q) = Q.extract q in drain_q q (x :: acc)
+
+let rec drain_iq q acc = 
+  if IQ.is_empty q then List.rev acc
+  else drain_iq q (IQ.extract q :: acc)
+
+(* Both queues must return the elements in the same order *)
+let testqueue1 () = 
+  let prios = Array.init 1000 (fun _ -> Random.int 100_000) in
+  let q = Array.fold_left (fun q p -> Q.insert q p p) Q.empty prios in
+  let iq = IQ.create ~arity:2 () in
+  Array.iter (fun p -> ignore (IQ.insert iq p p)) prios;
+  assert (IQ.length iq = 1000);
+  let l = drain_q q [] in
+  assert (drain_iq iq [] = l);
+  let iq = IQ.heapify (Array.map (fun p -> (p, p)) prios) in
+  assert (drain_iq iq [] = l);
+  assert (try ignore (IQ.top iq); false with IQ.Empty -> true)
+
+let testqueue2 () = 
+  let iq = IQ.create () in
+  let handles = Array.init 100 (fun i -> IQ.insert iq (1000 + i) i) in
+  IQ.decrease_key iq handles.(50) 5;
+  assert (IQ.top iq = 50 && IQ.top_priority iq = 5);
+  IQ.update iq handles.(50) 2000;
+  assert (IQ.top iq = 0);
+  IQ.remove iq handles.(0);
+  assert (not (IQ.mem iq handles.(0)));
+  assert (IQ.top iq = 1);
+  assert (IQ.priority iq handles.(50) = 2000 && IQ.value iq handles.(50) = 50);
+  assert (try IQ.decrease_key iq handles.(1) 5000; false with IQ.Invalid_priority -> true);
+  assert (try IQ.remove iq handles.(0); false with IQ.Invalid_handle -> true);
+  let l = drain_iq iq [] in
+  assert (List.length l = 99);
+  assert (List.nth l 98 = 50);
+  IQ.clear iq;
+  assert (IQ.is_empty iq && not (IQ.mem iq handles.(1)))
+
+(* Handles are recycled, so a long-lived queue only grows with its size *)
+let testqueue3 () = 
+  let iq = IQ.create ~capacity:1 () in
+  let live = Array.init 100 (fun i -> IQ.insert iq i i) in
+  let bound = IQ.capacity iq in
+  for i = 1 to 1_000_000 do
+    let k = i mod 100 in
+    IQ.remove iq live.(k);
+    assert (not (IQ.mem iq live.(k)));
+    live.(k) <- IQ.insert iq (Random.int 1000) k;
+    assert (IQ.value iq live.(k) = k)
+  done;
+  for _i = 1 to 1_000_000 do
+    IQ.pop iq;
+    ignore (IQ.insert iq (Random.int 1000) 0)
+  done;
+  assert (IQ.length iq = 100);
+  assert (IQ.capacity iq <= bound);
+  assert (List.length (drain_iq iq []) = 100);
+  assert (IQ.capacity iq <= bound)
+
+let () = 
+  testqueue1 ();
+  Printf.printf "\tTest 1 passed\n%!";
+  testqueue2 ();
+  Printf.printf "\tTest 2 passed\n%!";
+  testqueue3 ();
+  Printf.printf "\tTest 3 passed\n%!"
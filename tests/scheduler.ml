@@ -0,0 +1,106 @@
+open OgamlUtils
+
+let () =
+  Printf.printf "Beginning scheduler tests...\n%!"
+
+(* Deques *)
+let () =
+  let d = Scheduler.Deque.create () in
+  assert (Scheduler.Deque.is_empty d);
+  assert (Scheduler.Deque.pop d = None);
+  assert (Scheduler.Deque.steal d = None);
+  (* Enough elements to grow the buffer and wrap around it *)
+  for k = 0 to 9 do
+    for i = 0 to 99 do Scheduler.Deque.push d (100 * k + i) done;
+    assert (Scheduler.Deque.length d = 100);
+    for i = 0 to 49 do assert (Scheduler.Deque.steal d = Some (100 * k + i)) done;
+    for i = 99 downto 50 do assert (Scheduler.Deque.pop d = Some (100 * k + i)) done;
+    assert (Scheduler.Deque.is_empty d)
+  done;
+  Scheduler.Deque.push d 1;
+  Scheduler.Deque.push d 2;
+  assert (Scheduler.Deque.steal d = Some 1);
+  assert (Scheduler.Deque.pop d = Some 2);
+  assert (Scheduler.Deque.pop d = None)
+
+let () =
+  Printf.printf "\tTest 1 passed\n%!"
+
+let pool = Scheduler.create ~workers:3 ()
+
+(* Tasks and exceptions *)
+exception Test_exception of int
+
+let () =
+  assert (Scheduler.workers pool = 3);
+  let promises = Array.init 100 (fun i -> Scheduler.async pool (fun () -> i * i)) in
+  Array.iteri (fun i p -> assert (Scheduler.await pool p = i * i)) promises;
+  let p = Scheduler.async pool (fun () -> raise (Test_exception 42)) in
+  assert (try ignore (Scheduler.await pool p); false with Test_exception 42 -> true);
+  (* Tasks waiting for their subtasks *)
+  let rec fib n =
+    if n < 2 then n
+    else begin
+      let p = Scheduler.async pool (fun () -> fib (n - 1)) in
+      let b = fib (n - 2) in
+      Scheduler.await pool p + b
+    end
+  in
+  assert (Scheduler.await pool (Scheduler.async pool (fun () -> fib 15)) = 610)
+
+let () =
+  Printf.printf "\tTest 2 passed\n%!"
+
+(* Parallel loops *)
+let () =
+  for n = 0 to 40 do
+    let count = Array.make n 0 in
+    Scheduler.parallel_for pool ~chunk_size:3 ~start:0 ~finish:(n - 1) (fun i ->
+      count.(i) <- count.(i) + 1);
+    assert (Array.fold_left (fun ok c -> ok && c = 1) true count)
+  done;
+  let n = 100_000 in
+  let count = Array.make n 0 in
+  Scheduler.parallel_for pool ~start:0 ~finish:(n - 1) (fun i -> count.(i) <- count.(i) + 1);
+  assert (Array.fold_left (fun ok c -> ok && c = 1) true count);
+  let sum = Scheduler.parallel_reduce pool ~start:1 ~finish:n (+) 0 (fun i -> i) in
+  assert (sum = n * (n + 1) / 2);
+  (* Combination in the order of the range *)
+  let l = Scheduler.parallel_reduce pool ~chunk_size:2 ~start:0 ~finish:99 (@) [] (fun i -> [i]) in
+  assert (l = Array.to_list (Array.init 100 (fun i -> i)));
+  assert (Scheduler.parallel_reduce pool ~start:5 ~finish:4 (+) 17 (fun i -> i) = 17);
+  (* Nested loops *)
+  let total = Scheduler.parallel_reduce pool ~chunk_size:1 ~start:0 ~finish:7 (+) 0 (fun _ ->
+    Scheduler.parallel_reduce pool ~chunk_size:5 ~start:0 ~finish:99 (+) 0 (fun j -> j))
+  in
+  assert (total = 8 * 4950);
+  assert (try
+      Scheduler.parallel_for pool ~chunk_size:4 ~start:0 ~finish:99 (fun i ->
+        if i = 57 then raise (Test_exception i));
+      false
+    with Test_exception 57 -> true)
+
+let () =
+  Printf.printf "\tTest 3 passed\n%!"
+
+(* Statistics and shutdown *)
+let () =
+  let stats = Scheduler.stats pool in
+  assert (Array.length stats = 3);
+  assert (Array.fold_left (fun n s -> n + s.Scheduler.tasks) 0 stats > 0);
+  Array.iter (fun s ->
+    let u = Scheduler.utilization s in
+    assert (u >= 0. && u <= 1.)
+  ) stats;
+  Scheduler.reset_stats pool;
+  Array.iter (fun s -> assert (s.Scheduler.tasks = 0 && s.Scheduler.steals = 0)) (Scheduler.stats pool);
+  let p = Scheduler.async pool (fun () -> Thread.delay 0.01; 1) in
+  Scheduler.shutdown pool;
+  assert (Scheduler.await pool p = 1);
+  assert (try ignore (Scheduler.async pool (fun () -> 0)); false
+          with Scheduler.Scheduler_exception _ -> true);
+  assert (try ignore (Scheduler.create ~workers:0 ()); false
+          with Scheduler.Scheduler_exception _ -> true)
+
+let () =
+  Printf.printf "\tTest 4 passed\n%!"
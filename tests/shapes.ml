@@ -0,0 +1,208 @@
+open OgamlGraphics
+open OgamlMath
+
+let () =
+  Printf.printf "Beginning shape tests...\n%!"
+
+let settings = OgamlCore.ContextSettings.create ()
+
+let window = Window.create ~width:100 ~height:100 ~settings ~title:"" ()
+
+let triangles t = Bigarray.Array1.dim t / 6
+
+(* Bounds of a triangulation *)
+let bounds t =
+  let x0 = ref infinity and y0 = ref infinity in
+  let x1 = ref neg_infinity and y1 = ref neg_infinity in
+  for i = 0 to Bigarray.Array1.dim t / 2 - 1 do
+    x0 := min !x0 t.{2 * i};
+    x1 := max !x1 t.{2 * i};
+    y0 := min !y0 t.{2 * i + 1};
+    y1 := max !y1 t.{2 * i + 1}
+  done;
+  (!x0, !y0, !x1, !y1)
+
+let close_to a b = abs_float (a -. b) < 1e-3
+
+(* Area of a mesh, triangles are not supposed to overlap *)
+let area mesh =
+  let v = mesh.Path.vertices and idx = mesh.Path.indices in
+  let s = ref 0. in
+  for t = 0 to Bigarray.Array1.dim idx / 3 - 1 do
+    let p k = Int32.to_int idx.{3 * t + k} in
+    let ax = v.{2 * p 0} and ay = v.{2 * p 0 + 1} in
+    let bx = v.{2 * p 1} and by = v.{2 * p 1 + 1} in
+    let cx = v.{2 * p 2} and cy = v.{2 * p 2 + 1} in
+    s := !s +. abs_float ((bx -. ax) *. (cy -. ay) -. (cx -. ax) *. (by -. ay)) /. 2.
+  done;
+  !s
+
+let test_path1 () =
+  (* Flattening *)
+  let square = Path.rectangle ~position:Vector2f.zero ~size:(Vector2f.make 10. 10.) in
+  begin match Path.flatten square with
+  | [(p, true)] -> assert (Array.length p = 8)
+  | _ -> assert false
+  end;
+  assert (Bigarray.Array1.dim (Path.fill square).Path.indices = 6);
+  (* Curves are flattened within the tolerance *)
+  let circle = Path.circle ~center:Vector2f.zero ~radius:100. in
+  let count tolerance =
+    match Path.flatten ~tolerance circle with
+    | [(p, true)] ->
+      for i = 0 to Array.length p / 2 - 1 do
+        assert (close_to (sqrt (p.(2 * i) ** 2. +. p.(2 * i + 1) ** 2.)) 100.)
+      done;
+      Array.length p / 2
+    | _ -> assert false
+  in
+  assert (count 1. < count 0.1);
+  let n = count Path.tolerance in
+  assert (100. *. (1. -. cos (Constants.pi /. float_of_int n)) <= Path.tolerance);
+  let curve =
+    Path.(empty
+          |> move_to Vector2f.zero
+          |> cubic_to (Vector2f.make 0. 100.) (Vector2f.make 100. 100.) (Vector2f.make 100. 0.))
+  in
+  begin match Path.flatten curve with
+  | [(p, false)] ->
+    let n = Array.length p in
+    assert (n > 8);
+    assert (p.(0) = 0. && p.(1) = 0.);
+    assert (close_to p.(n - 2) 100. && close_to p.(n - 1) 0.)
+  | _ -> assert false
+  end;
+  (try ignore (Path.flatten ~tolerance:0. curve); assert false
+   with Path.Path_error _ -> ())
+
+let test_path2 () =
+  (* Strokes, joins and caps *)
+  let square = Path.rectangle ~position:Vector2f.zero ~size:(Vector2f.make 10. 10.) in
+  let (x0, y0, x1, y1) = bounds (Path.stroke ~width:2. square) in
+  assert (x0 = -1. && y0 = -1. && x1 = 11. && y1 = 11.);
+  let (x0, y0, x1, y1) = bounds (Path.stroke ~side:`Right ~join:`Bevel ~width:2. square) in
+  assert (x0 = -2. && y0 = -2. && x1 = 12. && y1 = 12.);
+  assert (triangles (Path.stroke ~join:`Bevel ~width:2. square) = 12);
+  let (x0, y0, x1, y1) = bounds (Path.stroke ~side:`Left ~width:2. square) in
+  assert (x0 = 0. && y0 = 0. && x1 = 10. && y1 = 10.);
+  let line = Path.(empty |> move_to Vector2f.zero |> line_to (Vector2f.make 10. 0.)) in
+  assert (triangles (Path.stroke ~width:2. line) = 2);
+  let (x0, _, x1, _) = bounds (Path.stroke ~cap:`Square ~width:2. line) in
+  assert (x0 = -1. && x1 = 11.);
+  let (x0, y0, x1, y1) = bounds (Path.stroke ~cap:`Round ~width:20. line) in
+  (* Round caps are flattened within the tolerance *)
+  assert (x0 >= -10.001 && x0 <= -10. +. Path.tolerance);
+  assert (x1 <= 20.001 && x1 >= 20. -. Path.tolerance);
+  assert (y0 >= -10.001 && y1 <= 10.001);
+  assert (triangles (Path.stroke ~width:0. line) = 0);
+  (* Repeated points of caller-supplied contours are merged *)
+  let repeated = [|0.; 0.; 0.; 0.; 10.; 0.; 10.; 0.; 10.; 10.; 0.; 0.|] in
+  List.iter (fun (closed, merged) ->
+    List.iter (fun join ->
+      let t = Path.outline ~join ~cap:`Round ~width:2. [(repeated, closed)] in
+      (* No NaN *)
+      for i = 0 to Bigarray.Array1.dim t - 1 do
+        assert (t.{i} = t.{i})
+      done;
+      let t' = Path.outline ~join ~cap:`Round ~width:2. [(merged, closed)] in
+      assert (triangles t = triangles t')
+    ) [`Bevel; `Miter 4.; `Round]
+  ) [(true, [|0.; 0.; 10.; 0.; 10.; 10.|]);
+     (false, [|0.; 0.; 10.; 0.; 10.; 10.; 0.; 0.|])];
+  assert (triangles (Path.outline ~width:2. [([|1.; 1.; 1.; 1.|], false)]) = 0)
+
+let test_path3 () =
+  (* Concave polygons, holes and fill rules *)
+  let v = Vector2f.make in
+  let concave = Path.polygon [v 0. 0.; v 10. 0.; v 10. 10.; v 5. 3.; v 0. 10.] in
+  assert (close_to (area (Path.fill concave)) 65.);
+  let square = Path.rectangle ~position:Vector2f.zero ~size:(v 10. 10.) in
+  let hole = Path.polygon [v 2. 2.; v 2. 8.; v 8. 8.; v 8. 2.] in
+  let same = Path.rectangle ~position:(v 2. 2.) ~size:(v 6. 6.) in
+  assert (close_to (area (Path.fill (Path.append square hole))) 64.);
+  assert (close_to (area (Path.fill ~rule:`EvenOdd (Path.append square hole))) 64.);
+  assert (close_to (area (Path.fill (Path.append square same))) 100.);
+  assert (close_to (area (Path.fill ~rule:`EvenOdd (Path.append square same))) 64.);
+  let bowtie = Path.polygon [v 0. 0.; v 10. 10.; v 10. 0.; v 0. 10.] in
+  assert (close_to (area (Path.fill bowtie)) 50.);
+  (* The center of a pentagram is filled with the non-zero rule only *)
+  let star = Path.polygon (Array.to_list (Array.init 5 (fun k ->
+    let a = Constants.pi /. 2. +. float_of_int k *. 4. *. Constants.pi /. 5. in
+    v (100. *. cos a) (100. *. sin a))))
+  in
+  let nonzero = area (Path.fill star) and evenodd = area (Path.fill ~rule:`EvenOdd star) in
+  assert (abs_float (nonzero -. 11225.7) < 1.);
+  assert (evenodd < nonzero);
+  (* Vertices are shared *)
+  let mesh = Path.fill concave in
+  assert (Bigarray.Array1.dim mesh.Path.vertices / 2 < Bigarray.Array1.dim mesh.Path.indices);
+  (* A convex contour is a fan *)
+  let circle = Path.fill (Path.circle ~center:Vector2f.zero ~radius:10.) in
+  assert (Bigarray.Array1.dim circle.Path.indices / 3
+          = Bigarray.Array1.dim circle.Path.vertices / 2 - 2)
+
+let test_shape1 () =
+  (* Transformations do not change the tessellation *)
+  let shape = Shape.create_circle ~position:(Vector2f.make 50. 50.) ~radius:20.
+    ~color:(`RGB Color.RGB.white) ~thickness:2. ()
+  in
+  let source () =
+    let src = VertexArray.VertexSource.empty () in
+    Shape.to_source shape src;
+    src
+  in
+  let n = VertexArray.VertexSource.length (source ()) in
+  assert (n mod 3 = 0 && n > 0);
+  Shape.draw (module Window) ~target:window ~shape ();
+  Shape.rotate shape 1.;
+  Shape.translate shape (Vector2f.make 3. 4.);
+  Shape.scale shape (Vector2f.make 1.5 1.5);
+  Shape.draw (module Window) ~target:window ~shape ();
+  assert (VertexArray.VertexSource.length (source ()) = n);
+  (* The circle is flattened again at a larger scale *)
+  Shape.set_scale shape (Vector2f.make 10. 10.);
+  Shape.draw (module Window) ~target:window ~shape ();
+  assert (VertexArray.VertexSource.length (source ()) > n);
+  Shape.set_thickness shape 0.;
+  Shape.set_color shape (`RGB Color.RGB.red);
+  Shape.draw (module Window) ~target:window ~shape ()
+
+let test_shape2 () =
+  (* Sources are transformed *)
+  let shape = Shape.create_rectangle ~position:(Vector2f.make 10. 20.)
+    ~size:(Vector2f.make 4. 2.) ~color:(`RGB Color.RGB.white)
+    ~origin:(Vector2f.make 2. 1.) ~rotation:(Constants.pi /. 2.) ()
+  in
+  let src = VertexArray.VertexSource.empty () in
+  Shape.to_source shape src;
+  assert (VertexArray.VertexSource.length src = 6);
+  VertexArray.VertexSource.iter src (fun v ->
+    let p = VertexArray.Vertex.Attribute.get v VertexArray.SimpleVertex.position in
+    assert (p.Vector3f.x >= 9. -. 1e-3 && p.Vector3f.x <= 11. +. 1e-3);
+    assert (p.Vector3f.y >= 18. -. 1e-3 && p.Vector3f.y <= 22. +. 1e-3));
+  (* Open paths are only stroked *)
+  let path = Path.(empty |> move_to Vector2f.zero |> quad_to ~control:(Vector2f.make 5. 10.) (Vector2f.make 10. 0.)) in
+  let shape = Shape.create_path ~path ~thickness:1. ~cap:`Round () in
+  Shape.draw (module Window) ~target:window ~shape ();
+  (* Concave polygons are drawn in one call *)
+  let shape = Shape.create_polygon ~color:(`RGB Color.RGB.white)
+    ~points:Vector2f.([make 0. 0.; make 10. 0.; make 10. 10.; make 5. 3.; make 0. 10.]) ()
+  in
+  let src = VertexArray.VertexSource.empty () in
+  Shape.to_source shape src;
+  assert (VertexArray.VertexSource.length src = 3 * 4);
+  Shape.draw (module Window) ~target:window ~shape ();
+  Shape.set_thickness shape 1.;
+  Shape.draw (module Window) ~target:window ~shape ()
+
+let () =
+  test_path1 ();
+  Printf.printf "\tTest 1 passed\n%!";
+  test_path2 ();
+  Printf.printf "\tTest 2 passed\n%!";
+  test_path3 ();
+  Printf.printf "\tTest 3 passed\n%!";
+  test_shape1 ();
+  Printf.printf "\tTest 4 passed\n%!";
+  test_shape2 ();
+  Printf.printf "\tTest 5 passed\n%!"
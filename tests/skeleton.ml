@@ -0,0 +1,194 @@
+open OgamlGraphics
+open OgamlMath
+open OgamlUtils
+
+let () =
+  Printf.printf "Beginning skeleton tests...\n%!"
+
+let settings = OgamlCore.ContextSettings.create ()
+
+let window = Window.create ~width:100 ~height:100 ~settings ~title:"" ()
+
+let close_to ?(eps = 1e-4) a b = abs_float (a -. b) < eps
+
+let joint ?(parent = -1) ?(translation = Vector3f.zero)
+          ?(rotation = Quaternion.one) ?(scale = Vector3f.make 1. 1. 1.) name =
+  Skeleton.({name; parent; translation; rotation; scale})
+
+(* A chain of 3 joints along x *)
+let arm = Skeleton.create [
+  joint "shoulder" ~translation:(Vector3f.make 1. 2. 0.) ~scale:(Vector3f.make 2. 2. 2.);
+  joint "elbow" ~parent:0 ~translation:Vector3f.unit_x
+    ~rotation:(Quaternion.rotation Vector3f.unit_y 0.3);
+  joint "wrist" ~parent:1 ~translation:Vector3f.unit_x
+]
+
+(* Compares the matrix of a joint in a palette with a matrix *)
+let assert_matrix buf i m =
+  let m = Matrix3D.to_bigarray m in
+  for k = 0 to 15 do
+    assert (close_to buf.{16 * i + k} m.{k})
+  done
+
+let test_skeleton () =
+  assert (Skeleton.joints arm = 3);
+  assert (Skeleton.find arm "wrist" = 2);
+  assert ((Skeleton.joint arm 1).Skeleton.name = "elbow");
+  (* The bind pose does not move the vertices *)
+  let pose = Skeleton.Pose.create arm in
+  let palette = Skeleton.buffer arm in
+  Skeleton.palette pose palette;
+  for i = 0 to 2 do
+    assert_matrix palette i (Matrix3D.identity ())
+  done;
+  (* Rotations compose along the chain like matrices *)
+  let elbow = Vector3f.make 3. 2. 0. in
+  Skeleton.Pose.set_rotation pose 1 (Quaternion.rotation Vector3f.unit_z (Constants.pi /. 2.));
+  Skeleton.palette pose palette;
+  assert_matrix palette 0 (Matrix3D.identity ());
+  let expected = Matrix3D.(product (translation elbow)
+    (product (rotation Vector3f.unit_z (Constants.pi /. 2.))
+    (product (rotation Vector3f.unit_y (-0.3)) (translation (Vector3f.prop (-1.) elbow)))))
+  in
+  assert_matrix palette 1 expected;
+  assert_matrix palette 2 expected;
+  (* The wrist follows the elbow *)
+  let wrist = Vector3f.make (3. +. 2. *. cos 0.3) 2. (-. 2. *. sin 0.3) in
+  let tip = Matrix3D.times expected wrist in
+  assert (close_to tip.Vector3f.x 3. && close_to tip.Vector3f.y 4.);
+  Skeleton.Pose.reset pose;
+  Skeleton.palette pose palette;
+  assert_matrix palette 2 (Matrix3D.identity ());
+  (try ignore (Skeleton.create [joint "a" ~parent:1; joint "b"]); assert false
+   with Skeleton.Skeleton_error _ -> ());
+  (try ignore (Skeleton.create [joint "a"; joint "a" ~parent:0]); assert false
+   with Skeleton.Skeleton_error _ -> ());
+  (try ignore (Skeleton.create [joint "a" ~scale:Vector3f.zero]); assert false
+   with Skeleton.Skeleton_error _ -> ());
+  (try ignore (Skeleton.find arm "hand"); assert false
+   with Skeleton.Skeleton_error _ -> ());
+  (try Skeleton.palette pose (Bigarray.Array1.sub palette 0 16); assert false
+   with Skeleton.Skeleton_error _ -> ())
+
+let () =
+  test_skeleton ();
+  Printf.printf "\tTest 1 passed\n%!"
+
+let angle q = 2. *. atan2 q.Quaternion.k q.Quaternion.r
+
+let test_clips () =
+  let z = Vector3f.unit_z in
+  let bend = Skeleton.Clip.create arm [
+    (1, Skeleton.Clip.Rotation, Animation.Track.rotation [|0.; 2.|]
+       [|Quaternion.rotation z 0.; Quaternion.rotation z (Constants.pi /. 2.)|]);
+    (2, Skeleton.Clip.Translation, Animation.Track.linear ~dimension:3 [|0.; 2.|]
+       [|1.; 0.; 0.; 3.; 0.; 0.|])
+  ] in
+  assert (Skeleton.Clip.duration bend = 2.);
+  let pose = Skeleton.Pose.create arm in
+  Skeleton.Clip.sample bend 1. pose;
+  assert (close_to (angle (Skeleton.Pose.rotation pose 1)) (Constants.pi /. 4.));
+  assert (close_to (Skeleton.Pose.translation pose 2).Vector3f.x 2.);
+  (* Joints that are not animated keep their bind pose *)
+  assert ((Skeleton.Pose.scale pose 0).Vector3f.x = 2.);
+  Skeleton.Clip.sample ~loop:true bend 5. pose;
+  assert (close_to (angle (Skeleton.Pose.rotation pose 1)) (Constants.pi /. 4.));
+  (* Blending *)
+  let rest = Skeleton.Pose.create arm in
+  let blended = Skeleton.Pose.create arm in
+  Skeleton.Clip.sample bend 2. pose;
+  Skeleton.Pose.blend rest pose 0.5 blended;
+  assert (close_to (angle (Skeleton.Pose.rotation blended 1)) (Constants.pi /. 4.));
+  assert (close_to (Quaternion.norm (Skeleton.Pose.rotation blended 1)) 1.);
+  assert (close_to (Skeleton.Pose.translation blended 2).Vector3f.x 2.);
+  Skeleton.Pose.blend ~mask:[|1.; 1.; 0.|] rest pose 1. blended;
+  assert (close_to (angle (Skeleton.Pose.rotation blended 1)) (Constants.pi /. 2.));
+  assert (close_to (Skeleton.Pose.translation blended 2).Vector3f.x 1.);
+  (* Opposite quaternions are blended along the shortest path *)
+  Skeleton.Pose.set_rotation pose 1 (Quaternion.prop (-1.) (Skeleton.Pose.rotation pose 1));
+  Skeleton.Pose.blend rest pose 0.5 blended;
+  assert (close_to (abs_float (angle (Skeleton.Pose.rotation blended 1))) (Constants.pi /. 4.));
+  (try Skeleton.Pose.blend ~mask:[|1.|] rest pose 1. blended; assert false
+   with Skeleton.Skeleton_error _ -> ());
+  (try ignore (Skeleton.Clip.create arm [(0, Skeleton.Clip.Scale, Animation.Track.linear [|0.|] [|1.|])]);
+       assert false
+   with Skeleton.Skeleton_error _ -> ());
+  (try ignore (Skeleton.Clip.create arm [(3, Skeleton.Clip.Translation,
+                 Animation.Track.linear ~dimension:3 [|0.|] [|1.; 1.; 1.|])]);
+       assert false
+   with Skeleton.Skeleton_error _ -> ());
+  let other = Skeleton.create [joint "root"] in
+  (try Skeleton.Clip.sample bend 0. (Skeleton.Pose.create other); assert false
+   with Skeleton.Skeleton_error _ -> ())
+
+let () =
+  test_clips ();
+  Printf.printf "\tTest 2 passed\n%!"
+
+let test_influences () =
+  let (j, w) = Skeleton.influences [(3, 1.); (7, 4.); (1, 0.5); (2, 2.); (9, 2.5)] in
+  assert (j = (7, 9, 2, 3));
+  let (a, b, c, d) = w in
+  assert (close_to (a +. b +. c +. d) 1.);
+  assert (close_to a (4. /. 9.5));
+  let (j, w) = Skeleton.influences [(5, 2.)] in
+  assert (j = (5, 0, 0, 0) && w = (1., 0., 0., 0.));
+  (try ignore (Skeleton.influences [(256, 1.)]); assert false
+   with Skeleton.Skeleton_error _ -> ())
+
+let () =
+  test_influences ();
+  Printf.printf "\tTest 3 passed\n%!"
+
+(* Skinned vertices are drawn with a palette *)
+let test_skinning () =
+  let color = `RGB Color.RGB.white in
+  let vertex position joints weights =
+    VertexArray.SkinnedVertex.create ~position ~color ~joints ~weights ()
+  in
+  let source = VertexArray.(VertexSource.(
+    empty ~size:3 ()
+    << vertex Vector3f.unit_x (0, 1, 0, 0) (0.5, 0.5, 0., 0.)
+    << vertex Vector3f.unit_y (1, 2, 0, 0) (0.25, 0.75, 0., 0.)
+    << vertex Vector3f.unit_z (2, 0, 0, 0) (1., 0., 0., 0.)
+  )) in
+  (* Weights are quantized on 8 bits *)
+  let weights = ref [] in
+  VertexArray.VertexSource.iter source (fun v ->
+    let (a, b, _, _) = VertexArray.Vertex.Attribute.get v VertexArray.SkinnedVertex.weights in
+    let (j, _, _, _) = VertexArray.Vertex.Attribute.get v VertexArray.SkinnedVertex.joints in
+    weights := (j, a, b) :: !weights);
+  begin match List.rev !weights with
+  | [(0, a, b); (1, c, d); (2, e, f)] ->
+    assert (close_to ~eps:(1. /. 255.) a 0.5 && close_to ~eps:(1. /. 255.) b 0.5);
+    assert (close_to ~eps:(1. /. 255.) c 0.25 && close_to ~eps:(1. /. 255.) d 0.75);
+    assert (e = 1. && f = 0.)
+  | _ -> assert false
+  end;
+  (try ignore (vertex Vector3f.zero (0, 256, 0, 0) (1., 0., 0., 0.)); assert false
+   with VertexArray.Vertex.Invalid_value _ -> ());
+  let vao = VertexArray.static (module Window) window source in
+  let program = Skeleton.program (module Window) ~context:window arm in
+  let pose = Skeleton.Pose.create arm in
+  let palette = Skeleton.buffer arm in
+  Skeleton.Pose.set_rotation pose 1 (Quaternion.rotation Vector3f.unit_z 1.);
+  Skeleton.palette pose palette;
+  let uniform = Uniform.empty
+    |> Uniform.matrix3D "transform" (Matrix3D.identity ())
+    |> Uniform.matrix3D_array "joint_matrices" palette
+  in
+  VertexArray.draw (module Window) ~target:window ~vertices:vao ~program ~uniform ();
+  (* Palettes larger than the uniform array are rejected *)
+  let uniform = Uniform.empty
+    |> Uniform.matrix3D "transform" (Matrix3D.identity ())
+    |> Uniform.matrix3D_array "joint_matrices"
+         (Bigarray.Array1.create Bigarray.float32 Bigarray.c_layout (16 * 4))
+  in
+  try
+    VertexArray.draw (module Window) ~target:window ~vertices:vao ~program ~uniform ();
+    assert false
+  with Uniform.Invalid_uniform _ -> ()
+
+let () =
+  test_skinning ();
+  Printf.printf "\tTest 4 passed\n%!"
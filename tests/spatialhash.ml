@@ -0,0 +1,63 @@
+open OgamlMath
+open OgamlUtils
+
+let () =
+  Printf.printf "Beginning spatial hash tests...\n%!"
+
+let rnd_rect size =
+  FloatRect.create
+    (Vector2f.make (Random.float 1000. -. 500.) (Random.float 1000. -. 500.))
+    (Vector2f.make (Random.float size -. size /. 2.) (Random.float size -. size /. 2.))
+
+let normalize (a, b) = if a < b then (a, b) else (b, a)
+
+(* Pairs and queries against a brute force search, over several frames *)
+let () =
+  let grid = SpatialHash2D.create ~capacity:4 ~cell_size:20. () in
+  for _frame = 1 to 5 do
+    SpatialHash2D.clear grid;
+    assert (SpatialHash2D.length grid = 0);
+    assert (SpatialHash2D.pairs grid = []);
+    (* Mostly small objects, and a few objects covering many cells *)
+    let rects = Array.init 1500 (fun i -> rnd_rect (if i mod 100 = 0 then 200. else 30.)) in
+    Array.iteri (fun i r -> SpatialHash2D.add grid i r) rects;
+    assert (SpatialHash2D.length grid = 1500);
+    let expected = ref [] in
+    for i = 0 to 1499 do
+      for j = i + 1 to 1499 do
+        if FloatRect.intersects rects.(i) rects.(j) then expected := (i, j) :: !expected
+      done
+    done;
+    let found = List.map normalize (SpatialHash2D.pairs grid) in
+    assert (List.sort compare found = List.sort compare !expected);
+    for _i = 1 to 50 do
+      let q = rnd_rect 100. in
+      let found = ref [] in
+      SpatialHash2D.query grid q (fun i -> found := i :: !found);
+      let expected = ref [] in
+      Array.iteri (fun i r -> if FloatRect.intersects r q then expected := i :: !expected) rects;
+      assert (List.sort compare !found = List.sort compare !expected)
+    done
+  done
+
+let () =
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Cells *)
+let () =
+  let grid = SpatialHash2D.create ~cell_size:10. () in
+  assert (SpatialHash2D.cell grid (Vector2f.make 15. (-5.)) = Vector2i.make 1 (-1));
+  SpatialHash2D.add grid 7 (FloatRect.create (Vector2f.make 5. 5.) (Vector2f.make 10. 2.));
+  assert (SpatialHash2D.cells grid = 2);
+  let found = ref [] in
+  SpatialHash2D.iter_cell grid (Vector2i.make 1 0) (fun i -> found := i :: !found);
+  assert (!found = [7]);
+  found := [];
+  SpatialHash2D.iter_cell grid (Vector2i.make 0 1) (fun i -> found := i :: !found);
+  assert (!found = []);
+  SpatialHash2D.clear grid;
+  assert (SpatialHash2D.cells grid = 0);
+  SpatialHash2D.iter_cell grid (Vector2i.make 1 0) (fun _ -> assert false)
+
+let () =
+  Printf.printf "\tTest 2 passed\n%!"
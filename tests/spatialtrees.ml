@@ -0,0 +1,132 @@
+open OgamlMath
+open OgamlUtils
+open SpatialTree
+
+let () =
+  Printf.printf "Beginning spatial tree tests...\n%!"
+
+let rnd_rect () =
+  (* Some objects are outside of the bounds of the tree *)
+  FloatRect.create
+    (Vector2f.make (Random.float 1100. -. 50.) (Random.float 1100. -. 50.))
+    (Vector2f.make (Random.float 30.) (Random.float 30.))
+
+let rnd_box () =
+  FloatBox.create
+    (Vector3f.make (Random.float 220. -. 10.) (Random.float 220. -. 10.) (Random.float 220. -. 10.))
+    (Vector3f.make (Random.float 10.) (Random.float 10.) (Random.float 10.))
+
+let sorted l = List.sort compare l
+
+(* Random insertions, removals and moves, checked against a linear scan *)
+let () =
+  let tree = Quadtree.create ~leaf_size:4 (FloatRect.create Vector2f.zero (Vector2f.make 1000. 1000.)) in
+  let live = Hashtbl.create 97 in
+  let handles () = Hashtbl.fold (fun h _ l -> h :: l) live [] in
+  let pick () = let l = handles () in List.nth l (Random.int (List.length l)) in
+  for i = 0 to 20000 do
+    let r = Random.float 1. in
+    if r < 0.3 || Hashtbl.length live = 0 then begin
+      let b = rnd_rect () in
+      let h = Quadtree.insert tree b i in
+      Hashtbl.replace live h (b, i)
+    end else if r < 0.45 then begin
+      let h = pick () in
+      Quadtree.remove tree h;
+      Hashtbl.remove live h
+    end else begin
+      let h = pick () in
+      let (b, v) = Hashtbl.find live h in
+      let b =
+        if Random.float 1. < 0.8 then
+          FloatRect.translate b (Vector2f.make (Random.float 10. -. 5.) (Random.float 10. -. 5.))
+        else rnd_rect ()
+      in
+      Quadtree.update tree h b;
+      Hashtbl.replace live h (b, v)
+    end;
+    if i mod 1000 = 0 then begin
+      assert (Quadtree.length tree = Hashtbl.length live);
+      for _i = 1 to 20 do
+        let q = FloatRect.extend (rnd_rect ()) (Vector2f.make (Random.float 200.) (Random.float 200.)) in
+        let found = ref [] in
+        Quadtree.range tree q (fun h v ->
+          assert (snd (Hashtbl.find live h) = v);
+          found := h :: !found);
+        let expected = Hashtbl.fold (fun h (b, _) l ->
+          if FloatRect.intersects b q then h :: l else l) live []
+        in
+        assert (sorted !found = sorted expected)
+      done
+    end
+  done;
+  List.iter (Quadtree.remove tree) (handles ());
+  assert (Quadtree.length tree = 0);
+  assert (Quadtree.nodes tree = 1)
+
+let () =
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Point and nearest queries *)
+let () =
+  let tree = Quadtree.create (FloatRect.create Vector2f.zero (Vector2f.make 1000. 1000.)) in
+  let rects = Array.init 2000 (fun _ -> rnd_rect ()) in
+  Array.iteri (fun i b -> assert (Quadtree.insert tree b () = i)) rects;
+  let dist (p : Vector2f.t) b =
+    let p1 = FloatRect.abs_position b and p2 = FloatRect.abs_corner b in
+    let d x a b = if x < a then a -. x else if x > b then x -. b else 0. in
+    let dx = d p.Vector2f.x p1.Vector2f.x p2.Vector2f.x in
+    let dy = d p.Vector2f.y p1.Vector2f.y p2.Vector2f.y in
+    sqrt (dx *. dx +. dy *. dy)
+  in
+  for _i = 1 to 100 do
+    let p = Vector2f.make (Random.float 1000.) (Random.float 1000.) in
+    let found = ref [] in
+    Quadtree.point tree p (fun h () -> found := h :: !found);
+    let expected = ref [] in
+    Array.iteri (fun i b -> if dist p b = 0. then expected := i :: !expected) rects;
+    assert (sorted !found = sorted !expected);
+    let nearest = Quadtree.nearest tree p 10 in
+    let all = Array.to_list (Array.map (dist p) rects) |> List.sort compare in
+    assert (List.length nearest = 10);
+    List.iteri (fun i (h, d) ->
+      assert (d = List.nth all i);
+      assert (d = dist p rects.(h))
+    ) nearest;
+    let bounded = Quadtree.nearest tree ~max_dist:20. p 2000 in
+    assert (List.length bounded = List.length (List.filter (fun d -> d <= 20.) all))
+  done
+
+let () =
+  Printf.printf "\tTest 2 passed\n%!"
+
+(* Octree range and frustum queries *)
+let () =
+  let tree = Octree.create (FloatBox.create Vector3f.zero (Vector3f.make 200. 200. 200.)) in
+  let boxes = Array.init 3000 (fun _ -> rnd_box ()) in
+  Array.iteri (fun i b -> ignore (Octree.insert tree b i)) boxes;
+  for _i = 1 to 50 do
+    let q = FloatBox.create
+      (Vector3f.make (Random.float 200.) (Random.float 200.) (Random.float 200.))
+      (Vector3f.make (Random.float 50.) (Random.float 50.) (Random.float 50.))
+    in
+    let found = ref [] in
+    Octree.range tree q (fun _ v -> found := v :: !found);
+    let expected = ref [] in
+    Array.iteri (fun i b -> if FloatBox.intersects b q then expected := i :: !expected) boxes;
+    assert (sorted !found = sorted !expected)
+  done;
+  for _i = 1 to 20 do
+    let eye = Vector3f.make (Random.float 200.) (Random.float 200.) (Random.float 200.) in
+    let view = Matrix3D.look_at ~from:eye ~at:(Vector3f.make 100. 100. 100.) ~up:Vector3f.unit_y in
+    let projection = Matrix3D.perspective ~near:0.1 ~far:150. ~width:800. ~height:600. ~fov:(90. *. Constants.pi /. 180.) in
+    let frustum = Frustum.create ~view ~projection in
+    let found = ref [] in
+    Octree.frustum tree frustum (fun _ v -> found := v :: !found);
+    let expected = ref [] in
+    Array.iteri (fun i b -> if Frustum.intersects_box frustum b then expected := i :: !expected) boxes;
+    assert (sorted !found = sorted !expected)
+  done
+
+let () =
+  Printf.printf "\tTest 3 passed\n%!"
@@ -0,0 +1,111 @@
+open OgamlUtils
+
+let () =
+  Printf.printf "Beginning UTF-8 tests...\n%!"
+
+let encode codes =
+  let buf = Buffer.create 16 in
+  List.iter (fun c ->
+    let s = UTF8String.make 1 c in
+    Buffer.add_string buf (UTF8String.to_string s)
+  ) codes;
+  Buffer.contents buf
+
+(* Validation *)
+let () =
+  assert (UTF8String.validate "" = None);
+  assert (UTF8String.validate "hello" = None);
+  assert (UTF8String.validate "h\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80" = None);
+  (* Overlong sequences, surrogates, codes above 0x10FFFF, truncated sequences *)
+  assert (UTF8String.validate "\xc0\xaf" = Some 0);
+  assert (UTF8String.validate "ab\xe0\x80\xaf" = Some 2);
+  assert (UTF8String.validate "a\xed\xa0\x80" = Some 1);
+  assert (UTF8String.validate "abc\xf4\x90\x80\x80" = Some 3);
+  assert (UTF8String.validate "abcdefghijklmnopqrstuvwxyz\xe2\x82" = Some 26);
+  assert (UTF8String.validate "\x80" = Some 0);
+  (try ignore (UTF8String.from_string "abc\xff"); assert false
+   with UTF8String.UTF8_error _ -> ());
+  let s = UTF8String.from_string "h\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80" in
+  assert (UTF8String.length s = 6);
+  assert (UTF8String.byte_length s = 12);
+  assert (not (UTF8String.is_ascii s));
+  assert (UTF8String.is_ascii (UTF8String.from_string "plain"));
+  assert (UTF8String.to_string s = "h\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80");
+  assert (encode [0x68; 0xe9; 0x20; 0x20ac; 0x20; 0x1f600] = UTF8String.to_string s)
+
+let () =
+  Printf.printf "\tTest 1 passed\n%!"
+
+(* Random access against a decoded copy *)
+let () =
+  let codes = Array.init 1000 (fun i ->
+    match i mod 5 with
+    | 0 -> 0x41 + i mod 26
+    | 1 -> 0xe9
+    | 2 -> 0x4e00 + i
+    | 3 -> 0x10000 + i
+    | _ -> 0x20
+  ) in
+  let s = UTF8String.from_string (encode (Array.to_list codes)) in
+  assert (UTF8String.length s = 1000);
+  let offset = ref 0 in
+  Array.iteri (fun i c ->
+    assert (UTF8String.get s i = c);
+    assert (UTF8String.byte_offset s i = !offset);
+    offset := !offset + UTF8String.byte_length (UTF8String.make 1 c)
+  ) codes;
+  assert (UTF8String.byte_offset s 1000 = UTF8String.byte_length s);
+  (* Setting a code of another width moves the following ones *)
+  UTF8String.set s 500 0x1f600;
+  codes.(500) <- 0x1f600;
+  UTF8String.set s 3 0x41;
+  codes.(3) <- 0x41;
+  Array.iteri (fun i c -> assert (UTF8String.get s i = c)) codes;
+  (try ignore (UTF8String.get s 1000); assert false
+   with UTF8String.Out_of_bounds _ -> ());
+  (try UTF8String.set s 0 0xd800; assert false
+   with UTF8String.UTF8_error _ -> ());
+  let a = UTF8String.from_string "abc" in
+  UTF8String.set a 1 0xe9;
+  assert (not (UTF8String.is_ascii a));
+  assert (UTF8String.to_string a = "a\xc3\xa9c");
+  UTF8String.set a 1 0x62;
+  assert (UTF8String.is_ascii a && UTF8String.get a 2 = 0x63);
+  UTF8String.set a 1 0xe9;
+  UTF8String.set a 1 0xe8;
+  assert (UTF8String.to_string a = "a\xc3\xa8c");
+  (* The bytes are copied in and out *)
+  let src = Bytes.of_string "abc" in
+  let a = UTF8String.from_string (Bytes.unsafe_to_string src) in
+  Bytes.set src 0 '\xff';
+  assert (UTF8String.get a 0 = 0x61);
+  Bytes.set (Bytes.unsafe_of_string (UTF8String.to_string a)) 0 '\xff';
+  assert (UTF8String.get a 0 = 0x61)
+
+let () =
+  Printf.printf "\tTest 2 passed\n%!"
+
+(* Iterators *)
+let () =
+  let text = "caf\xc3\xa9 \xe2\x82\xac\n\xf0\x9f\x98\x80" in
+  let s = UTF8String.from_string text in
+  let l = ref [] in
+  UTF8String.iter s (fun c -> l := c :: !l);
+  let codes = [0x63; 0x61; 0x66; 0xe9; 0x20; 0x20ac; 0x0a; 0x1f600] in
+  assert (List.rev !l = codes);
+  assert (UTF8String.fold s (fun c l -> c :: l) [] = List.rev codes);
+  UTF8String.iteri s (fun i c -> assert (List.nth codes i = c));
+  let upper = UTF8String.map s (fun c -> if c >= 0x61 && c <= 0x7a then c - 32 else c) in
+  assert (UTF8String.to_string upper = "CAF\xc3\xa9 \xe2\x82\xac\n\xf0\x9f\x98\x80");
+  (try ignore (UTF8String.map s (fun _ -> 0x110000)); assert false
+   with UTF8String.UTF8_error _ -> ());
+  (* Long strings are handled without recursion *)
+  let long = String.make 2_000_000 'a' ^ "\xc3\xa9" in
+  let s = UTF8String.from_string long in
+  assert (UTF8String.length s = 2_000_001);
+  assert (UTF8String.fold s (fun c n -> n + c) 0 = 2_000_000 * 0x61 + 0xe9);
+  assert (UTF8String.get s 2_000_000 = 0xe9);
+  assert (UTF8String.length (UTF8String.empty ()) = 0)
+
+let () =
+  Printf.printf "\tTest 3 passed\n%!"
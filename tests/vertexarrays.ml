@@ -212,6 +212,31 @@ let test_vao10 () =
       end
     )
 
+let test_vao11 () =
+  let vertex v = VertexArray.SimpleVertex.create ~position:v () in
+  let vsource = VertexArray.(VertexSource.(
+    empty ~size:4 () << vertex Vector3f.unit_x << vertex Vector3f.unit_y << vertex Vector3f.unit_z
+  )) in
+  let vao = VertexArray.dynamic (module Window) window vsource in
+  let update = VertexArray.(VertexSource.(empty () << vertex Vector3f.zero << vertex Vector3f.zero)) in
+  VertexArray.update vao update 1;
+  assert (VertexArray.length vao = 3);
+  begin try
+    VertexArray.update vao update 2;
+    assert false
+  with
+    VertexArray.Out_of_bounds _ -> ()
+  end;
+  begin try
+    let colored = VertexArray.(VertexSource.(
+      empty () << SimpleVertex.create ~position:Vector3f.zero ~color:(`RGB Color.RGB.black) ()
+    )) in
+    VertexArray.update vao colored 0;
+    assert false
+  with
+    VertexArray.VertexSource.Incompatible_sources -> ()
+  end
+
 let () =
   test_vao1 ();
   Printf.printf "\tTest 1 passed\n%!";
@@ -233,3 +258,5 @@ let () =
   Printf.printf "\tTest 9 passed\n%!";
   test_vao10 ();
   Printf.printf "\tTest 10 passed\n%!";
+  test_vao11 ();
+  Printf.printf "\tTest 11 passed\n%!";